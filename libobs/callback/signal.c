@@ -16,35 +16,243 @@
 
 #include "../util/darray.h"
 #include "../util/threading.h"
+#include "../util/platform.h"
 
 #include "decl.h"
 #include "signal.h"
 
+/*
+ * Emitting a signal does not take any lock.  The callbacks of a signal are
+ * kept in an immutable array that connect and disconnect replace with a
+ * modified copy.  An emitter holds a reference to the array it started with,
+ * so connecting or disconnecting never waits for a signal to finish, except
+ * that disconnect waits for the disconnected callback itself if it is
+ * running on another thread, so that its data can be freed afterwards.
+ */
+
+#define SIGNAL_BUCKETS 32
+
+struct signal_id {
+	uint32_t hash;
+	const char *name;
+};
+
 struct signal_callback {
 	signal_callback_t callback;
 	void *data;
-	bool remove;
 	bool keep_ref;
+
+	volatile bool remove;
+	volatile long active;
+	volatile long refs;
+};
+
+struct callback_array {
+	volatile long refs;
+	size_t num;
+	struct signal_callback **callbacks;
 };
 
 struct signal_info {
 	struct decl_info func;
-	DARRAY(struct signal_callback) callbacks;
+	signal_id_t id;
+
+	/* only replaced with the mutex held */
+	struct callback_array *volatile callbacks;
 	pthread_mutex_t mutex;
-	bool signalling;
+
+	/* readers announce themselves in the counter of the current phase
+	 * while they take a reference to the array, replacing the array
+	 * flips the phase and waits for the old counter to drop to zero */
+	volatile long phase;
+	volatile long readers[2];
 
 	struct signal_info *next;
 };
 
+static inline uint32_t hash_signal_name(const char *name)
+{
+	uint32_t hash = 2166136261u;
+
+	while (*name) {
+		hash ^= (uint8_t)*(name++);
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Interned signal names */
+
+#define SIGNAL_ID_TABLE_MIN 256
+
+static pthread_mutex_t signal_id_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct signal_id **signal_id_table = NULL;
+static size_t signal_id_capacity = 0;
+static size_t signal_id_count = 0;
+
+static inline void signal_id_table_insert(struct signal_id **table, size_t capacity, struct signal_id *id)
+{
+	size_t idx = id->hash & (capacity - 1);
+
+	while (table[idx])
+		idx = (idx + 1) & (capacity - 1);
+	table[idx] = id;
+}
+
+/* IDs live for the lifetime of the process, so they are allocated outside
+ * of bmalloc and not reported as leaks on shutdown */
+signal_id_t signal_get_id(const char *name)
+{
+	struct signal_id *id = NULL;
+	uint32_t hash;
+
+	if (!name)
+		return NULL;
+
+	hash = hash_signal_name(name);
+
+	pthread_mutex_lock(&signal_id_mutex);
+
+	if (signal_id_capacity) {
+		size_t idx = hash & (signal_id_capacity - 1);
+
+		while (signal_id_table[idx]) {
+			struct signal_id *cur = signal_id_table[idx];
+			if (cur->hash == hash && strcmp(cur->name, name) == 0) {
+				id = cur;
+				goto done;
+			}
+			idx = (idx + 1) & (signal_id_capacity - 1);
+		}
+	}
+
+	if ((signal_id_count + 1) * 2 > signal_id_capacity) {
+		size_t capacity = signal_id_capacity ? signal_id_capacity * 2 : SIGNAL_ID_TABLE_MIN;
+		struct signal_id **table = calloc(capacity, sizeof(*table));
+		if (!table)
+			goto done;
+
+		for (size_t i = 0; i < signal_id_capacity; i++) {
+			if (signal_id_table[i])
+				signal_id_table_insert(table, capacity, signal_id_table[i]);
+		}
+
+		free(signal_id_table);
+		signal_id_table = table;
+		signal_id_capacity = capacity;
+	}
+
+	size_t len = strlen(name);
+	id = malloc(sizeof(*id) + len + 1);
+	if (!id)
+		goto done;
+
+	id->hash = hash;
+	id->name = memcpy(id + 1, name, len + 1);
+	signal_id_table_insert(signal_id_table, signal_id_capacity, id);
+	signal_id_count++;
+
+done:
+	pthread_mutex_unlock(&signal_id_mutex);
+	return id;
+}
+
+const char *signal_id_get_name(signal_id_t id)
+{
+	return id ? id->name : NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Callback arrays */
+
+static inline void signal_callback_release(struct signal_callback *cb)
+{
+	if (os_atomic_dec_long(&cb->refs) == 0)
+		bfree(cb);
+}
+
+static struct callback_array *callback_array_create(size_t num)
+{
+	struct callback_array *array = bmalloc(sizeof(*array) + sizeof(struct signal_callback *) * num);
+	array->refs = 1;
+	array->num = 0;
+	array->callbacks = (struct signal_callback **)(array + 1);
+	return array;
+}
+
+static inline void callback_array_push(struct callback_array *array, struct signal_callback *cb)
+{
+	os_atomic_inc_long(&cb->refs);
+	array->callbacks[array->num++] = cb;
+}
+
+static void callback_array_release(struct callback_array *array)
+{
+	if (!array || os_atomic_dec_long(&array->refs) != 0)
+		return;
+
+	for (size_t i = 0; i < array->num; i++)
+		signal_callback_release(array->callbacks[i]);
+	bfree(array);
+}
+
+static struct callback_array *callback_array_acquire(struct signal_info *si)
+{
+	for (;;) {
+		long phase = os_atomic_load_long(&si->phase);
+		volatile long *readers = &si->readers[phase & 1];
+
+		os_atomic_inc_long(readers);
+
+		if (os_atomic_load_long(&si->phase) == phase) {
+			struct callback_array *array = os_atomic_load_ptr((void *const volatile *)&si->callbacks);
+			if (array)
+				os_atomic_inc_long(&array->refs);
+
+			os_atomic_dec_long(readers);
+			return array;
+		}
+
+		os_atomic_dec_long(readers);
+	}
+}
+
+/* must hold the signal mutex */
+static void callback_array_replace(struct signal_info *si, struct callback_array *array)
+{
+	struct callback_array *old = os_atomic_exchange_ptr((void *volatile *)&si->callbacks, array);
+	long phase = os_atomic_inc_long(&si->phase) - 1;
+
+	/* readers only stay in the counter for a few instructions */
+	while (os_atomic_load_long(&si->readers[phase & 1]))
+		os_sleep_ms(0);
+
+	callback_array_release(old);
+}
+
+static inline size_t signal_get_callback_idx(struct callback_array *array, signal_callback_t callback, void *data)
+{
+	for (size_t i = 0; array && i < array->num; i++) {
+		struct signal_callback *sc = array->callbacks[i];
+
+		if (sc->callback == callback && sc->data == data)
+			return i;
+	}
+
+	return DARRAY_INVALID;
+}
+
+/* ------------------------------------------------------------------------- */
+
 static inline struct signal_info *signal_info_create(struct decl_info *info)
 {
-	struct signal_info *si = bmalloc(sizeof(struct signal_info));
+	struct signal_info *si = bzalloc(sizeof(struct signal_info));
 	si->func = *info;
-	si->next = NULL;
-	si->signalling = false;
-	da_init(si->callbacks);
+	si->id = signal_get_id(info->name);
 
-	if (pthread_mutex_init_recursive(&si->mutex) != 0) {
+	if (!si->id || pthread_mutex_init(&si->mutex, NULL) != 0) {
 		blog(LOG_ERROR, "Could not create signal");
 
 		decl_info_free(&si->func);
@@ -60,23 +268,11 @@ static inline void signal_info_destroy(struct signal_info *si)
 	if (si) {
 		pthread_mutex_destroy(&si->mutex);
 		decl_info_free(&si->func);
-		da_free(si->callbacks);
+		callback_array_release(si->callbacks);
 		bfree(si);
 	}
 }
 
-static inline size_t signal_get_callback_idx(struct signal_info *si, signal_callback_t callback, void *data)
-{
-	for (size_t i = 0; i < si->callbacks.num; i++) {
-		struct signal_callback *sc = si->callbacks.array + i;
-
-		if (sc->callback == callback && sc->data == data)
-			return i;
-	}
-
-	return DARRAY_INVALID;
-}
-
 struct global_callback_info {
 	global_signal_callback_t callback;
 	void *data;
@@ -85,30 +281,50 @@ struct global_callback_info {
 };
 
 struct signal_handler {
-	struct signal_info *first;
+	/* signals are only ever added, and a signal is fully set up before
+	 * it is linked in, so lookups don't need the mutex */
+	struct signal_info *volatile buckets[SIGNAL_BUCKETS];
 	pthread_mutex_t mutex;
 	volatile long refs;
 
 	DARRAY(struct global_callback_info) global_callbacks;
+	volatile long num_global_callbacks;
 	pthread_mutex_t global_callbacks_mutex;
 };
 
-static struct signal_info *getsignal(signal_handler_t *handler, const char *name, struct signal_info **p_last)
+static inline struct signal_info *get_bucket(signal_handler_t *handler, uint32_t hash)
+{
+	return os_atomic_load_ptr((void *const volatile *)&handler->buckets[hash % SIGNAL_BUCKETS]);
+}
+
+static struct signal_info *getsignal(signal_handler_t *handler, const char *name)
 {
-	struct signal_info *signal, *last = NULL;
+	uint32_t hash;
+
+	if (!handler || !name)
+		return NULL;
 
-	signal = handler->first;
-	while (signal != NULL) {
-		if (strcmp(signal->func.name, name) == 0)
-			break;
+	hash = hash_signal_name(name);
 
-		last = signal;
-		signal = signal->next;
+	for (struct signal_info *si = get_bucket(handler, hash); si; si = si->next) {
+		if (si->id->hash == hash && strcmp(si->id->name, name) == 0)
+			return si;
 	}
 
-	if (p_last)
-		*p_last = last;
-	return signal;
+	return NULL;
+}
+
+static struct signal_info *getsignal_id(signal_handler_t *handler, signal_id_t id)
+{
+	if (!handler || !id)
+		return NULL;
+
+	for (struct signal_info *si = get_bucket(handler, id->hash); si; si = si->next) {
+		if (si->id == id)
+			return si;
+	}
+
+	return NULL;
 }
 
 /* ------------------------------------------------------------------------- */
@@ -116,7 +332,6 @@ static struct signal_info *getsignal(signal_handler_t *handler, const char *name
 signal_handler_t *signal_handler_create(void)
 {
 	struct signal_handler *handler = bzalloc(sizeof(struct signal_handler));
-	handler->first = NULL;
 	handler->refs = 1;
 
 	if (pthread_mutex_init(&handler->mutex, NULL) != 0) {
@@ -137,11 +352,13 @@ signal_handler_t *signal_handler_create(void)
 
 static void signal_handler_actually_destroy(signal_handler_t *handler)
 {
-	struct signal_info *sig = handler->first;
-	while (sig != NULL) {
-		struct signal_info *next = sig->next;
-		signal_info_destroy(sig);
-		sig = next;
+	for (size_t i = 0; i < SIGNAL_BUCKETS; i++) {
+		struct signal_info *sig = handler->buckets[i];
+		while (sig != NULL) {
+			struct signal_info *next = sig->next;
+			signal_info_destroy(sig);
+			sig = next;
+		}
 	}
 
 	da_free(handler->global_callbacks);
@@ -160,7 +377,7 @@ void signal_handler_destroy(signal_handler_t *handler)
 bool signal_handler_add(signal_handler_t *handler, const char *signal_decl)
 {
 	struct decl_info func = {0};
-	struct signal_info *sig, *last;
+	struct signal_info *sig;
 	bool success = true;
 
 	if (!parse_decl_string(&func, signal_decl)) {
@@ -170,17 +387,21 @@ bool signal_handler_add(signal_handler_t *handler, const char *signal_decl)
 
 	pthread_mutex_lock(&handler->mutex);
 
-	sig = getsignal(handler, func.name, &last);
+	sig = getsignal(handler, func.name);
 	if (sig) {
 		blog(LOG_WARNING, "Signal declaration '%s' exists", func.name);
 		decl_info_free(&func);
 		success = false;
 	} else {
 		sig = signal_info_create(&func);
-		if (!last)
-			handler->first = sig;
-		else
-			last->next = sig;
+		if (sig) {
+			struct signal_info *volatile *bucket = &handler->buckets[sig->id->hash % SIGNAL_BUCKETS];
+
+			sig->next = *bucket;
+			os_atomic_store_ptr((void *volatile *)bucket, sig);
+		} else {
+			success = false;
+		}
 	}
 
 	pthread_mutex_unlock(&handler->mutex);
@@ -191,17 +412,14 @@ bool signal_handler_add(signal_handler_t *handler, const char *signal_decl)
 static void signal_handler_connect_internal(signal_handler_t *handler, const char *signal, signal_callback_t callback,
 					    void *data, bool keep_ref)
 {
-	struct signal_info *sig, *last;
-	struct signal_callback cb_data = {callback, data, false, keep_ref};
+	struct signal_info *sig;
+	struct callback_array *old, *array;
 	size_t idx;
 
 	if (!handler)
 		return;
 
-	pthread_mutex_lock(&handler->mutex);
-	sig = getsignal(handler, signal, &last);
-	pthread_mutex_unlock(&handler->mutex);
-
+	sig = getsignal(handler, signal);
 	if (!sig) {
 		blog(LOG_WARNING,
 		     "signal_handler_connect: "
@@ -217,9 +435,23 @@ static void signal_handler_connect_internal(signal_handler_t *handler, const cha
 	if (keep_ref)
 		os_atomic_inc_long(&handler->refs);
 
-	idx = signal_get_callback_idx(sig, callback, data);
-	if (keep_ref || idx == DARRAY_INVALID)
-		da_push_back(sig->callbacks, &cb_data);
+	old = sig->callbacks;
+	idx = signal_get_callback_idx(old, callback, data);
+	if (keep_ref || idx == DARRAY_INVALID) {
+		struct signal_callback *cb = bzalloc(sizeof(*cb));
+		size_t num = old ? old->num : 0;
+
+		cb->callback = callback;
+		cb->data = data;
+		cb->keep_ref = keep_ref;
+
+		array = callback_array_create(num + 1);
+		for (size_t i = 0; i < num; i++)
+			callback_array_push(array, old->callbacks[i]);
+		callback_array_push(array, cb);
+
+		callback_array_replace(sig, array);
+	}
 
 	pthread_mutex_unlock(&sig->mutex);
 }
@@ -234,24 +466,66 @@ void signal_handler_connect_ref(signal_handler_t *handler, const char *signal, s
 	signal_handler_connect_internal(handler, signal, callback, data, true);
 }
 
-static inline struct signal_info *getsignal_locked(signal_handler_t *handler, const char *name)
+/* must hold the signal mutex, returns the number of handler references held
+ * by the removed callbacks */
+static long remove_callbacks(struct signal_info *sig, struct signal_callback *target)
 {
-	struct signal_info *sig;
+	struct callback_array *old = sig->callbacks;
+	struct callback_array *array;
+	long remove_refs = 0;
 
-	if (!handler)
-		return NULL;
+	if (!old)
+		return 0;
 
-	pthread_mutex_lock(&handler->mutex);
-	sig = getsignal(handler, name, NULL);
-	pthread_mutex_unlock(&handler->mutex);
+	array = callback_array_create(old->num);
 
-	return sig;
+	for (size_t i = 0; i < old->num; i++) {
+		struct signal_callback *cb = old->callbacks[i];
+
+		if (cb == target || os_atomic_load_bool(&cb->remove)) {
+			os_atomic_set_bool(&cb->remove, true);
+			if (cb->keep_ref)
+				remove_refs++;
+		} else {
+			callback_array_push(array, cb);
+		}
+	}
+
+	if (array->num == old->num) {
+		callback_array_release(array);
+		return 0;
+	}
+
+	callback_array_replace(sig, array);
+	return remove_refs;
+}
+
+/* callbacks currently being called on this thread, innermost first */
+struct signal_call {
+	struct signal_callback *cb;
+	struct signal_call *prev;
+};
+
+static THREAD_LOCAL struct signal_call *current_signal_call = NULL;
+static THREAD_LOCAL struct global_callback_info *current_global_cb = NULL;
+
+static inline long calls_on_this_thread(struct signal_callback *cb)
+{
+	long count = 0;
+
+	for (struct signal_call *call = current_signal_call; call; call = call->prev) {
+		if (call->cb == cb)
+			count++;
+	}
+
+	return count;
 }
 
 void signal_handler_disconnect(signal_handler_t *handler, const char *signal, signal_callback_t callback, void *data)
 {
-	struct signal_info *sig = getsignal_locked(handler, signal);
-	bool keep_ref = false;
+	struct signal_info *sig = getsignal(handler, signal);
+	struct signal_callback *cb = NULL;
+	long remove_refs = 0;
 	size_t idx;
 
 	if (!sig)
@@ -259,77 +533,85 @@ void signal_handler_disconnect(signal_handler_t *handler, const char *signal, si
 
 	pthread_mutex_lock(&sig->mutex);
 
-	idx = signal_get_callback_idx(sig, callback, data);
+	idx = signal_get_callback_idx(sig->callbacks, callback, data);
 	if (idx != DARRAY_INVALID) {
-		if (sig->signalling) {
-			sig->callbacks.array[idx].remove = true;
-		} else {
-			keep_ref = sig->callbacks.array[idx].keep_ref;
-			da_erase(sig->callbacks, idx);
-		}
+		cb = sig->callbacks->callbacks[idx];
+		os_atomic_inc_long(&cb->refs);
+		remove_refs = remove_callbacks(sig, cb);
 	}
 
 	pthread_mutex_unlock(&sig->mutex);
 
-	if (keep_ref && os_atomic_dec_long(&handler->refs) == 0) {
-		signal_handler_actually_destroy(handler);
+	if (cb) {
+		/* another thread may be inside the callback right now */
+		long own_calls = calls_on_this_thread(cb);
+
+		while (os_atomic_load_long(&cb->active) > own_calls)
+			os_sleep_ms(1);
+
+		signal_callback_release(cb);
 	}
-}
 
-static THREAD_LOCAL struct signal_callback *current_signal_cb = NULL;
-static THREAD_LOCAL struct global_callback_info *current_global_cb = NULL;
+	while (remove_refs--) {
+		if (os_atomic_dec_long(&handler->refs) == 0)
+			signal_handler_actually_destroy(handler);
+	}
+}
 
 void signal_handler_remove_current(void)
 {
-	if (current_signal_cb)
-		current_signal_cb->remove = true;
+	if (current_signal_call)
+		os_atomic_set_bool(&current_signal_call->cb->remove, true);
 	else if (current_global_cb)
 		current_global_cb->remove = true;
 }
 
-void signal_handler_signal(signal_handler_t *handler, const char *signal, calldata_t *params)
+static void signal_emit(signal_handler_t *handler, struct signal_info *sig, calldata_t *params)
 {
-	struct signal_info *sig = getsignal_locked(handler, signal);
+	struct callback_array *array = callback_array_acquire(sig);
+	bool removed = false;
 	long remove_refs = 0;
 
-	if (!sig)
-		return;
+	for (size_t i = 0; array && i < array->num; i++) {
+		struct signal_callback *cb = array->callbacks[i];
 
-	pthread_mutex_lock(&sig->mutex);
-	sig->signalling = true;
+		/* marked active before checking the flag, so a disconnect
+		 * either sees the call or the call sees the disconnect */
+		os_atomic_inc_long(&cb->active);
+
+		if (!os_atomic_load_bool(&cb->remove)) {
+			struct signal_call call = {cb, current_signal_call};
 
-	for (size_t i = 0; i < sig->callbacks.num; i++) {
-		struct signal_callback *cb = sig->callbacks.array + i;
-		if (!cb->remove) {
-			current_signal_cb = cb;
+			current_signal_call = &call;
 			cb->callback(cb->data, params);
-			current_signal_cb = NULL;
+			current_signal_call = call.prev;
+
+			if (os_atomic_load_bool(&cb->remove))
+				removed = true;
 		}
+
+		os_atomic_dec_long(&cb->active);
 	}
 
-	for (size_t i = sig->callbacks.num; i > 0; i--) {
-		struct signal_callback *cb = sig->callbacks.array + i - 1;
-		if (cb->remove) {
-			if (cb->keep_ref)
-				remove_refs++;
+	callback_array_release(array);
 
-			da_erase(sig->callbacks, i - 1);
-		}
+	/* callbacks that removed themselves with signal_handler_remove_current */
+	if (removed) {
+		pthread_mutex_lock(&sig->mutex);
+		remove_refs = remove_callbacks(sig, NULL);
+		pthread_mutex_unlock(&sig->mutex);
 	}
 
-	sig->signalling = false;
-	pthread_mutex_unlock(&sig->mutex);
-
-	pthread_mutex_lock(&handler->global_callbacks_mutex);
+	if (os_atomic_load_long(&handler->num_global_callbacks)) {
+		pthread_mutex_lock(&handler->global_callbacks_mutex);
 
-	if (handler->global_callbacks.num) {
 		for (size_t i = 0; i < handler->global_callbacks.num; i++) {
 			struct global_callback_info *cb = handler->global_callbacks.array + i;
 
 			if (!cb->remove) {
 				cb->signaling++;
 				current_global_cb = cb;
-				cb->callback(cb->data, signal, params);
+				cb->callback(cb->data, sig->id->name, params);
 				current_global_cb = NULL;
 				cb->signaling--;
 			}
@@ -341,15 +623,32 @@ void signal_handler_signal(signal_handler_t *handler, const char *signal, callda
 			if (cb->remove && !cb->signaling)
 				da_erase(handler->global_callbacks, i - 1);
 		}
-	}
 
-	pthread_mutex_unlock(&handler->global_callbacks_mutex);
+		os_atomic_set_long(&handler->num_global_callbacks, (long)handler->global_callbacks.num);
+		pthread_mutex_unlock(&handler->global_callbacks_mutex);
+	}
 
 	if (remove_refs) {
 		os_atomic_set_long(&handler->refs, os_atomic_load_long(&handler->refs) - remove_refs);
 	}
 }
 
+void signal_handler_signal(signal_handler_t *handler, const char *signal, calldata_t *params)
+{
+	struct signal_info *sig = getsignal(handler, signal);
+
+	if (sig)
+		signal_emit(handler, sig, params);
+}
+
+void signal_handler_signal_id(signal_handler_t *handler, signal_id_t id, calldata_t *params)
+{
+	struct signal_info *sig = getsignal_id(handler, id);
+
+	if (sig)
+		signal_emit(handler, sig, params);
+}
+
 void signal_handler_connect_global(signal_handler_t *handler, global_signal_callback_t callback, void *data)
 {
 	struct global_callback_info cb_data = {callback, data, 0, false};
@@ -364,6 +663,7 @@ void signal_handler_connect_global(signal_handler_t *handler, global_signal_call
 	if (idx == DARRAY_INVALID)
 		da_push_back(handler->global_callbacks, &cb_data);
 
+	os_atomic_set_long(&handler->num_global_callbacks, (long)handler->global_callbacks.num);
 	pthread_mutex_unlock(&handler->global_callbacks_mutex);
 }
 
@@ -387,5 +687,6 @@ void signal_handler_disconnect_global(signal_handler_t *handler, global_signal_c
 			da_erase(handler->global_callbacks, idx);
 	}
 
+	os_atomic_set_long(&handler->num_global_callbacks, (long)handler->global_callbacks.num);
 	pthread_mutex_unlock(&handler->global_callbacks_mutex);
 }
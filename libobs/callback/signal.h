@@ -68,6 +68,23 @@ EXPORT void signal_handler_remove_current(void);
 
 EXPORT void signal_handler_signal(signal_handler_t *handler, const char *signal, calldata_t *params);
 
+/*
+ * Interned signal names
+ *
+ *   Signal IDs are shared by all signal handlers and stay valid for the
+ * lifetime of the process, so they can be looked up once and kept in a
+ * static variable.  Signalling by ID skips hashing and comparing the name,
+ * which is worth it for signals that are emitted very often.
+ */
+
+struct signal_id;
+typedef const struct signal_id *signal_id_t;
+
+EXPORT signal_id_t signal_get_id(const char *name);
+EXPORT const char *signal_id_get_name(signal_id_t id);
+
+EXPORT void signal_handler_signal_id(signal_handler_t *handler, signal_id_t id, calldata_t *params);
+
 #ifdef __cplusplus
 }
 #endif
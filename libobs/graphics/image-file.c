@@ -15,10 +15,13 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 ******************************************************************************/
 
+#include <inttypes.h>
+
 #include "image-file.h"
 #include "../util/base.h"
 #include "../util/platform.h"
 #include "../util/dstr.h"
+#include "../util/threading.h"
 #include "vec4.h"
 
 #define blog(level, format, ...) blog(level, "%s: " format, __FUNCTION__, __VA_ARGS__)
@@ -69,8 +72,336 @@ static inline void *alloc_mem(gs_image_file_t *image, uint64_t *mem_usage, size_
 	return bzalloc(size);
 }
 
+static inline void premultiply_frame(uint8_t *data, size_t area, enum gs_image_alpha_mode alpha_mode)
+{
+	if (alpha_mode == GS_IMAGE_ALPHA_PREMULTIPLY_SRGB) {
+		gs_premultiply_xyza_srgb_loop(data, area);
+	} else if (alpha_mode == GS_IMAGE_ALPHA_PREMULTIPLY) {
+		gs_premultiply_xyza_loop(data, area);
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+/* streamed GIF decoding                                                     */
+
+#define GIF_STREAM_MIN_FRAMES 3
+
+struct gs_gif_stream {
+	gs_image_file_t *image;
+	enum gs_image_alpha_mode alpha_mode;
+	int frame_count;
+	size_t frame_size;
+
+	/* frames [read, write) of the window are ready, the worker decodes
+	 * the next one into the slot at write */
+	pthread_mutex_t mutex;
+	os_event_t *event;
+	pthread_t thread;
+	bool thread_created;
+	bool stop;
+	bool reset;
+	uint8_t *window_data;
+	int *window_frames;
+	size_t window;
+	size_t read;
+	size_t write;
+	int next_frame;
+
+	/* only used by the worker */
+	int last_decoded_frame;
+	uint8_t **compressed;
+	size_t *compressed_size;
+	uint64_t compressed_budget;
+	uint64_t compressed_bytes;
+	uint8_t *scratch;
+	uint64_t frames_decoded;
+	uint64_t frames_decompressed;
+
+	/* only used by the consumer */
+	int shown_frame;
+	uint64_t late_ticks;
+};
+
+/* Frames are stored as runs of pixels: a header with the top bit set repeats
+ * the pixel after it, otherwise the header is followed by that many pixels.
+ * GIF frames are mostly flat areas of palette colors, so this goes a long
+ * way for very little work. */
+#define RLE_RUN 0x80000000U
+#define RLE_MAX_COUNT 0x7FFFFFFFU
+
+static size_t rle_encode(uint8_t *dst, const uint8_t *src, size_t count)
+{
+	const uint32_t *in = (const uint32_t *)src;
+	uint32_t *out = (uint32_t *)dst;
+	size_t i = 0;
+	size_t o = 0;
+
+	while (i < count) {
+		size_t run = 1;
+		while (i + run < count && run < RLE_MAX_COUNT && in[i + run] == in[i])
+			run++;
+
+		if (run >= 3) {
+			out[o++] = RLE_RUN | (uint32_t)run;
+			out[o++] = in[i];
+			i += run;
+			continue;
+		}
+
+		size_t start = i;
+		size_t header = o++;
+
+		while (i < count && i - start < RLE_MAX_COUNT) {
+			if (i + 2 < count && in[i] == in[i + 1] && in[i] == in[i + 2])
+				break;
+			out[o++] = in[i++];
+		}
+
+		out[header] = (uint32_t)(i - start);
+	}
+
+	return o * sizeof(uint32_t);
+}
+
+static void rle_decode(uint8_t *dst, const uint8_t *src, size_t size)
+{
+	const uint32_t *in = (const uint32_t *)src;
+	const uint32_t *end = in + size / sizeof(uint32_t);
+	uint32_t *out = (uint32_t *)dst;
+
+	while (in < end) {
+		uint32_t header = *(in++);
+		uint32_t count = header & RLE_MAX_COUNT;
+
+		if (header & RLE_RUN) {
+			uint32_t pixel = *(in++);
+			for (uint32_t i = 0; i < count; i++)
+				*(out++) = pixel;
+		} else {
+			memcpy(out, in, count * sizeof(uint32_t));
+			out += count;
+			in += count;
+		}
+	}
+}
+
+static inline uint8_t *gif_stream_slot(struct gs_gif_stream *stream, size_t pos)
+{
+	return stream->window_data + (pos % stream->window) * stream->frame_size;
+}
+
+static void gif_stream_compress_frame(struct gs_gif_stream *stream, int frame, const uint8_t *data)
+{
+	size_t size = rle_encode(stream->scratch, data, stream->frame_size / 4);
+
+	if (size >= stream->frame_size || stream->compressed_bytes + size > stream->compressed_budget)
+		return;
+
+	stream->compressed[frame] = bmemdup(stream->scratch, size);
+	stream->compressed_size[frame] = size;
+	stream->compressed_bytes += size;
+}
+
+static void gif_stream_decode_frame(struct gs_gif_stream *stream, int frame, uint8_t *dst)
+{
+	gs_image_file_t *image = stream->image;
+
+	if (stream->compressed && stream->compressed[frame]) {
+		rle_decode(dst, stream->compressed[frame], stream->compressed_size[frame]);
+		stream->frames_decompressed++;
+		return;
+	}
+
+	/* frames are drawn over the ones before them, so anything that was
+	 * skipped still has to be decoded */
+	int first = (frame < stream->last_decoded_frame) ? 0 : stream->last_decoded_frame + 1;
+	for (int i = first; i <= frame; i++)
+		gif_decode_frame(&image->gif, i);
+	stream->last_decoded_frame = frame;
+
+	memcpy(dst, image->gif.frame_image, stream->frame_size);
+	premultiply_frame(dst, stream->frame_size / 4, stream->alpha_mode);
+	stream->frames_decoded++;
+
+	if (stream->compressed)
+		gif_stream_compress_frame(stream, frame, dst);
+}
+
+static void *gif_stream_thread(void *data)
+{
+	struct gs_gif_stream *stream = data;
+
+	os_set_thread_name("gif decoder");
+
+	pthread_mutex_lock(&stream->mutex);
+
+	while (!stream->stop) {
+		if (stream->write - stream->read == stream->window) {
+			pthread_mutex_unlock(&stream->mutex);
+			os_event_wait(stream->event);
+			pthread_mutex_lock(&stream->mutex);
+			continue;
+		}
+
+		int frame = stream->next_frame;
+		uint8_t *dst = gif_stream_slot(stream, stream->write);
+		stream->reset = false;
+
+		pthread_mutex_unlock(&stream->mutex);
+
+		/* the slot at write is not visible to the consumer */
+		gif_stream_decode_frame(stream, frame, dst);
+
+		pthread_mutex_lock(&stream->mutex);
+
+		/* if the consumer jumped elsewhere in the meantime, this frame is
+		 * no longer wanted */
+		if (!stream->reset) {
+			stream->window_frames[stream->write % stream->window] = frame;
+			stream->write++;
+			stream->next_frame = (frame + 1) % stream->frame_count;
+		}
+	}
+
+	pthread_mutex_unlock(&stream->mutex);
+	return NULL;
+}
+
+/* Returns the frame if the worker has decoded it, or NULL if it hasn't got to
+ * it yet.  The frame stays valid until the next call. */
+static uint8_t *gif_stream_get_frame(struct gs_gif_stream *stream, int frame)
+{
+	uint8_t *data = NULL;
+	bool signal = false;
+
+	pthread_mutex_lock(&stream->mutex);
+
+	/* frames before the requested one are no longer needed */
+	while (stream->read != stream->write) {
+		if (stream->window_frames[stream->read % stream->window] == frame) {
+			data = gif_stream_slot(stream, stream->read);
+			break;
+		}
+
+		stream->read++;
+		signal = true;
+	}
+
+	/* restart from the requested frame unless the worker is about to get
+	 * to it anyway */
+	if (!data) {
+		int ahead = (frame - stream->next_frame + stream->frame_count) % stream->frame_count;
+		if ((size_t)ahead >= stream->window) {
+			stream->next_frame = frame;
+			stream->reset = true;
+			signal = true;
+		}
+	}
+
+	pthread_mutex_unlock(&stream->mutex);
+
+	if (signal)
+		os_event_signal(stream->event);
+	return data;
+}
+
+static void gif_stream_destroy(struct gs_gif_stream *stream)
+{
+	if (!stream)
+		return;
+
+	if (stream->thread_created) {
+		pthread_mutex_lock(&stream->mutex);
+		stream->stop = true;
+		pthread_mutex_unlock(&stream->mutex);
+
+		os_event_signal(stream->event);
+		pthread_join(stream->thread, NULL);
+	}
+
+	blog(LOG_DEBUG,
+	     "%d frame window, %" PRIu64 " frames decoded, %" PRIu64 " decompressed "
+	     "(%" PRIu64 " bytes), waited for the decoder on %" PRIu64 " ticks",
+	     (int)stream->window, stream->frames_decoded, stream->frames_decompressed, stream->compressed_bytes,
+	     stream->late_ticks);
+
+	if (stream->compressed) {
+		for (int i = 0; i < stream->frame_count; i++)
+			bfree(stream->compressed[i]);
+	}
+
+	os_event_destroy(stream->event);
+	pthread_mutex_destroy(&stream->mutex);
+	bfree(stream->compressed);
+	bfree(stream->compressed_size);
+	bfree(stream->scratch);
+	bfree(stream->window_frames);
+	bfree(stream->window_data);
+	bfree(stream);
+}
+
+static struct gs_gif_stream *gif_stream_create(gs_image_file_t *image, enum gs_image_alpha_mode alpha_mode,
+					       uint64_t budget, bool compress, uint64_t *mem_usage)
+{
+	struct gs_gif_stream *stream = bzalloc(sizeof(*stream));
+	uint64_t window_bytes;
+
+	stream->image = image;
+	stream->alpha_mode = alpha_mode;
+	stream->frame_count = (int)image->gif.frame_count;
+	stream->frame_size = (size_t)image->gif.width * image->gif.height * 4;
+	stream->last_decoded_frame = -1;
+
+	/* with compression, half of the budget goes to compressed frames */
+	stream->window = (size_t)((compress ? budget / 2 : budget) / stream->frame_size);
+	if (stream->window < GIF_STREAM_MIN_FRAMES)
+		stream->window = GIF_STREAM_MIN_FRAMES;
+	if (stream->window > (size_t)stream->frame_count)
+		stream->window = (size_t)stream->frame_count;
+
+	window_bytes = (uint64_t)stream->window * stream->frame_size;
+	stream->window_data = bmalloc(stream->window * stream->frame_size);
+	stream->window_frames = bzalloc(stream->window * sizeof(int));
+
+	if (compress) {
+		stream->compressed_budget = budget > window_bytes ? budget - window_bytes : 0;
+		stream->compressed = bzalloc(stream->frame_count * sizeof(uint8_t *));
+		stream->compressed_size = bzalloc(stream->frame_count * sizeof(size_t));
+		stream->scratch = bmalloc(stream->frame_size * 2 + sizeof(uint32_t) * 2);
+	}
+
+	if (mem_usage)
+		*mem_usage += window_bytes + stream->compressed_budget;
+
+	/* the first frame is needed right away for the texture */
+	gif_stream_decode_frame(stream, 0, stream->window_data);
+	stream->window_frames[0] = 0;
+	stream->write = 1;
+	stream->next_frame = 1;
+
+	if (pthread_mutex_init(&stream->mutex, NULL) != 0)
+		goto fail;
+	if (os_event_init(&stream->event, OS_EVENT_TYPE_AUTO) != 0)
+		goto fail;
+	if (pthread_create(&stream->thread, NULL, gif_stream_thread, stream) != 0)
+		goto fail;
+
+	stream->thread_created = true;
+	return stream;
+
+fail:
+	blog(LOG_WARNING, "Failed to create decoder thread, decoding %d frames at once", stream->frame_count);
+	if (mem_usage)
+		*mem_usage -= window_bytes + stream->compressed_budget;
+	gif_stream_destroy(stream);
+	return NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+
 static bool init_animated_gif(gs_image_file_t *image, const char *path, uint64_t *mem_usage,
-			      enum gs_image_alpha_mode alpha_mode)
+			      enum gs_image_alpha_mode alpha_mode, uint64_t gif_memory_budget,
+			      bool gif_compress_frames, struct gs_gif_stream **stream)
 {
 	bool is_animated_gif = true;
 	gif_result result;
@@ -122,13 +453,24 @@ static bool init_animated_gif(gs_image_file_t *image, const char *path, uint64_t
 
 	max_size = (uint64_t)image->gif.width * (uint64_t)image->gif.height * (uint64_t)image->gif.frame_count * 4LLU;
 
-	if ((uint64_t)get_full_decoded_gif_size(image) != max_size) {
+	image->is_animated_gif = (image->gif.frame_count > 1 && result >= 0);
+
+	if (image->is_animated_gif && stream && gif_memory_budget && max_size > gif_memory_budget)
+		*stream = gif_stream_create(image, alpha_mode, gif_memory_budget, gif_compress_frames, mem_usage);
+
+	if (stream && *stream) {
+		image->cx = (uint32_t)image->gif.width;
+		image->cy = (uint32_t)image->gif.height;
+		image->format = GS_RGBA;
+
+		if (mem_usage)
+			*mem_usage += size;
+
+	} else if ((uint64_t)get_full_decoded_gif_size(image) != max_size) {
 		blog(LOG_WARNING, "Gif '%s' overflowed maximum pointer size", path);
 		goto fail;
-	}
 
-	image->is_animated_gif = (image->gif.frame_count > 1 && result >= 0);
-	if (image->is_animated_gif) {
+	} else if (image->is_animated_gif) {
 		gif_decode_frame(&image->gif, 0);
 
 		image->animation_frame_cache = alloc_mem(image, mem_usage, image->gif.frame_count * sizeof(uint8_t *));
@@ -153,11 +495,7 @@ static bool init_animated_gif(gs_image_file_t *image, const char *path, uint64_t
 			*mem_usage += size;
 		}
 
-		if (alpha_mode == GS_IMAGE_ALPHA_PREMULTIPLY_SRGB) {
-			gs_premultiply_xyza_srgb_loop(image->gif.frame_image, (size_t)image->cx * image->cy);
-		} else if (alpha_mode == GS_IMAGE_ALPHA_PREMULTIPLY) {
-			gs_premultiply_xyza_loop(image->gif.frame_image, (size_t)image->cx * image->cy);
-		}
+		premultiply_frame(image->gif.frame_image, (size_t)image->cx * image->cy, alpha_mode);
 	} else {
 		gif_finalise(&image->gif);
 		bfree(image->gif_data);
@@ -179,7 +517,9 @@ not_animated:
 }
 
 static void gs_image_file_init_internal(gs_image_file_t *image, const char *file, uint64_t *mem_usage,
-					enum gs_color_space *space, enum gs_image_alpha_mode alpha_mode)
+					enum gs_color_space *space, enum gs_image_alpha_mode alpha_mode,
+					uint64_t gif_memory_budget, bool gif_compress_frames,
+					struct gs_gif_stream **stream)
 {
 	size_t len;
 
@@ -194,7 +534,8 @@ static void gs_image_file_init_internal(gs_image_file_t *image, const char *file
 	len = strlen(file);
 
 	if (len > 4 && astrcmpi(file + len - 4, ".gif") == 0) {
-		if (init_animated_gif(image, file, mem_usage, alpha_mode)) {
+		if (init_animated_gif(image, file, mem_usage, alpha_mode, gif_memory_budget, gif_compress_frames,
+				      stream)) {
 			return;
 		}
 	}
@@ -216,7 +557,7 @@ static void gs_image_file_init_internal(gs_image_file_t *image, const char *file
 void gs_image_file_init(gs_image_file_t *image, const char *file)
 {
 	enum gs_color_space unused;
-	gs_image_file_init_internal(image, file, NULL, &unused, GS_IMAGE_ALPHA_STRAIGHT);
+	gs_image_file_init_internal(image, file, NULL, &unused, GS_IMAGE_ALPHA_STRAIGHT, 0, false, NULL);
 }
 
 void gs_image_file_free(gs_image_file_t *image)
@@ -242,31 +583,53 @@ void gs_image_file_free(gs_image_file_t *image)
 void gs_image_file2_init(gs_image_file2_t *if2, const char *file)
 {
 	enum gs_color_space unused;
-	gs_image_file_init_internal(&if2->image, file, &if2->mem_usage, &unused, GS_IMAGE_ALPHA_STRAIGHT);
+	gs_image_file_init_internal(&if2->image, file, &if2->mem_usage, &unused, GS_IMAGE_ALPHA_STRAIGHT, 0, false,
+				    NULL);
 }
 
 void gs_image_file3_init(gs_image_file3_t *if3, const char *file, enum gs_image_alpha_mode alpha_mode)
 {
 	enum gs_color_space unused;
-	gs_image_file_init_internal(&if3->image2.image, file, &if3->image2.mem_usage, &unused, alpha_mode);
+	gs_image_file_init_internal(&if3->image2.image, file, &if3->image2.mem_usage, &unused, alpha_mode, 0, false,
+				    NULL);
 	if3->alpha_mode = alpha_mode;
 }
 
 void gs_image_file4_init(gs_image_file4_t *if4, const char *file, enum gs_image_alpha_mode alpha_mode)
 {
 	gs_image_file_init_internal(&if4->image3.image2.image, file, &if4->image3.image2.mem_usage, &if4->space,
-				    alpha_mode);
+				    alpha_mode, 0, false, NULL);
 	if4->image3.alpha_mode = alpha_mode;
 }
 
-void gs_image_file_init_texture(gs_image_file_t *image)
+void gs_image_file5_init(gs_image_file5_t *if5, const char *file, enum gs_image_alpha_mode alpha_mode,
+			 uint64_t gif_memory_budget, bool gif_compress_frames)
+{
+	gs_image_file4_t *if4 = &if5->image4;
+
+	if5->gif_stream = NULL;
+	gs_image_file_init_internal(&if4->image3.image2.image, file, &if4->image3.image2.mem_usage, &if4->space,
+				    alpha_mode, gif_memory_budget, gif_compress_frames, &if5->gif_stream);
+	if4->image3.alpha_mode = alpha_mode;
+}
+
+void gs_image_file5_free(gs_image_file5_t *if5)
+{
+	/* the decoder thread uses the gif, so it has to go first */
+	gif_stream_destroy(if5->gif_stream);
+	if5->gif_stream = NULL;
+
+	gs_image_file4_free(&if5->image4);
+}
+
+static void gs_image_file_init_texture_internal(gs_image_file_t *image, struct gs_gif_stream *stream)
 {
 	if (!image->loaded)
 		return;
 
 	if (image->is_animated_gif) {
-		image->texture = gs_texture_create(image->cx, image->cy, image->format, 1,
-						   (const uint8_t **)&image->gif.frame_image, GS_DYNAMIC);
+		const uint8_t *data = stream ? gif_stream_get_frame(stream, 0) : image->gif.frame_image;
+		image->texture = gs_texture_create(image->cx, image->cy, image->format, 1, &data, GS_DYNAMIC);
 
 	} else {
 		image->texture = gs_texture_create(image->cx, image->cy, image->format, 1,
@@ -276,6 +639,16 @@ void gs_image_file_init_texture(gs_image_file_t *image)
 	}
 }
 
+void gs_image_file_init_texture(gs_image_file_t *image)
+{
+	gs_image_file_init_texture_internal(image, NULL);
+}
+
+void gs_image_file5_init_texture(gs_image_file5_t *if5)
+{
+	gs_image_file_init_texture_internal(&if5->image4.image3.image2.image, if5->gif_stream);
+}
+
 static inline uint64_t get_time(gs_image_file_t *image, int i)
 {
 	uint64_t val = (uint64_t)image->gif.frames[i].frame_delay * 10000000ULL;
@@ -328,11 +701,7 @@ static void decode_new_frame(gs_image_file_t *image, int new_frame, enum gs_imag
 			size_t pos = new_frame * area * 4;
 			image->animation_frame_cache[new_frame] = image->animation_frame_data + pos;
 
-			if (alpha_mode == GS_IMAGE_ALPHA_PREMULTIPLY_SRGB) {
-				gs_premultiply_xyza_srgb_loop(image->gif.frame_image, area);
-			} else if (alpha_mode == GS_IMAGE_ALPHA_PREMULTIPLY) {
-				gs_premultiply_xyza_loop(image->gif.frame_image, area);
-			}
+			premultiply_frame(image->gif.frame_image, area, alpha_mode);
 
 			memcpy(image->animation_frame_cache[new_frame], image->gif.frame_image, area * 4);
 
@@ -344,7 +713,7 @@ static void decode_new_frame(gs_image_file_t *image, int new_frame, enum gs_imag
 }
 
 static bool gs_image_file_tick_internal(gs_image_file_t *image, uint64_t elapsed_time_ns,
-					enum gs_image_alpha_mode alpha_mode)
+					enum gs_image_alpha_mode alpha_mode, struct gs_gif_stream *stream)
 {
 	int loops;
 
@@ -355,6 +724,20 @@ static bool gs_image_file_tick_internal(gs_image_file_t *image, uint64_t elapsed
 	if (loops >= 0xFFFF)
 		loops = 0;
 
+	/* the frame only changes on screen once the decoder has it, but the
+	 * animation keeps its pace */
+	if (stream) {
+		if (!loops || image->cur_loop < loops)
+			image->cur_frame = calculate_new_frame(image, elapsed_time_ns, loops);
+		if (image->cur_frame == stream->shown_frame)
+			return false;
+		if (gif_stream_get_frame(stream, image->cur_frame))
+			return true;
+
+		stream->late_ticks++;
+		return false;
+	}
+
 	if (!loops || image->cur_loop < loops) {
 		int new_frame = calculate_new_frame(image, elapsed_time_ns, loops);
 
@@ -369,29 +752,45 @@ static bool gs_image_file_tick_internal(gs_image_file_t *image, uint64_t elapsed
 
 bool gs_image_file_tick(gs_image_file_t *image, uint64_t elapsed_time_ns)
 {
-	return gs_image_file_tick_internal(image, elapsed_time_ns, false);
+	return gs_image_file_tick_internal(image, elapsed_time_ns, false, NULL);
 }
 
 bool gs_image_file2_tick(gs_image_file2_t *if2, uint64_t elapsed_time_ns)
 {
-	return gs_image_file_tick_internal(&if2->image, elapsed_time_ns, false);
+	return gs_image_file_tick_internal(&if2->image, elapsed_time_ns, false, NULL);
 }
 
 bool gs_image_file3_tick(gs_image_file3_t *if3, uint64_t elapsed_time_ns)
 {
-	return gs_image_file_tick_internal(&if3->image2.image, elapsed_time_ns, if3->alpha_mode);
+	return gs_image_file_tick_internal(&if3->image2.image, elapsed_time_ns, if3->alpha_mode, NULL);
 }
 
 bool gs_image_file4_tick(gs_image_file4_t *if4, uint64_t elapsed_time_ns)
 {
-	return gs_image_file_tick_internal(&if4->image3.image2.image, elapsed_time_ns, if4->image3.alpha_mode);
+	return gs_image_file_tick_internal(&if4->image3.image2.image, elapsed_time_ns, if4->image3.alpha_mode, NULL);
 }
 
-static void gs_image_file_update_texture_internal(gs_image_file_t *image, enum gs_image_alpha_mode alpha_mode)
+bool gs_image_file5_tick(gs_image_file5_t *if5, uint64_t elapsed_time_ns)
+{
+	gs_image_file3_t *if3 = &if5->image4.image3;
+	return gs_image_file_tick_internal(&if3->image2.image, elapsed_time_ns, if3->alpha_mode, if5->gif_stream);
+}
+
+static void gs_image_file_update_texture_internal(gs_image_file_t *image, enum gs_image_alpha_mode alpha_mode,
+						  struct gs_gif_stream *stream)
 {
 	if (!image->is_animated_gif || !image->loaded)
 		return;
 
+	if (stream) {
+		uint8_t *data = gif_stream_get_frame(stream, image->cur_frame);
+		if (data) {
+			gs_texture_set_image(image->texture, data, image->gif.width * 4, false);
+			stream->shown_frame = image->cur_frame;
+		}
+		return;
+	}
+
 	if (!image->animation_frame_cache[image->cur_frame])
 		decode_new_frame(image, image->cur_frame, alpha_mode);
 
@@ -401,20 +800,26 @@ static void gs_image_file_update_texture_internal(gs_image_file_t *image, enum g
 
 void gs_image_file_update_texture(gs_image_file_t *image)
 {
-	gs_image_file_update_texture_internal(image, false);
+	gs_image_file_update_texture_internal(image, false, NULL);
 }
 
 void gs_image_file2_update_texture(gs_image_file2_t *if2)
 {
-	gs_image_file_update_texture_internal(&if2->image, false);
+	gs_image_file_update_texture_internal(&if2->image, false, NULL);
 }
 
 void gs_image_file3_update_texture(gs_image_file3_t *if3)
 {
-	gs_image_file_update_texture_internal(&if3->image2.image, if3->alpha_mode);
+	gs_image_file_update_texture_internal(&if3->image2.image, if3->alpha_mode, NULL);
 }
 
 void gs_image_file4_update_texture(gs_image_file4_t *if4)
 {
-	gs_image_file_update_texture_internal(&if4->image3.image2.image, if4->image3.alpha_mode);
+	gs_image_file_update_texture_internal(&if4->image3.image2.image, if4->image3.alpha_mode, NULL);
+}
+
+void gs_image_file5_update_texture(gs_image_file5_t *if5)
+{
+	gs_image_file3_t *if3 = &if5->image4.image3;
+	gs_image_file_update_texture_internal(&if3->image2.image, if3->alpha_mode, if5->gif_stream);
 }
@@ -61,10 +61,18 @@ struct gs_image_file4 {
 	enum gs_color_space space;
 };
 
+struct gs_gif_stream;
+
+struct gs_image_file5 {
+	struct gs_image_file4 image4;
+	struct gs_gif_stream *gif_stream;
+};
+
 typedef struct gs_image_file gs_image_file_t;
 typedef struct gs_image_file2 gs_image_file2_t;
 typedef struct gs_image_file3 gs_image_file3_t;
 typedef struct gs_image_file4 gs_image_file4_t;
+typedef struct gs_image_file5 gs_image_file5_t;
 
 EXPORT void gs_image_file_init(gs_image_file_t *image, const char *file);
 EXPORT void gs_image_file_free(gs_image_file_t *image);
@@ -88,6 +96,19 @@ EXPORT void gs_image_file4_init(gs_image_file4_t *if4, const char *file, enum gs
 EXPORT bool gs_image_file4_tick(gs_image_file4_t *if4, uint64_t elapsed_time_ns);
 EXPORT void gs_image_file4_update_texture(gs_image_file4_t *if4);
 
+/* Animated GIFs that would need more than gif_memory_budget bytes to keep
+ * every frame decoded are decoded ahead on a worker thread into a sliding
+ * window of frames instead.  With gif_compress_frames, decoded frames are also
+ * kept run-length encoded as long as they fit in the budget, so later loops
+ * don't have to decode them again.  A budget of 0 keeps every frame decoded. */
+EXPORT void gs_image_file5_init(gs_image_file5_t *if5, const char *file, enum gs_image_alpha_mode alpha_mode,
+				uint64_t gif_memory_budget, bool gif_compress_frames);
+EXPORT void gs_image_file5_free(gs_image_file5_t *if5);
+
+EXPORT void gs_image_file5_init_texture(gs_image_file5_t *if5);
+EXPORT bool gs_image_file5_tick(gs_image_file5_t *if5, uint64_t elapsed_time_ns);
+EXPORT void gs_image_file5_update_texture(gs_image_file5_t *if5);
+
 static inline void gs_image_file2_free(gs_image_file2_t *if2)
 {
 	gs_image_file_free(&if2->image);
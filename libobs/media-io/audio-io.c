@@ -43,16 +43,69 @@ extern profiler_name_store_t *obs_get_profiler_name_store(void);
 		int invalid = 0; \
 	} while (0)
 
+/* number of mix blocks a threaded input may fall behind before blocks are
+ * dropped, roughly 340 ms at 48 kHz */
+#define AUDIO_INPUT_QUEUE_BLOCKS 16
+
+struct audio_block {
+	float *data[MAX_AUDIO_CHANNELS];
+	uint32_t frames;
+	uint64_t timestamp;
+
+	/* span of blocks dropped right before this one, delivered to the
+	 * input as silence so its timestamps stay continuous */
+	uint64_t silence_frames;
+	uint64_t silence_timestamp;
+};
+
+/* Threaded inputs receive a copy of each mix block through a single
+ * producer/single consumer ring and run their resampler and callback on their
+ * own thread, so a slow consumer cannot hold up the audio thread or any of
+ * the other inputs. */
+struct audio_input_worker {
+	pthread_t thread;
+	os_sem_t *sem;
+	volatile bool stop;
+	bool detached;
+
+	size_t mix_idx;
+	size_t planes;
+	size_t sample_rate;
+	audio_resampler_t *resampler;
+	audio_output_callback_t callback;
+	void *param;
+
+	float *buffer;
+	float *silence;
+	struct audio_block blocks[AUDIO_INPUT_QUEUE_BLOCKS];
+	size_t write_pos;
+	size_t read_pos;
+	volatile long queued;
+	volatile long max_queued;
+
+	/* only touched by the audio thread and read by the stats function,
+	 * both with the output's input_mutex held */
+	uint64_t total_blocks;
+	uint64_t gap_frames;
+	uint64_t gap_timestamp;
+	volatile long dropped;
+};
+
 struct audio_input {
 	struct audio_convert_info conversion;
 	audio_resampler_t *resampler;
+	struct audio_input_worker *worker;
 
 	audio_output_callback_t callback;
 	void *param;
 };
 
+static void audio_input_worker_stop(struct audio_input_worker *worker);
+
 static inline void audio_input_free(struct audio_input *input)
 {
+	if (input->worker)
+		audio_input_worker_stop(input->worker);
 	audio_resampler_destroy(input->resampler);
 }
 
@@ -81,18 +134,18 @@ struct audio_output {
 
 /* ------------------------------------------------------------------------- */
 
-static bool resample_audio_output(struct audio_input *input, struct audio_data *data)
+static bool resample_audio_output_ex(audio_resampler_t *resampler, struct audio_data *data)
 {
 	bool success = true;
 
-	if (input->resampler) {
+	if (resampler) {
 		uint8_t *output[MAX_AV_PLANES];
 		uint32_t frames;
 		uint64_t offset;
 
 		memset(output, 0, sizeof(output));
 
-		success = audio_resampler_resample(input->resampler, output, &frames, &offset,
+		success = audio_resampler_resample(resampler, output, &frames, &offset,
 						   (const uint8_t *const *)data->data, data->frames);
 
 		for (size_t i = 0; i < MAX_AV_PLANES; i++)
@@ -104,6 +157,205 @@ static bool resample_audio_output(struct audio_input *input, struct audio_data *
 	return success;
 }
 
+static inline bool resample_audio_output(struct audio_input *input, struct audio_data *data)
+{
+	return resample_audio_output_ex(input->resampler, data);
+}
+
+static void audio_input_worker_destroy(struct audio_input_worker *worker)
+{
+	os_sem_destroy(worker->sem);
+	audio_resampler_destroy(worker->resampler);
+	bfree(worker->silence);
+	bfree(worker->buffer);
+	bfree(worker);
+}
+
+static void audio_input_worker_output_silence(struct audio_input_worker *worker, const struct audio_block *block)
+{
+	uint64_t offset = 0;
+
+	while (offset < block->silence_frames) {
+		struct audio_data data = {0};
+		uint64_t frames = block->silence_frames - offset;
+
+		if (frames > AUDIO_OUTPUT_FRAMES)
+			frames = AUDIO_OUTPUT_FRAMES;
+
+		for (size_t i = 0; i < worker->planes; i++)
+			data.data[i] = (uint8_t *)worker->silence;
+		data.frames = (uint32_t)frames;
+		data.timestamp = block->silence_timestamp + audio_frames_to_ns(worker->sample_rate, offset);
+
+		if (resample_audio_output_ex(worker->resampler, &data))
+			worker->callback(worker->param, worker->mix_idx, &data);
+
+		offset += frames;
+	}
+}
+
+static void audio_input_worker_output(struct audio_input_worker *worker)
+{
+	struct audio_block *block = &worker->blocks[worker->read_pos];
+	struct audio_data data = {0};
+
+	if (block->silence_frames)
+		audio_input_worker_output_silence(worker, block);
+
+	for (size_t i = 0; i < worker->planes; i++)
+		data.data[i] = (uint8_t *)block->data[i];
+	data.frames = block->frames;
+	data.timestamp = block->timestamp;
+
+	/* with the resampler the data is copied again, so the slot can be
+	 * handed back to the audio thread before the callback runs */
+	if (worker->resampler) {
+		bool success = resample_audio_output_ex(worker->resampler, &data);
+		worker->read_pos = (worker->read_pos + 1) % AUDIO_INPUT_QUEUE_BLOCKS;
+		os_atomic_dec_long(&worker->queued);
+
+		if (success)
+			worker->callback(worker->param, worker->mix_idx, &data);
+	} else {
+		worker->callback(worker->param, worker->mix_idx, &data);
+
+		worker->read_pos = (worker->read_pos + 1) % AUDIO_INPUT_QUEUE_BLOCKS;
+		os_atomic_dec_long(&worker->queued);
+	}
+}
+
+static void *audio_input_thread(void *param)
+{
+	struct audio_input_worker *worker = param;
+
+	os_set_thread_name("audio-io: input thread");
+
+	/* every queued block posts the semaphore once, and stopping posts it
+	 * one last time, so blocks queued before the input was disconnected
+	 * are still delivered */
+	while (os_sem_wait(worker->sem) == 0) {
+		if (!os_atomic_load_long(&worker->queued)) {
+			if (os_atomic_load_bool(&worker->stop))
+				break;
+			continue;
+		}
+
+		audio_input_worker_output(worker);
+
+		/* the callback disconnected its own input */
+		if (worker->detached)
+			break;
+	}
+
+	if (worker->detached)
+		audio_input_worker_destroy(worker);
+	return NULL;
+}
+
+static struct audio_input_worker *audio_input_worker_create(struct audio_output *audio, struct audio_input *input,
+							    size_t mix_idx)
+{
+	struct audio_input_worker *worker = bzalloc(sizeof(struct audio_input_worker));
+	size_t block_floats = audio->planes * AUDIO_OUTPUT_FRAMES;
+
+	worker->mix_idx = mix_idx;
+	worker->planes = audio->planes;
+	worker->sample_rate = audio->info.samples_per_sec;
+	worker->callback = input->callback;
+	worker->param = input->param;
+	worker->buffer = bmalloc(AUDIO_INPUT_QUEUE_BLOCKS * block_floats * sizeof(float));
+	worker->silence = bzalloc(AUDIO_OUTPUT_FRAMES * audio->block_size);
+
+	for (size_t i = 0; i < AUDIO_INPUT_QUEUE_BLOCKS; i++) {
+		for (size_t j = 0; j < audio->planes; j++)
+			worker->blocks[i].data[j] = worker->buffer + i * block_floats + j * AUDIO_OUTPUT_FRAMES;
+	}
+
+	if (os_sem_init(&worker->sem, 0) != 0)
+		goto fail;
+	if (pthread_create(&worker->thread, NULL, audio_input_thread, worker) != 0)
+		goto fail;
+
+	/* the resampler now belongs to the input thread */
+	worker->resampler = input->resampler;
+	input->resampler = NULL;
+	return worker;
+
+fail:
+	os_sem_destroy(worker->sem);
+	bfree(worker->silence);
+	bfree(worker->buffer);
+	bfree(worker);
+	return NULL;
+}
+
+static void audio_input_worker_stop(struct audio_input_worker *worker)
+{
+	os_atomic_set_bool(&worker->stop, true);
+
+	/* an input callback can end up disconnecting itself (e.g. an encoder
+	 * stopping after an encode error), in which case the thread cannot be
+	 * joined and cleans up after itself instead */
+	if (pthread_equal(pthread_self(), worker->thread)) {
+		worker->detached = true;
+		pthread_detach(worker->thread);
+		return;
+	}
+
+	os_sem_post(worker->sem);
+	pthread_join(worker->thread, NULL);
+
+	/* the input has already been removed from its mix, so the audio
+	 * thread no longer touches total_blocks */
+	long dropped = os_atomic_load_long(&worker->dropped);
+	if (dropped)
+		blog(LOG_INFO,
+		     "audio_input_worker_stop: %ld of %" PRIu64 " audio blocks replaced with silence on mix %zu",
+		     dropped, worker->total_blocks, worker->mix_idx);
+
+	audio_input_worker_destroy(worker);
+}
+
+static void audio_input_worker_queue(struct audio_input_worker *worker, float (*buf)[AUDIO_OUTPUT_FRAMES],
+				     uint64_t timestamp, uint32_t frames)
+{
+	long queued = os_atomic_load_long(&worker->queued);
+
+	worker->total_blocks++;
+
+	/* the audio of a dropped block is lost, but its span is remembered
+	 * and handed to the input as silence ahead of the next block that
+	 * fits, so the input never sees a hole in its timestamps */
+	if (queued == AUDIO_INPUT_QUEUE_BLOCKS) {
+		if (!worker->gap_frames)
+			worker->gap_timestamp = timestamp;
+		worker->gap_frames += frames;
+
+		if (os_atomic_inc_long(&worker->dropped) == 1)
+			blog(LOG_WARNING,
+			     "audio_input_worker_queue: Input on mix %zu "
+			     "is falling behind, replacing audio with silence",
+			     worker->mix_idx);
+		return;
+	}
+
+	struct audio_block *block = &worker->blocks[worker->write_pos];
+	for (size_t i = 0; i < worker->planes; i++)
+		memcpy(block->data[i], buf[i], frames * sizeof(float));
+	block->frames = frames;
+	block->timestamp = timestamp;
+	block->silence_frames = worker->gap_frames;
+	block->silence_timestamp = worker->gap_timestamp;
+	worker->gap_frames = 0;
+
+	worker->write_pos = (worker->write_pos + 1) % AUDIO_INPUT_QUEUE_BLOCKS;
+	queued = os_atomic_inc_long(&worker->queued);
+	if (queued > os_atomic_load_long(&worker->max_queued))
+		os_atomic_set_long(&worker->max_queued, queued);
+
+	os_sem_post(worker->sem);
+}
+
 static inline void do_audio_output(struct audio_output *audio, size_t mix_idx, uint64_t timestamp, uint32_t frames)
 {
 	struct audio_mix *mix = &audio->mixes[mix_idx];
@@ -116,6 +368,12 @@ static inline void do_audio_output(struct audio_output *audio, size_t mix_idx, u
 
 		float(*buf)[AUDIO_OUTPUT_FRAMES] = input->conversion.allow_clipping ? mix->buffer_unclamped
 										    : mix->buffer;
+
+		if (input->worker) {
+			audio_input_worker_queue(input->worker, buf, timestamp, frames);
+			continue;
+		}
+
 		for (size_t i = 0; i < audio->planes; i++)
 			data.data[i] = (uint8_t *)buf[i];
 
@@ -129,7 +387,7 @@ static inline void do_audio_output(struct audio_output *audio, size_t mix_idx, u
 	pthread_mutex_unlock(&audio->input_mutex);
 }
 
-static inline void clamp_audio_output(struct audio_output *audio, size_t bytes)
+static inline void clamp_audio_output(struct audio_output *audio, uint32_t active_mixes, size_t bytes)
 {
 	size_t float_size = bytes / sizeof(float);
 
@@ -137,7 +395,7 @@ static inline void clamp_audio_output(struct audio_output *audio, size_t bytes)
 		struct audio_mix *mix = &audio->mixes[mix_idx];
 
 		/* do not process mixing if a specific mix is inactive */
-		if (!mix->inputs.num)
+		if ((active_mixes & (1 << mix_idx)) == 0)
 			continue;
 
 		for (size_t plane = 0; plane < audio->planes; plane++) {
@@ -179,11 +437,13 @@ static void input_and_output(struct audio_output *audio, uint64_t audio_time, ui
 	}
 	pthread_mutex_unlock(&audio->input_mutex);
 
-	/* clear mix buffers */
+	/* clear mix buffers, inactive mixes are neither mixed into nor
+	 * output below */
 	for (size_t mix_idx = 0; mix_idx < MAX_AUDIO_MIXES; mix_idx++) {
 		struct audio_mix *mix = &audio->mixes[mix_idx];
 
-		memset(mix->buffer, 0, sizeof(mix->buffer));
+		if ((active_mixes & (1 << mix_idx)) != 0)
+			memset(mix->buffer, 0, sizeof(mix->buffer));
 
 		for (size_t i = 0; i < audio->planes; i++)
 			data[mix_idx].data[i] = mix->buffer[i];
@@ -195,11 +455,15 @@ static void input_and_output(struct audio_output *audio, uint64_t audio_time, ui
 		return;
 
 	/* clamps audio data to -1.0..1.0 */
-	clamp_audio_output(audio, bytes);
+	clamp_audio_output(audio, active_mixes, bytes);
 
 	/* output */
-	for (size_t i = 0; i < MAX_AUDIO_MIXES; i++)
-		do_audio_output(audio, i, new_ts, AUDIO_OUTPUT_FRAMES);
+	for (size_t i = 0; i < MAX_AUDIO_MIXES; i++) {
+		/* a mix that gained its first input during this tick was
+		 * not cleared, it starts outputting on the next one */
+		if ((active_mixes & (1 << i)) != 0)
+			do_audio_output(audio, i, new_ts, AUDIO_OUTPUT_FRAMES);
+	}
 }
 
 static void *audio_thread(void *param)
@@ -286,8 +550,8 @@ static inline bool audio_input_init(struct audio_input *input, struct audio_outp
 	return true;
 }
 
-bool audio_output_connect(audio_t *audio, size_t mi, const struct audio_convert_info *conversion,
-			  audio_output_callback_t callback, void *param)
+static bool audio_output_connect_internal(audio_t *audio, size_t mi, const struct audio_convert_info *conversion,
+					  audio_output_callback_t callback, void *param, bool threaded)
 {
 	bool success = false;
 
@@ -319,6 +583,15 @@ bool audio_output_connect(audio_t *audio, size_t mi, const struct audio_convert_
 			input.conversion.samples_per_sec = audio->info.samples_per_sec;
 
 		success = audio_input_init(&input, audio);
+		if (success && threaded) {
+			input.worker = audio_input_worker_create(audio, &input, mi);
+			if (!input.worker) {
+				blog(LOG_ERROR, "audio_output_connect: Failed to "
+						"create input thread");
+				audio_input_free(&input);
+				success = false;
+			}
+		}
 		if (success)
 			da_push_back(mix->inputs, &input);
 	}
@@ -328,21 +601,72 @@ bool audio_output_connect(audio_t *audio, size_t mi, const struct audio_convert_
 	return success;
 }
 
+bool audio_output_connect(audio_t *audio, size_t mi, const struct audio_convert_info *conversion,
+			  audio_output_callback_t callback, void *param)
+{
+	return audio_output_connect_internal(audio, mi, conversion, callback, param, false);
+}
+
+bool audio_output_connect_threaded(audio_t *audio, size_t mi, const struct audio_convert_info *conversion,
+				   audio_output_callback_t callback, void *param)
+{
+	return audio_output_connect_internal(audio, mi, conversion, callback, param, true);
+}
+
+bool audio_output_get_input_stats(audio_t *audio, size_t mix_idx, audio_output_callback_t callback, void *param,
+				  struct audio_input_stats *stats)
+{
+	bool found = false;
+
+	if (!audio || !stats || mix_idx >= MAX_AUDIO_MIXES)
+		return false;
+
+	pthread_mutex_lock(&audio->input_mutex);
+
+	size_t idx = audio_get_input_idx(audio, mix_idx, callback, param);
+	if (idx != DARRAY_INVALID) {
+		struct audio_input_worker *worker = audio->mixes[mix_idx].inputs.array[idx].worker;
+
+		memset(stats, 0, sizeof(*stats));
+		if (worker) {
+			stats->queued = (uint32_t)os_atomic_load_long(&worker->queued);
+			stats->max_queued = (uint32_t)os_atomic_load_long(&worker->max_queued);
+			stats->capacity = AUDIO_INPUT_QUEUE_BLOCKS;
+			stats->blocks = worker->total_blocks;
+			stats->dropped = (uint64_t)os_atomic_load_long(&worker->dropped);
+		}
+		found = true;
+	}
+
+	pthread_mutex_unlock(&audio->input_mutex);
+
+	return found;
+}
+
 void audio_output_disconnect(audio_t *audio, size_t mix_idx, audio_output_callback_t callback, void *param)
 {
 	if (!audio || mix_idx >= MAX_AUDIO_MIXES)
 		return;
 
+	struct audio_input input;
+	bool found = false;
+
 	pthread_mutex_lock(&audio->input_mutex);
 
 	size_t idx = audio_get_input_idx(audio, mix_idx, callback, param);
 	if (idx != DARRAY_INVALID) {
 		struct audio_mix *mix = &audio->mixes[mix_idx];
-		audio_input_free(mix->inputs.array + idx);
+		input = mix->inputs.array[idx];
 		da_erase(mix->inputs, idx);
+		found = true;
 	}
 
 	pthread_mutex_unlock(&audio->input_mutex);
+
+	/* freed outside of the lock, stopping a threaded input waits for its
+	 * callback, which may itself need to take the lock */
+	if (found)
+		audio_input_free(&input);
 }
 
 static inline bool valid_audio_params(const struct audio_output_info *info)
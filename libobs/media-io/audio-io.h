@@ -215,6 +215,29 @@ EXPORT bool audio_output_connect(audio_t *video, size_t mix_idx, const struct au
 				 audio_output_callback_t callback, void *param);
 EXPORT void audio_output_disconnect(audio_t *video, size_t mix_idx, audio_output_callback_t callback, void *param);
 
+/**
+ * Same as audio_output_connect, but the callback (and any resampling) runs on
+ * a dedicated thread for this input instead of the audio thread.  The input is
+ * handed a queue of mix blocks; if it falls too far behind, further blocks are
+ * replaced with silence rather than stalling the mix for everyone else.
+ */
+EXPORT bool audio_output_connect_threaded(audio_t *audio, size_t mix_idx, const struct audio_convert_info *conversion,
+					  audio_output_callback_t callback, void *param);
+
+struct audio_input_stats {
+	uint32_t queued;
+	uint32_t max_queued;
+	uint32_t capacity;
+
+	uint64_t blocks;
+	uint64_t dropped;
+};
+
+/** Returns queue statistics of a connected input, all zero for inputs that
+ * are not threaded */
+EXPORT bool audio_output_get_input_stats(audio_t *audio, size_t mix_idx, audio_output_callback_t callback, void *param,
+					 struct audio_input_stats *stats);
+
 EXPORT bool audio_output_active(const audio_t *audio);
 
 EXPORT size_t audio_output_get_block_size(const audio_t *audio);
@@ -0,0 +1,182 @@
+/******************************************************************************
+    Copyright (C) 2026 by agent <agent@local>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "format-conversion-internal.h"
+
+#ifdef FORMAT_CONVERSION_X86_64
+
+#include <immintrin.h>
+
+/* Gathers byte 1 (luma) of each packed pixel into the low dword of each lane */
+#define LUM_SHUFFLE                                                                                             \
+	_mm256_setr_epi8(1, 5, 9, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 5, 9, 13, -1, -1, -1, \
+			 -1, -1, -1, -1, -1, -1, -1, -1, -1)
+
+FC_TARGET_AVX2 static inline __m128i lum_8(__m256i line)
+{
+	__m256i val = _mm256_shuffle_epi8(line, LUM_SHUFFLE);
+	val = _mm256_permutevar8x32_epi32(val, _mm256_setr_epi32(0, 4, 0, 0, 0, 0, 0, 0));
+	return _mm256_castsi256_si128(val);
+}
+
+/* Returns the 2x2 averaged chroma of 8 pixels as U0 V0 U1 V1 ... U3 V3 */
+FC_TARGET_AVX2 static inline __m128i chroma_8(__m256i line1, __m256i line2)
+{
+	__m256i uv_mask = _mm256_set1_epi16(0x00FF);
+	__m256i sum = _mm256_add_epi16(_mm256_and_si256(line1, uv_mask), _mm256_and_si256(line2, uv_mask));
+	__m128i avg;
+
+	sum = _mm256_add_epi16(sum, _mm256_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+	sum = _mm256_srli_epi16(sum, 2);
+	sum = _mm256_permutevar8x32_epi32(sum, _mm256_setr_epi32(0, 2, 4, 6, 0, 0, 0, 0));
+
+	avg = _mm256_castsi256_si128(sum);
+	return _mm_packus_epi16(avg, avg);
+}
+
+FC_TARGET_AVX2 static uint32_t compress_i420_row_avx2(const uint8_t *in0, const uint8_t *in1, uint8_t *lum0,
+						      uint8_t *lum1, uint8_t *u, uint8_t *v, uint32_t width)
+{
+	const __m128i split = _mm_setr_epi8(0, 2, 4, 6, 1, 3, 5, 7, -1, -1, -1, -1, -1, -1, -1, -1);
+	uint32_t x;
+
+	for (x = 0; x + 8 <= width; x += 8) {
+		__m256i line1 = _mm256_loadu_si256((const __m256i *)(in0 + x * 4));
+		__m256i line2 = _mm256_loadu_si256((const __m256i *)(in1 + x * 4));
+		__m128i chroma = _mm_shuffle_epi8(chroma_8(line1, line2), split);
+
+		_mm_storel_epi64((__m128i *)(lum0 + x), lum_8(line1));
+		_mm_storel_epi64((__m128i *)(lum1 + x), lum_8(line2));
+		*(int *)(u + (x >> 1)) = _mm_cvtsi128_si32(chroma);
+		*(int *)(v + (x >> 1)) = _mm_cvtsi128_si32(_mm_srli_si128(chroma, 4));
+	}
+
+	return x;
+}
+
+FC_TARGET_AVX2 static uint32_t compress_nv12_row_avx2(const uint8_t *in0, const uint8_t *in1, uint8_t *lum0,
+						      uint8_t *lum1, uint8_t *uv, uint32_t width)
+{
+	uint32_t x;
+
+	for (x = 0; x + 8 <= width; x += 8) {
+		__m256i line1 = _mm256_loadu_si256((const __m256i *)(in0 + x * 4));
+		__m256i line2 = _mm256_loadu_si256((const __m256i *)(in1 + x * 4));
+
+		_mm_storel_epi64((__m128i *)(lum0 + x), lum_8(line1));
+		_mm_storel_epi64((__m128i *)(lum1 + x), lum_8(line2));
+		_mm_storel_epi64((__m128i *)(uv + x), chroma_8(line1, line2));
+	}
+
+	return x;
+}
+
+FC_TARGET_AVX2 static uint32_t convert_i444_row_avx2(const uint8_t *in, uint8_t *lum, uint8_t *u, uint8_t *v,
+						     uint32_t width)
+{
+	const __m256i shuffle = _mm256_setr_epi8(1, 5, 9, 13, 0, 4, 8, 12, 2, 6, 10, 14, -1, -1, -1, -1, 1, 5, 9,
+						 13, 0, 4, 8, 12, 2, 6, 10, 14, -1, -1, -1, -1);
+	const __m256i gather = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+	uint32_t x;
+
+	for (x = 0; x + 8 <= width; x += 8) {
+		__m256i line = _mm256_loadu_si256((const __m256i *)(in + x * 4));
+		__m256i planes = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(line, shuffle), gather);
+		__m128i yu = _mm256_castsi256_si128(planes);
+
+		_mm_storel_epi64((__m128i *)(lum + x), yu);
+		_mm_storel_epi64((__m128i *)(u + x), _mm_unpackhi_epi64(yu, yu));
+		_mm_storel_epi64((__m128i *)(v + x), _mm256_extracti128_si256(planes, 1));
+	}
+
+	return x;
+}
+
+FC_TARGET_AVX2 static uint32_t decompress_420_row_avx2(const uint8_t *lum, const uint8_t *u, const uint8_t *v,
+						       uint8_t *out, uint32_t width)
+{
+	uint32_t x;
+
+	for (x = 0; x + 16 <= width; x += 16) {
+		__m128i y = _mm_loadu_si128((const __m128i *)(lum + x));
+		__m128i uv = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(v + (x >> 1))),
+					       _mm_loadl_epi64((const __m128i *)(u + (x >> 1))));
+		__m256i out0 = _mm256_cvtepu16_epi32(_mm_unpacklo_epi16(uv, uv));
+		__m256i out1 = _mm256_cvtepu16_epi32(_mm_unpackhi_epi16(uv, uv));
+
+		out0 = _mm256_or_si256(out0, _mm256_slli_epi32(_mm256_cvtepu8_epi32(y), 16));
+		out1 = _mm256_or_si256(out1, _mm256_slli_epi32(_mm256_cvtepu8_epi32(_mm_srli_si128(y, 8)), 16));
+
+		_mm256_storeu_si256((__m256i *)(out + x * 4), out0);
+		_mm256_storeu_si256((__m256i *)(out + x * 4 + 32), out1);
+	}
+
+	return x;
+}
+
+FC_TARGET_AVX2 static uint32_t decompress_nv12_row_avx2(const uint8_t *lum, const uint8_t *uv, uint8_t *out,
+							uint32_t width)
+{
+	uint32_t x;
+
+	for (x = 0; x + 16 <= width; x += 16) {
+		__m128i y = _mm_loadu_si128((const __m128i *)(lum + x));
+		__m128i chroma = _mm_loadu_si128((const __m128i *)(uv + x));
+		__m256i out0 = _mm256_cvtepu16_epi32(_mm_unpacklo_epi16(chroma, chroma));
+		__m256i out1 = _mm256_cvtepu16_epi32(_mm_unpackhi_epi16(chroma, chroma));
+
+		out0 = _mm256_or_si256(_mm256_slli_epi32(out0, 8), _mm256_cvtepu8_epi32(y));
+		out1 = _mm256_or_si256(_mm256_slli_epi32(out1, 8), _mm256_cvtepu8_epi32(_mm_srli_si128(y, 8)));
+
+		_mm256_storeu_si256((__m256i *)(out + x * 4), out0);
+		_mm256_storeu_si256((__m256i *)(out + x * 4 + 32), out1);
+	}
+
+	return x;
+}
+
+FC_TARGET_AVX2 static uint32_t decompress_422_row_avx2(const uint8_t *in, uint8_t *out, uint32_t pairs,
+						       bool leading_lum)
+{
+	const __m256i keep_mask = _mm256_set1_epi32(leading_lum ? 0xFFFFFF00 : 0xFFFF00FF);
+	const __m256i lum_mask = _mm256_set1_epi32(leading_lum ? 0x000000FF : 0x0000FF00);
+	uint32_t i;
+
+	for (i = 0; i + 8 <= pairs; i += 8) {
+		__m256i dw = _mm256_loadu_si256((const __m256i *)(in + i * 4));
+		__m256i dw2 = _mm256_or_si256(_mm256_and_si256(dw, keep_mask),
+					      _mm256_and_si256(_mm256_srli_epi32(dw, 16), lum_mask));
+		__m256i lo = _mm256_unpacklo_epi32(dw, dw2);
+		__m256i hi = _mm256_unpackhi_epi32(dw, dw2);
+
+		_mm256_storeu_si256((__m256i *)(out + i * 8), _mm256_permute2x128_si256(lo, hi, 0x20));
+		_mm256_storeu_si256((__m256i *)(out + i * 8 + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+	}
+
+	return i;
+}
+
+const struct format_conversion_kernels format_conversion_avx2 = {
+	.compress_i420 = compress_i420_row_avx2,
+	.compress_nv12 = compress_nv12_row_avx2,
+	.convert_i444 = convert_i444_row_avx2,
+	.decompress_420 = decompress_420_row_avx2,
+	.decompress_nv12 = decompress_nv12_row_avx2,
+	.decompress_422 = decompress_422_row_avx2,
+};
+
+#endif
@@ -0,0 +1,196 @@
+/******************************************************************************
+    Copyright (C) 2026 by agent <agent@local>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "format-conversion-internal.h"
+
+#ifdef FORMAT_CONVERSION_X86_64
+
+#include <immintrin.h>
+
+/* Gathers byte 1 (luma) of each packed pixel into the low dword of each lane */
+#define LUM_SHUFFLE                                                                                           \
+	_mm512_broadcast_i32x4(_mm_setr_epi8(1, 5, 9, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1))
+
+FC_TARGET_AVX512 static inline __m128i lum_16(__m512i line)
+{
+	__m512i val = _mm512_shuffle_epi8(line, LUM_SHUFFLE);
+	val = _mm512_permutexvar_epi32(_mm512_setr_epi32(0, 4, 8, 12, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0), val);
+	return _mm512_castsi512_si128(val);
+}
+
+/* Returns the 2x2 averaged chroma of 16 pixels, U0 V0 U1 V1 ... U3 V3 in the
+ * low qword of each lane */
+FC_TARGET_AVX512 static inline __m256i chroma_16(__m512i line1, __m512i line2)
+{
+	__m512i uv_mask = _mm512_set1_epi16(0x00FF);
+	__m512i sum = _mm512_add_epi16(_mm512_and_si512(line1, uv_mask), _mm512_and_si512(line2, uv_mask));
+	__m256i avg;
+
+	sum = _mm512_add_epi16(sum, _mm512_shuffle_epi32(sum, _MM_PERM_CDAB));
+	sum = _mm512_srli_epi16(sum, 2);
+	sum = _mm512_permutexvar_epi32(_mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 0, 0, 0, 0, 0, 0, 0, 0), sum);
+
+	avg = _mm512_castsi512_si256(sum);
+	return _mm256_packus_epi16(avg, avg);
+}
+
+FC_TARGET_AVX512 static uint32_t compress_i420_row_avx512(const uint8_t *in0, const uint8_t *in1, uint8_t *lum0,
+							  uint8_t *lum1, uint8_t *u, uint8_t *v, uint32_t width)
+{
+	const __m256i split = _mm256_setr_epi8(0, 2, 4, 6, 1, 3, 5, 7, -1, -1, -1, -1, -1, -1, -1, -1, 0, 2, 4, 6, 1,
+					       3, 5, 7, -1, -1, -1, -1, -1, -1, -1, -1);
+	const __m256i gather = _mm256_setr_epi32(0, 4, 1, 5, 0, 0, 0, 0);
+	uint32_t x;
+
+	for (x = 0; x + 16 <= width; x += 16) {
+		__m512i line1 = _mm512_loadu_si512((const void *)(in0 + x * 4));
+		__m512i line2 = _mm512_loadu_si512((const void *)(in1 + x * 4));
+		__m256i chroma = _mm256_shuffle_epi8(chroma_16(line1, line2), split);
+		__m128i uv = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(chroma, gather));
+
+		_mm_storeu_si128((__m128i *)(lum0 + x), lum_16(line1));
+		_mm_storeu_si128((__m128i *)(lum1 + x), lum_16(line2));
+		_mm_storel_epi64((__m128i *)(u + (x >> 1)), uv);
+		_mm_storel_epi64((__m128i *)(v + (x >> 1)), _mm_unpackhi_epi64(uv, uv));
+	}
+
+	return x;
+}
+
+FC_TARGET_AVX512 static uint32_t compress_nv12_row_avx512(const uint8_t *in0, const uint8_t *in1, uint8_t *lum0,
+							  uint8_t *lum1, uint8_t *uv, uint32_t width)
+{
+	uint32_t x;
+
+	for (x = 0; x + 16 <= width; x += 16) {
+		__m512i line1 = _mm512_loadu_si512((const void *)(in0 + x * 4));
+		__m512i line2 = _mm512_loadu_si512((const void *)(in1 + x * 4));
+		__m256i chroma = _mm256_permute4x64_epi64(chroma_16(line1, line2), _MM_SHUFFLE(3, 1, 2, 0));
+
+		_mm_storeu_si128((__m128i *)(lum0 + x), lum_16(line1));
+		_mm_storeu_si128((__m128i *)(lum1 + x), lum_16(line2));
+		_mm_storeu_si128((__m128i *)(uv + x), _mm256_castsi256_si128(chroma));
+	}
+
+	return x;
+}
+
+FC_TARGET_AVX512 static uint32_t convert_i444_row_avx512(const uint8_t *in, uint8_t *lum, uint8_t *u, uint8_t *v,
+							 uint32_t width)
+{
+	const __m512i shuffle =
+		_mm512_broadcast_i32x4(_mm_setr_epi8(1, 5, 9, 13, 0, 4, 8, 12, 2, 6, 10, 14, -1, -1, -1, -1));
+	const __m512i gather = _mm512_setr_epi32(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+	uint32_t x;
+
+	for (x = 0; x + 16 <= width; x += 16) {
+		__m512i line = _mm512_loadu_si512((const void *)(in + x * 4));
+		__m512i planes = _mm512_permutexvar_epi32(gather, _mm512_shuffle_epi8(line, shuffle));
+
+		_mm_storeu_si128((__m128i *)(lum + x), _mm512_castsi512_si128(planes));
+		_mm_storeu_si128((__m128i *)(u + x), _mm512_extracti32x4_epi32(planes, 1));
+		_mm_storeu_si128((__m128i *)(v + x), _mm512_extracti32x4_epi32(planes, 2));
+	}
+
+	return x;
+}
+
+FC_TARGET_AVX512 static uint32_t decompress_420_row_avx512(const uint8_t *lum, const uint8_t *u, const uint8_t *v,
+							   uint8_t *out, uint32_t width)
+{
+	uint32_t x;
+
+	for (x = 0; x + 32 <= width; x += 32) {
+		__m256i y = _mm256_loadu_si256((const __m256i *)(lum + x));
+		__m128i u16 = _mm_loadu_si128((const __m128i *)(u + (x >> 1)));
+		__m128i v16 = _mm_loadu_si128((const __m128i *)(v + (x >> 1)));
+		__m128i uv_lo = _mm_unpacklo_epi8(v16, u16);
+		__m128i uv_hi = _mm_unpackhi_epi8(v16, u16);
+		__m256i dup0 = _mm256_set_m128i(_mm_unpackhi_epi16(uv_lo, uv_lo), _mm_unpacklo_epi16(uv_lo, uv_lo));
+		__m256i dup1 = _mm256_set_m128i(_mm_unpackhi_epi16(uv_hi, uv_hi), _mm_unpacklo_epi16(uv_hi, uv_hi));
+		__m512i out0 = _mm512_cvtepu16_epi32(dup0);
+		__m512i out1 = _mm512_cvtepu16_epi32(dup1);
+
+		out0 = _mm512_or_si512(out0, _mm512_slli_epi32(_mm512_cvtepu8_epi32(_mm256_castsi256_si128(y)), 16));
+		out1 = _mm512_or_si512(out1,
+				       _mm512_slli_epi32(_mm512_cvtepu8_epi32(_mm256_extracti128_si256(y, 1)), 16));
+
+		_mm512_storeu_si512((void *)(out + x * 4), out0);
+		_mm512_storeu_si512((void *)(out + x * 4 + 64), out1);
+	}
+
+	return x;
+}
+
+FC_TARGET_AVX512 static uint32_t decompress_nv12_row_avx512(const uint8_t *lum, const uint8_t *uv, uint8_t *out,
+							    uint32_t width)
+{
+	uint32_t x;
+
+	for (x = 0; x + 32 <= width; x += 32) {
+		__m256i y = _mm256_loadu_si256((const __m256i *)(lum + x));
+		__m256i chroma = _mm256_loadu_si256((const __m256i *)(uv + x));
+		__m128i c0 = _mm256_castsi256_si128(chroma);
+		__m128i c1 = _mm256_extracti128_si256(chroma, 1);
+		__m256i dup0 = _mm256_set_m128i(_mm_unpackhi_epi16(c0, c0), _mm_unpacklo_epi16(c0, c0));
+		__m256i dup1 = _mm256_set_m128i(_mm_unpackhi_epi16(c1, c1), _mm_unpacklo_epi16(c1, c1));
+		__m512i out0 = _mm512_slli_epi32(_mm512_cvtepu16_epi32(dup0), 8);
+		__m512i out1 = _mm512_slli_epi32(_mm512_cvtepu16_epi32(dup1), 8);
+
+		out0 = _mm512_or_si512(out0, _mm512_cvtepu8_epi32(_mm256_castsi256_si128(y)));
+		out1 = _mm512_or_si512(out1, _mm512_cvtepu8_epi32(_mm256_extracti128_si256(y, 1)));
+
+		_mm512_storeu_si512((void *)(out + x * 4), out0);
+		_mm512_storeu_si512((void *)(out + x * 4 + 64), out1);
+	}
+
+	return x;
+}
+
+FC_TARGET_AVX512 static uint32_t decompress_422_row_avx512(const uint8_t *in, uint8_t *out, uint32_t pairs,
+							   bool leading_lum)
+{
+	const __m512i keep_mask = _mm512_set1_epi32(leading_lum ? 0xFFFFFF00 : 0xFFFF00FF);
+	const __m512i lum_mask = _mm512_set1_epi32(leading_lum ? 0x000000FF : 0x0000FF00);
+	const __m512i first = _mm512_setr_epi64(0, 1, 8, 9, 2, 3, 10, 11);
+	const __m512i second = _mm512_setr_epi64(4, 5, 12, 13, 6, 7, 14, 15);
+	uint32_t i;
+
+	for (i = 0; i + 16 <= pairs; i += 16) {
+		__m512i dw = _mm512_loadu_si512((const void *)(in + i * 4));
+		__m512i dw2 = _mm512_or_si512(_mm512_and_si512(dw, keep_mask),
+					      _mm512_and_si512(_mm512_srli_epi32(dw, 16), lum_mask));
+		__m512i lo = _mm512_unpacklo_epi32(dw, dw2);
+		__m512i hi = _mm512_unpackhi_epi32(dw, dw2);
+
+		_mm512_storeu_si512((void *)(out + i * 8), _mm512_permutex2var_epi64(lo, first, hi));
+		_mm512_storeu_si512((void *)(out + i * 8 + 64), _mm512_permutex2var_epi64(lo, second, hi));
+	}
+
+	return i;
+}
+
+const struct format_conversion_kernels format_conversion_avx512 = {
+	.compress_i420 = compress_i420_row_avx512,
+	.compress_nv12 = compress_nv12_row_avx512,
+	.convert_i444 = convert_i444_row_avx512,
+	.decompress_420 = decompress_420_row_avx512,
+	.decompress_nv12 = decompress_nv12_row_avx512,
+	.decompress_422 = decompress_422_row_avx512,
+};
+
+#endif
@@ -0,0 +1,64 @@
+/******************************************************************************
+    Copyright (C) 2026 by agent <agent@local>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include "../util/c99defs.h"
+#include "format-conversion.h"
+
+#if defined(__x86_64__) || (defined(_M_X64) && !defined(_M_ARM64EC))
+#define FORMAT_CONVERSION_X86_64
+#endif
+
+/* AVX2/AVX-512 kernels are compiled with per-function target attributes so
+ * that the rest of libobs does not need to be built with those instruction
+ * sets enabled.  MSVC allows the intrinsics without any special flags. */
+#if defined(__GNUC__) || defined(__clang__)
+#define FC_TARGET_AVX2 __attribute__((target("avx2")))
+#define FC_TARGET_AVX512 __attribute__((target("avx2,avx512f,avx512bw")))
+#else
+#define FC_TARGET_AVX2
+#define FC_TARGET_AVX512
+#endif
+
+/*
+ * Each kernel converts as many leading pixels of a line (or a pair of lines)
+ * as it can and returns how many it converted.  Whatever is left over is
+ * finished by the scalar code in format-conversion.c, which also serves as the
+ * reference implementation, so every kernel set produces identical output.
+ */
+struct format_conversion_kernels {
+	uint32_t (*compress_i420)(const uint8_t *in0, const uint8_t *in1, uint8_t *lum0, uint8_t *lum1, uint8_t *u,
+				  uint8_t *v, uint32_t width);
+	uint32_t (*compress_nv12)(const uint8_t *in0, const uint8_t *in1, uint8_t *lum0, uint8_t *lum1, uint8_t *uv,
+				  uint32_t width);
+	uint32_t (*convert_i444)(const uint8_t *in, uint8_t *lum, uint8_t *u, uint8_t *v, uint32_t width);
+	uint32_t (*decompress_420)(const uint8_t *lum, const uint8_t *u, const uint8_t *v, uint8_t *out,
+				   uint32_t width);
+	uint32_t (*decompress_nv12)(const uint8_t *lum, const uint8_t *uv, uint8_t *out, uint32_t width);
+	uint32_t (*decompress_422)(const uint8_t *in, uint8_t *out, uint32_t pairs, bool leading_lum);
+};
+
+/* Forces the conversion functions to use a specific instruction set, returns
+ * false if the CPU does not support it.  Not exported, the tests build the
+ * conversion code into their own executable to use it. */
+extern bool format_conversion_set_simd(enum format_conversion_simd simd);
+
+#ifdef FORMAT_CONVERSION_X86_64
+extern const struct format_conversion_kernels format_conversion_avx2;
+extern const struct format_conversion_kernels format_conversion_avx512;
+#endif
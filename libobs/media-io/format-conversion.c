@@ -16,8 +16,18 @@
 ******************************************************************************/
 
 #include "format-conversion.h"
+#include "format-conversion-internal.h"
 
 #include "../util/sse-intrin.h"
+#include "../util/threading.h"
+
+#ifdef FORMAT_CONVERSION_X86_64
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
 
 /* ...surprisingly, if I don't use a macro to force inlining, it causes the
  * CPU usage to boost by a tremendous amount in debug builds. */
@@ -25,26 +35,17 @@
 #define get_m128_32_0(val) (*((uint32_t *)&val))
 #define get_m128_32_1(val) (*(((uint32_t *)&val) + 1))
 
-#define pack_shift(lum_plane, lum_pos0, lum_pos1, line1, line2, mask, sh)                           \
+#define pack_shift(lum0, lum1, line1, line2, mask, sh)                                              \
 	do {                                                                                        \
 		__m128i pack_val = _mm_packs_epi32(_mm_srli_si128(_mm_and_si128(line1, mask), sh),  \
 						   _mm_srli_si128(_mm_and_si128(line2, mask), sh)); \
 		pack_val = _mm_packus_epi16(pack_val, pack_val);                                    \
                                                                                                     \
-		*(uint32_t *)(lum_plane + lum_pos0) = get_m128_32_0(pack_val);                      \
-		*(uint32_t *)(lum_plane + lum_pos1) = get_m128_32_1(pack_val);                      \
-	} while (false)
-
-#define pack_val(lum_plane, lum_pos0, lum_pos1, line1, line2, mask)                                         \
-	do {                                                                                                \
-		__m128i pack_val = _mm_packs_epi32(_mm_and_si128(line1, mask), _mm_and_si128(line2, mask)); \
-		pack_val = _mm_packus_epi16(pack_val, pack_val);                                            \
-                                                                                                            \
-		*(uint32_t *)(lum_plane + lum_pos0) = get_m128_32_0(pack_val);                              \
-		*(uint32_t *)(lum_plane + lum_pos1) = get_m128_32_1(pack_val);                              \
+		*(uint32_t *)(lum0) = get_m128_32_0(pack_val);                                      \
+		*(uint32_t *)(lum1) = get_m128_32_1(pack_val);                                      \
 	} while (false)
 
-#define pack_ch_1plane(uv_plane, chroma_pos, line1, line2, uv_mask)                                            \
+#define pack_ch_1plane(uv_plane, line1, line2, uv_mask)                                                        \
 	do {                                                                                                   \
 		__m128i add_val = _mm_add_epi64(_mm_and_si128(line1, uv_mask), _mm_and_si128(line2, uv_mask)); \
 		__m128i avg_val = _mm_add_epi64(add_val, _mm_shuffle_epi32(add_val, _MM_SHUFFLE(2, 3, 0, 1))); \
@@ -52,10 +53,10 @@
 		avg_val = _mm_shuffle_epi32(avg_val, _MM_SHUFFLE(3, 1, 2, 0));                                 \
 		avg_val = _mm_packus_epi16(avg_val, avg_val);                                                  \
                                                                                                                \
-		*(uint32_t *)(uv_plane + chroma_pos) = get_m128_32_0(avg_val);                                 \
+		*(uint32_t *)(uv_plane) = get_m128_32_0(avg_val);                                              \
 	} while (false)
 
-#define pack_ch_2plane(u_plane, v_plane, chroma_pos, line1, line2, uv_mask)                                    \
+#define pack_ch_2plane(u_plane, v_plane, line1, line2, uv_mask)                                                \
 	do {                                                                                                   \
 		uint32_t packed_vals;                                                                          \
                                                                                                                \
@@ -68,8 +69,8 @@
                                                                                                                \
 		packed_vals = get_m128_32_0(avg_val);                                                          \
                                                                                                                \
-		*(uint16_t *)(u_plane + chroma_pos) = (uint16_t)(packed_vals);                                 \
-		*(uint16_t *)(v_plane + chroma_pos) = (uint16_t)(packed_vals >> 16);                           \
+		*(uint16_t *)(u_plane) = (uint16_t)(packed_vals);                                              \
+		*(uint16_t *)(v_plane) = (uint16_t)(packed_vals >> 16);                                        \
 	} while (false)
 
 static FORCE_INLINE uint32_t min_uint32(uint32_t a, uint32_t b)
@@ -77,34 +78,410 @@ static FORCE_INLINE uint32_t min_uint32(uint32_t a, uint32_t b)
 	return a < b ? a : b;
 }
 
+/* ------------------------------------------------------------------------- */
+/* scalar reference                                                          */
+
+static void compress_420_c(const uint8_t *in0, const uint8_t *in1, uint8_t *lum0, uint8_t *lum1, uint8_t *u,
+			   uint8_t *v, uint32_t uv_step, uint32_t x, uint32_t width)
+{
+	for (; x < width; x += 2) {
+		const uint8_t *p0 = in0 + x * 4;
+		const uint8_t *p1 = in1 + x * 4;
+		const uint32_t next = (x + 1 < width) ? 4 : 0;
+		const uint32_t chroma_pos = (x >> 1) * uv_step;
+
+		lum0[x] = p0[1];
+		if (lum1)
+			lum1[x] = p1[1];
+		if (next) {
+			lum0[x + 1] = p0[5];
+			if (lum1)
+				lum1[x + 1] = p1[5];
+		}
+
+		u[chroma_pos] = (uint8_t)((p0[0] + p0[next] + p1[0] + p1[next]) >> 2);
+		v[chroma_pos] = (uint8_t)((p0[2] + p0[next + 2] + p1[2] + p1[next + 2]) >> 2);
+	}
+}
+
+static void convert_444_c(const uint8_t *in, uint8_t *lum, uint8_t *u, uint8_t *v, uint32_t x, uint32_t width)
+{
+	for (; x < width; x++) {
+		const uint8_t *p = in + x * 4;
+
+		lum[x] = p[1];
+		u[x] = p[0];
+		v[x] = p[2];
+	}
+}
+
+static void decompress_420_c(const uint8_t *lum, const uint8_t *u, const uint8_t *v, uint8_t *out, uint32_t x,
+			     uint32_t width)
+{
+	uint32_t *out32 = (uint32_t *)out;
+
+	for (; x < width; x++)
+		out32[x] = ((uint32_t)lum[x] << 16) | ((uint32_t)u[x >> 1] << 8) | v[x >> 1];
+}
+
+static void decompress_nv12_c(const uint8_t *lum, const uint8_t *uv, uint8_t *out, uint32_t x, uint32_t width)
+{
+	uint32_t *out32 = (uint32_t *)out;
+
+	for (; x < width; x++) {
+		const uint8_t *chroma = uv + (x >> 1) * 2;
+		out32[x] = lum[x] | ((uint32_t)chroma[0] << 8) | ((uint32_t)chroma[1] << 16);
+	}
+}
+
+static void decompress_422_c(const uint8_t *in, uint8_t *out, uint32_t i, uint32_t pairs, bool leading_lum)
+{
+	register const uint32_t *input32 = (const uint32_t *)in + i;
+	register const uint32_t *input32_end = (const uint32_t *)in + pairs;
+	register uint32_t *output32 = (uint32_t *)out + i * 2;
+
+	if (leading_lum) {
+		while (input32 < input32_end) {
+			register uint32_t dw = *input32;
+
+			output32[0] = dw;
+			dw &= 0xFFFFFF00;
+			dw |= (uint8_t)(dw >> 16);
+			output32[1] = dw;
+
+			output32 += 2;
+			input32++;
+		}
+	} else {
+		while (input32 < input32_end) {
+			register uint32_t dw = *input32;
+
+			output32[0] = dw;
+			dw &= 0xFFFF00FF;
+			dw |= (dw >> 16) & 0xFF00;
+			output32[1] = dw;
+
+			output32 += 2;
+			input32++;
+		}
+	}
+}
+
+static uint32_t compress_i420_row_c(const uint8_t *in0, const uint8_t *in1, uint8_t *lum0, uint8_t *lum1, uint8_t *u,
+				    uint8_t *v, uint32_t width)
+{
+	compress_420_c(in0, in1, lum0, lum1, u, v, 1, 0, width);
+	return width;
+}
+
+static uint32_t compress_nv12_row_c(const uint8_t *in0, const uint8_t *in1, uint8_t *lum0, uint8_t *lum1, uint8_t *uv,
+				    uint32_t width)
+{
+	compress_420_c(in0, in1, lum0, lum1, uv, uv + 1, 2, 0, width);
+	return width;
+}
+
+static uint32_t convert_i444_row_c(const uint8_t *in, uint8_t *lum, uint8_t *u, uint8_t *v, uint32_t width)
+{
+	convert_444_c(in, lum, u, v, 0, width);
+	return width;
+}
+
+static uint32_t decompress_420_row_c(const uint8_t *lum, const uint8_t *u, const uint8_t *v, uint8_t *out,
+				     uint32_t width)
+{
+	decompress_420_c(lum, u, v, out, 0, width);
+	return width;
+}
+
+static uint32_t decompress_nv12_row_c(const uint8_t *lum, const uint8_t *uv, uint8_t *out, uint32_t width)
+{
+	decompress_nv12_c(lum, uv, out, 0, width);
+	return width;
+}
+
+static uint32_t decompress_422_row_c(const uint8_t *in, uint8_t *out, uint32_t pairs, bool leading_lum)
+{
+	decompress_422_c(in, out, 0, pairs, leading_lum);
+	return pairs;
+}
+
+static const struct format_conversion_kernels format_conversion_c = {
+	.compress_i420 = compress_i420_row_c,
+	.compress_nv12 = compress_nv12_row_c,
+	.convert_i444 = convert_i444_row_c,
+	.decompress_420 = decompress_420_row_c,
+	.decompress_nv12 = decompress_nv12_row_c,
+	.decompress_422 = decompress_422_row_c,
+};
+
+/* ------------------------------------------------------------------------- */
+/* SSE2 (or its SIMDe equivalent on other architectures)                     */
+
+static uint32_t compress_i420_row_sse2(const uint8_t *in0, const uint8_t *in1, uint8_t *lum0, uint8_t *lum1,
+				       uint8_t *u, uint8_t *v, uint32_t width)
+{
+	__m128i lum_mask = _mm_set1_epi32(0x0000FF00);
+	__m128i uv_mask = _mm_set1_epi16(0x00FF);
+	uint32_t x;
+
+	for (x = 0; x + 4 <= width; x += 4) {
+		__m128i line1 = _mm_loadu_si128((const __m128i *)(in0 + x * 4));
+		__m128i line2 = _mm_loadu_si128((const __m128i *)(in1 + x * 4));
+
+		pack_shift(lum0 + x, lum1 + x, line1, line2, lum_mask, 1);
+		pack_ch_2plane(u + (x >> 1), v + (x >> 1), line1, line2, uv_mask);
+	}
+
+	return x;
+}
+
+static uint32_t compress_nv12_row_sse2(const uint8_t *in0, const uint8_t *in1, uint8_t *lum0, uint8_t *lum1,
+				       uint8_t *uv, uint32_t width)
+{
+	__m128i lum_mask = _mm_set1_epi32(0x0000FF00);
+	__m128i uv_mask = _mm_set1_epi16(0x00FF);
+	uint32_t x;
+
+	for (x = 0; x + 4 <= width; x += 4) {
+		__m128i line1 = _mm_loadu_si128((const __m128i *)(in0 + x * 4));
+		__m128i line2 = _mm_loadu_si128((const __m128i *)(in1 + x * 4));
+
+		pack_shift(lum0 + x, lum1 + x, line1, line2, lum_mask, 1);
+		pack_ch_1plane(uv + x, line1, line2, uv_mask);
+	}
+
+	return x;
+}
+
+static uint32_t convert_i444_row_sse2(const uint8_t *in, uint8_t *lum, uint8_t *u, uint8_t *v, uint32_t width)
+{
+	__m128i lum_mask = _mm_set1_epi32(0x0000FF00);
+	__m128i u_mask = _mm_set1_epi32(0x000000FF);
+	__m128i v_mask = _mm_set1_epi32(0x00FF0000);
+	uint32_t x;
+
+	for (x = 0; x + 8 <= width; x += 8) {
+		__m128i line1 = _mm_loadu_si128((const __m128i *)(in + x * 4));
+		__m128i line2 = _mm_loadu_si128((const __m128i *)(in + x * 4 + 16));
+
+		pack_shift(lum + x, lum + x + 4, line1, line2, lum_mask, 1);
+		pack_shift(u + x, u + x + 4, line1, line2, u_mask, 0);
+		pack_shift(v + x, v + x + 4, line1, line2, v_mask, 2);
+	}
+
+	return x;
+}
+
+static uint32_t decompress_420_row_sse2(const uint8_t *lum, const uint8_t *u, const uint8_t *v, uint8_t *out,
+					uint32_t width)
+{
+	__m128i zero = _mm_setzero_si128();
+	uint32_t x;
+
+	for (x = 0; x + 8 <= width; x += 8) {
+		__m128i y = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(lum + x)), zero);
+		__m128i uv = _mm_unpacklo_epi8(_mm_cvtsi32_si128(*(const int *)(v + (x >> 1))),
+					       _mm_cvtsi32_si128(*(const int *)(u + (x >> 1))));
+
+		uv = _mm_unpacklo_epi16(uv, uv);
+		_mm_storeu_si128((__m128i *)(out + x * 4), _mm_unpacklo_epi16(uv, y));
+		_mm_storeu_si128((__m128i *)(out + x * 4 + 16), _mm_unpackhi_epi16(uv, y));
+	}
+
+	return x;
+}
+
+static uint32_t decompress_nv12_row_sse2(const uint8_t *lum, const uint8_t *uv, uint8_t *out, uint32_t width)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i u_mask = _mm_set1_epi16(0x00FF);
+	uint32_t x;
+
+	for (x = 0; x + 8 <= width; x += 8) {
+		__m128i y = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(lum + x)), zero);
+		__m128i chroma = _mm_loadl_epi64((const __m128i *)(uv + x));
+		__m128i yu, v;
+
+		chroma = _mm_unpacklo_epi16(chroma, chroma);
+		yu = _mm_or_si128(y, _mm_slli_epi16(_mm_and_si128(chroma, u_mask), 8));
+		v = _mm_srli_epi16(chroma, 8);
+
+		_mm_storeu_si128((__m128i *)(out + x * 4), _mm_unpacklo_epi16(yu, v));
+		_mm_storeu_si128((__m128i *)(out + x * 4 + 16), _mm_unpackhi_epi16(yu, v));
+	}
+
+	return x;
+}
+
+static uint32_t decompress_422_row_sse2(const uint8_t *in, uint8_t *out, uint32_t pairs, bool leading_lum)
+{
+	__m128i keep_mask = _mm_set1_epi32(leading_lum ? 0xFFFFFF00 : 0xFFFF00FF);
+	__m128i lum_mask = _mm_set1_epi32(leading_lum ? 0x000000FF : 0x0000FF00);
+	uint32_t i;
+
+	for (i = 0; i + 4 <= pairs; i += 4) {
+		__m128i dw = _mm_loadu_si128((const __m128i *)(in + i * 4));
+		__m128i dw2 =
+			_mm_or_si128(_mm_and_si128(dw, keep_mask), _mm_and_si128(_mm_srli_epi32(dw, 16), lum_mask));
+
+		_mm_storeu_si128((__m128i *)(out + i * 8), _mm_unpacklo_epi32(dw, dw2));
+		_mm_storeu_si128((__m128i *)(out + i * 8 + 16), _mm_unpackhi_epi32(dw, dw2));
+	}
+
+	return i;
+}
+
+static const struct format_conversion_kernels format_conversion_sse2 = {
+	.compress_i420 = compress_i420_row_sse2,
+	.compress_nv12 = compress_nv12_row_sse2,
+	.convert_i444 = convert_i444_row_sse2,
+	.decompress_420 = decompress_420_row_sse2,
+	.decompress_nv12 = decompress_nv12_row_sse2,
+	.decompress_422 = decompress_422_row_sse2,
+};
+
+/* ------------------------------------------------------------------------- */
+/* runtime dispatch                                                          */
+
+#ifdef FORMAT_CONVERSION_X86_64
+static void get_cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4])
+{
+#ifdef _MSC_VER
+	__cpuidex((int *)regs, (int)leaf, (int)subleaf);
+#else
+	__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static uint64_t get_xcr0(void)
+{
+#ifdef _MSC_VER
+	return _xgetbv(0);
+#else
+	uint32_t eax, edx;
+	__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return ((uint64_t)edx << 32) | eax;
+#endif
+}
+#endif
+
+static enum format_conversion_simd detect_simd(void)
+{
+#ifdef FORMAT_CONVERSION_X86_64
+	uint32_t regs[4];
+	uint64_t xcr0;
+
+	get_cpuid(0, 0, regs);
+	if (regs[0] < 7)
+		return FORMAT_CONVERSION_SIMD_SSE2;
+
+	/* the OS also has to save the extended register state */
+	get_cpuid(1, 0, regs);
+	if ((regs[2] & (1 << 27)) == 0)
+		return FORMAT_CONVERSION_SIMD_SSE2;
+
+	xcr0 = get_xcr0();
+	if ((xcr0 & 0x6) != 0x6)
+		return FORMAT_CONVERSION_SIMD_SSE2;
+
+	get_cpuid(7, 0, regs);
+	if ((xcr0 & 0xE0) == 0xE0 && (regs[1] & (1 << 16)) != 0 && (regs[1] & (1 << 30)) != 0)
+		return FORMAT_CONVERSION_SIMD_AVX512;
+	if ((regs[1] & (1 << 5)) != 0)
+		return FORMAT_CONVERSION_SIMD_AVX2;
+#endif
+	return FORMAT_CONVERSION_SIMD_SSE2;
+}
+
+static const struct format_conversion_kernels *get_kernel_set(enum format_conversion_simd simd)
+{
+	switch (simd) {
+	case FORMAT_CONVERSION_SIMD_NONE:
+		return &format_conversion_c;
+	case FORMAT_CONVERSION_SIMD_SSE2:
+		return &format_conversion_sse2;
+#ifdef FORMAT_CONVERSION_X86_64
+	case FORMAT_CONVERSION_SIMD_AVX2:
+		return &format_conversion_avx2;
+	case FORMAT_CONVERSION_SIMD_AVX512:
+		return &format_conversion_avx512;
+#else
+	case FORMAT_CONVERSION_SIMD_AVX2:
+	case FORMAT_CONVERSION_SIMD_AVX512:
+		break;
+#endif
+	}
+
+	return NULL;
+}
+
+static volatile long cur_simd = -1;
+static volatile long max_simd = -1;
+
+static enum format_conversion_simd get_max_simd(void)
+{
+	long simd = os_atomic_load_long(&max_simd);
+	if (simd < 0) {
+		simd = (long)detect_simd();
+		os_atomic_store_long(&max_simd, simd);
+	}
+
+	return (enum format_conversion_simd)simd;
+}
+
+enum format_conversion_simd format_conversion_get_simd(void)
+{
+	long simd = os_atomic_load_long(&cur_simd);
+	if (simd < 0) {
+		simd = (long)get_max_simd();
+		os_atomic_compare_swap_long(&cur_simd, -1, simd);
+		simd = os_atomic_load_long(&cur_simd);
+	}
+
+	return (enum format_conversion_simd)simd;
+}
+
+bool format_conversion_set_simd(enum format_conversion_simd simd)
+{
+	if (simd > get_max_simd() || !get_kernel_set(simd))
+		return false;
+
+	os_atomic_store_long(&cur_simd, (long)simd);
+	return true;
+}
+
+static inline const struct format_conversion_kernels *get_kernels(void)
+{
+	return get_kernel_set(format_conversion_get_simd());
+}
+
+/* ------------------------------------------------------------------------- */
+
 void compress_uyvx_to_i420(const uint8_t *input, uint32_t in_linesize, uint32_t start_y, uint32_t end_y,
 			   uint8_t *output[], const uint32_t out_linesize[])
 {
+	const struct format_conversion_kernels *k = get_kernels();
 	uint8_t *lum_plane = output[0];
 	uint8_t *u_plane = output[1];
 	uint8_t *v_plane = output[2];
 	uint32_t width = min_uint32(in_linesize, out_linesize[0]);
 	uint32_t y;
 
-	__m128i lum_mask = _mm_set1_epi32(0x0000FF00);
-	__m128i uv_mask = _mm_set1_epi16(0x00FF);
-
 	for (y = start_y; y < end_y; y += 2) {
-		uint32_t y_pos = y * in_linesize;
-		uint32_t chroma_y_pos = (y >> 1) * out_linesize[1];
-		uint32_t lum_y_pos = y * out_linesize[0];
-		uint32_t x;
-
-		for (x = 0; x < width; x += 4) {
-			const uint8_t *img = input + y_pos + x * 4;
-			uint32_t lum_pos0 = lum_y_pos + x;
-			uint32_t lum_pos1 = lum_pos0 + out_linesize[0];
-
-			__m128i line1 = _mm_load_si128((const __m128i *)img);
-			__m128i line2 = _mm_load_si128((const __m128i *)(img + in_linesize));
-
-			pack_shift(lum_plane, lum_pos0, lum_pos1, line1, line2, lum_mask, 1);
-			pack_ch_2plane(u_plane, v_plane, chroma_y_pos + (x >> 1), line1, line2, uv_mask);
+		const uint8_t *in0 = input + y * in_linesize;
+		uint8_t *lum0 = lum_plane + y * out_linesize[0];
+		uint8_t *u = u_plane + (y >> 1) * out_linesize[1];
+		uint8_t *v = v_plane + (y >> 1) * out_linesize[2];
+
+		if (y + 1 < end_y) {
+			const uint8_t *in1 = in0 + in_linesize;
+			uint8_t *lum1 = lum0 + out_linesize[0];
+			uint32_t x = k->compress_i420(in0, in1, lum0, lum1, u, v, width);
+
+			compress_420_c(in0, in1, lum0, lum1, u, v, 1, x, width);
+		} else {
+			compress_420_c(in0, in0, lum0, NULL, u, v, 1, 0, width);
 		}
 	}
 }
@@ -112,30 +489,25 @@ void compress_uyvx_to_i420(const uint8_t *input, uint32_t in_linesize, uint32_t
 void compress_uyvx_to_nv12(const uint8_t *input, uint32_t in_linesize, uint32_t start_y, uint32_t end_y,
 			   uint8_t *output[], const uint32_t out_linesize[])
 {
+	const struct format_conversion_kernels *k = get_kernels();
 	uint8_t *lum_plane = output[0];
 	uint8_t *chroma_plane = output[1];
 	uint32_t width = min_uint32(in_linesize, out_linesize[0]);
 	uint32_t y;
 
-	__m128i lum_mask = _mm_set1_epi32(0x0000FF00);
-	__m128i uv_mask = _mm_set1_epi16(0x00FF);
-
 	for (y = start_y; y < end_y; y += 2) {
-		uint32_t y_pos = y * in_linesize;
-		uint32_t chroma_y_pos = (y >> 1) * out_linesize[1];
-		uint32_t lum_y_pos = y * out_linesize[0];
-		uint32_t x;
-
-		for (x = 0; x < width; x += 4) {
-			const uint8_t *img = input + y_pos + x * 4;
-			uint32_t lum_pos0 = lum_y_pos + x;
-			uint32_t lum_pos1 = lum_pos0 + out_linesize[0];
-
-			__m128i line1 = _mm_load_si128((const __m128i *)img);
-			__m128i line2 = _mm_load_si128((const __m128i *)(img + in_linesize));
-
-			pack_shift(lum_plane, lum_pos0, lum_pos1, line1, line2, lum_mask, 1);
-			pack_ch_1plane(chroma_plane, chroma_y_pos + x, line1, line2, uv_mask);
+		const uint8_t *in0 = input + y * in_linesize;
+		uint8_t *lum0 = lum_plane + y * out_linesize[0];
+		uint8_t *uv = chroma_plane + (y >> 1) * out_linesize[1];
+
+		if (y + 1 < end_y) {
+			const uint8_t *in1 = in0 + in_linesize;
+			uint8_t *lum1 = lum0 + out_linesize[0];
+			uint32_t x = k->compress_nv12(in0, in1, lum0, lum1, uv, width);
+
+			compress_420_c(in0, in1, lum0, lum1, uv, uv + 1, 2, x, width);
+		} else {
+			compress_420_c(in0, in0, lum0, NULL, uv, uv + 1, 2, 0, width);
 		}
 	}
 }
@@ -143,146 +515,69 @@ void compress_uyvx_to_nv12(const uint8_t *input, uint32_t in_linesize, uint32_t
 void convert_uyvx_to_i444(const uint8_t *input, uint32_t in_linesize, uint32_t start_y, uint32_t end_y,
 			  uint8_t *output[], const uint32_t out_linesize[])
 {
-	uint8_t *lum_plane = output[0];
-	uint8_t *u_plane = output[1];
-	uint8_t *v_plane = output[2];
+	const struct format_conversion_kernels *k = get_kernels();
 	uint32_t width = min_uint32(in_linesize, out_linesize[0]);
 	uint32_t y;
 
-	__m128i lum_mask = _mm_set1_epi32(0x0000FF00);
-	__m128i u_mask = _mm_set1_epi32(0x000000FF);
-	__m128i v_mask = _mm_set1_epi32(0x00FF0000);
+	for (y = start_y; y < end_y; y++) {
+		const uint8_t *in = input + y * in_linesize;
+		uint8_t *lum = output[0] + y * out_linesize[0];
+		uint8_t *u = output[1] + y * out_linesize[1];
+		uint8_t *v = output[2] + y * out_linesize[2];
+		uint32_t x = k->convert_i444(in, lum, u, v, width);
 
-	for (y = start_y; y < end_y; y += 2) {
-		uint32_t y_pos = y * in_linesize;
-		uint32_t lum_y_pos = y * out_linesize[0];
-		uint32_t x;
-
-		for (x = 0; x < width; x += 4) {
-			const uint8_t *img = input + y_pos + x * 4;
-			uint32_t lum_pos0 = lum_y_pos + x;
-			uint32_t lum_pos1 = lum_pos0 + out_linesize[0];
-
-			__m128i line1 = _mm_load_si128((const __m128i *)img);
-			__m128i line2 = _mm_load_si128((const __m128i *)(img + in_linesize));
-
-			pack_shift(lum_plane, lum_pos0, lum_pos1, line1, line2, lum_mask, 1);
-			pack_val(u_plane, lum_pos0, lum_pos1, line1, line2, u_mask);
-			pack_shift(v_plane, lum_pos0, lum_pos1, line1, line2, v_mask, 2);
-		}
+		convert_444_c(in, lum, u, v, x, width);
 	}
 }
 
 void decompress_420(const uint8_t *const input[], const uint32_t in_linesize[], uint32_t start_y, uint32_t end_y,
 		    uint8_t *output, uint32_t out_linesize)
 {
-	uint32_t start_y_d2 = start_y / 2;
-	uint32_t width_d2 = in_linesize[0] / 2;
-	uint32_t height_d2 = end_y / 2;
+	const struct format_conversion_kernels *k = get_kernels();
+	uint32_t width = in_linesize[0];
 	uint32_t y;
 
-	for (y = start_y_d2; y < height_d2; y++) {
-		const uint8_t *chroma0 = input[1] + y * in_linesize[1];
-		const uint8_t *chroma1 = input[2] + y * in_linesize[2];
-		register const uint8_t *lum0, *lum1;
-		register uint32_t *output0, *output1;
-		uint32_t x;
-
-		lum0 = input[0] + y * 2 * in_linesize[0];
-		lum1 = lum0 + in_linesize[0];
-		output0 = (uint32_t *)(output + y * 2 * out_linesize);
-		output1 = (uint32_t *)((uint8_t *)output0 + out_linesize);
+	for (y = start_y; y < end_y; y++) {
+		const uint8_t *lum = input[0] + y * in_linesize[0];
+		const uint8_t *u = input[1] + (y >> 1) * in_linesize[1];
+		const uint8_t *v = input[2] + (y >> 1) * in_linesize[2];
+		uint8_t *out = output + y * out_linesize;
+		uint32_t x = k->decompress_420(lum, u, v, out, width);
 
-		for (x = 0; x < width_d2; x++) {
-			uint32_t out;
-			out = (*(chroma0++) << 8) | *(chroma1++);
-
-			*(output0++) = (*(lum0++) << 16) | out;
-			*(output0++) = (*(lum0++) << 16) | out;
-
-			*(output1++) = (*(lum1++) << 16) | out;
-			*(output1++) = (*(lum1++) << 16) | out;
-		}
+		decompress_420_c(lum, u, v, out, x, width);
 	}
 }
 
 void decompress_nv12(const uint8_t *const input[], const uint32_t in_linesize[], uint32_t start_y, uint32_t end_y,
 		     uint8_t *output, uint32_t out_linesize)
 {
-	uint32_t start_y_d2 = start_y / 2;
-	uint32_t width_d2 = min_uint32(in_linesize[0], out_linesize) / 2;
-	uint32_t height_d2 = end_y / 2;
+	const struct format_conversion_kernels *k = get_kernels();
+	uint32_t width = min_uint32(in_linesize[0], out_linesize);
 	uint32_t y;
 
-	for (y = start_y_d2; y < height_d2; y++) {
-		const uint16_t *chroma;
-		register const uint8_t *lum0, *lum1;
-		register uint32_t *output0, *output1;
-		uint32_t x;
-
-		chroma = (const uint16_t *)(input[1] + y * in_linesize[1]);
-		lum0 = input[0] + y * 2 * in_linesize[0];
-		lum1 = lum0 + in_linesize[0];
-		output0 = (uint32_t *)(output + y * 2 * out_linesize);
-		output1 = (uint32_t *)((uint8_t *)output0 + out_linesize);
-
-		for (x = 0; x < width_d2; x++) {
-			uint32_t out = *(chroma++) << 8;
-
-			*(output0++) = *(lum0++) | out;
-			*(output0++) = *(lum0++) | out;
+	for (y = start_y; y < end_y; y++) {
+		const uint8_t *lum = input[0] + y * in_linesize[0];
+		const uint8_t *uv = input[1] + (y >> 1) * in_linesize[1];
+		uint8_t *out = output + y * out_linesize;
+		uint32_t x = k->decompress_nv12(lum, uv, out, width);
 
-			*(output1++) = *(lum1++) | out;
-			*(output1++) = *(lum1++) | out;
-		}
+		decompress_nv12_c(lum, uv, out, x, width);
 	}
 }
 
 void decompress_422(const uint8_t *input, uint32_t in_linesize, uint32_t start_y, uint32_t end_y, uint8_t *output,
 		    uint32_t out_linesize, bool leading_lum)
 {
-	uint32_t width_d2 = min_uint32(in_linesize, out_linesize) / 2;
+	const struct format_conversion_kernels *k = get_kernels();
+	uint32_t width = min_uint32(in_linesize / 2, out_linesize / 4);
+	uint32_t pairs = width / 2;
 	uint32_t y;
 
-	register const uint32_t *input32;
-	register const uint32_t *input32_end;
-	register uint32_t *output32;
+	for (y = start_y; y < end_y; y++) {
+		const uint8_t *in = input + y * in_linesize;
+		uint8_t *out = output + y * out_linesize;
+		uint32_t i = k->decompress_422(in, out, pairs, leading_lum);
 
-	if (leading_lum) {
-		for (y = start_y; y < end_y; y++) {
-			input32 = (const uint32_t *)(input + y * in_linesize);
-			input32_end = input32 + width_d2;
-			output32 = (uint32_t *)(output + y * out_linesize);
-
-			while (input32 < input32_end) {
-				register uint32_t dw = *input32;
-
-				output32[0] = dw;
-				dw &= 0xFFFFFF00;
-				dw |= (uint8_t)(dw >> 16);
-				output32[1] = dw;
-
-				output32 += 2;
-				input32++;
-			}
-		}
-	} else {
-		for (y = start_y; y < end_y; y++) {
-			input32 = (const uint32_t *)(input + y * in_linesize);
-			input32_end = input32 + width_d2;
-			output32 = (uint32_t *)(output + y * out_linesize);
-
-			while (input32 < input32_end) {
-				register uint32_t dw = *input32;
-
-				output32[0] = dw;
-				dw &= 0xFFFF00FF;
-				dw |= (dw >> 16) & 0xFF00;
-				output32[1] = dw;
-
-				output32 += 2;
-				input32++;
-			}
-		}
+		decompress_422_c(in, out, i, pairs, leading_lum);
 	}
 }
@@ -25,8 +25,23 @@ extern "C" {
 
 /*
  * Functions for converting to and from packed 444 YUV
+ *
+ *   The conversion functions pick the fastest instruction set supported by the
+ * CPU at runtime.  Line widths do not need to be a multiple of the SIMD width,
+ * odd widths and heights are handled by a scalar fallback that produces the
+ * same output as the vectorized paths.
  */
 
+enum format_conversion_simd {
+	FORMAT_CONVERSION_SIMD_NONE,
+	FORMAT_CONVERSION_SIMD_SSE2,
+	FORMAT_CONVERSION_SIMD_AVX2,
+	FORMAT_CONVERSION_SIMD_AVX512,
+};
+
+/** Returns the instruction set currently used by the conversion functions */
+EXPORT enum format_conversion_simd format_conversion_get_simd(void);
+
 EXPORT void compress_uyvx_to_i420(const uint8_t *input, uint32_t in_linesize, uint32_t start_y, uint32_t end_y,
 				  uint8_t *output[], const uint32_t out_linesize[]);
 
@@ -187,21 +187,15 @@ void video_frame_get_plane_heights(uint32_t heights[MAX_AV_PLANES], enum video_f
 	}
 }
 
-void video_frame_init(struct video_frame *frame, enum video_format format, uint32_t width, uint32_t height)
+static size_t get_plane_layout(uint32_t linesizes[MAX_AV_PLANES], uint32_t heights[MAX_AV_PLANES],
+			       size_t offsets[MAX_AV_PLANES], enum video_format format, uint32_t width, uint32_t height)
 {
 	size_t size = 0;
-	uint32_t linesizes[MAX_AV_PLANES];
-	uint32_t heights[MAX_AV_PLANES];
-	size_t offsets[MAX_AV_PLANES];
 	int alignment = base_get_alignment();
 
-	if (!frame)
-		return;
-
-	memset(frame, 0, sizeof(struct video_frame));
-	memset(linesizes, 0, sizeof(linesizes));
-	memset(heights, 0, sizeof(heights));
-	memset(offsets, 0, sizeof(offsets));
+	memset(linesizes, 0, sizeof(uint32_t) * MAX_AV_PLANES);
+	memset(heights, 0, sizeof(uint32_t) * MAX_AV_PLANES);
+	memset(offsets, 0, sizeof(size_t) * MAX_AV_PLANES);
 
 	/* determine linesizes for each plane */
 	video_frame_get_linesizes(linesizes, format, width);
@@ -219,8 +213,32 @@ void video_frame_init(struct video_frame *frame, enum video_format format, uint3
 		offsets[i] = size;
 	}
 
-	/* allocate memory */
-	frame->data[0] = bmalloc(size);
+	return size;
+}
+
+size_t video_frame_get_size(enum video_format format, uint32_t width, uint32_t height)
+{
+	uint32_t linesizes[MAX_AV_PLANES];
+	uint32_t heights[MAX_AV_PLANES];
+	size_t offsets[MAX_AV_PLANES];
+
+	return get_plane_layout(linesizes, heights, offsets, format, width, height);
+}
+
+void video_frame_init_buffer(struct video_frame *frame, uint8_t *data, enum video_format format, uint32_t width,
+			     uint32_t height)
+{
+	uint32_t linesizes[MAX_AV_PLANES];
+	uint32_t heights[MAX_AV_PLANES];
+	size_t offsets[MAX_AV_PLANES];
+
+	if (!frame)
+		return;
+
+	memset(frame, 0, sizeof(struct video_frame));
+	get_plane_layout(linesizes, heights, offsets, format, width, height);
+
+	frame->data[0] = data;
 	frame->linesize[0] = linesizes[0];
 
 	/* apply plane data pointers according to offsets */
@@ -232,6 +250,14 @@ void video_frame_init(struct video_frame *frame, enum video_format format, uint3
 	}
 }
 
+void video_frame_init(struct video_frame *frame, enum video_format format, uint32_t width, uint32_t height)
+{
+	if (!frame)
+		return;
+
+	video_frame_init_buffer(frame, bmalloc(video_frame_get_size(format, width, height)), format, width, height);
+}
+
 void video_frame_copy(struct video_frame *dst, const struct video_frame *src, enum video_format format, uint32_t cy)
 {
 	uint32_t heights[MAX_AV_PLANES];
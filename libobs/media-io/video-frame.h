@@ -31,6 +31,14 @@ struct video_frame {
 
 EXPORT void video_frame_init(struct video_frame *frame, enum video_format format, uint32_t width, uint32_t height);
 
+/* Size of the single buffer holding every plane of a frame */
+EXPORT size_t video_frame_get_size(enum video_format format, uint32_t width, uint32_t height);
+
+/* Lays out the planes of a frame over an existing buffer of at least
+ * video_frame_get_size() bytes */
+EXPORT void video_frame_init_buffer(struct video_frame *frame, uint8_t *data, enum video_format format, uint32_t width,
+				    uint32_t height);
+
 static inline void video_frame_free(struct video_frame *frame)
 {
 	if (frame) {
@@ -34,10 +34,33 @@ extern profiler_name_store_t *obs_get_profiler_name_store(void);
 #define MAX_CONVERT_BUFFERS 3
 #define MAX_CACHE_SIZE 16
 
+/* The number of times a cached frame still has to be output and how many of
+ * those are repeats counted as skipped share one atomic value, so that the
+ * producer adding repeats and the video thread taking them never see one
+ * updated without the other.  Both saturate, which only happens if the video
+ * thread stalls for minutes. */
+#define FRAME_COUNT_BITS 16
+#define FRAME_COUNT_MAX ((1L << FRAME_COUNT_BITS) - 1)
+#define FRAME_SKIPPED_MAX 0x7FFFL
+
+static inline long frame_state(long count, long skipped)
+{
+	return (skipped << FRAME_COUNT_BITS) | count;
+}
+
+static inline long frame_state_count(long state)
+{
+	return state & FRAME_COUNT_MAX;
+}
+
+static inline long frame_state_skipped(long state)
+{
+	return (state >> FRAME_COUNT_BITS) & FRAME_SKIPPED_MAX;
+}
+
 struct cached_frame_info {
 	struct video_data frame;
-	int skipped;
-	int count;
+	volatile long state;
 };
 
 struct video_input {
@@ -58,6 +81,8 @@ struct video_input {
 
 	void (*callback)(void *param, struct video_data *frame);
 	void *param;
+
+	struct video_input_latency latency;
 };
 
 static inline void video_input_free(struct video_input *input)
@@ -67,11 +92,18 @@ static inline void video_input_free(struct video_input *input)
 	video_scaler_destroy(input->scaler);
 }
 
+/*
+ * Frames are passed from the graphics thread to the video thread through a
+ * single-producer/single-consumer ring.  The producer owns write_pos, the
+ * consumer owns read_pos, and the only shared state is the number of queued
+ * frames plus the repeat/skip counters of each slot.  When the ring is full the
+ * producer does not wait, it adds the frame to the repeat count of the newest
+ * queued frame instead and counts it as skipped.
+ */
 struct video_output {
 	struct video_output_info info;
 
 	pthread_t thread;
-	pthread_mutex_t data_mutex;
 	bool stop;
 
 	os_sem_t *update_semaphore;
@@ -82,9 +114,11 @@ struct video_output {
 	pthread_mutex_t input_mutex;
 	DARRAY(struct video_input) inputs;
 
-	size_t available_frames;
-	size_t first_added;
-	size_t last_added;
+	size_t write_pos;
+	size_t read_pos;
+	volatile long queued_frames;
+	volatile long max_queued_frames;
+	volatile long ring_full;
 	struct cached_frame_info cache[MAX_CACHE_SIZE];
 
 	struct video_output *parent;
@@ -123,19 +157,29 @@ static inline bool scale_video_output(struct video_input *input, struct video_da
 	return success;
 }
 
-static inline bool video_output_cur_frame(struct video_output *video)
+static inline void add_input_latency(struct video_input_latency *latency, uint64_t ns)
 {
-	struct cached_frame_info *frame_info;
-	bool complete;
-	bool skipped;
+	uint64_t bucket_ns = VIDEO_INPUT_LATENCY_BUCKET_NS;
+	size_t bucket = 0;
 
-	/* -------------------------------- */
-
-	pthread_mutex_lock(&video->data_mutex);
+	while (ns >= bucket_ns && bucket < VIDEO_INPUT_LATENCY_BUCKETS - 1) {
+		bucket_ns <<= 1;
+		bucket++;
+	}
 
-	frame_info = &video->cache[video->first_added];
+	latency->frames++;
+	latency->total_ns += ns;
+	if (ns > latency->max_ns)
+		latency->max_ns = ns;
+	latency->buckets[bucket]++;
+}
 
-	pthread_mutex_unlock(&video->data_mutex);
+static inline bool video_output_cur_frame(struct video_output *video)
+{
+	struct cached_frame_info *frame_info = &video->cache[video->read_pos];
+	long state, count, skipped;
+	bool repeat;
+	bool complete;
 
 	/* -------------------------------- */
 
@@ -155,33 +199,41 @@ static inline bool video_output_cur_frame(struct video_output *video)
 		if (skip)
 			continue;
 
+		uint64_t start = os_gettime_ns();
+
 		if (scale_video_output(input, &frame))
 			input->callback(input->param, &frame);
+
+		add_input_latency(&input->latency, os_gettime_ns() - start);
 	}
 
 	pthread_mutex_unlock(&video->input_mutex);
 
 	/* -------------------------------- */
 
-	pthread_mutex_lock(&video->data_mutex);
-
 	frame_info->frame.timestamp += video->frame_time;
-	complete = --frame_info->count == 0;
-	skipped = frame_info->skipped > 0;
+
+	state = os_atomic_load_long(&frame_info->state);
+	do {
+		count = frame_state_count(state) - 1;
+		skipped = frame_state_skipped(state);
+		repeat = count > 0 && skipped > 0;
+		if (repeat)
+			skipped--;
+	} while (!os_atomic_compare_exchange_long(&frame_info->state, &state, frame_state(count, skipped)));
+
+	complete = count == 0;
 
 	if (complete) {
-		if (++video->first_added == video->info.cache_size)
-			video->first_added = 0;
+		if (++video->read_pos == video->info.cache_size)
+			video->read_pos = 0;
+
+		os_atomic_dec_long(&video->queued_frames);
 
-		if (++video->available_frames == video->info.cache_size)
-			video->last_added = video->first_added;
-	} else if (skipped) {
-		--frame_info->skipped;
+	} else if (repeat) {
 		os_atomic_inc_long(&video->skipped_frames);
 	}
 
-	pthread_mutex_unlock(&video->data_mutex);
-
 	/* -------------------------------- */
 
 	return complete;
@@ -232,8 +284,6 @@ static inline void init_cache(struct video_output *video)
 
 		video_frame_init(frame, video->info.format, video->info.width, video->info.height);
 	}
-
-	video->available_frames = video->info.cache_size;
 }
 
 int video_output_open(video_t **video, struct video_output_info *info)
@@ -250,26 +300,25 @@ int video_output_open(video_t **video, struct video_output_info *info)
 	memcpy(&out->info, info, sizeof(struct video_output_info));
 	out->frame_time = util_mul_div64(1000000000ULL, info->fps_den, info->fps_num);
 
-	if (pthread_mutex_init_recursive(&out->data_mutex) != 0)
-		goto fail0;
 	if (pthread_mutex_init_recursive(&out->input_mutex) != 0)
-		goto fail1;
+		goto fail0;
 	if (os_sem_init(&out->update_semaphore, 0) != 0)
-		goto fail2;
-	if (pthread_create(&out->thread, NULL, video_thread, out) != 0)
-		goto fail3;
+		goto fail1;
 
 	init_cache(out);
 
+	if (pthread_create(&out->thread, NULL, video_thread, out) != 0)
+		goto fail2;
+
 	*video = out;
 	return VIDEO_OUTPUT_SUCCESS;
 
-fail3:
-	os_sem_destroy(out->update_semaphore);
 fail2:
-	pthread_mutex_destroy(&out->input_mutex);
+	for (size_t i = 0; i < out->info.cache_size; i++)
+		video_frame_free((struct video_frame *)&out->cache[i]);
+	os_sem_destroy(out->update_semaphore);
 fail1:
-	pthread_mutex_destroy(&out->data_mutex);
+	pthread_mutex_destroy(&out->input_mutex);
 fail0:
 	bfree(out);
 	return VIDEO_OUTPUT_FAIL;
@@ -293,7 +342,6 @@ void video_output_close(video_t *video)
 
 	pthread_mutex_unlock(&video->input_mutex);
 	os_sem_destroy(video->update_semaphore);
-	pthread_mutex_destroy(&video->data_mutex);
 	pthread_mutex_destroy(&video->input_mutex);
 
 	bfree(video);
@@ -373,6 +421,8 @@ static inline void reset_frames(video_t *video)
 {
 	os_atomic_set_long(&video->skipped_frames, 0);
 	os_atomic_set_long(&video->total_frames, 0);
+	os_atomic_set_long(&video->ring_full, 0);
+	os_atomic_set_long(&video->max_queued_frames, 0);
 }
 
 static const video_t *get_const_root(const video_t *video)
@@ -458,8 +508,11 @@ static void log_skipped(video_t *video)
 		     "Video stopped, number of "
 		     "skipped frames due "
 		     "to encoding lag: "
-		     "%ld/%ld (%0.1f%%)",
-		     video->skipped_frames, video->total_frames, percentage_skipped);
+		     "%ld/%ld (%0.1f%%), frame queue full %ld times, "
+		     "max queued frames: %ld/%zu",
+		     video->skipped_frames, video->total_frames, percentage_skipped,
+		     os_atomic_load_long(&video->ring_full), os_atomic_load_long(&video->max_queued_frames),
+		     video->info.cache_size);
 }
 
 void video_output_disconnect(video_t *video, void (*callback)(void *param, struct video_data *frame), void *param)
@@ -506,57 +559,72 @@ const struct video_output_info *video_output_get_info(const video_t *video)
 	return video ? &video->info : NULL;
 }
 
+/* Tries to add count repeats to the newest queued frame.  Fails if the video
+ * thread finished that frame in the meantime, in which case there is a free
+ * slot again. */
+static inline bool repeat_last_frame(struct video_output *video, int count)
+{
+	size_t last = video->write_pos ? video->write_pos - 1 : video->info.cache_size - 1;
+	struct cached_frame_info *cfi = &video->cache[last];
+	long state = os_atomic_load_long(&cfi->state);
+
+	while (frame_state_count(state) > 0) {
+		long new_count = frame_state_count(state) + count;
+		long new_skipped = frame_state_skipped(state) + count;
+
+		if (new_count > FRAME_COUNT_MAX)
+			new_count = FRAME_COUNT_MAX;
+		if (new_skipped > FRAME_SKIPPED_MAX)
+			new_skipped = FRAME_SKIPPED_MAX;
+
+		if (os_atomic_compare_exchange_long(&cfi->state, &state, frame_state(new_count, new_skipped)))
+			return true;
+	}
+
+	return false;
+}
+
 bool video_output_lock_frame(video_t *video, struct video_frame *frame, int count, uint64_t timestamp)
 {
 	struct cached_frame_info *cfi;
-	bool locked;
 
 	if (!video)
 		return false;
 
 	video = get_root(video);
 
-	pthread_mutex_lock(&video->data_mutex);
-
-	if (video->available_frames == 0) {
-		video->cache[video->last_added].count += count;
-		video->cache[video->last_added].skipped += count;
-		locked = false;
-
-	} else {
-		if (video->available_frames != video->info.cache_size) {
-			if (++video->last_added == video->info.cache_size)
-				video->last_added = 0;
+	while ((size_t)os_atomic_load_long(&video->queued_frames) == video->info.cache_size) {
+		if (repeat_last_frame(video, count)) {
+			os_atomic_inc_long(&video->ring_full);
+			return false;
 		}
-
-		cfi = &video->cache[video->last_added];
-		cfi->frame.timestamp = timestamp;
-		cfi->count = count;
-		cfi->skipped = 0;
-
-		memcpy(frame, &cfi->frame, sizeof(*frame));
-
-		locked = true;
 	}
 
-	pthread_mutex_unlock(&video->data_mutex);
+	cfi = &video->cache[video->write_pos];
+	cfi->frame.timestamp = timestamp;
+	os_atomic_set_long(&cfi->state, frame_state(count > FRAME_COUNT_MAX ? FRAME_COUNT_MAX : count, 0));
 
-	return locked;
+	memcpy(frame, &cfi->frame, sizeof(*frame));
+	return true;
 }
 
 void video_output_unlock_frame(video_t *video)
 {
+	long queued;
+
 	if (!video)
 		return;
 
 	video = get_root(video);
 
-	pthread_mutex_lock(&video->data_mutex);
+	if (++video->write_pos == video->info.cache_size)
+		video->write_pos = 0;
 
-	video->available_frames--;
-	os_sem_post(video->update_semaphore);
+	queued = os_atomic_inc_long(&video->queued_frames);
+	if (queued > os_atomic_load_long(&video->max_queued_frames))
+		os_atomic_set_long(&video->max_queued_frames, queued);
 
-	pthread_mutex_unlock(&video->data_mutex);
+	os_sem_post(video->update_semaphore);
 }
 
 uint64_t video_output_get_frame_time(const video_t *video)
@@ -623,6 +691,39 @@ uint32_t video_output_get_total_frames(const video_t *video)
 	return (uint32_t)os_atomic_load_long(&get_const_root(video)->total_frames);
 }
 
+bool video_output_get_queue_stats(const video_t *video, struct video_output_queue_stats *stats)
+{
+	if (!video || !stats)
+		return false;
+
+	video = get_const_root(video);
+
+	stats->queued = (uint32_t)os_atomic_load_long(&video->queued_frames);
+	stats->max_queued = (uint32_t)os_atomic_load_long(&video->max_queued_frames);
+	stats->capacity = (uint32_t)video->info.cache_size;
+	stats->full = (uint32_t)os_atomic_load_long(&video->ring_full);
+	return true;
+}
+
+bool video_output_get_input_latency(video_t *video, void (*callback)(void *param, struct video_data *frame),
+				    void *param, struct video_input_latency *latency)
+{
+	if (!video || !callback || !latency)
+		return false;
+
+	video = get_root(video);
+
+	pthread_mutex_lock(&video->input_mutex);
+
+	size_t idx = video_get_input_idx(video, callback, param);
+	if (idx != DARRAY_INVALID)
+		*latency = video->inputs.array[idx].latency;
+
+	pthread_mutex_unlock(&video->input_mutex);
+
+	return idx != DARRAY_INVALID;
+}
+
 /* Note: These four functions below are a very slight bit of a hack.  If the
  * texture encoder thread is active while the raw encoder thread is active, the
  * total frame count will just be doubled while they're both active.  Which is
@@ -325,6 +325,33 @@ EXPORT double video_output_get_frame_rate(const video_t *video);
 EXPORT uint32_t video_output_get_skipped_frames(const video_t *video);
 EXPORT uint32_t video_output_get_total_frames(const video_t *video);
 
+struct video_output_queue_stats {
+	uint32_t queued;
+	uint32_t max_queued;
+	uint32_t capacity;
+
+	/* frames that could not be queued because every slot was in use */
+	uint32_t full;
+};
+
+EXPORT bool video_output_get_queue_stats(const video_t *video, struct video_output_queue_stats *stats);
+
+/* Bucket i counts callbacks that took less than VIDEO_INPUT_LATENCY_BUCKET_NS
+ * << i, the last bucket counts everything slower than that. */
+#define VIDEO_INPUT_LATENCY_BUCKETS 16
+#define VIDEO_INPUT_LATENCY_BUCKET_NS 125000ULL
+
+struct video_input_latency {
+	uint64_t frames;
+	uint64_t total_ns;
+	uint64_t max_ns;
+	uint32_t buckets[VIDEO_INPUT_LATENCY_BUCKETS];
+};
+
+/** Returns how long a connected input's callback (including scaling) took */
+EXPORT bool video_output_get_input_latency(video_t *video, void (*callback)(void *param, struct video_data *frame),
+					   void *param, struct video_input_latency *latency);
+
 extern void video_output_inc_texture_encoders(video_t *video);
 extern void video_output_dec_texture_encoders(video_t *video);
 extern void video_output_inc_texture_frames(video_t *video);
@@ -18,6 +18,13 @@
 #include <inttypes.h>
 #include "obs-internal.h"
 #include "util/util_uint64.h"
+#include "util/sse-intrin.h"
+#include "media-io/format-conversion.h"
+#include "media-io/format-conversion-internal.h"
+
+#ifdef FORMAT_CONVERSION_X86_64
+#include <immintrin.h>
+#endif
 
 struct ts_info {
 	uint64_t start;
@@ -136,12 +143,66 @@ static inline size_t convert_time_to_frames(size_t sample_rate, uint64_t t)
 	return (size_t)util_mul_div64(t, sample_rate, 1000000000ULL);
 }
 
-static inline void mix_audio(struct audio_output_data *mixes, obs_source_t *source, size_t channels, size_t sample_rate,
-			     struct ts_info *ts)
+#ifdef FORMAT_CONVERSION_X86_64
+/* plain adds, so the result is identical to the SSE and scalar paths */
+static FC_TARGET_AVX2 size_t mix_float_buffer_avx(float *mix, const float *aud, size_t count)
+{
+	size_t i = 0;
+
+	for (; i + 32 <= count; i += 32) {
+		__m256 m0 = _mm256_add_ps(_mm256_loadu_ps(mix + i), _mm256_loadu_ps(aud + i));
+		__m256 m1 = _mm256_add_ps(_mm256_loadu_ps(mix + i + 8), _mm256_loadu_ps(aud + i + 8));
+		__m256 m2 = _mm256_add_ps(_mm256_loadu_ps(mix + i + 16), _mm256_loadu_ps(aud + i + 16));
+		__m256 m3 = _mm256_add_ps(_mm256_loadu_ps(mix + i + 24), _mm256_loadu_ps(aud + i + 24));
+		_mm256_storeu_ps(mix + i, m0);
+		_mm256_storeu_ps(mix + i + 8, m1);
+		_mm256_storeu_ps(mix + i + 16, m2);
+		_mm256_storeu_ps(mix + i + 24, m3);
+	}
+
+	_mm256_zeroupper();
+	return i;
+}
+#endif
+
+static inline void mix_float_buffer(float *mix, const float *aud, size_t count)
+{
+	size_t i = 0;
+
+#ifdef FORMAT_CONVERSION_X86_64
+	/* reuses the CPU detection (and the test override) of the format
+	 * conversion kernels, AVX2 implies AVX */
+	if (format_conversion_get_simd() >= FORMAT_CONVERSION_SIMD_AVX2)
+		i = mix_float_buffer_avx(mix, aud, count);
+#endif
+
+	for (; i + 16 <= count; i += 16) {
+		__m128 m0 = _mm_add_ps(_mm_loadu_ps(mix + i), _mm_loadu_ps(aud + i));
+		__m128 m1 = _mm_add_ps(_mm_loadu_ps(mix + i + 4), _mm_loadu_ps(aud + i + 4));
+		__m128 m2 = _mm_add_ps(_mm_loadu_ps(mix + i + 8), _mm_loadu_ps(aud + i + 8));
+		__m128 m3 = _mm_add_ps(_mm_loadu_ps(mix + i + 12), _mm_loadu_ps(aud + i + 12));
+		_mm_storeu_ps(mix + i, m0);
+		_mm_storeu_ps(mix + i + 4, m1);
+		_mm_storeu_ps(mix + i + 8, m2);
+		_mm_storeu_ps(mix + i + 12, m3);
+	}
+
+	for (; i < count; i++)
+		mix[i] += aud[i];
+}
+
+static inline void mix_audio(struct audio_output_data *mixes, obs_source_t *source, uint32_t mixers, size_t channels,
+			     size_t sample_rate, struct ts_info *ts)
 {
 	size_t total_floats = AUDIO_OUTPUT_FRAMES;
 	size_t start_point = 0;
 
+	/* only mixes that are output somewhere and that the source actually
+	 * put audio into this tick */
+	mixers &= source->audio_output_mixes;
+	if (!mixers)
+		return;
+
 	if (source->audio_ts < ts->start || ts->end <= source->audio_ts)
 		return;
 
@@ -154,17 +215,12 @@ static inline void mix_audio(struct audio_output_data *mixes, obs_source_t *sour
 	}
 
 	for (size_t mix_idx = 0; mix_idx < MAX_AUDIO_MIXES; mix_idx++) {
-		for (size_t ch = 0; ch < channels; ch++) {
-			register float *mix = mixes[mix_idx].data[ch];
-			register float *aud = source->audio_output_buf[mix_idx][ch];
-			register float *end;
-
-			mix += start_point;
-			end = aud + total_floats;
+		if ((mixers & (1 << mix_idx)) == 0)
+			continue;
 
-			while (aud < end)
-				*(mix++) += *(aud++);
-		}
+		for (size_t ch = 0; ch < channels; ch++)
+			mix_float_buffer(mixes[mix_idx].data[ch] + start_point, source->audio_output_buf[mix_idx][ch],
+					 total_floats);
 	}
 }
 
@@ -603,6 +659,74 @@ static inline void clear_audio_output_buf(obs_source_t *source, struct obs_core_
 	}
 }
 
+/* below this, handing sources to the thread pool costs more than it saves */
+#define MIN_PARALLEL_AUDIO_SOURCES 8
+#define MIN_AUDIO_SOURCES_PER_BATCH 4
+#define MAX_AUDIO_RENDER_BATCHES 8
+
+struct audio_render_batch {
+	obs_source_t **sources;
+	size_t num;
+	uint32_t mixers;
+	size_t channels;
+	size_t sample_rate;
+	size_t size;
+};
+
+/* scenes, transitions and submixes read the audio of other sources */
+static inline bool audio_render_is_leaf(const obs_source_t *source)
+{
+	return !source->info.audio_render && !source->info.audio_mix;
+}
+
+static void render_audio_batch(void *param)
+{
+	struct audio_render_batch *batch = param;
+
+	for (size_t i = 0; i < batch->num; i++)
+		obs_source_audio_render(batch->sources[i], batch->mixers, batch->channels, batch->sample_rate,
+					batch->size);
+}
+
+/* Renders the sources that only depend on their own audio, splitting them up
+ * between the audio thread and the thread pool when there are enough of them.
+ * Leaves only touch their own buffers, so the order doesn't matter. */
+static void render_audio_leaves(struct obs_core_audio *audio, uint32_t mixers, size_t channels, size_t sample_rate,
+				size_t size)
+{
+	struct audio_render_batch batches[MAX_AUDIO_RENDER_BATCHES];
+	size_t num = audio->render_leaves.num;
+	size_t num_batches = num / MIN_AUDIO_SOURCES_PER_BATCH;
+
+	if (num_batches > MAX_AUDIO_RENDER_BATCHES)
+		num_batches = MAX_AUDIO_RENDER_BATCHES;
+	if (num < MIN_PARALLEL_AUDIO_SOURCES || !audio->render_group)
+		num_batches = 1;
+
+	for (size_t i = 0; i < num_batches; i++) {
+		size_t start = num * i / num_batches;
+		size_t end = num * (i + 1) / num_batches;
+
+		batches[i].sources = audio->render_leaves.array + start;
+		batches[i].num = end - start;
+		batches[i].mixers = mixers;
+		batches[i].channels = channels;
+		batches[i].sample_rate = sample_rate;
+		batches[i].size = size;
+	}
+
+	for (size_t i = 1; i < num_batches; i++) {
+		if (!os_task_group_submit(audio->render_group, render_audio_batch, &batches[i],
+					  OS_TASK_PRIORITY_HIGH))
+			render_audio_batch(&batches[i]);
+	}
+
+	render_audio_batch(&batches[0]);
+
+	if (num_batches > 1)
+		os_task_group_wait(audio->render_group);
+}
+
 bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in, uint64_t *out_ts, uint32_t mixers,
 		    struct audio_output_data *mixes)
 {
@@ -683,9 +807,21 @@ bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in, uint6
 
 	/* ------------------------------------------------ */
 	/* render audio data */
+	da_resize(audio->render_leaves, 0);
+	for (size_t i = 0; i < audio->render_order.num; i++) {
+		obs_source_t *source = audio->render_order.array[i];
+		if (audio_render_is_leaf(source))
+			da_push_back(audio->render_leaves, &source);
+	}
+
+	render_audio_leaves(audio, mixers, channels, sample_rate, audio_size);
+
+	/* sources that mix other sources come after everything they depend
+	 * on in the render order */
 	for (size_t i = 0; i < audio->render_order.num; i++) {
 		obs_source_t *source = audio->render_order.array[i];
-		obs_source_audio_render(source, mixers, channels, sample_rate, audio_size);
+		if (!audio_render_is_leaf(source))
+			obs_source_audio_render(source, mixers, channels, sample_rate, audio_size);
 		if (should_silence_monitored_source(source, audio))
 			clear_audio_output_buf(source, audio);
 
@@ -706,6 +842,7 @@ bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in, uint6
 #endif
 			} else {
 				pthread_mutex_lock(&source->audio_buf_mutex);
+				audio_input_flush(source);
 				bool rerender = ignore_audio(source, channels, sample_rate, ts.start);
 				pthread_mutex_unlock(&source->audio_buf_mutex);
 
@@ -744,7 +881,7 @@ bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in, uint6
 			pthread_mutex_lock(&source->audio_buf_mutex);
 
 			if (source->audio_output_buf[0][0] && source->audio_ts)
-				mix_audio(mixes, source, channels, sample_rate, &ts);
+				mix_audio(mixes, source, mixers, channels, sample_rate, &ts);
 
 			pthread_mutex_unlock(&source->audio_buf_mutex);
 		}
@@ -757,6 +894,7 @@ bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in, uint6
 	source = data->first_audio_source;
 	while (source) {
 		pthread_mutex_lock(&source->audio_buf_mutex);
+		audio_input_flush(source);
 		discard_audio(audio, source, channels, sample_rate, &ts);
 		pthread_mutex_unlock(&source->audio_buf_mutex);
 
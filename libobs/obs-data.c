@@ -27,12 +27,18 @@
 #include "graphics/quat.h"
 #include "obs-data.h"
 
-#include <jansson.h>
+#include <errno.h>
+#include <locale.h>
+#include <math.h>
+#include <stdarg.h>
+
+struct obs_data_arena;
 
 struct obs_data_item {
 	volatile long ref;
 	const char *name;
 	struct obs_data *parent;
+	struct obs_data_arena *arena;
 	UT_hash_handle hh;
 	enum obs_data_type type;
 	size_t name_len;
@@ -63,6 +69,100 @@ struct obs_data_number {
 	};
 };
 
+/* ------------------------------------------------------------------------- */
+/* Item arena
+ *
+ * Loading JSON creates a large number of small items that are usually freed
+ * together, so rather than allocating each one separately they're carved out
+ * of blocks shared by the items of the same object.  Every object loaded gets
+ * its own arena, so an object that outlives the document it was loaded from
+ * (such as the settings of a source) only keeps its own items' blocks alive.
+ * Each item holds a reference to its arena, and the blocks are freed along
+ * with the last item.  Items that need to grow are moved out to the heap.
+ *
+ * Blocks start small and double in size up to ARENA_MAX_BLOCK_SIZE, so that
+ * objects with only a few items don't waste much. */
+
+#define ARENA_MIN_BLOCK_SIZE 512
+#define ARENA_MAX_BLOCK_SIZE (64 * 1024)
+
+struct obs_data_arena_block {
+	struct obs_data_arena_block *next;
+	size_t size;
+	size_t used;
+};
+
+struct obs_data_arena {
+	volatile long ref;
+	size_t block_size;
+	struct obs_data_arena_block *blocks;
+};
+
+static inline size_t get_align_size(size_t size);
+
+static struct obs_data_arena *obs_data_arena_create(void)
+{
+	struct obs_data_arena *arena = bzalloc(sizeof(struct obs_data_arena));
+	arena->ref = 1;
+	arena->block_size = ARENA_MIN_BLOCK_SIZE;
+	return arena;
+}
+
+static void obs_data_arena_release(struct obs_data_arena *arena)
+{
+	if (!arena || os_atomic_dec_long(&arena->ref) != 0)
+		return;
+
+	struct obs_data_arena_block *block = arena->blocks;
+	while (block) {
+		struct obs_data_arena_block *next = block->next;
+		bfree(block);
+		block = next;
+	}
+
+	bfree(arena);
+}
+
+/* only used while the arena's object is being loaded, so not thread safe */
+static void *obs_data_arena_alloc(struct obs_data_arena *arena, size_t size)
+{
+	const size_t header_size = get_align_size(sizeof(struct obs_data_arena_block));
+	struct obs_data_arena_block *block = arena->blocks;
+	uint8_t *ptr;
+
+	size = get_align_size(size);
+
+	if (!block || block->size - block->used < size) {
+		size_t block_size = arena->block_size;
+
+		if (size > block_size / 4)
+			block_size = size;
+		else if (arena->block_size < ARENA_MAX_BLOCK_SIZE)
+			arena->block_size *= 2;
+
+		block = bmalloc(header_size + block_size);
+		block->size = block_size;
+		block->used = 0;
+
+		/* large allocations get their own block, keep filling the
+		 * current one */
+		if (block_size == size && arena->blocks) {
+			block->next = arena->blocks->next;
+			arena->blocks->next = block;
+		} else {
+			block->next = arena->blocks;
+			arena->blocks = block;
+		}
+	}
+
+	ptr = (uint8_t *)block + header_size + block->used;
+	block->used += size;
+
+	os_atomic_inc_long(&arena->ref);
+	memset(ptr, 0, size);
+	return ptr;
+}
+
 /* ------------------------------------------------------------------------- */
 /* Item structure, designed to be one allocation only */
 
@@ -261,8 +361,9 @@ static inline void item_autoselect_data_addref(struct obs_data_item *item)
 	}
 }
 
-static struct obs_data_item *obs_data_item_create(const char *name, const void *data, size_t size,
-						  enum obs_data_type type, bool default_data, bool autoselect_data)
+static struct obs_data_item *obs_data_item_create(struct obs_data_arena *arena, const char *name, const void *data,
+						  size_t size, enum obs_data_type type, bool default_data,
+						  bool autoselect_data)
 {
 	struct obs_data_item *item;
 	size_t name_size, total_size;
@@ -273,7 +374,12 @@ static struct obs_data_item *obs_data_item_create(const char *name, const void *
 	name_size = get_name_align_size(name);
 	total_size = name_size + sizeof(struct obs_data_item) + size;
 
-	item = bzalloc(total_size);
+	if (arena) {
+		item = obs_data_arena_alloc(arena, total_size);
+		item->arena = arena;
+	} else {
+		item = bzalloc(total_size);
+	}
 
 	item->capacity = total_size;
 	item->type = type;
@@ -329,7 +435,17 @@ static struct obs_data_item *obs_data_item_ensure_capacity(struct obs_data_item
 	struct obs_data *parent = item->parent;
 	obs_data_item_detach(item);
 
-	new_item = brealloc(item, new_size);
+	if (item->arena) {
+		struct obs_data_arena *arena = item->arena;
+
+		new_item = bmalloc(new_size);
+		memcpy(new_item, item, item->capacity);
+		new_item->arena = NULL;
+		obs_data_arena_release(arena);
+	} else {
+		new_item = brealloc(item, new_size);
+	}
+
 	new_item->capacity = new_size;
 	new_item->name = get_item_name(new_item);
 
@@ -347,7 +463,11 @@ static inline void obs_data_item_destroy(struct obs_data_item *item)
 	item_default_data_release(item);
 	item_autoselect_data_release(item);
 	obs_data_item_detach(item);
-	bfree(item);
+
+	if (item->arena)
+		obs_data_arena_release(item->arena);
+	else
+		bfree(item);
 }
 
 static inline void move_data(obs_data_item_t *old_item, void *old_data, obs_data_item_t *item, void *data, size_t len)
@@ -438,149 +558,764 @@ static inline void obs_data_item_set_autoselect_data(struct obs_data_item **p_it
 	*p_item = item;
 }
 
+static struct obs_data_item *get_item(struct obs_data *data, const char *name);
+
 /* ------------------------------------------------------------------------- */
+/* JSON reader
+ *
+ * Parses straight into items in a single pass, without building a jansson
+ * tree first.  It accepts what json_loads did with JSON_REJECT_DUPLICATES:
+ * the root must be an object or an array, the text must be valid UTF-8 and
+ * keys must be unique.  As before, nulls are dropped and arrays only keep
+ * their objects. */
+
+#define JSON_MAX_DEPTH 2048
+
+struct json_reader {
+	const char *start;
+	const char *p;
+	struct obs_data_arena *arena;
+
+	/* decoded keys and strings, used as a stack while nesting */
+	DARRAY(char) text;
+	size_t depth;
+
+	const char *error_pos;
+	char error[128];
+};
+
+static bool json_error(struct json_reader *r, const char *format, ...)
+{
+	va_list args;
+
+	if (r->error_pos)
+		return false;
+
+	va_start(args, format);
+	vsnprintf(r->error, sizeof(r->error), format, args);
+	va_end(args);
+
+	r->error_pos = r->p;
+	return false;
+}
+
+static int json_error_line(const struct json_reader *r)
+{
+	int line = 1;
 
-static void obs_data_add_json_item(obs_data_t *data, const char *key, json_t *json);
+	for (const char *p = r->start; p < r->error_pos; p++) {
+		if (*p == '\n')
+			line++;
+	}
+
+	return line;
+}
 
-static inline void obs_data_add_json_object_data(obs_data_t *data, json_t *jobj)
+/* returns the length of the UTF-8 sequence at str, or 0 if it's invalid */
+static size_t utf8_sequence_length(const uint8_t *str)
 {
-	const char *item_key;
-	json_t *jitem;
+	uint8_t c = str[0];
+	uint32_t codepoint;
+	size_t len;
 
-	json_object_foreach (jobj, item_key, jitem) {
-		obs_data_add_json_item(data, item_key, jitem);
+	if (c < 0x80)
+		return 1;
+	else if (c < 0xC2)
+		return 0;
+	else if (c < 0xE0)
+		len = 2;
+	else if (c < 0xF0)
+		len = 3;
+	else if (c < 0xF5)
+		len = 4;
+	else
+		return 0;
+
+	codepoint = c & (0x7F >> len);
+
+	for (size_t i = 1; i < len; i++) {
+		if ((str[i] & 0xC0) != 0x80)
+			return 0;
+		codepoint = (codepoint << 6) | (str[i] & 0x3F);
 	}
+
+	if ((len == 3 && codepoint < 0x800) || (len == 4 && codepoint < 0x10000) || codepoint > 0x10FFFF ||
+	    (codepoint >= 0xD800 && codepoint <= 0xDFFF))
+		return 0;
+
+	return len;
 }
 
-static inline void obs_data_add_json_object(obs_data_t *data, const char *key, json_t *jobj)
+static bool utf8_valid(const char *str)
 {
-	obs_data_t *sub_obj = obs_data_create();
+	const uint8_t *p = (const uint8_t *)str;
+
+	while (*p) {
+		size_t len = utf8_sequence_length(p);
+		if (!len)
+			return false;
+		p += len;
+	}
+
+	return true;
+}
 
-	obs_data_add_json_object_data(sub_obj, jobj);
-	obs_data_set_obj(data, key, sub_obj);
-	obs_data_release(sub_obj);
+static inline void json_skip_space(struct json_reader *r)
+{
+	while (*r->p == ' ' || *r->p == '\t' || *r->p == '\n' || *r->p == '\r')
+		r->p++;
 }
 
-static void obs_data_add_json_array(obs_data_t *data, const char *key, json_t *jarray)
+static bool json_read_hex4(struct json_reader *r, const char *p, uint32_t *val)
 {
-	obs_data_array_t *array = obs_data_array_create();
-	size_t idx;
-	json_t *jitem;
+	*val = 0;
 
-	json_array_foreach (jarray, idx, jitem) {
-		obs_data_t *item;
+	for (size_t i = 0; i < 4; i++) {
+		char c = p[i];
+		uint32_t digit;
 
-		if (!json_is_object(jitem))
-			continue;
+		if (c >= '0' && c <= '9')
+			digit = (uint32_t)(c - '0');
+		else if (c >= 'a' && c <= 'f')
+			digit = (uint32_t)(c - 'a' + 10);
+		else if (c >= 'A' && c <= 'F')
+			digit = (uint32_t)(c - 'A' + 10);
+		else
+			return json_error(r, "invalid escape");
 
-		item = obs_data_create();
-		obs_data_add_json_object_data(item, jitem);
-		obs_data_array_push_back(array, item);
-		obs_data_release(item);
+		*val = (*val << 4) | digit;
 	}
 
-	obs_data_set_array(data, key, array);
-	obs_data_array_release(array);
+	return true;
 }
 
-static void obs_data_add_json_item(obs_data_t *data, const char *key, json_t *json)
+static void json_push_codepoint(struct json_reader *r, uint32_t codepoint)
 {
-	if (json_is_object(json))
-		obs_data_add_json_object(data, key, json);
-	else if (json_is_array(json))
-		obs_data_add_json_array(data, key, json);
-	else if (json_is_string(json))
-		obs_data_set_string(data, key, json_string_value(json));
-	else if (json_is_integer(json))
-		obs_data_set_int(data, key, json_integer_value(json));
-	else if (json_is_real(json))
-		obs_data_set_double(data, key, json_real_value(json));
-	else if (json_is_true(json))
-		obs_data_set_bool(data, key, true);
-	else if (json_is_false(json))
-		obs_data_set_bool(data, key, false);
+	char utf8[4];
+	size_t len;
+
+	if (codepoint < 0x80) {
+		utf8[0] = (char)codepoint;
+		len = 1;
+	} else if (codepoint < 0x800) {
+		utf8[0] = (char)(0xC0 | (codepoint >> 6));
+		utf8[1] = (char)(0x80 | (codepoint & 0x3F));
+		len = 2;
+	} else if (codepoint < 0x10000) {
+		utf8[0] = (char)(0xE0 | (codepoint >> 12));
+		utf8[1] = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+		utf8[2] = (char)(0x80 | (codepoint & 0x3F));
+		len = 3;
+	} else {
+		utf8[0] = (char)(0xF0 | (codepoint >> 18));
+		utf8[1] = (char)(0x80 | ((codepoint >> 12) & 0x3F));
+		utf8[2] = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+		utf8[3] = (char)(0x80 | (codepoint & 0x3F));
+		len = 4;
+	}
+
+	da_push_back_array(r->text, utf8, len);
 }
 
-/* ------------------------------------------------------------------------- */
+static bool json_read_unicode_escape(struct json_reader *r, const char **pp)
+{
+	const char *p = *pp;
+	uint32_t codepoint;
+	uint32_t low;
+
+	if (!json_read_hex4(r, p, &codepoint))
+		return false;
+	p += 4;
+
+	if (codepoint >= 0xD800 && codepoint <= 0xDBFF) {
+		if (p[0] != '\\' || p[1] != 'u')
+			return json_error(r, "invalid Unicode '\\u%04X'", codepoint);
+		if (!json_read_hex4(r, p + 2, &low))
+			return false;
+		if (low < 0xDC00 || low > 0xDFFF)
+			return json_error(r, "invalid Unicode '\\u%04X\\u%04X'", codepoint, low);
+
+		codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+		p += 6;
+
+	} else if (codepoint >= 0xDC00 && codepoint <= 0xDFFF) {
+		return json_error(r, "invalid Unicode '\\u%04X'", codepoint);
+
+	} else if (!codepoint) {
+		return json_error(r, "\\u0000 is not allowed");
+	}
+
+	json_push_codepoint(r, codepoint);
+	*pp = p;
+	return true;
+}
 
-static inline void set_json_string(json_t *json, const char *name, obs_data_item_t *item)
+/* decodes the string at the current position onto the text stack */
+static bool json_read_string(struct json_reader *r, size_t *offset)
 {
-	const char *val = obs_data_item_get_string(item);
-	json_object_set_new(json, name, json_string(val));
+	const char *p = r->p + 1;
+
+	*offset = r->text.num;
+
+	for (;;) {
+		const char *run = p;
+		uint8_t c;
+
+		while ((uint8_t)*p >= 0x20 && (uint8_t)*p < 0x80 && *p != '"' && *p != '\\')
+			p++;
+		if (p != run)
+			da_push_back_array(r->text, run, (size_t)(p - run));
+
+		r->p = p;
+		c = (uint8_t)*p;
+
+		if (c == '"') {
+			p++;
+			break;
+
+		} else if (c >= 0x80) {
+			size_t len = utf8_sequence_length((const uint8_t *)p);
+			if (!len)
+				return json_error(r, "unable to decode byte 0x%x", c);
+
+			da_push_back_array(r->text, p, len);
+			p += len;
+			continue;
+
+		} else if (!c) {
+			return json_error(r, "premature end of input");
+
+		} else if (c != '\\') {
+			return json_error(r, "control character 0x%x", c);
+		}
+
+		char ch;
+		switch (*++p) {
+		case '"':
+		case '\\':
+		case '/':
+			ch = *p;
+			break;
+		case 'b':
+			ch = '\b';
+			break;
+		case 'f':
+			ch = '\f';
+			break;
+		case 'n':
+			ch = '\n';
+			break;
+		case 'r':
+			ch = '\r';
+			break;
+		case 't':
+			ch = '\t';
+			break;
+		case 'u':
+			p++;
+			if (!json_read_unicode_escape(r, &p))
+				return false;
+			continue;
+		default:
+			return json_error(r, "invalid escape");
+		}
+
+		da_push_back(r->text, &ch);
+		p++;
+	}
+
+	char end = 0;
+	da_push_back(r->text, &end);
+
+	r->p = p;
+	return true;
 }
 
-static inline void set_json_number(json_t *json, const char *name, obs_data_item_t *item)
+/* strtod uses the locale's decimal point */
+static double json_strtod(const char *str, size_t len, bool *overflow)
 {
-	enum obs_data_number_type type = obs_data_item_numtype(item);
+	char point = *localeconv()->decimal_point;
+	struct dstr long_str = {0};
+	char buf[64];
+	char *copy = buf;
+	double val;
 
-	if (type == OBS_DATA_NUM_INT) {
-		long long val = obs_data_item_get_int(item);
-		json_object_set_new(json, name, json_integer(val));
+	if (len < sizeof(buf)) {
+		memcpy(buf, str, len);
+		buf[len] = 0;
 	} else {
-		double val = obs_data_item_get_double(item);
-		json_object_set_new(json, name, json_real(val));
+		dstr_ncopy(&long_str, str, len);
+		copy = long_str.array;
+	}
+
+	if (point != '.') {
+		char *dot = strchr(copy, '.');
+		if (dot)
+			*dot = point;
 	}
+
+	errno = 0;
+	val = strtod(copy, NULL);
+	*overflow = errno == ERANGE && (val == HUGE_VAL || val == -HUGE_VAL);
+
+	dstr_free(&long_str);
+	return val;
 }
 
-static inline void set_json_bool(json_t *json, const char *name, obs_data_item_t *item)
+static inline bool is_digit(char c)
 {
-	bool val = obs_data_item_get_bool(item);
-	json_object_set_new(json, name, val ? json_true() : json_false());
+	return c >= '0' && c <= '9';
 }
 
-static json_t *obs_data_to_json(obs_data_t *data, bool with_defaults);
+static bool json_read_number(struct json_reader *r, struct obs_data_number *num)
+{
+	const char *start = r->p;
+	const char *p = start;
+	bool real = false;
+
+	if (*p == '-')
+		p++;
+
+	if (*p == '0') {
+		p++;
+	} else if (is_digit(*p)) {
+		while (is_digit(*p))
+			p++;
+	} else {
+		return json_error(r, "invalid token");
+	}
+
+	if (*p == '.') {
+		if (!is_digit(*++p))
+			return json_error(r, "invalid token");
+		while (is_digit(*p))
+			p++;
+		real = true;
+	}
+
+	if (*p == 'e' || *p == 'E') {
+		p++;
+		if (*p == '+' || *p == '-')
+			p++;
+		if (!is_digit(*p))
+			return json_error(r, "invalid token");
+		while (is_digit(*p))
+			p++;
+		real = true;
+	}
+
+	if (real) {
+		bool overflow;
+
+		num->type = OBS_DATA_NUM_DOUBLE;
+		num->double_val = json_strtod(start, (size_t)(p - start), &overflow);
+		if (overflow)
+			return json_error(r, "real number overflow");
+	} else {
+		errno = 0;
+		num->type = OBS_DATA_NUM_INT;
+		num->int_val = strtoll(start, NULL, 10);
+		if (errno == ERANGE)
+			return json_error(r, *start == '-' ? "too big negative integer" : "too big integer");
+	}
+
+	r->p = p;
+	return true;
+}
 
-static inline void set_json_obj(json_t *json, const char *name, obs_data_item_t *item, bool with_defaults)
+static void json_add_item(struct json_reader *r, obs_data_t *data, size_t key_offset, const void *ptr, size_t size,
+			  enum obs_data_type type)
 {
-	obs_data_t *obj = obs_data_item_get_obj(item);
-	json_object_set_new(json, name, obs_data_to_json(obj, with_defaults));
-	obs_data_release(obj);
+	const char *name = r->text.array + key_offset;
+	struct obs_data_item *item = obs_data_item_create(r->arena, name, ptr, size, type, false, false);
+
+	item->parent = data;
+	HASH_ADD_STR(data->items, name, item);
 }
 
-static inline void set_json_array(json_t *json, const char *name, obs_data_item_t *item, bool with_defaults)
+static bool json_read_object(struct json_reader *r, obs_data_t *data);
+static bool json_read_array(struct json_reader *r, obs_data_array_t *array);
+
+/* reads a value into data under the key at key_offset of the text stack, or
+ * only validates it if data is NULL */
+static bool json_read_value(struct json_reader *r, obs_data_t *data, size_t key_offset)
 {
-	json_t *jarray = json_array();
-	obs_data_array_t *array = obs_data_item_get_array(item);
-	size_t count = obs_data_array_count(array);
+	struct obs_data_number num;
+	bool success;
+	bool val;
+
+	json_skip_space(r);
 
-	for (size_t idx = 0; idx < count; idx++) {
-		obs_data_t *sub_item = obs_data_array_item(array, idx);
-		json_t *jitem = obs_data_to_json(sub_item, with_defaults);
-		json_array_append_new(jarray, jitem);
-		obs_data_release(sub_item);
+	switch (*r->p) {
+	case '{': {
+		obs_data_t *obj = obs_data_create();
+		success = json_read_object(r, obj);
+		if (success && data)
+			json_add_item(r, data, key_offset, &obj, sizeof(obj), OBS_DATA_OBJECT);
+		obs_data_release(obj);
+		return success;
 	}
+	case '[': {
+		obs_data_array_t *array = obs_data_array_create();
+		success = json_read_array(r, array);
+		if (success && data)
+			json_add_item(r, data, key_offset, &array, sizeof(array), OBS_DATA_ARRAY);
+		obs_data_array_release(array);
+		return success;
+	}
+	case '"': {
+		size_t offset;
+		if (!json_read_string(r, &offset))
+			return false;
+		if (data)
+			json_add_item(r, data, key_offset, r->text.array + offset, r->text.num - offset,
+				      OBS_DATA_STRING);
+		r->text.num = offset;
+		return true;
+	}
+	case 't':
+	case 'f':
+		val = *r->p == 't';
+		if (strncmp(r->p, val ? "true" : "false", val ? 4 : 5) != 0)
+			return json_error(r, "invalid token");
+		r->p += val ? 4 : 5;
+		if (data)
+			json_add_item(r, data, key_offset, &val, sizeof(val), OBS_DATA_BOOLEAN);
+		return true;
+	case 'n':
+		if (strncmp(r->p, "null", 4) != 0)
+			return json_error(r, "invalid token");
+		r->p += 4;
+		return true;
+	default:
+		if (!json_read_number(r, &num))
+			return false;
+		if (data)
+			json_add_item(r, data, key_offset, &num, sizeof(num), OBS_DATA_NUMBER);
+		return true;
+	}
+}
+
+static bool json_read_object_items(struct json_reader *r, obs_data_t *data)
+{
+	r->p++;
+	if (++r->depth > JSON_MAX_DEPTH)
+		return json_error(r, "maximum parsing depth reached");
+
+	json_skip_space(r);
+	if (*r->p == '}') {
+		r->p++;
+		r->depth--;
+		return true;
+	}
+
+	for (;;) {
+		size_t key_offset;
+		bool success;
+
+		json_skip_space(r);
+		if (*r->p != '"')
+			return json_error(r, "string or '}' expected");
+		if (!json_read_string(r, &key_offset))
+			return false;
+		if (get_item(data, r->text.array + key_offset))
+			return json_error(r, "duplicate object key");
+
+		json_skip_space(r);
+		if (*r->p != ':')
+			return json_error(r, "':' expected");
+		r->p++;
+
+		success = json_read_value(r, data, key_offset);
+		r->text.num = key_offset;
+		if (!success)
+			return false;
+
+		json_skip_space(r);
+		if (*r->p == '}')
+			break;
+		if (*r->p != ',')
+			return json_error(r, "'}' expected");
+		r->p++;
+	}
+
+	r->p++;
+	r->depth--;
+	return true;
+}
+
+/* the items of every object go into an arena of their own */
+static bool json_read_object(struct json_reader *r, obs_data_t *data)
+{
+	struct obs_data_arena *parent_arena = r->arena;
+	bool success;
+
+	r->arena = obs_data_arena_create();
+	success = json_read_object_items(r, data);
+	obs_data_arena_release(r->arena);
 
-	json_object_set_new(json, name, jarray);
-	obs_data_array_release(array);
+	r->arena = parent_arena;
+	return success;
 }
 
-static json_t *obs_data_to_json(obs_data_t *data, bool with_defaults)
+static bool json_read_array(struct json_reader *r, obs_data_array_t *array)
 {
-	json_t *json = json_object();
+	r->p++;
+	if (++r->depth > JSON_MAX_DEPTH)
+		return json_error(r, "maximum parsing depth reached");
 
-	obs_data_item_t *item = NULL;
-	obs_data_item_t *temp = NULL;
+	json_skip_space(r);
+	if (*r->p == ']') {
+		r->p++;
+		r->depth--;
+		return true;
+	}
 
-	HASH_ITER (hh, data->items, item, temp) {
-		enum obs_data_type type = obs_data_item_gettype(item);
-		const char *name = get_item_name(item);
+	for (;;) {
+		json_skip_space(r);
+
+		if (*r->p == '{') {
+			obs_data_t *obj = obs_data_create();
+			bool success = json_read_object(r, obj);
+			if (success)
+				obs_data_array_push_back(array, obj);
+			obs_data_release(obj);
+			if (!success)
+				return false;
+
+		} else if (!json_read_value(r, NULL, 0)) {
+			return false;
+		}
+
+		json_skip_space(r);
+		if (*r->p == ']')
+			break;
+		if (*r->p != ',')
+			return json_error(r, "']' expected");
+		r->p++;
+	}
+
+	r->p++;
+	r->depth--;
+	return true;
+}
+
+static bool json_read_root(struct json_reader *r, obs_data_t *data)
+{
+	bool success;
+
+	json_skip_space(r);
+
+	if (*r->p == '{') {
+		success = json_read_object(r, data);
+	} else if (*r->p == '[') {
+		/* valid, but there's nothing to load from it */
+		obs_data_array_t *array = obs_data_array_create();
+		success = json_read_array(r, array);
+		obs_data_array_release(array);
+	} else {
+		return json_error(r, "'[' or '{' expected");
+	}
+
+	if (!success)
+		return false;
+
+	json_skip_space(r);
+	if (*r->p)
+		return json_error(r, "end of file expected");
+
+	return true;
+}
+
+/* ------------------------------------------------------------------------- */
+/* JSON writer
+ *
+ * Writes the items straight into a string, with the same output json_dumps
+ * gave with JSON_PRESERVE_ORDER and either JSON_COMPACT or JSON_INDENT(4).
+ * Like with jansson, items whose name or string isn't valid UTF-8 and numbers
+ * that aren't finite are left out. */
+
+#define JSON_INDENT_SPACES 4
+
+struct json_writer {
+	struct dstr out;
+	bool pretty;
+	bool with_defaults;
+};
+
+static void json_write_indent(struct json_writer *w, size_t depth)
+{
+	static const char spaces[] = "                                ";
+	size_t count = depth * JSON_INDENT_SPACES;
+
+	if (!w->pretty)
+		return;
+
+	dstr_cat_ch(&w->out, '\n');
+
+	while (count) {
+		size_t len = count < sizeof(spaces) - 1 ? count : sizeof(spaces) - 1;
+		dstr_ncat(&w->out, spaces, len);
+		count -= len;
+	}
+}
+
+static void json_write_string(struct dstr *out, const char *str)
+{
+	const char *run = str;
+	const char *p = str;
+
+	dstr_cat_ch(out, '"');
 
-		if (!with_defaults && !obs_data_item_has_user_value(item))
+	for (; *p; p++) {
+		uint8_t c = (uint8_t)*p;
+		char escape[8];
+
+		if (c >= 0x20 && c != '"' && c != '\\')
 			continue;
 
-		if (type == OBS_DATA_STRING)
-			set_json_string(json, name, item);
-		else if (type == OBS_DATA_NUMBER)
-			set_json_number(json, name, item);
-		else if (type == OBS_DATA_BOOLEAN)
-			set_json_bool(json, name, item);
-		else if (type == OBS_DATA_OBJECT)
-			set_json_obj(json, name, item, with_defaults);
-		else if (type == OBS_DATA_ARRAY)
-			set_json_array(json, name, item, with_defaults);
+		dstr_ncat(out, run, (size_t)(p - run));
+		run = p + 1;
+
+		switch (c) {
+		case '"':
+			dstr_cat(out, "\\\"");
+			break;
+		case '\\':
+			dstr_cat(out, "\\\\");
+			break;
+		case '\b':
+			dstr_cat(out, "\\b");
+			break;
+		case '\f':
+			dstr_cat(out, "\\f");
+			break;
+		case '\n':
+			dstr_cat(out, "\\n");
+			break;
+		case '\r':
+			dstr_cat(out, "\\r");
+			break;
+		case '\t':
+			dstr_cat(out, "\\t");
+			break;
+		default:
+			snprintf(escape, sizeof(escape), "\\u%04X", c);
+			dstr_cat(out, escape);
+		}
+	}
+
+	dstr_ncat(out, run, (size_t)(p - run));
+	dstr_cat_ch(out, '"');
+}
+
+static bool json_item_writable(obs_data_item_t *item)
+{
+	if (!utf8_valid(get_item_name(item)))
+		return false;
+
+	switch (item->type) {
+	case OBS_DATA_STRING:
+		return utf8_valid(obs_data_item_get_string(item));
+	case OBS_DATA_NUMBER:
+		return obs_data_item_numtype(item) == OBS_DATA_NUM_INT || isfinite(obs_data_item_get_double(item));
+	case OBS_DATA_BOOLEAN:
+	case OBS_DATA_OBJECT:
+	case OBS_DATA_ARRAY:
+		return true;
+	case OBS_DATA_NULL:
+		break;
+	}
+
+	return false;
+}
+
+static void json_write_object(struct json_writer *w, obs_data_t *data, size_t depth);
+
+static void json_write_array(struct json_writer *w, obs_data_array_t *array, size_t depth)
+{
+	size_t count = array ? array->objects.num : 0;
+
+	if (!count) {
+		dstr_cat(&w->out, "[]");
+		return;
+	}
+
+	dstr_cat_ch(&w->out, '[');
+
+	for (size_t i = 0; i < count; i++) {
+		if (i)
+			dstr_cat_ch(&w->out, ',');
+		json_write_indent(w, depth + 1);
+		json_write_object(w, array->objects.array[i], depth + 1);
+	}
+
+	json_write_indent(w, depth);
+	dstr_cat_ch(&w->out, ']');
+}
+
+static void json_write_number(struct json_writer *w, obs_data_item_t *item)
+{
+	char buf[64];
+	int len;
+
+	/* the length is what counts, os_dtostr can leave stray characters
+	 * after it when it shortens the exponent */
+	if (obs_data_item_numtype(item) == OBS_DATA_NUM_INT)
+		len = snprintf(buf, sizeof(buf), "%lld", obs_data_item_get_int(item));
+	else
+		len = os_dtostr(obs_data_item_get_double(item), buf, sizeof(buf));
+
+	if (len > 0)
+		dstr_ncat(&w->out, buf, (size_t)len);
+	else
+		dstr_cat(&w->out, "0.0");
+}
+
+static void json_write_object(struct json_writer *w, obs_data_t *data, size_t depth)
+{
+	obs_data_item_t *item = NULL;
+	obs_data_item_t *temp = NULL;
+	bool empty = true;
+
+	dstr_cat_ch(&w->out, '{');
+
+	if (data) {
+		HASH_ITER (hh, data->items, item, temp) {
+			if (!w->with_defaults && !obs_data_item_has_user_value(item))
+				continue;
+			if (!json_item_writable(item))
+				continue;
+
+			if (!empty)
+				dstr_cat_ch(&w->out, ',');
+			empty = false;
+
+			json_write_indent(w, depth + 1);
+			json_write_string(&w->out, get_item_name(item));
+			dstr_cat(&w->out, w->pretty ? ": " : ":");
+
+			if (item->type == OBS_DATA_STRING) {
+				json_write_string(&w->out, obs_data_item_get_string(item));
+			} else if (item->type == OBS_DATA_NUMBER) {
+				json_write_number(w, item);
+			} else if (item->type == OBS_DATA_BOOLEAN) {
+				dstr_cat(&w->out, obs_data_item_get_bool(item) ? "true" : "false");
+			} else if (item->type == OBS_DATA_OBJECT) {
+				obs_data_t *obj = obs_data_item_get_obj(item);
+				json_write_object(w, obj, depth + 1);
+				obs_data_release(obj);
+			} else if (item->type == OBS_DATA_ARRAY) {
+				obs_data_array_t *array = obs_data_item_get_array(item);
+				json_write_array(w, array, depth + 1);
+				obs_data_array_release(array);
+			}
+		}
 	}
 
-	return json;
+	if (!empty)
+		json_write_indent(w, depth);
+	dstr_cat_ch(&w->out, '}');
 }
 
 /* ------------------------------------------------------------------------- */
@@ -596,22 +1331,21 @@ obs_data_t *obs_data_create()
 obs_data_t *obs_data_create_from_json(const char *json_string)
 {
 	obs_data_t *data = obs_data_create();
+	struct json_reader reader = {0};
 
-	json_error_t error;
-	json_t *root = json_loads(json_string, JSON_REJECT_DUPLICATES, &error);
+	reader.start = json_string ? json_string : "";
+	reader.p = reader.start;
 
-	if (root) {
-		obs_data_add_json_object_data(data, root);
-		json_decref(root);
-	} else {
+	if (!json_read_root(&reader, data)) {
 		blog(LOG_ERROR,
 		     "obs-data.c: [obs_data_create_from_json] "
 		     "Failed reading json string (%d): %s",
-		     error.line, error.text);
+		     json_error_line(&reader), reader.error);
 		obs_data_release(data);
 		data = NULL;
 	}
 
+	da_free(reader.text);
 	return data;
 }
 
@@ -672,8 +1406,7 @@ static inline void obs_data_destroy(struct obs_data *data)
 		obs_data_item_release(&item);
 	}
 
-	/* NOTE: don't use bfree for json text, allocated by json */
-	free(data->json);
+	bfree(data->json);
 	bfree(data);
 }
 
@@ -691,20 +1424,14 @@ static const char *obs_data_get_json_internal(obs_data_t *data, bool pretty, boo
 	if (!data)
 		return NULL;
 
-	size_t flags = JSON_PRESERVE_ORDER;
-
-	if (pretty)
-		flags |= JSON_INDENT(4);
-	else
-		flags |= JSON_COMPACT;
+	struct json_writer writer = {0};
+	writer.pretty = pretty;
+	writer.with_defaults = with_defaults;
 
-	/* NOTE: don't use libobs bfree for json text */
-	free(data->json);
-	data->json = NULL;
+	json_write_object(&writer, data, 0);
 
-	json_t *root = obs_data_to_json(data, with_defaults);
-	data->json = json_dumps(root, flags);
-	json_decref(root);
+	bfree(data->json);
+	data->json = writer.out.array;
 
 	return data->json;
 }
@@ -868,7 +1595,7 @@ static void set_item_data(struct obs_data *data, struct obs_data_item **item, co
 	obs_data_item_t *new_item = NULL;
 
 	if ((!item || !*item) && data) {
-		new_item = obs_data_item_create(name, ptr, size, type, default_data, autoselect_data);
+		new_item = obs_data_item_create(NULL, name, ptr, size, type, default_data, autoselect_data);
 		new_item->parent = data;
 		HASH_ADD_STR(data->items, name, new_item);
 
@@ -2169,3 +2896,282 @@ bool obs_data_item_get_autoselect_frames_per_second(obs_data_item_t *item, struc
 {
 	return get_frames_per_second(obs_data_item_get_autoselect_obj(item), fps, option);
 }
+
+/* ------------------------------------------------------------------------- */
+/* Snapshots */
+
+struct obs_data_snapshot_entry {
+	uint32_t hash;
+	enum obs_data_type type;
+	const char *name;
+
+	union {
+		struct obs_data_number num;
+		bool boolean;
+		const char *str;
+		obs_data_snapshot_t *obj;
+		struct {
+			obs_data_snapshot_t **items;
+			size_t count;
+		} array;
+	};
+};
+
+/* The entries (sorted by hash), the item pointers of arrays and the strings
+ * all live in the same allocation as the snapshot itself. */
+struct obs_data_snapshot {
+	volatile long ref;
+	size_t count;
+	struct obs_data_snapshot_entry *entries;
+};
+
+/* FNV-1a */
+static inline uint32_t get_key_hash(const char *name)
+{
+	uint32_t hash = 2166136261u;
+
+	while (*name) {
+		hash ^= (uint8_t)*name++;
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+obs_data_key_t obs_data_key(const char *name)
+{
+	obs_data_key_t key = {name ? name : "", 0};
+	key.hash = get_key_hash(key.name);
+	return key;
+}
+
+static inline bool snapshot_item_valid(struct obs_data_item *item)
+{
+	return item->type != OBS_DATA_NULL && get_item_data(item) != NULL;
+}
+
+static inline const char *snapshot_copy_string(char **text, const char *str)
+{
+	size_t size = strlen(str) + 1;
+	char *copy = *text;
+
+	memcpy(copy, str, size);
+	*text += size;
+	return copy;
+}
+
+static int compare_snapshot_entries(const void *a, const void *b)
+{
+	const struct obs_data_snapshot_entry *entry_a = a;
+	const struct obs_data_snapshot_entry *entry_b = b;
+
+	if (entry_a->hash != entry_b->hash)
+		return entry_a->hash < entry_b->hash ? -1 : 1;
+	return strcmp(entry_a->name, entry_b->name);
+}
+
+obs_data_snapshot_t *obs_data_snapshot_create(obs_data_t *data)
+{
+	struct obs_data_item *item, *temp;
+	struct obs_data_snapshot_entry *entry;
+	obs_data_snapshot_t *snapshot;
+	obs_data_snapshot_t **items;
+	size_t count = 0;
+	size_t num_items = 0;
+	size_t text_size = 0;
+	char *text;
+
+	if (!data)
+		return NULL;
+
+	HASH_ITER (hh, data->items, item, temp) {
+		if (!snapshot_item_valid(item))
+			continue;
+
+		count++;
+		text_size += strlen(get_item_name(item)) + 1;
+
+		if (item->type == OBS_DATA_STRING) {
+			text_size += strlen(get_item_data(item)) + 1;
+		} else if (item->type == OBS_DATA_ARRAY) {
+			obs_data_array_t *array = get_item_array(item);
+			if (array)
+				num_items += array->objects.num;
+		}
+	}
+
+	snapshot = bmalloc(sizeof(*snapshot) + count * sizeof(*entry) + num_items * sizeof(*items) + text_size);
+	snapshot->ref = 1;
+	snapshot->count = count;
+	snapshot->entries = (struct obs_data_snapshot_entry *)(snapshot + 1);
+	items = (obs_data_snapshot_t **)(snapshot->entries + count);
+	text = (char *)(items + num_items);
+
+	entry = snapshot->entries;
+
+	HASH_ITER (hh, data->items, item, temp) {
+		if (!snapshot_item_valid(item))
+			continue;
+
+		void *value = get_item_data(item);
+
+		memset(entry, 0, sizeof(*entry));
+		entry->name = snapshot_copy_string(&text, get_item_name(item));
+		entry->hash = get_key_hash(entry->name);
+		entry->type = item->type;
+
+		switch (item->type) {
+		case OBS_DATA_NULL:
+			break;
+		case OBS_DATA_STRING:
+			entry->str = snapshot_copy_string(&text, value);
+			break;
+		case OBS_DATA_NUMBER:
+			entry->num = *(struct obs_data_number *)value;
+			break;
+		case OBS_DATA_BOOLEAN:
+			entry->boolean = *(bool *)value;
+			break;
+		case OBS_DATA_OBJECT:
+			entry->obj = obs_data_snapshot_create(*(obs_data_t **)value);
+			break;
+		case OBS_DATA_ARRAY: {
+			obs_data_array_t *array = *(obs_data_array_t **)value;
+
+			entry->array.items = items;
+			entry->array.count = array ? array->objects.num : 0;
+
+			for (size_t i = 0; i < entry->array.count; i++)
+				*(items++) = obs_data_snapshot_create(array->objects.array[i]);
+			break;
+		}
+		}
+
+		entry++;
+	}
+
+	qsort(snapshot->entries, count, sizeof(*entry), compare_snapshot_entries);
+	return snapshot;
+}
+
+void obs_data_snapshot_addref(obs_data_snapshot_t *snapshot)
+{
+	if (snapshot)
+		os_atomic_inc_long(&snapshot->ref);
+}
+
+static void obs_data_snapshot_destroy(obs_data_snapshot_t *snapshot)
+{
+	for (size_t i = 0; i < snapshot->count; i++) {
+		struct obs_data_snapshot_entry *entry = &snapshot->entries[i];
+
+		if (entry->type == OBS_DATA_OBJECT) {
+			obs_data_snapshot_release(entry->obj);
+		} else if (entry->type == OBS_DATA_ARRAY) {
+			for (size_t j = 0; j < entry->array.count; j++)
+				obs_data_snapshot_release(entry->array.items[j]);
+		}
+	}
+
+	bfree(snapshot);
+}
+
+void obs_data_snapshot_release(obs_data_snapshot_t *snapshot)
+{
+	if (!snapshot)
+		return;
+
+	if (os_atomic_dec_long(&snapshot->ref) == 0)
+		obs_data_snapshot_destroy(snapshot);
+}
+
+static const struct obs_data_snapshot_entry *get_snapshot_entry(const obs_data_snapshot_t *snapshot,
+								obs_data_key_t key)
+{
+	size_t lo = 0;
+	size_t hi;
+
+	if (!snapshot || !key.name)
+		return NULL;
+
+	hi = snapshot->count;
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+
+		if (snapshot->entries[mid].hash < key.hash)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	for (; lo < snapshot->count && snapshot->entries[lo].hash == key.hash; lo++) {
+		if (strcmp(snapshot->entries[lo].name, key.name) == 0)
+			return &snapshot->entries[lo];
+	}
+
+	return NULL;
+}
+
+static inline const struct obs_data_snapshot_entry *
+get_snapshot_entry_type(const obs_data_snapshot_t *snapshot, obs_data_key_t key, enum obs_data_type type)
+{
+	const struct obs_data_snapshot_entry *entry = get_snapshot_entry(snapshot, key);
+	return entry && entry->type == type ? entry : NULL;
+}
+
+bool obs_data_snapshot_has_value(const obs_data_snapshot_t *snapshot, obs_data_key_t key)
+{
+	return get_snapshot_entry(snapshot, key) != NULL;
+}
+
+const char *obs_data_snapshot_get_string(const obs_data_snapshot_t *snapshot, obs_data_key_t key)
+{
+	const struct obs_data_snapshot_entry *entry = get_snapshot_entry_type(snapshot, key, OBS_DATA_STRING);
+	return entry ? entry->str : "";
+}
+
+long long obs_data_snapshot_get_int(const obs_data_snapshot_t *snapshot, obs_data_key_t key)
+{
+	const struct obs_data_snapshot_entry *entry = get_snapshot_entry_type(snapshot, key, OBS_DATA_NUMBER);
+
+	if (!entry)
+		return 0;
+
+	return (entry->num.type == OBS_DATA_NUM_INT) ? entry->num.int_val : (long long)entry->num.double_val;
+}
+
+double obs_data_snapshot_get_double(const obs_data_snapshot_t *snapshot, obs_data_key_t key)
+{
+	const struct obs_data_snapshot_entry *entry = get_snapshot_entry_type(snapshot, key, OBS_DATA_NUMBER);
+
+	if (!entry)
+		return 0.0;
+
+	return (entry->num.type == OBS_DATA_NUM_INT) ? (double)entry->num.int_val : entry->num.double_val;
+}
+
+bool obs_data_snapshot_get_bool(const obs_data_snapshot_t *snapshot, obs_data_key_t key)
+{
+	const struct obs_data_snapshot_entry *entry = get_snapshot_entry_type(snapshot, key, OBS_DATA_BOOLEAN);
+	return entry ? entry->boolean : false;
+}
+
+const obs_data_snapshot_t *obs_data_snapshot_get_obj(const obs_data_snapshot_t *snapshot, obs_data_key_t key)
+{
+	const struct obs_data_snapshot_entry *entry = get_snapshot_entry_type(snapshot, key, OBS_DATA_OBJECT);
+	return entry ? entry->obj : NULL;
+}
+
+size_t obs_data_snapshot_array_count(const obs_data_snapshot_t *snapshot, obs_data_key_t key)
+{
+	const struct obs_data_snapshot_entry *entry = get_snapshot_entry_type(snapshot, key, OBS_DATA_ARRAY);
+	return entry ? entry->array.count : 0;
+}
+
+const obs_data_snapshot_t *obs_data_snapshot_array_item(const obs_data_snapshot_t *snapshot, obs_data_key_t key,
+							size_t idx)
+{
+	const struct obs_data_snapshot_entry *entry = get_snapshot_entry_type(snapshot, key, OBS_DATA_ARRAY);
+	return entry && idx < entry->array.count ? entry->array.items[idx] : NULL;
+}
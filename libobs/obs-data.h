@@ -296,6 +296,49 @@ OBS_DEPRECATED EXPORT bool obs_data_item_get_autoselect_frames_per_second(obs_da
 									  struct media_frames_per_second *fps,
 									  const char **option);
 
+/* ------------------------------------------------------------------------- */
+/* Snapshots
+ *
+ *   An immutable, reference counted copy of the current values of an obs_data
+ * (user values, falling back to default values like the obs_data_get_*
+ * functions).  A snapshot never changes after it's created, so it can be read
+ * from any thread without locking and without racing obs_data_set_* calls on
+ * the data it was taken from.
+ *
+ *   Values are looked up with keys that are resolved once up front, so hot
+ * paths don't have to hash strings.  The name of a key is not copied, it has
+ * to stay valid for as long as the key is used (a string literal, usually).
+ *
+ *   Objects and array items returned from a snapshot are borrowed, they stay
+ * valid for as long as the snapshot they were taken from is referenced.
+ */
+
+struct obs_data_key {
+	const char *name;
+	uint32_t hash;
+};
+typedef struct obs_data_key obs_data_key_t;
+
+struct obs_data_snapshot;
+typedef struct obs_data_snapshot obs_data_snapshot_t;
+
+EXPORT obs_data_key_t obs_data_key(const char *name);
+
+EXPORT obs_data_snapshot_t *obs_data_snapshot_create(obs_data_t *data);
+EXPORT void obs_data_snapshot_addref(obs_data_snapshot_t *snapshot);
+EXPORT void obs_data_snapshot_release(obs_data_snapshot_t *snapshot);
+
+EXPORT bool obs_data_snapshot_has_value(const obs_data_snapshot_t *snapshot, obs_data_key_t key);
+EXPORT const char *obs_data_snapshot_get_string(const obs_data_snapshot_t *snapshot, obs_data_key_t key);
+EXPORT long long obs_data_snapshot_get_int(const obs_data_snapshot_t *snapshot, obs_data_key_t key);
+EXPORT double obs_data_snapshot_get_double(const obs_data_snapshot_t *snapshot, obs_data_key_t key);
+EXPORT bool obs_data_snapshot_get_bool(const obs_data_snapshot_t *snapshot, obs_data_key_t key);
+EXPORT const obs_data_snapshot_t *obs_data_snapshot_get_obj(const obs_data_snapshot_t *snapshot, obs_data_key_t key);
+
+EXPORT size_t obs_data_snapshot_array_count(const obs_data_snapshot_t *snapshot, obs_data_key_t key);
+EXPORT const obs_data_snapshot_t *obs_data_snapshot_array_item(const obs_data_snapshot_t *snapshot,
+							       obs_data_key_t key, size_t idx);
+
 /* ------------------------------------------------------------------------- */
 /* OBS-specific functions */
 
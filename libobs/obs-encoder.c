@@ -348,7 +348,11 @@ static void add_connection(struct obs_encoder *encoder)
 		struct audio_convert_info audio_info = {0};
 		get_audio_info(encoder, &audio_info);
 
-		audio_output_connect(encoder->media, encoder->mixer_idx, &audio_info, receive_audio, encoder);
+		if ((encoder->info.caps & OBS_ENCODER_CAP_THREADED_AUDIO) != 0)
+			audio_output_connect_threaded(encoder->media, encoder->mixer_idx, &audio_info, receive_audio,
+						      encoder);
+		else
+			audio_output_connect(encoder->media, encoder->mixer_idx, &audio_info, receive_audio, encoder);
 	} else {
 		struct video_scale_info info = {0};
 		get_video_info(encoder, &info);
@@ -372,15 +376,52 @@ static void add_connection(struct obs_encoder *encoder)
 	set_encoder_active(encoder, true);
 }
 
+static void log_raw_video_latency(struct obs_encoder *encoder)
+{
+	struct video_input_latency latency;
+	uint64_t slow = 0;
+
+	if (!video_output_get_input_latency(encoder->media, receive_video, encoder, &latency) || !latency.frames)
+		return;
+
+	/* roughly anything that took longer than a frame interval at 60 FPS */
+	for (size_t i = 1; i < VIDEO_INPUT_LATENCY_BUCKETS; i++) {
+		if ((VIDEO_INPUT_LATENCY_BUCKET_NS << (i - 1)) >= 16000000ULL)
+			slow += latency.buckets[i];
+	}
+
+	blog(LOG_INFO,
+	     "encoder '%s': %" PRIu64 " raw frames, average frame time %.2f ms, "
+	     "max %.2f ms, %" PRIu64 " frames over 16 ms",
+	     encoder->context.name, latency.frames, (double)latency.total_ns / (double)latency.frames / 1000000.0,
+	     (double)latency.max_ns / 1000000.0, slow);
+}
+
+static void log_raw_audio_queue(struct obs_encoder *encoder)
+{
+	struct audio_input_stats stats;
+
+	if (!audio_output_get_input_stats(encoder->media, encoder->mixer_idx, receive_audio, encoder, &stats) ||
+	    !stats.blocks)
+		return;
+
+	blog(LOG_INFO,
+	     "encoder '%s': %" PRIu64 " audio blocks, max queued %" PRIu32 "/%" PRIu32 ", %" PRIu64
+	     " dropped",
+	     encoder->context.name, stats.blocks, stats.max_queued, stats.capacity, stats.dropped);
+}
+
 void obs_encoder_group_actually_destroy(obs_encoder_group_t *group);
 static void remove_connection(struct obs_encoder *encoder, bool shutdown)
 {
 	if (encoder->info.type == OBS_ENCODER_AUDIO) {
+		log_raw_audio_queue(encoder);
 		audio_output_disconnect(encoder->media, encoder->mixer_idx, receive_audio, encoder);
 	} else {
 		if (gpu_encode_available(encoder)) {
 			stop_gpu_encode(encoder);
 		} else {
+			log_raw_video_latency(encoder);
 			stop_raw_video(encoder->media, receive_video, encoder);
 		}
 	}
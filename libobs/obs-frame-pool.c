@@ -0,0 +1,202 @@
+/******************************************************************************
+    Copyright (C) 2026 by agent <agent@local>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include <inttypes.h>
+
+#include "obs-frame-pool.h"
+#include "media-io/video-frame.h"
+#include "util/platform.h"
+
+#define DEFAULT_IDLE_TIMEOUT_NS 10000000000ULL
+#define TRIM_INTERVAL_NS 1000000000ULL
+
+/* above this, frames that are given back are freed instead of pooled */
+#define MAX_IDLE_BYTES (512ULL * 1024 * 1024)
+
+#define MIN_CLASS_SIZE 4096
+
+struct pooled_frame {
+	struct obs_source_frame frame;
+	size_t capacity;
+};
+
+/* eight classes per power of two, so at most 1/8th of a buffer is wasted */
+static size_t get_class_size(size_t size)
+{
+	size_t step = MIN_CLASS_SIZE / 8;
+
+	if (size <= MIN_CLASS_SIZE)
+		return MIN_CLASS_SIZE;
+
+	while (step * 8 < size / 2)
+		step *= 2;
+
+	return (size + step - 1) & ~(step - 1);
+}
+
+static struct frame_pool_class *get_class(struct frame_pool *pool, size_t size)
+{
+	for (size_t i = 0; i < pool->classes.num; i++) {
+		if (pool->classes.array[i].size == size)
+			return &pool->classes.array[i];
+	}
+
+	return NULL;
+}
+
+static void free_class(struct frame_pool *pool, struct frame_pool_class *fpc)
+{
+	for (size_t i = 0; i < fpc->frames.num; i++)
+		obs_source_frame_destroy(fpc->frames.array[i]);
+
+	pool->idle_bytes -= fpc->frames.num * fpc->size;
+	pool->released += fpc->frames.num;
+	da_free(fpc->frames);
+}
+
+bool frame_pool_init(struct frame_pool *pool)
+{
+	memset(pool, 0, sizeof(*pool));
+	pool->idle_timeout_ns = DEFAULT_IDLE_TIMEOUT_NS;
+	return pthread_mutex_init(&pool->mutex, NULL) == 0;
+}
+
+void frame_pool_free(struct frame_pool *pool)
+{
+	if (pool->hits || pool->misses)
+		blog(LOG_INFO,
+		     "Async frame pool: %" PRIu64 " hits, %" PRIu64 " misses, "
+		     "%" PRIu64 " frames released while idle",
+		     pool->hits, pool->misses, pool->released);
+
+	for (size_t i = 0; i < pool->classes.num; i++)
+		free_class(pool, &pool->classes.array[i]);
+	da_free(pool->classes);
+
+	pthread_mutex_destroy(&pool->mutex);
+}
+
+struct obs_source_frame *frame_pool_create_frame(struct frame_pool *pool, enum video_format format,
+						 uint32_t width, uint32_t height)
+{
+	size_t size = get_class_size(video_frame_get_size(format, width, height));
+	struct pooled_frame *pf = NULL;
+	struct video_frame vid_frame;
+	uint8_t *data;
+
+	pthread_mutex_lock(&pool->mutex);
+
+	struct frame_pool_class *fpc = get_class(pool, size);
+	if (fpc) {
+		fpc->last_used = os_gettime_ns();
+
+		if (fpc->frames.num) {
+			pf = (struct pooled_frame *)fpc->frames.array[--fpc->frames.num];
+			pool->idle_bytes -= size;
+		}
+	}
+
+	if (pf)
+		pool->hits++;
+	else
+		pool->misses++;
+
+	pthread_mutex_unlock(&pool->mutex);
+
+	if (pf) {
+		data = pf->frame.data[0];
+		memset(&pf->frame, 0, sizeof(pf->frame));
+	} else {
+		pf = bzalloc(sizeof(*pf));
+		pf->capacity = size;
+		data = bmalloc(size);
+	}
+
+	video_frame_init_buffer(&vid_frame, data, format, width, height);
+	pf->frame.pooled = true;
+	pf->frame.format = format;
+	pf->frame.width = width;
+	pf->frame.height = height;
+
+	for (size_t i = 0; i < MAX_AV_PLANES; i++) {
+		pf->frame.data[i] = vid_frame.data[i];
+		pf->frame.linesize[i] = vid_frame.linesize[i];
+	}
+
+	return &pf->frame;
+}
+
+void frame_pool_destroy_frame(struct frame_pool *pool, struct obs_source_frame *frame)
+{
+	struct pooled_frame *pf = (struct pooled_frame *)frame;
+
+	if (!frame)
+		return;
+
+	if (!frame->pooled) {
+		obs_source_frame_destroy(frame);
+		return;
+	}
+
+	pthread_mutex_lock(&pool->mutex);
+
+	if (pool->idle_bytes + pf->capacity > MAX_IDLE_BYTES) {
+		pthread_mutex_unlock(&pool->mutex);
+		obs_source_frame_destroy(frame);
+		return;
+	}
+
+	struct frame_pool_class *fpc = get_class(pool, pf->capacity);
+	if (!fpc) {
+		fpc = da_push_back_new(pool->classes);
+		fpc->size = pf->capacity;
+		fpc->last_used = os_gettime_ns();
+	}
+
+	da_push_back(fpc->frames, &frame);
+	pool->idle_bytes += pf->capacity;
+
+	pthread_mutex_unlock(&pool->mutex);
+}
+
+void frame_pool_trim(struct frame_pool *pool)
+{
+	uint64_t cur_time = os_gettime_ns();
+
+	if (cur_time - pool->last_trim < TRIM_INTERVAL_NS)
+		return;
+
+	pool->last_trim = cur_time;
+
+	pthread_mutex_lock(&pool->mutex);
+
+	for (size_t i = pool->classes.num; i > 0; i--) {
+		struct frame_pool_class *fpc = &pool->classes.array[i - 1];
+
+		if (cur_time - fpc->last_used < pool->idle_timeout_ns)
+			continue;
+
+		if (fpc->frames.num)
+			blog(LOG_DEBUG, "Async frame pool: releasing %zu idle frames of %zu bytes", fpc->frames.num,
+			     fpc->size);
+
+		free_class(pool, fpc);
+		da_erase(pool->classes, i - 1);
+	}
+
+	pthread_mutex_unlock(&pool->mutex);
+}
@@ -0,0 +1,73 @@
+/******************************************************************************
+    Copyright (C) 2026 by agent <agent@local>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include "util/darray.h"
+#include "util/threading.h"
+#include "obs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Pool of async source frames shared by all sources.  Frames are grouped in
+ * size classes by the size of their data buffer, so a source that switches
+ * resolution or format, or a media source that starts a new clip, picks up
+ * frames another source (or itself, earlier) has given back instead of
+ * allocating new ones.  A size class that has not been used for the idle
+ * timeout is released.
+ *
+ * Pooled frames are ordinary bmalloc allocations, so obs_source_frame_destroy
+ * still works on them; the frame just doesn't make it back into the pool.
+ * They are marked with the pooled flag, frames that were not made by the pool
+ * (e.g. returned by an async filter) are destroyed instead of pooled.
+ */
+
+struct frame_pool_class {
+	size_t size;
+	uint64_t last_used;
+	DARRAY(struct obs_source_frame *) frames;
+};
+
+struct frame_pool {
+	pthread_mutex_t mutex;
+	DARRAY(struct frame_pool_class) classes;
+
+	uint64_t idle_timeout_ns;
+	uint64_t last_trim;
+	size_t idle_bytes;
+
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t released;
+};
+
+extern bool frame_pool_init(struct frame_pool *pool);
+extern void frame_pool_free(struct frame_pool *pool);
+
+extern struct obs_source_frame *frame_pool_create_frame(struct frame_pool *pool, enum video_format format,
+							uint32_t width, uint32_t height);
+extern void frame_pool_destroy_frame(struct frame_pool *pool, struct obs_source_frame *frame);
+
+/* releases size classes that have been idle for longer than the timeout */
+extern void frame_pool_trim(struct frame_pool *pool);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,220 @@
+/******************************************************************************
+    Copyright (C) 2026 by agent <agent@local>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "obs-interleave.h"
+
+/* consumed packets are only removed from the front of a queue once enough of
+ * them have piled up, so popping does not move the whole queue every time */
+#define INTERLEAVE_COMPACT_MIN 32
+
+static inline struct interleaved_packet *queue_head(struct packet_interleaver *pi, size_t q)
+{
+	struct interleave_queue *queue = &pi->queues[q];
+	return queue->packets.array + queue->head;
+}
+
+static inline bool heap_less(struct packet_interleaver *pi, size_t a, size_t b)
+{
+	return interleaved_packet_less(queue_head(pi, pi->heap[a]), queue_head(pi, pi->heap[b]));
+}
+
+static inline void heap_swap(struct packet_interleaver *pi, size_t a, size_t b)
+{
+	uint8_t tmp = pi->heap[a];
+	pi->heap[a] = pi->heap[b];
+	pi->heap[b] = tmp;
+}
+
+static void heap_sift_up(struct packet_interleaver *pi, size_t idx)
+{
+	while (idx > 0) {
+		size_t parent = (idx - 1) / 2;
+		if (!heap_less(pi, idx, parent))
+			break;
+
+		heap_swap(pi, idx, parent);
+		idx = parent;
+	}
+}
+
+static void heap_sift_down(struct packet_interleaver *pi, size_t idx)
+{
+	for (;;) {
+		size_t left = idx * 2 + 1;
+		size_t right = left + 1;
+		size_t smallest = idx;
+
+		if (left < pi->heap_size && heap_less(pi, left, smallest))
+			smallest = left;
+		if (right < pi->heap_size && heap_less(pi, right, smallest))
+			smallest = right;
+		if (smallest == idx)
+			break;
+
+		heap_swap(pi, idx, smallest);
+		idx = smallest;
+	}
+}
+
+static void heap_rebuild(struct packet_interleaver *pi)
+{
+	pi->heap_size = 0;
+	for (size_t q = 0; q < INTERLEAVE_MAX_QUEUES; q++) {
+		if (interleave_queue_size(&pi->queues[q]))
+			pi->heap[pi->heap_size++] = (uint8_t)q;
+	}
+
+	for (size_t i = pi->heap_size / 2; i > 0; i--)
+		heap_sift_down(pi, i - 1);
+}
+
+void packet_interleaver_free(struct packet_interleaver *pi)
+{
+	for (size_t q = 0; q < INTERLEAVE_MAX_QUEUES; q++) {
+		struct interleave_queue *queue = &pi->queues[q];
+
+		for (size_t i = queue->head; i < queue->packets.num; i++)
+			obs_encoder_packet_release(&queue->packets.array[i].packet);
+		da_free(queue->packets);
+	}
+
+	memset(pi, 0, sizeof(*pi));
+}
+
+void packet_interleaver_push(struct packet_interleaver *pi, const struct encoder_packet *packet)
+{
+	size_t q = interleave_queue_idx(packet->type, packet->track_idx);
+	struct interleave_queue *queue = &pi->queues[q];
+	struct interleaved_packet ip = {*packet, pi->next_seq++};
+	bool was_empty = !interleave_queue_size(queue);
+	size_t idx = queue->packets.num;
+
+	/* encoders hand packets over in DTS order, but don't rely on it */
+	while (idx > queue->head && interleaved_packet_less(&ip, &queue->packets.array[idx - 1]))
+		idx--;
+
+	if (idx == queue->packets.num)
+		da_push_back(queue->packets, &ip);
+	else
+		da_insert(queue->packets, idx, &ip);
+
+	pi->num++;
+
+	if (was_empty) {
+		pi->heap[pi->heap_size++] = (uint8_t)q;
+		heap_sift_up(pi, pi->heap_size - 1);
+	} else if (idx == queue->head) {
+		heap_rebuild(pi);
+	}
+}
+
+bool packet_interleaver_pop(struct packet_interleaver *pi, struct encoder_packet *packet)
+{
+	if (!pi->heap_size)
+		return false;
+
+	size_t q = pi->heap[0];
+	struct interleave_queue *queue = &pi->queues[q];
+
+	*packet = queue->packets.array[queue->head++].packet;
+	pi->num--;
+
+	if (queue->head == queue->packets.num) {
+		queue->packets.num = 0;
+		queue->head = 0;
+		pi->heap[0] = pi->heap[--pi->heap_size];
+	} else if (queue->head >= INTERLEAVE_COMPACT_MIN && queue->head * 2 >= queue->packets.num) {
+		da_erase_range(queue->packets, 0, queue->head);
+		queue->head = 0;
+	}
+
+	heap_sift_down(pi, 0);
+	return true;
+}
+
+struct interleaved_packet *packet_interleaver_peek(struct packet_interleaver *pi)
+{
+	return pi->heap_size ? queue_head(pi, pi->heap[0]) : NULL;
+}
+
+struct interleaved_packet *packet_interleaver_first(struct packet_interleaver *pi, enum obs_encoder_type type,
+						    size_t track_idx)
+{
+	size_t q = interleave_queue_idx(type, track_idx);
+	return interleave_queue_size(&pi->queues[q]) ? queue_head(pi, q) : NULL;
+}
+
+struct interleaved_packet *packet_interleaver_last(struct packet_interleaver *pi, enum obs_encoder_type type,
+						   size_t track_idx)
+{
+	struct interleave_queue *queue = &pi->queues[interleave_queue_idx(type, track_idx)];
+	return interleave_queue_size(queue) ? da_end(queue->packets) : NULL;
+}
+
+void packet_interleaver_resort(struct packet_interleaver *pi)
+{
+	/* offsets are applied per track, so queues are almost always still
+	 * in order and the insertion sort is a single pass */
+	for (size_t q = 0; q < INTERLEAVE_MAX_QUEUES; q++) {
+		struct interleave_queue *queue = &pi->queues[q];
+		struct interleaved_packet *array = queue->packets.array;
+
+		for (size_t i = queue->head + 1; i < queue->packets.num; i++) {
+			struct interleaved_packet cur = array[i];
+			size_t j = i;
+
+			while (j > queue->head && interleaved_packet_less(&cur, &array[j - 1])) {
+				array[j] = array[j - 1];
+				j--;
+			}
+			array[j] = cur;
+		}
+	}
+
+	heap_rebuild(pi);
+}
+
+void packet_interleaver_iter_init(const struct packet_interleaver *pi, struct packet_interleaver_iter *iter)
+{
+	for (size_t q = 0; q < INTERLEAVE_MAX_QUEUES; q++)
+		iter->pos[q] = pi->queues[q].head;
+}
+
+struct interleaved_packet *packet_interleaver_iter_next(struct packet_interleaver *pi,
+							struct packet_interleaver_iter *iter)
+{
+	struct interleaved_packet *next = NULL;
+	size_t next_q = 0;
+
+	for (size_t i = 0; i < pi->heap_size; i++) {
+		size_t q = pi->heap[i];
+		struct interleave_queue *queue = &pi->queues[q];
+
+		if (iter->pos[q] >= queue->packets.num)
+			continue;
+
+		struct interleaved_packet *cur = &queue->packets.array[iter->pos[q]];
+		if (!next || interleaved_packet_less(cur, next)) {
+			next = cur;
+			next_q = q;
+		}
+	}
+
+	if (next)
+		iter->pos[next_q]++;
+	return next;
+}
@@ -0,0 +1,110 @@
+/******************************************************************************
+    Copyright (C) 2026 by agent <agent@local>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include "util/darray.h"
+#include "obs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Packet interleaver used by outputs.  Every encoder track gets its own FIFO
+ * (encoders produce packets in DTS order, so pushing is an append), and the
+ * heads of the FIFOs are kept in a small min-heap so the next packet to send
+ * is found without scanning everything that is buffered.
+ *
+ * Packets are ordered by DTS; at equal DTS video comes before audio, video
+ * tracks are ordered by track index, and audio packets keep their arrival
+ * order.
+ */
+
+#define INTERLEAVE_MAX_QUEUES (MAX_OUTPUT_VIDEO_ENCODERS + MAX_OUTPUT_AUDIO_ENCODERS)
+
+struct interleaved_packet {
+	struct encoder_packet packet;
+	uint64_t seq;
+};
+
+struct interleave_queue {
+	DARRAY(struct interleaved_packet) packets;
+	size_t head;
+};
+
+struct packet_interleaver {
+	struct interleave_queue queues[INTERLEAVE_MAX_QUEUES];
+	uint8_t heap[INTERLEAVE_MAX_QUEUES];
+	size_t heap_size;
+	size_t num;
+	uint64_t next_seq;
+};
+
+struct packet_interleaver_iter {
+	size_t pos[INTERLEAVE_MAX_QUEUES];
+};
+
+static inline bool interleaved_packet_less(const struct interleaved_packet *a, const struct interleaved_packet *b)
+{
+	if (a->packet.dts_usec != b->packet.dts_usec)
+		return a->packet.dts_usec < b->packet.dts_usec;
+	if (a->packet.type != b->packet.type)
+		return a->packet.type == OBS_ENCODER_VIDEO;
+	if (a->packet.type == OBS_ENCODER_VIDEO && a->packet.track_idx != b->packet.track_idx)
+		return a->packet.track_idx < b->packet.track_idx;
+	return a->seq < b->seq;
+}
+
+static inline size_t interleave_queue_idx(enum obs_encoder_type type, size_t track_idx)
+{
+	return type == OBS_ENCODER_VIDEO ? track_idx : MAX_OUTPUT_VIDEO_ENCODERS + track_idx;
+}
+
+static inline size_t interleave_queue_size(const struct interleave_queue *queue)
+{
+	return queue->packets.num - queue->head;
+}
+
+/** Releases all buffered packets and frees the queues */
+extern void packet_interleaver_free(struct packet_interleaver *pi);
+
+/** Takes ownership of the packet; track_idx must already be set */
+extern void packet_interleaver_push(struct packet_interleaver *pi, const struct encoder_packet *packet);
+
+/** Removes the next packet in interleaved order, ownership goes to the caller */
+extern bool packet_interleaver_pop(struct packet_interleaver *pi, struct encoder_packet *packet);
+
+/** Returns the next packet in interleaved order without removing it */
+extern struct interleaved_packet *packet_interleaver_peek(struct packet_interleaver *pi);
+
+extern struct interleaved_packet *packet_interleaver_first(struct packet_interleaver *pi, enum obs_encoder_type type,
+							   size_t track_idx);
+extern struct interleaved_packet *packet_interleaver_last(struct packet_interleaver *pi, enum obs_encoder_type type,
+							  size_t track_idx);
+
+/** Must be called after the timestamps of buffered packets were changed */
+extern void packet_interleaver_resort(struct packet_interleaver *pi);
+
+/** Walks buffered packets in interleaved order without removing them */
+extern void packet_interleaver_iter_init(const struct packet_interleaver *pi, struct packet_interleaver_iter *iter);
+extern struct interleaved_packet *packet_interleaver_iter_next(struct packet_interleaver *pi,
+							       struct packet_interleaver_iter *iter);
+
+#ifdef __cplusplus
+}
+#endif
@@ -21,6 +21,7 @@
 #include "util/darray.h"
 #include "util/deque.h"
 #include "util/dstr.h"
+#include "util/float-ring.h"
 #include "util/threading.h"
 #include "util/platform.h"
 #include "util/profiler.h"
@@ -38,6 +39,8 @@
 #include "media-io/audio-io.h"
 
 #include "obs.h"
+#include "obs-interleave.h"
+#include "obs-frame-pool.h"
 
 #include <obsversion.h>
 #include <caption/caption.h>
@@ -386,6 +389,39 @@ struct obs_core_video_mix {
 extern struct obs_core_video_mix *obs_create_video_mix(struct obs_video_info *ovi);
 extern void obs_free_video_mix(struct obs_core_video_mix *video);
 
+/* Raw frames are copied into the video output in row bands, the graphics
+ * thread always takes the first band and the thread pool takes the rest */
+#define MAX_VIDEO_COPY_BANDS 4
+
+struct video_copy_plane {
+	const uint8_t *in;
+	uint8_t *out;
+	uint32_t width;
+	uint32_t height;
+	uint32_t in_linesize;
+	uint32_t out_linesize;
+};
+
+struct video_copy_job;
+
+struct video_copy_band {
+	struct video_copy_job *job;
+	size_t band;
+};
+
+struct video_copy_job {
+	os_task_group_t *group;
+	struct video_copy_band bands[MAX_VIDEO_COPY_BANDS];
+	size_t max_bands;
+
+	struct video_copy_plane planes[MAX_AV_PLANES];
+	size_t num_planes;
+	size_t num_bands;
+};
+
+extern bool obs_init_video_copy_job(void);
+extern void obs_free_video_copy_job(void);
+
 struct obs_core_video {
 	graphics_t *graphics;
 	gs_effect_t *default_effect;
@@ -411,6 +447,14 @@ struct obs_core_video {
 	uint32_t lagged_frames;
 	bool thread_initialized;
 
+	/* scene item transforms recalculated in the current/last frame */
+	volatile long transform_updates;
+	uint32_t last_frame_transform_updates;
+
+	/* scene items skipped by culling in the current/last frame */
+	volatile long culled_items;
+	uint32_t last_frame_culled_items;
+
 	gs_texture_t *transparent_texture;
 
 	gs_effect_t *deinterlace_discard_effect;
@@ -433,6 +477,8 @@ struct obs_core_video {
 
 	pthread_mutex_t mixes_mutex;
 	DARRAY(struct obs_core_video_mix *) mixes;
+
+	struct video_copy_job copy_job;
 };
 
 extern void add_ready_encoder_group(obs_encoder_t *encoder);
@@ -445,6 +491,11 @@ struct obs_core_audio {
 	DARRAY(struct obs_source *) render_order;
 	DARRAY(struct obs_source *) root_nodes;
 
+	/* sources of render_order that don't depend on the audio of other
+	 * sources, these are rendered in parallel */
+	DARRAY(struct obs_source *) render_leaves;
+	os_task_group_t *render_group;
+
 	uint64_t buffered_ts;
 	struct deque buffered_timestamps;
 	uint64_t buffering_wait_ticks;
@@ -504,6 +555,18 @@ struct obs_core_data {
 
 	DARRAY(char *) protocols;
 	DARRAY(obs_source_t *) sources_to_tick;
+
+	/* bumped whenever a source is renamed, lets scenes know their name
+	 * index is out of date */
+	volatile long source_renames;
+
+	/* sources with OBS_SOURCE_THREADSAFE_TICK, ticked on the thread pool */
+	DARRAY(obs_source_t *) pooled_ticks;
+	DARRAY(uint64_t) pooled_tick_times;
+	os_task_group_t *tick_group;
+
+	/* shared by the async video caches of all sources */
+	struct frame_pool frame_pool;
 };
 
 /* user hotkeys */
@@ -543,6 +606,23 @@ struct obs_core_hotkeys {
 
 typedef DARRAY(struct obs_source_info) obs_source_info_array_t;
 
+/* IDs of signals that are emitted often, see signal_get_id */
+struct obs_core_signal_ids {
+	signal_id_t source_update;
+	signal_id_t source_volume;
+
+	signal_id_t update;
+	signal_id_t volume;
+	signal_id_t media_play;
+	signal_id_t media_pause;
+	signal_id_t media_restart;
+	signal_id_t media_stopped;
+	signal_id_t media_next;
+	signal_id_t media_previous;
+	signal_id_t media_started;
+	signal_id_t media_ended;
+};
+
 struct obs_core {
 	struct obs_module *first_module;
 	struct obs_module *first_disabled_module;
@@ -562,6 +642,7 @@ struct obs_core {
 
 	signal_handler_t *signals;
 	proc_handler_t *procs;
+	struct obs_core_signal_ids signal_ids;
 
 	char *locale;
 	char *module_config_path;
@@ -805,6 +886,15 @@ struct media_action {
 	};
 };
 
+/* contiguous audio handed from the thread that outputs it to the audio thread,
+ * the samples are in obs_source::audio_input_ring */
+#define AUDIO_INPUT_PACKETS 64
+
+struct audio_input_packet {
+	uint64_t timestamp;
+	size_t frames;
+};
+
 struct obs_source {
 	struct obs_context_data context;
 	struct obs_source_info info;
@@ -820,6 +910,11 @@ struct obs_source {
 	/* signals to call the source update in the video thread */
 	long defer_update_count;
 
+	/* read-only copy of the settings for other threads, replaced whenever
+	 * the settings are updated */
+	obs_data_snapshot_t *settings_snapshot;
+	pthread_mutex_t settings_snapshot_mutex;
+
 	/* ensures show/hide are only called once */
 	volatile long show_refs;
 
@@ -868,8 +963,17 @@ struct obs_source {
 	uint64_t audio_ts;
 	struct deque audio_input_buf[MAX_AUDIO_CHANNELS];
 	size_t last_audio_input_buf_size;
+
+	/* lets obs_source_output_audio append to audio_input_buf without
+	 * taking audio_buf_mutex, moved over by audio_input_flush */
+	struct float_ring audio_input_ring;
+	struct audio_input_packet audio_input_packets[AUDIO_INPUT_PACKETS];
+	volatile long audio_input_packets_write;
+	volatile long audio_input_packets_read;
 	DARRAY(struct audio_action) audio_actions;
 	float *audio_output_buf[MAX_AUDIO_MIXES][MAX_AUDIO_CHANNELS];
+	/* mixes of audio_output_buf that can hold non-silent audio this tick */
+	uint32_t audio_output_mixes;
 	float *audio_mix_buf[MAX_AUDIO_CHANNELS];
 	struct resample_info sample_info;
 	audio_resampler_t *resampler;
@@ -1042,6 +1146,19 @@ static inline void obs_source_dosignal(struct obs_source *source, const char *si
 		signal_handler_signal(source->context.signals, signal_source, &data);
 }
 
+static inline void obs_source_dosignal_id(struct obs_source *source, signal_id_t signal_obs, signal_id_t signal_source)
+{
+	struct calldata data;
+	uint8_t stack[128];
+
+	calldata_init_fixed(&data, stack, sizeof(stack));
+	calldata_set_ptr(&data, "source", source);
+	if (signal_obs && !source->context.private)
+		signal_handler_signal_id(obs->signals, signal_obs, &data);
+	if (signal_source)
+		signal_handler_signal_id(source->context.signals, signal_source, &data);
+}
+
 static inline void obs_source_dosignal_canvas(struct obs_source *source, struct obs_canvas *canvas,
 					      const char *signal_obs, const char *signal_source)
 {
@@ -1122,11 +1239,16 @@ extern void obs_source_set_texcoords_centered(obs_source_t *source, bool centere
 extern void obs_source_activate(obs_source_t *source, enum view_type type);
 extern void obs_source_deactivate(obs_source_t *source, enum view_type type);
 extern void obs_source_video_tick(obs_source_t *source, float seconds);
+/* ticks everything but the source's own video_tick, returns whether it has
+ * one to call */
+extern bool obs_source_video_tick_prepare(obs_source_t *source, float seconds);
 extern float obs_source_get_target_volume(obs_source_t *source, obs_source_t *target);
 extern uint64_t obs_source_get_last_async_ts(const obs_source_t *source);
 
 extern void obs_source_audio_render(obs_source_t *source, uint32_t mixers, size_t channels, size_t sample_rate,
 				    size_t size);
+/* moves queued audio into audio_input_buf, audio_buf_mutex must be held */
+extern void audio_input_flush(obs_source_t *source);
 
 extern void add_alignment(struct vec2 *v, uint32_t align, int cx, int cy);
 
@@ -1228,7 +1350,7 @@ struct obs_output {
 	pthread_t end_data_capture_thread;
 	os_event_t *stopping_event;
 	pthread_mutex_t interleaved_mutex;
-	DARRAY(struct encoder_packet) interleaved_packets;
+	struct packet_interleaver interleaver;
 	size_t interleaver_max_batch_size;
 	int stop_code;
 
@@ -1514,6 +1636,8 @@ extern void source_profiler_async_frame_received(obs_source_t *source);
 extern uint64_t source_profiler_source_tick_start(void);
 /* Submit start timestamp for source */
 extern void source_profiler_source_tick_end(obs_source_t *source, uint64_t start);
+/* Submit tick duration for source, for ticks that were run on another thread */
+extern void source_profiler_source_tick_submit(obs_source_t *source, uint64_t tick_time);
 
 /* Obtain GPU timer and start timestamp for render start of a source. */
 extern uint64_t source_profiler_source_render_begin(gs_timer_t **timer);
@@ -262,9 +262,7 @@ fail:
 
 static inline void free_packets(struct obs_output *output)
 {
-	for (size_t i = 0; i < output->interleaved_packets.num; i++)
-		obs_encoder_packet_release(output->interleaved_packets.array + i);
-	da_free(output->interleaved_packets);
+	packet_interleaver_free(&output->interleaver);
 }
 
 static inline void clear_raw_audio_buffers(obs_output_t *output)
@@ -1680,11 +1678,12 @@ static bool add_caption(struct obs_output *output, struct encoder_packet *out)
 
 static inline void send_interleaved(struct obs_output *output)
 {
-	struct encoder_packet out = output->interleaved_packets.array[0];
+	struct encoder_packet out;
 	struct encoder_packet_time ept_local = {0};
 	bool found_ept = false;
 
-	da_erase(output->interleaved_packets, 0);
+	if (!packet_interleaver_pop(&output->interleaver, &out))
+		return;
 
 	if (out.type == OBS_ENCODER_VIDEO) {
 		output->total_frames++;
@@ -1769,51 +1768,88 @@ static inline void set_higher_ts(struct obs_output *output, struct encoder_packe
 }
 
 static inline struct encoder_packet *find_first_packet_type(struct obs_output *output, enum obs_encoder_type type,
-							    size_t audio_idx);
-static int find_first_packet_type_idx(struct obs_output *output, enum obs_encoder_type type, size_t audio_idx);
+							    size_t idx)
+{
+	struct interleaved_packet *ip = packet_interleaver_first(&output->interleaver, type, idx);
+	return ip ? &ip->packet : NULL;
+}
 
-/* gets the point where audio and video are closest together */
-static size_t get_interleaved_start_idx(struct obs_output *output)
+static inline struct encoder_packet *find_last_packet_type(struct obs_output *output, enum obs_encoder_type type,
+							   size_t idx)
 {
-	int64_t closest_diff = 0x7FFFFFFFFFFFFFFFLL;
-	struct encoder_packet *first_video = find_first_packet_type(output, OBS_ENCODER_VIDEO, 0);
-	size_t video_idx = DARRAY_INVALID;
-	size_t idx = 0;
+	struct interleaved_packet *ip = packet_interleaver_last(&output->interleaver, type, idx);
+	return ip ? &ip->packet : NULL;
+}
+
+/* first audio packet of any track that is not ordered before the given one */
+static struct interleaved_packet *find_first_audio_from(struct obs_output *output,
+							const struct interleaved_packet *from)
+{
+	struct interleaved_packet *first = NULL;
 
-	for (size_t i = 0; i < output->interleaved_packets.num; i++) {
-		struct encoder_packet *packet = &output->interleaved_packets.array[i];
-		int64_t diff;
+	for (size_t i = 0; i < MAX_OUTPUT_AUDIO_ENCODERS; i++) {
+		size_t q = interleave_queue_idx(OBS_ENCODER_AUDIO, i);
+		struct interleave_queue *queue = &output->interleaver.queues[q];
 
-		if (packet->type != OBS_ENCODER_AUDIO) {
-			if (packet == first_video)
-				video_idx = i;
-			continue;
+		for (size_t j = queue->head; j < queue->packets.num; j++) {
+			struct interleaved_packet *ip = &queue->packets.array[j];
+
+			if (interleaved_packet_less(ip, from))
+				continue;
+			if (!first || interleaved_packet_less(ip, first))
+				first = ip;
+			break;
 		}
+	}
+
+	return first;
+}
+
+/* gets the point where audio and video are closest together, everything
+ * ordered before the returned packet can be discarded */
+static bool get_interleaved_start(struct obs_output *output, struct interleaved_packet *start)
+{
+	int64_t closest_diff = 0x7FFFFFFFFFFFFFFFLL;
+	struct interleaved_packet *first_video = packet_interleaver_first(&output->interleaver, OBS_ENCODER_VIDEO, 0);
+	struct interleaved_packet *closest = NULL;
+	struct interleaved_packet *first_audio;
+
+	if (!first_video)
+		return false;
 
-		diff = llabs(packet->dts_usec - first_video->dts_usec);
-		if (diff < closest_diff) {
-			closest_diff = diff;
-			idx = i;
+	for (size_t i = 0; i < MAX_OUTPUT_AUDIO_ENCODERS; i++) {
+		size_t q = interleave_queue_idx(OBS_ENCODER_AUDIO, i);
+		struct interleave_queue *queue = &output->interleaver.queues[q];
+
+		for (size_t j = queue->head; j < queue->packets.num; j++) {
+			struct interleaved_packet *ip = &queue->packets.array[j];
+			int64_t diff = llabs(ip->packet.dts_usec - first_video->packet.dts_usec);
+
+			if (diff < closest_diff || (diff == closest_diff && interleaved_packet_less(ip, closest))) {
+				closest_diff = diff;
+				closest = ip;
+			}
 		}
 	}
 
-	idx = video_idx < idx ? video_idx : idx;
+	if (!closest)
+		return false;
 
-	/* Early AAC/Opus audio packets will be for "priming" the encoder and contain silence, but they should not be
-	 * discarded. Set the idx to the first audio packet if closest PTS was <= 0. */
-	size_t first_audio_idx = idx;
-	while (output->interleaved_packets.array[first_audio_idx].type != OBS_ENCODER_AUDIO)
-		first_audio_idx++;
+	*start = interleaved_packet_less(first_video, closest) ? *first_video : *closest;
 
-	if (output->interleaved_packets.array[first_audio_idx].pts <= 0) {
+	/* Early AAC/Opus audio packets will be for "priming" the encoder and contain silence, but they should not be
+	 * discarded. Start at the first audio packet if closest PTS was <= 0. */
+	first_audio = find_first_audio_from(output, start);
+	if (first_audio && first_audio->packet.pts <= 0) {
 		for (size_t i = 0; i < MAX_OUTPUT_AUDIO_ENCODERS; i++) {
-			int audio_idx = find_first_packet_type_idx(output, OBS_ENCODER_AUDIO, i);
-			if (audio_idx >= 0 && (size_t)audio_idx < idx)
-				idx = audio_idx;
+			struct interleaved_packet *ip =
+				packet_interleaver_first(&output->interleaver, OBS_ENCODER_AUDIO, i);
+			if (ip && interleaved_packet_less(ip, start))
+				*start = *ip;
 		}
 	}
 
-	return idx;
+	return true;
 }
 
 static int64_t get_encoder_duration(struct obs_encoder *encoder)
@@ -1821,44 +1857,42 @@ static int64_t get_encoder_duration(struct obs_encoder *encoder)
 	return (encoder->timebase_num * 1000000LL / encoder->timebase_den) * encoder->framesize;
 }
 
-static int prune_premature_packets(struct obs_output *output)
+/* returns -1 if packets are still missing, 1 if everything up to and
+ * including *last should be pruned, and 0 otherwise */
+static int prune_premature_packets(struct obs_output *output, struct interleaved_packet *last)
 {
-	struct encoder_packet *video;
-	int video_idx;
-	int max_idx;
+	struct interleaved_packet *video;
+	struct interleaved_packet *max;
 	int64_t duration_usec, max_audio_duration_usec = 0;
 	int64_t max_diff = 0;
 	int64_t diff = 0;
 	int audio_encoders = 0;
 
-	video_idx = find_first_packet_type_idx(output, OBS_ENCODER_VIDEO, 0);
-	if (video_idx == -1)
+	video = packet_interleaver_first(&output->interleaver, OBS_ENCODER_VIDEO, 0);
+	if (!video)
 		return -1;
 
-	max_idx = video_idx;
-	video = &output->interleaved_packets.array[video_idx];
-	duration_usec = video->timebase_num * 1000000LL / video->timebase_den;
+	max = video;
+	duration_usec = video->packet.timebase_num * 1000000LL / video->packet.timebase_den;
 
 	for (size_t i = 0; i < MAX_OUTPUT_AUDIO_ENCODERS; i++) {
-		struct encoder_packet *audio;
-		int audio_idx;
+		struct interleaved_packet *audio;
 		int64_t audio_duration_usec = 0;
 
 		if (!output->audio_encoders[i])
 			continue;
 		audio_encoders++;
 
-		audio_idx = find_first_packet_type_idx(output, OBS_ENCODER_AUDIO, i);
-		if (audio_idx == -1) {
+		audio = packet_interleaver_first(&output->interleaver, OBS_ENCODER_AUDIO, i);
+		if (!audio) {
 			output->received_audio = false;
 			return -1;
 		}
 
-		audio = &output->interleaved_packets.array[audio_idx];
-		if (audio_idx > max_idx)
-			max_idx = audio_idx;
+		if (interleaved_packet_less(max, audio))
+			max = audio;
 
-		diff = audio->dts_usec - video->dts_usec;
+		diff = audio->packet.dts_usec - video->packet.dts_usec;
 		if (diff > max_diff)
 			max_diff = diff;
 
@@ -1877,95 +1911,76 @@ static int prune_premature_packets(struct obs_output *output)
 		duration_usec = max_audio_duration_usec;
 	}
 
-	return diff > duration_usec ? max_idx + 1 : 0;
+	if (diff > duration_usec) {
+		*last = *max;
+		return 1;
+	}
+
+	return 0;
 }
 
 #define DEBUG_STARTING_PACKETS 0
 
-static void discard_to_idx(struct obs_output *output, size_t idx)
+static void discard_next_packet(struct obs_output *output)
 {
-	for (size_t i = 0; i < idx; i++) {
-		struct encoder_packet *packet = &output->interleaved_packets.array[i];
+	struct encoder_packet packet;
+
+	if (!packet_interleaver_pop(&output->interleaver, &packet))
+		return;
+
 #if DEBUG_STARTING_PACKETS == 1
-		blog(LOG_DEBUG, "discarding %s packet, dts: %lld, pts: %lld",
-		     packet->type == OBS_ENCODER_VIDEO ? "video" : "audio", packet->dts, packet->pts);
+	blog(LOG_DEBUG, "discarding %s packet, dts: %lld, pts: %lld",
+	     packet.type == OBS_ENCODER_VIDEO ? "video" : "audio", packet.dts, packet.pts);
 #endif
-		if (packet->type == OBS_ENCODER_VIDEO) {
-			da_pop_front(output->encoder_packet_times[packet->track_idx]);
-		}
-		obs_encoder_packet_release(packet);
+	if (packet.type == OBS_ENCODER_VIDEO) {
+		da_pop_front(output->encoder_packet_times[packet.track_idx]);
 	}
+	obs_encoder_packet_release(&packet);
+}
 
-	da_erase_range(output->interleaved_packets, 0, idx);
+/* discards every packet ordered before the given one (or up to and including
+ * it), the packet must be a copy as the queues move while discarding */
+static void discard_to_packet(struct obs_output *output, const struct interleaved_packet *to, bool inclusive)
+{
+	struct interleaved_packet *ip;
+
+	while ((ip = packet_interleaver_peek(&output->interleaver)) != NULL) {
+		if (inclusive ? interleaved_packet_less(to, ip) : !interleaved_packet_less(ip, to))
+			break;
+
+		discard_next_packet(output);
+	}
 }
 
 static bool prune_interleaved_packets(struct obs_output *output)
 {
-	size_t start_idx = 0;
-	int prune_start = prune_premature_packets(output);
+	struct interleaved_packet to;
+	int prune = prune_premature_packets(output, &to);
 
 #if DEBUG_STARTING_PACKETS == 1
-	blog(LOG_DEBUG, "--------- Pruning! %d ---------", prune_start);
-	for (size_t i = 0; i < output->interleaved_packets.num; i++) {
-		struct encoder_packet *packet = &output->interleaved_packets.array[i];
+	struct packet_interleaver_iter iter;
+	struct interleaved_packet *ip;
+
+	blog(LOG_DEBUG, "--------- Pruning! %d ---------", prune);
+	packet_interleaver_iter_init(&output->interleaver, &iter);
+	while ((ip = packet_interleaver_iter_next(&output->interleaver, &iter)) != NULL) {
 		blog(LOG_DEBUG, "packet: %s %d, ts: %lld, pruned = %s",
-		     packet->type == OBS_ENCODER_AUDIO ? "audio" : "video", (int)packet->track_idx, packet->dts_usec,
-		     (int)i < prune_start ? "true" : "false");
+		     ip->packet.type == OBS_ENCODER_AUDIO ? "audio" : "video", (int)ip->packet.track_idx,
+		     ip->packet.dts_usec, prune == 1 && !interleaved_packet_less(&to, ip) ? "true" : "false");
 	}
 #endif
 
 	/* prunes the first video packet if it's too far away from audio */
-	if (prune_start == -1)
+	if (prune == -1)
 		return false;
-	else if (prune_start != 0)
-		start_idx = (size_t)prune_start;
-	else
-		start_idx = get_interleaved_start_idx(output);
-
-	if (start_idx)
-		discard_to_idx(output, start_idx);
+	else if (prune == 1)
+		discard_to_packet(output, &to, true);
+	else if (get_interleaved_start(output, &to))
+		discard_to_packet(output, &to, false);
 
 	return true;
 }
 
-static int find_first_packet_type_idx(struct obs_output *output, enum obs_encoder_type type, size_t idx)
-{
-	for (size_t i = 0; i < output->interleaved_packets.num; i++) {
-		struct encoder_packet *packet = &output->interleaved_packets.array[i];
-
-		if (packet->type == type && packet->track_idx == idx)
-			return (int)i;
-	}
-
-	return -1;
-}
-
-static int find_last_packet_type_idx(struct obs_output *output, enum obs_encoder_type type, size_t idx)
-{
-	for (size_t i = output->interleaved_packets.num; i > 0; i--) {
-		struct encoder_packet *packet = &output->interleaved_packets.array[i - 1];
-
-		if (packet->type == type && packet->track_idx == idx)
-			return (int)(i - 1);
-	}
-
-	return -1;
-}
-
-static inline struct encoder_packet *find_first_packet_type(struct obs_output *output, enum obs_encoder_type type,
-							    size_t audio_idx)
-{
-	int idx = find_first_packet_type_idx(output, type, audio_idx);
-	return (idx != -1) ? &output->interleaved_packets.array[idx] : NULL;
-}
-
-static inline struct encoder_packet *find_last_packet_type(struct obs_output *output, enum obs_encoder_type type,
-							   size_t audio_idx)
-{
-	int idx = find_last_packet_type_idx(output, type, audio_idx);
-	return (idx != -1) ? &output->interleaved_packets.array[idx] : NULL;
-}
-
 static bool get_audio_and_video_packets(struct obs_output *output, struct encoder_packet **video,
 					struct encoder_packet **audio)
 {
@@ -2000,7 +2015,7 @@ static bool initialize_interleaved_packets(struct obs_output *output)
 	struct encoder_packet *video[MAX_OUTPUT_VIDEO_ENCODERS] = {0};
 	struct encoder_packet *audio[MAX_OUTPUT_AUDIO_ENCODERS] = {0};
 	struct encoder_packet *last_audio[MAX_OUTPUT_AUDIO_ENCODERS] = {0};
-	size_t start_idx;
+	struct interleaved_packet start;
 	size_t first_audio_idx;
 	size_t first_video_idx;
 
@@ -2029,9 +2044,8 @@ static bool initialize_interleaved_packets(struct obs_output *output)
 	}
 
 	/* clear out excess starting audio if it hasn't been already */
-	start_idx = get_interleaved_start_idx(output);
-	if (start_idx) {
-		discard_to_idx(output, start_idx);
+	if (get_interleaved_start(output, &start)) {
+		discard_to_packet(output, &start, false);
 		if (!get_audio_and_video_packets(output, video, audio))
 			return false;
 	}
@@ -2062,67 +2076,34 @@ static bool initialize_interleaved_packets(struct obs_output *output)
 	output->highest_audio_ts -= audio[first_audio_idx]->dts_usec;
 
 	/* apply new offsets to all existing packet DTS/PTS values */
-	for (size_t i = 0; i < output->interleaved_packets.num; i++) {
-		struct encoder_packet *packet = &output->interleaved_packets.array[i];
-		apply_interleaved_packet_offset(output, packet, NULL);
-	}
-
-	return true;
-}
-
-static inline void insert_interleaved_packet(struct obs_output *output, struct encoder_packet *out)
-{
-	size_t idx;
-	for (idx = 0; idx < output->interleaved_packets.num; idx++) {
-		struct encoder_packet *cur_packet;
-		cur_packet = output->interleaved_packets.array + idx;
-
-		// sort video packets with same DTS by track index,
-		// to prevent the pruning logic from removing additional
-		// video tracks
-		if (out->dts_usec == cur_packet->dts_usec && out->type == OBS_ENCODER_VIDEO &&
-		    cur_packet->type == OBS_ENCODER_VIDEO && out->track_idx > cur_packet->track_idx)
-			continue;
+	for (size_t q = 0; q < INTERLEAVE_MAX_QUEUES; q++) {
+		struct interleave_queue *queue = &output->interleaver.queues[q];
 
-		if (out->dts_usec == cur_packet->dts_usec && out->type == OBS_ENCODER_VIDEO) {
-			break;
-		} else if (out->dts_usec < cur_packet->dts_usec) {
-			break;
-		}
+		for (size_t i = queue->head; i < queue->packets.num; i++)
+			apply_interleaved_packet_offset(output, &queue->packets.array[i].packet, NULL);
 	}
 
-	da_insert(output->interleaved_packets, idx, out);
+	return true;
 }
 
 static void resort_interleaved_packets(struct obs_output *output)
 {
-	DARRAY(struct encoder_packet) old_array;
-
-	old_array.da = output->interleaved_packets.da;
-	memset(&output->interleaved_packets, 0, sizeof(output->interleaved_packets));
-
-	for (size_t i = 0; i < old_array.num; i++) {
-		set_higher_ts(output, &old_array.array[i]);
+	for (size_t q = 0; q < INTERLEAVE_MAX_QUEUES; q++) {
+		struct interleave_queue *queue = &output->interleaver.queues[q];
 
-		insert_interleaved_packet(output, &old_array.array[i]);
+		for (size_t i = queue->head; i < queue->packets.num; i++)
+			set_higher_ts(output, &queue->packets.array[i].packet);
 	}
 
-	da_free(old_array);
+	packet_interleaver_resort(&output->interleaver);
 }
 
 static void discard_unused_audio_packets(struct obs_output *output, int64_t dts_usec)
 {
-	size_t idx = 0;
-
-	for (; idx < output->interleaved_packets.num; idx++) {
-		struct encoder_packet *p = &output->interleaved_packets.array[idx];
-
-		if (p->dts_usec >= dts_usec)
-			break;
-	}
+	struct interleaved_packet *ip;
 
-	if (idx)
-		discard_to_idx(output, idx);
+	while ((ip = packet_interleaver_peek(&output->interleaver)) != NULL && ip->packet.dts_usec < dts_usec)
+		discard_next_packet(output);
 }
 
 static bool purge_encoder_group_keyframe_data(obs_output_t *output, size_t idx)
@@ -2201,16 +2182,18 @@ static void apply_ept_offsets(struct obs_output *output)
 	}
 }
 
-static inline size_t count_streamable_frames(struct obs_output *output)
+static inline size_t count_streamable_frames(struct obs_output *output, size_t limit)
 {
+	struct packet_interleaver_iter iter;
+	struct interleaved_packet *ip;
 	size_t eligible = 0;
 
-	for (size_t idx = 0; idx < output->interleaved_packets.num; idx++) {
-		struct encoder_packet *pkt = &output->interleaved_packets.array[idx];
+	packet_interleaver_iter_init(&output->interleaver, &iter);
 
+	while (eligible < limit && (ip = packet_interleaver_iter_next(&output->interleaver, &iter)) != NULL) {
 		/* Only count an interleaved packet as streamable if there are packets of the opposing type and of a
 		 * higher timestamp in the interleave buffer. This ensures that the timestamps are monotonic. */
-		if (!has_higher_opposing_ts(output, pkt))
+		if (!has_higher_opposing_ts(output, &ip->packet))
 			break;
 
 		eligible++;
@@ -2269,7 +2252,7 @@ static void interleave_packets(void *data, struct encoder_packet *packet, struct
 	else
 		check_received(output, packet);
 
-	insert_interleaved_packet(output, &out);
+	packet_interleaver_push(&output->interleaver, &out);
 
 	received_video = true;
 	for (size_t i = 0; i < MAX_OUTPUT_VIDEO_ENCODERS; i++) {
@@ -2291,7 +2274,9 @@ static void interleave_packets(void *data, struct encoder_packet *packet, struct
 		} else {
 			set_higher_ts(output, &out);
 
-			size_t streamable = count_streamable_frames(output);
+			/* counting further than one past the batch limit would
+			 * not change what gets sent */
+			size_t streamable = count_streamable_frames(output, output->interleaver_max_batch_size + 2);
 			if (streamable) {
 				send_interleaved(output);
 
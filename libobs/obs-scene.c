@@ -19,6 +19,7 @@
 #include "util/threading.h"
 #include "util/util_uint64.h"
 #include "graphics/math-defs.h"
+#include "graphics/bounds.h"
 #include "obs-scene.h"
 #include "obs-internal.h"
 
@@ -201,6 +202,58 @@ static inline void full_unlock(struct obs_scene *scene)
 	video_unlock(scene);
 }
 
+/* must be called with the scene locked, before any item that was part of
+ * the list is freed */
+static inline void clear_item_index(struct obs_scene *scene)
+{
+	struct obs_scene_item *item, *tmp;
+
+	HASH_ITER (hh_name, scene->items_by_name, item, tmp) {
+		bfree(item->index_name);
+		item->index_name = NULL;
+	}
+
+	HASH_CLEAR(hh_id, scene->items_by_id);
+	HASH_CLEAR(hh_name, scene->items_by_name);
+	scene->indexed_groups = 0;
+	scene->items_indexed = false;
+}
+
+static void index_scene_items(struct obs_scene *scene)
+{
+	long renames = os_atomic_load_long(&obs->data.source_renames);
+	struct obs_scene_item *item;
+	struct obs_scene_item *found;
+
+	if (scene->items_indexed && scene->indexed_renames == renames)
+		return;
+
+	clear_item_index(scene);
+
+	for (item = scene->first_item; item; item = item->next) {
+		const char *name = item->source->context.name;
+
+		HASH_FIND(hh_id, scene->items_by_id, &item->id, sizeof(item->id), found);
+		if (!found)
+			HASH_ADD(hh_id, scene->items_by_id, id, sizeof(item->id), item);
+
+		if (name) {
+			HASH_FIND(hh_name, scene->items_by_name, name, strlen(name), found);
+			if (!found) {
+				item->index_name = bstrdup(name);
+				HASH_ADD_KEYPTR(hh_name, scene->items_by_name, item->index_name,
+						strlen(item->index_name), item);
+			}
+		}
+
+		if (item->is_group)
+			scene->indexed_groups++;
+	}
+
+	scene->items_indexed = true;
+	scene->indexed_renames = renames;
+}
+
 static void obs_sceneitem_remove_internal(obs_sceneitem_t *item);
 
 static void remove_all_items(struct obs_scene *scene)
@@ -293,6 +346,8 @@ static void scene_enum_all_sources(void *data, obs_source_enum_proc_t enum_callb
 
 static inline void detach_sceneitem(struct obs_scene_item *item)
 {
+	clear_item_index(item->parent);
+
 	if (item->prev)
 		item->prev->next = item->next;
 	else
@@ -306,6 +361,8 @@ static inline void detach_sceneitem(struct obs_scene_item *item)
 
 static inline void attach_sceneitem(struct obs_scene *parent, struct obs_scene_item *item, struct obs_scene_item *prev)
 {
+	clear_item_index(parent);
+
 	item->prev = prev;
 	item->parent = parent;
 
@@ -614,6 +671,8 @@ static void update_item_transform(struct obs_scene_item *item, bool update_tex)
 	if (os_atomic_load_long(&item->defer_update) > 0)
 		return;
 
+	os_atomic_inc_long(&obs->video.transform_updates);
+
 	/* Reset bounds crop */
 	memset(&item->bounds_crop, 0, sizeof(item->bounds_crop));
 
@@ -1004,14 +1063,24 @@ static void scene_video_tick(void *data, float seconds)
 	UNUSED_PARAMETER(seconds);
 }
 
-/* assumes video lock */
-static void update_transforms_and_prune_sources(obs_scene_t *scene, obs_scene_item_ptr_array_t *remove_items,
+/* Only the items that are flagged, whose source size changed, or that were
+ * moved by their group are recalculated (everything is if the canvas size
+ * changed).  A group is only resized when one of its items changed, and it
+ * only counts as changed in its own parent if it was resized, so a change in
+ * a nested group only walks back up the groups that contain it.
+ *
+ * Returns whether group_sceneitem was resized.
+ *
+ * assumes video lock */
+static bool update_transforms_and_prune_sources(obs_scene_t *scene, obs_scene_item_ptr_array_t *remove_items,
 						obs_sceneitem_t *group_sceneitem, bool scene_size_changed)
 {
 	struct obs_scene_item *item = scene->first_item;
 	bool rebuild_group = group_sceneitem && os_atomic_load_bool(&group_sceneitem->update_group_resize);
 
 	while (item) {
+		bool group_resized = false;
+
 		if (obs_source_removed(item->source)) {
 			struct obs_scene_item *del_item = item;
 			item = item->next;
@@ -1026,7 +1095,8 @@ static void update_transforms_and_prune_sources(obs_scene_t *scene, obs_scene_it
 			obs_scene_t *group_scene = item->source->context.data;
 
 			video_lock(group_scene);
-			update_transforms_and_prune_sources(group_scene, remove_items, item, scene_size_changed);
+			group_resized =
+				update_transforms_and_prune_sources(group_scene, remove_items, item, scene_size_changed);
 			video_unlock(group_scene);
 		}
 
@@ -1034,13 +1104,21 @@ static void update_transforms_and_prune_sources(obs_scene_t *scene, obs_scene_it
 
 			update_item_transform(item, true);
 			rebuild_group = true;
+		} else if (group_resized) {
+			/* resize_group already recalculated the group's
+			 * transform, but its box changed in this scene */
+			rebuild_group = true;
 		}
 
 		item = item->next;
 	}
 
-	if (rebuild_group && group_sceneitem)
+	if (rebuild_group && group_sceneitem) {
 		resize_group(group_sceneitem, scene_size_changed);
+		return true;
+	}
+
+	return false;
 }
 
 static inline bool scene_size_changed(obs_scene_t *scene)
@@ -1056,6 +1134,108 @@ static inline bool scene_size_changed(obs_scene_t *scene)
 	return true;
 }
 
+/* ------------------------------------------------------------------------- */
+/* culling */
+
+/* Before drawing, items are walked from the top down and any item that can't
+ * end up in the output is skipped: items entirely outside of the scene, items
+ * that are cropped away, and items entirely covered by an item above them
+ * whose source is flagged as OBS_SOURCE_OPAQUE.  Nested scenes always draw
+ * through a texture the size of the scene, so anything outside of it would
+ * be clipped anyway, as it is by the canvas for the scenes of a view. */
+
+#define MAX_OCCLUDERS 8
+
+/* keeps the filtered edges of an occluder from counting as opaque */
+#define OCCLUDER_EDGE 1.0f
+
+static inline bool item_rendered(const struct obs_scene_item *item)
+{
+	return item->user_visible || transition_active(item->hide_transition);
+}
+
+static inline bool item_is_occluder(const struct obs_scene_item *item)
+{
+	const struct obs_source *source = item->source;
+
+	return (source->info.output_flags & OBS_SOURCE_OPAQUE) != 0 && source->enabled && !source->filters.num &&
+	       item->user_visible && !transition_active(item->show_transition) &&
+	       !transition_active(item->hide_transition) && default_blending_enabled(item) &&
+	       close_float(item->draw_transform.x.y, 0.0f, EPSILON) &&
+	       close_float(item->draw_transform.y.x, 0.0f, EPSILON);
+}
+
+static inline bool bounds_contains_2d(const struct bounds *b, const struct bounds *test)
+{
+	return b->min.x <= test->min.x && b->min.y <= test->min.y && b->max.x >= test->max.x &&
+	       b->max.y >= test->max.y;
+}
+
+static bool item_occluded(const struct bounds *b, const struct bounds *occluders, size_t num)
+{
+	for (size_t i = 0; i < num; i++) {
+		if (bounds_contains_2d(&occluders[i], b))
+			return true;
+	}
+
+	return false;
+}
+
+/* assumes video lock */
+static void cull_scene_items(struct obs_scene *scene)
+{
+	struct bounds occluders[MAX_OCCLUDERS];
+	size_t num_occluders = 0;
+	struct obs_scene_item *item = scene->first_item;
+	struct bounds scene_bounds;
+	uint32_t width = scene_getwidth(scene);
+	uint32_t height = scene_getheight(scene);
+
+	if (!item)
+		return;
+	while (item->next)
+		item = item->next;
+
+	/* an item has to reach at least one pixel center to be drawn */
+	vec3_set(&scene_bounds.min, 0.5f, 0.5f, 0.0f);
+	vec3_set(&scene_bounds.max, (float)width - 0.5f, (float)height - 0.5f, 0.0f);
+
+	for (; item; item = item->prev) {
+		struct bounds local;
+		struct bounds b;
+
+		item->culled = false;
+
+		if (!width || !height || !item_rendered(item) || !item->last_width || !item->last_height)
+			continue;
+
+		uint32_t cx = calc_cx(item, item->last_width);
+		uint32_t cy = calc_cy(item, item->last_height);
+
+		if (cx && cy) {
+			vec3_zero(&local.min);
+			vec3_set(&local.max, (float)cx, (float)cy, 0.0f);
+			bounds_transform(&b, &local, &item->draw_transform);
+
+			item->culled = !bounds_intersects(&scene_bounds, &b, 0.0f) ||
+				       item_occluded(&b, occluders, num_occluders);
+		} else {
+			item->culled = true;
+		}
+
+		if (item->culled) {
+			os_atomic_inc_long(&obs->video.culled_items);
+			continue;
+		}
+
+		if (num_occluders < MAX_OCCLUDERS && item_is_occluder(item)) {
+			struct bounds *occluder = &occluders[num_occluders++];
+			vec3_set(&occluder->min, b.min.x + OCCLUDER_EDGE, b.min.y + OCCLUDER_EDGE, b.min.z);
+			vec3_set(&occluder->max, b.max.x - OCCLUDER_EDGE, b.max.y - OCCLUDER_EDGE, b.max.z);
+		}
+	}
+}
+
 static void scene_video_render(void *data, gs_effect_t *effect)
 {
 	obs_scene_item_ptr_array_t remove_items;
@@ -1071,12 +1251,14 @@ static void scene_video_render(void *data, gs_effect_t *effect)
 		update_transforms_and_prune_sources(scene, &remove_items, NULL, size_changed);
 	}
 
+	cull_scene_items(scene);
+
 	gs_blend_state_push();
 	gs_reset_blend_state();
 
 	item = scene->first_item;
 	while (item) {
-		if (item->user_visible || transition_active(item->hide_transition))
+		if (item_rendered(item) && !item->culled)
 			render_item(item);
 
 		item = item->next;
@@ -2029,23 +2211,24 @@ obs_scene_t *obs_group_from_source(const obs_source_t *source)
 	return source->context.data;
 }
 
+static inline obs_sceneitem_t *find_item_by_name(obs_scene_t *scene, const char *name)
+{
+	obs_sceneitem_t *item;
+
+	index_scene_items(scene);
+	HASH_FIND(hh_name, scene->items_by_name, name, strlen(name), item);
+	return item;
+}
+
 obs_sceneitem_t *obs_scene_find_source(obs_scene_t *scene, const char *name)
 {
 	struct obs_scene_item *item;
 
-	if (!scene)
+	if (!scene || !name)
 		return NULL;
 
 	full_lock(scene);
-
-	item = scene->first_item;
-	while (item) {
-		if (strcmp(item->source->context.name, name) == 0)
-			break;
-
-		item = item->next;
-	}
-
+	item = find_item_by_name(scene, name);
 	full_unlock(scene);
 
 	return item;
@@ -2055,26 +2238,27 @@ obs_sceneitem_t *obs_scene_find_source_recursive(obs_scene_t *scene, const char
 {
 	struct obs_scene_item *item;
 
-	if (!scene)
+	if (!scene || !name)
 		return NULL;
 
 	full_lock(scene);
 
-	item = scene->first_item;
-	while (item) {
-		if (strcmp(item->source->context.name, name) == 0)
-			break;
+	/* the first match in list order wins, so only groups that come before
+	 * the scene's own matching item need to be searched */
+	obs_sceneitem_t *direct = find_item_by_name(scene, name);
+	item = direct;
 
-		if (item->is_group) {
-			obs_scene_t *group = item->source->context.data;
-			obs_sceneitem_t *child = obs_scene_find_source(group, name);
+	if (scene->indexed_groups) {
+		for (obs_sceneitem_t *group = scene->first_item; group && group != direct; group = group->next) {
+			if (!group->is_group)
+				continue;
+
+			obs_sceneitem_t *child = obs_scene_find_source(group->source->context.data, name);
 			if (child) {
 				item = child;
 				break;
 			}
 		}
-
-		item = item->next;
 	}
 
 	full_unlock(scene);
@@ -2090,15 +2274,8 @@ obs_sceneitem_t *obs_scene_find_sceneitem_by_id(obs_scene_t *scene, int64_t id)
 		return NULL;
 
 	full_lock(scene);
-
-	item = scene->first_item;
-	while (item) {
-		if (item->id == id)
-			break;
-
-		item = item->next;
-	}
-
+	index_scene_items(scene);
+	HASH_FIND(hh_id, scene->items_by_id, &id, sizeof(id), item);
 	full_unlock(scene);
 
 	return item;
@@ -2317,6 +2494,8 @@ static obs_sceneitem_t *obs_scene_add_internal(obs_scene_t *scene, obs_source_t
 
 	full_lock(scene);
 
+	clear_item_index(scene);
+
 	if (insert_after) {
 		obs_sceneitem_t *next = insert_after->next;
 		if (next)
@@ -3132,6 +3311,7 @@ bool obs_scene_reorder_items(obs_scene_t *scene, obs_sceneitem_t *const *item_or
 		return false;
 	}
 
+	clear_item_index(scene);
 	scene->first_item = item_order[0];
 
 	obs_sceneitem_t *prev = NULL;
@@ -3293,7 +3473,17 @@ int64_t obs_sceneitem_get_id(const obs_sceneitem_t *item)
 
 void obs_sceneitem_set_id(obs_sceneitem_t *item, int64_t id)
 {
+	obs_scene_t *scene = item->parent;
+
+	if (!scene) {
+		item->id = id;
+		return;
+	}
+
+	full_lock(scene);
 	item->id = id;
+	clear_item_index(scene);
+	full_unlock(scene);
 }
 
 obs_data_t *obs_sceneitem_get_private_settings(obs_sceneitem_t *item)
@@ -3413,6 +3603,9 @@ static void apply_group_transform(obs_sceneitem_t *item, obs_sceneitem_t *group)
 	update_item_transform(item, false);
 }
 
+/* in pixels, anything below this is rounding noise from the transforms */
+#define MIN_RESIZE_OFFSET 0.0001f
+
 static bool resize_scene_base(obs_scene_t *scene, struct vec2 *minv, struct vec2 *maxv, struct vec2 *scale)
 {
 	vec2_set(minv, M_INFINITE, M_INFINITE);
@@ -3450,8 +3643,14 @@ static bool resize_scene_base(obs_scene_t *scene, struct vec2 *minv, struct vec2
 		item = item->next;
 	}
 
+	/* the items only need to be moved (and their transforms recalculated)
+	 * if the top-left corner of the scene moved.  Otherwise the offset is
+	 * dropped, so that the group isn't moved by it either and doesn't
+	 * drift a little further on every resize. */
 	item = scene->first_item;
-	if (item) {
+	if (fabsf(minv->x) <= MIN_RESIZE_OFFSET && fabsf(minv->y) <= MIN_RESIZE_OFFSET) {
+		vec2_zero(minv);
+	} else {
 		struct vec2 minv_rel;
 		if (!item->absolute_coordinates)
 			size_from_absolute(&minv_rel, minv, item);
@@ -3560,6 +3759,7 @@ obs_sceneitem_t *obs_scene_insert_group(obs_scene_t *scene, const char *name, ob
 
 	full_lock(scene);
 	full_lock(sub_scene);
+	clear_item_index(sub_scene);
 	sub_scene->first_item = items[0];
 
 	for (size_t i = count; i > 0; i--) {
@@ -3877,6 +4077,7 @@ bool obs_scene_reorder_items2(obs_scene_t *scene, struct obs_sceneitem_order_inf
 		}
 	}
 
+	clear_item_index(scene);
 	scene->first_item = item_order[0].item;
 
 	obs_sceneitem_t *prev = NULL;
@@ -3888,11 +4089,12 @@ bool obs_scene_reorder_items2(obs_scene_t *scene, struct obs_sceneitem_order_inf
 			obs_sceneitem_t *sub_prev = NULL;
 			obs_scene_t *sub_scene = info->item->source->context.data;
 
-			sub_scene->first_item = NULL;
-
 			obs_scene_addref(sub_scene);
 			full_lock(sub_scene);
 
+			clear_item_index(sub_scene);
+			sub_scene->first_item = NULL;
+
 			for (i++; i < item_order_size; i++) {
 				struct obs_sceneitem_order_info *sub_info = &item_order[i];
 				obs_sceneitem_t *sub_item = sub_info->item;
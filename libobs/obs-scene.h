@@ -19,6 +19,7 @@
 
 #include "obs.h"
 #include "graphics/matrix4.h"
+#include "util/uthash.h"
 
 /* how obs scene! */
 
@@ -36,6 +37,9 @@ struct obs_scene_item {
 	bool update_transform;
 	bool update_group_resize;
 
+	/* set by the culling pass when the item can't be seen this render */
+	bool culled;
+
 	int64_t id;
 
 	struct obs_scene *parent;
@@ -94,6 +98,13 @@ struct obs_scene_item {
 	/* would do **prev_next, but not really great for reordering */
 	struct obs_scene_item *prev;
 	struct obs_scene_item *next;
+
+	UT_hash_handle hh_id;
+	UT_hash_handle hh_name;
+
+	/* copy of the source name the item is indexed under, renames swap out
+	 * and free the source's own name without taking any scene lock */
+	char *index_name;
 };
 
 struct obs_scene {
@@ -113,4 +124,13 @@ struct obs_scene {
 	pthread_mutex_t video_mutex;
 	pthread_mutex_t audio_mutex;
 	struct obs_scene_item *first_item;
+
+	/* Lookup indexes for first_item (uthash), built on the first lookup
+	 * after the list changed or any source got renamed.  Only the first
+	 * item in list order is indexed for a given id or name. */
+	struct obs_scene_item *items_by_id;
+	struct obs_scene_item *items_by_name;
+	size_t indexed_groups;
+	bool items_indexed;
+	long indexed_renames;
 };
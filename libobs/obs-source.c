@@ -226,6 +226,7 @@ static bool obs_source_init(struct obs_source *source)
 	pthread_mutex_init_value(&source->audio_cb_mutex);
 	pthread_mutex_init_value(&source->caption_cb_mutex);
 	pthread_mutex_init_value(&source->media_actions_mutex);
+	pthread_mutex_init_value(&source->settings_snapshot_mutex);
 
 	if (pthread_mutex_init_recursive(&source->filter_mutex) != 0)
 		return false;
@@ -243,6 +244,8 @@ static bool obs_source_init(struct obs_source *source)
 		return false;
 	if (pthread_mutex_init(&source->media_actions_mutex, NULL) != 0)
 		return false;
+	if (pthread_mutex_init(&source->settings_snapshot_mutex, NULL) != 0)
+		return false;
 
 	if (is_audio_source(source) || is_composite_source(source))
 		allocate_audio_output_buffer(source);
@@ -263,6 +266,25 @@ static bool obs_source_init(struct obs_source *source)
 	return true;
 }
 
+/* Called from whichever thread changes the settings.  Scenes are skipped,
+ * their settings only hold the item list they were saved with. */
+static void obs_source_update_settings_snapshot(struct obs_source *source)
+{
+	obs_data_snapshot_t *snapshot;
+
+	if (source->info.type == OBS_SOURCE_TYPE_SCENE)
+		return;
+
+	snapshot = obs_data_snapshot_create(source->context.settings);
+
+	pthread_mutex_lock(&source->settings_snapshot_mutex);
+	obs_data_snapshot_t *prev = source->settings_snapshot;
+	source->settings_snapshot = snapshot;
+	pthread_mutex_unlock(&source->settings_snapshot_mutex);
+
+	obs_data_snapshot_release(prev);
+}
+
 static void obs_source_init_finalize(struct obs_source *source, obs_canvas_t *canvas)
 {
 	if (is_audio_source(source)) {
@@ -421,6 +443,8 @@ static obs_source_t *obs_source_create_internal(const char *id, const char *name
 	if (!private)
 		obs_source_init_audio_hotkeys(source);
 
+	obs_source_update_settings_snapshot(source);
+
 	/* allow the source to be created even if creation fails so that the
 	 * user's data doesn't become lost */
 	if (info && info->create)
@@ -428,6 +452,10 @@ static obs_source_t *obs_source_create_internal(const char *id, const char *name
 	if ((!info || info->create) && !source->context.data)
 		blog(LOG_ERROR, "Failed to create source '%s'!", name);
 
+	/* create often migrates or fills in settings */
+	if (info && info->create)
+		obs_source_update_settings_snapshot(source);
+
 	blog(LOG_DEBUG, "%ssource '%s' (%s) created", private ? "private " : "", name, id);
 
 	source->flags = source->default_flags;
@@ -632,10 +660,21 @@ void obs_source_frame_init(struct obs_source_frame *frame, enum video_format for
 	}
 }
 
+/* frames of the async cache and the preload frame come from the shared pool */
+static inline struct obs_source_frame *async_frame_create(enum video_format format, uint32_t width, uint32_t height)
+{
+	return frame_pool_create_frame(&obs->data.frame_pool, format, width, height);
+}
+
+static inline void async_frame_destroy(struct obs_source_frame *frame)
+{
+	frame_pool_destroy_frame(&obs->data.frame_pool, frame);
+}
+
 static inline void obs_source_frame_decref(struct obs_source_frame *frame)
 {
 	if (os_atomic_dec_long(&frame->refs) == 0)
-		obs_source_frame_destroy(frame);
+		async_frame_destroy(frame);
 }
 
 static bool obs_source_filter_remove_refless(obs_source_t *source, obs_source_t *filter);
@@ -742,11 +781,15 @@ static void obs_source_destroy_defer(struct obs_source *source)
 		bfree(source->audio_data.data[i]);
 	for (i = 0; i < MAX_AUDIO_CHANNELS; i++)
 		deque_free(&source->audio_input_buf[i]);
+	if (source->audio_input_ring.overruns)
+		blog(LOG_DEBUG, "source '%s': audio input queue was full %ld times", source->context.name,
+		     source->audio_input_ring.overruns);
+	float_ring_free(&source->audio_input_ring);
 	audio_resampler_destroy(source->resampler);
 	bfree(source->audio_output_buf[0][0]);
 	bfree(source->audio_mix_buf[0]);
 
-	obs_source_frame_destroy(source->async_preload_frame);
+	async_frame_destroy(source->async_preload_frame);
 
 	if (source->info.type == OBS_SOURCE_TYPE_TRANSITION)
 		obs_transition_free(source);
@@ -766,6 +809,8 @@ static void obs_source_destroy_defer(struct obs_source *source)
 	pthread_mutex_destroy(&source->caption_cb_mutex);
 	pthread_mutex_destroy(&source->async_mutex);
 	pthread_mutex_destroy(&source->media_actions_mutex);
+	pthread_mutex_destroy(&source->settings_snapshot_mutex);
+	obs_data_snapshot_release(source->settings_snapshot);
 	obs_data_release(source->private_settings);
 	obs_context_data_free(&source->context);
 
@@ -994,7 +1039,8 @@ static void obs_source_deferred_update(obs_source_t *source)
 		long count = os_atomic_load_long(&source->defer_update_count);
 		source->info.update(source->context.data, source->context.settings);
 		os_atomic_compare_swap_long(&source->defer_update_count, count, 0);
-		obs_source_dosignal(source, "source_update", "update");
+		obs_source_update_settings_snapshot(source);
+		obs_source_dosignal_id(source, obs->signal_ids.source_update, obs->signal_ids.update);
 	}
 }
 
@@ -1007,11 +1053,18 @@ void obs_source_update(obs_source_t *source, obs_data_t *settings)
 		obs_data_apply(source->context.settings, settings);
 	}
 
+	/* update callbacks can change the settings again, so the snapshot is
+	 * refreshed after they run (video sources also get one right away,
+	 * their update is deferred to the video thread) */
 	if (source->info.output_flags & OBS_SOURCE_VIDEO) {
+		obs_source_update_settings_snapshot(source);
 		os_atomic_inc_long(&source->defer_update_count);
 	} else if (source->context.data && source->info.update) {
 		source->info.update(source->context.data, source->context.settings);
-		obs_source_dosignal(source, "source_update", "update");
+		obs_source_update_settings_snapshot(source);
+		obs_source_dosignal_id(source, obs->signal_ids.source_update, obs->signal_ids.update);
+	} else {
+		obs_source_update_settings_snapshot(source);
 	}
 }
 
@@ -1231,27 +1284,27 @@ void process_media_actions(obs_source_t *source)
 			source->info.media_play_pause(source->context.data, action.pause);
 
 			if (action.pause)
-				obs_source_dosignal(source, NULL, "media_pause");
+				obs_source_dosignal_id(source, NULL, obs->signal_ids.media_pause);
 			else
-				obs_source_dosignal(source, NULL, "media_play");
+				obs_source_dosignal_id(source, NULL, obs->signal_ids.media_play);
 			break;
 
 		case MEDIA_ACTION_RESTART:
 			source->info.media_restart(source->context.data);
-			obs_source_dosignal(source, NULL, "media_restart");
+			obs_source_dosignal_id(source, NULL, obs->signal_ids.media_restart);
 			break;
 
 		case MEDIA_ACTION_STOP:
 			source->info.media_stop(source->context.data);
-			obs_source_dosignal(source, NULL, "media_stopped");
+			obs_source_dosignal_id(source, NULL, obs->signal_ids.media_stopped);
 			break;
 		case MEDIA_ACTION_NEXT:
 			source->info.media_next(source->context.data);
-			obs_source_dosignal(source, NULL, "media_next");
+			obs_source_dosignal_id(source, NULL, obs->signal_ids.media_next);
 			break;
 		case MEDIA_ACTION_PREVIOUS:
 			source->info.media_previous(source->context.data);
-			obs_source_dosignal(source, NULL, "media_previous");
+			obs_source_dosignal_id(source, NULL, obs->signal_ids.media_previous);
 			break;
 		case MEDIA_ACTION_SET_TIME:
 			source->info.media_set_time(source->context.data, action.ms);
@@ -1289,12 +1342,12 @@ static void async_tick(obs_source_t *source)
 	pthread_mutex_unlock(&source->async_mutex);
 }
 
-void obs_source_video_tick(obs_source_t *source, float seconds)
+bool obs_source_video_tick_prepare(obs_source_t *source, float seconds)
 {
 	bool now_showing, now_active;
 
 	if (!obs_source_valid(source, "obs_source_video_tick"))
-		return;
+		return false;
 
 	if (source->info.type == OBS_SOURCE_TYPE_TRANSITION)
 		obs_transition_tick(source, seconds);
@@ -1358,11 +1411,16 @@ void obs_source_video_tick(obs_source_t *source, float seconds)
 		source->active = now_active;
 	}
 
-	if (source->context.data && source->info.video_tick)
-		source->info.video_tick(source->context.data, seconds);
-
 	source->async_rendered = false;
 	source->deinterlace_rendered = false;
+
+	return source->context.data && source->info.video_tick;
+}
+
+void obs_source_video_tick(obs_source_t *source, float seconds)
+{
+	if (obs_source_video_tick_prepare(source, seconds))
+		source->info.video_tick(source->context.data, seconds);
 }
 
 /* unless the value is 3+ hours worth of frames, this won't overflow */
@@ -1392,7 +1450,7 @@ static inline void reset_audio_timing(obs_source_t *source, uint64_t timestamp,
 	source->timing_adjust = os_time - timestamp;
 }
 
-static void reset_audio_data(obs_source_t *source, uint64_t os_time)
+static void clear_audio_input(obs_source_t *source)
 {
 	for (size_t i = 0; i < MAX_AUDIO_CHANNELS; i++) {
 		if (source->audio_input_buf[i].size)
@@ -1400,10 +1458,118 @@ static void reset_audio_data(obs_source_t *source, uint64_t os_time)
 	}
 
 	source->last_audio_input_buf_size = 0;
+}
+
+static void reset_audio_data(obs_source_t *source, uint64_t os_time)
+{
+	audio_input_flush(source);
+	clear_audio_input(source);
+
 	source->audio_ts = os_time;
 	source->next_audio_sys_ts_min = os_time;
 }
 
+/* ------------------------------------------------------------------------- */
+/* Audio input queue
+ *
+ * Audio that continues where the previous audio left off (the common case) is
+ * queued in a lock-free ring by the thread that outputs it, and moved into
+ * audio_input_buf by whichever thread holds audio_buf_mutex next: the audio
+ * thread when it renders or discards the source's audio, or the outputting
+ * thread itself when it has to place audio at a timestamp, reset the buffers
+ * or the ring is full.  Calls to source_output_audio_data are serialized by
+ * audio_mutex, so the ring only ever has one writer, and only the holder of
+ * audio_buf_mutex reads from it. */
+
+#define AUDIO_INPUT_RING_FRAMES (AUDIO_OUTPUT_FRAMES * 16)
+
+static bool audio_input_queue(obs_source_t *source, const struct audio_data *in, size_t channels)
+{
+	struct float_ring *ring = &source->audio_input_ring;
+	long write = source->audio_input_packets_write;
+	long read = os_atomic_load_long(&source->audio_input_packets_read);
+	const float *planes[MAX_AUDIO_CHANNELS];
+	struct audio_input_packet *packet;
+
+	/* the ring is only read once it has a packet */
+	if (!ring->data)
+		float_ring_init(ring, channels, AUDIO_INPUT_RING_FRAMES);
+	if (ring->planes != channels)
+		return false;
+
+	if ((unsigned long)(write - read) >= AUDIO_INPUT_PACKETS) {
+		os_atomic_inc_long(&ring->overruns);
+		return false;
+	}
+
+	for (size_t i = 0; i < channels; i++)
+		planes[i] = (const float *)in->data[i];
+
+	if (!float_ring_write(ring, planes, in->frames))
+		return false;
+
+	packet = &source->audio_input_packets[(unsigned long)write % AUDIO_INPUT_PACKETS];
+	packet->timestamp = in->timestamp;
+	packet->frames = in->frames;
+
+	os_atomic_set_long(&source->audio_input_packets_write, write + 1);
+	return true;
+}
+
+static void push_back_ring_frames(struct deque *dq, struct float_ring *ring, size_t plane, size_t frames)
+{
+	size_t offset = 0;
+
+	while (offset < frames) {
+		size_t count;
+		const float *data = float_ring_peek(ring, plane, offset, &count);
+
+		if (!count)
+			break;
+		if (count > frames - offset)
+			count = frames - offset;
+
+		deque_push_back(dq, data, count * sizeof(float));
+		offset += count;
+	}
+}
+
+void audio_input_flush(obs_source_t *source)
+{
+	struct float_ring *ring = &source->audio_input_ring;
+	long read = source->audio_input_packets_read;
+	long write = os_atomic_load_long(&source->audio_input_packets_write);
+
+	if (read == write)
+		return;
+
+	for (; read != write; read++) {
+		struct audio_input_packet *packet =
+			&source->audio_input_packets[(unsigned long)read % AUDIO_INPUT_PACKETS];
+		size_t size = packet->frames * sizeof(float);
+
+		/* what source_output_audio_place does without a timestamp */
+		if (!source->audio_ts) {
+			clear_audio_input(source);
+			source->audio_ts = packet->timestamp;
+		}
+
+		/* do not allow the circular buffers to become too big */
+		if ((source->audio_input_buf[0].size + size) <= MAX_BUF_SIZE) {
+			for (size_t i = 0; i < ring->planes; i++)
+				push_back_ring_frames(&source->audio_input_buf[i], ring, i, packet->frames);
+		}
+
+		float_ring_advance(ring, packet->frames);
+	}
+
+	os_atomic_set_long(&source->audio_input_packets_read, read);
+
+	/* reset audio input buffer size to ensure that audio doesn't get
+	 * perpetually cut */
+	source->last_audio_input_buf_size = 0;
+}
+
 static void handle_ts_jump(obs_source_t *source, uint64_t expected, uint64_t ts, uint64_t diff, uint64_t os_time)
 {
 	blog(LOG_DEBUG,
@@ -1547,8 +1713,6 @@ static void source_output_audio_data(obs_source_t *source, const struct audio_da
 
 	in.timestamp += source->timing_adjust;
 
-	pthread_mutex_lock(&source->audio_buf_mutex);
-
 	if (source->next_audio_sys_ts_min == in.timestamp) {
 		push_back = true;
 
@@ -1583,13 +1747,20 @@ static void source_output_audio_data(obs_source_t *source, const struct audio_da
 	}
 
 	if (source->monitoring_type != OBS_MONITORING_TYPE_MONITOR_ONLY) {
-		if (push_back && source->audio_ts)
-			source_output_audio_push_back(source, &in);
-		else
-			source_output_audio_place(source, &in);
-	}
+		size_t channels = audio_output_get_channels(obs->audio.audio);
 
-	pthread_mutex_unlock(&source->audio_buf_mutex);
+		if (!push_back || !audio_input_queue(source, &in, channels)) {
+			pthread_mutex_lock(&source->audio_buf_mutex);
+			audio_input_flush(source);
+
+			if (push_back && source->audio_ts)
+				source_output_audio_push_back(source, &in);
+			else
+				source_output_audio_place(source, &in);
+
+			pthread_mutex_unlock(&source->audio_buf_mutex);
+		}
+	}
 
 	source_signal_audio_data(source, data, source_muted(source, os_time));
 }
@@ -3263,6 +3434,21 @@ obs_data_t *obs_source_get_settings(const obs_source_t *source)
 	return source->context.settings;
 }
 
+obs_data_snapshot_t *obs_source_get_settings_snapshot(obs_source_t *source)
+{
+	obs_data_snapshot_t *snapshot;
+
+	if (!obs_source_valid(source, "obs_source_get_settings_snapshot"))
+		return NULL;
+
+	pthread_mutex_lock(&source->settings_snapshot_mutex);
+	snapshot = source->settings_snapshot;
+	obs_data_snapshot_addref(snapshot);
+	pthread_mutex_unlock(&source->settings_snapshot_mutex);
+
+	return snapshot;
+}
+
 struct obs_source_frame *filter_async_video(obs_source_t *source, struct obs_source_frame *in)
 {
 	size_t i;
@@ -3428,7 +3614,7 @@ static void clean_cache(obs_source_t *source)
 		struct async_frame *af = &source->async_cache.array[i - 1];
 		if (!af->used) {
 			if (++af->unused_count == MAX_UNUSED_FRAME_DURATION) {
-				obs_source_frame_destroy(af->frame);
+				async_frame_destroy(af->frame);
 				da_erase(source->async_cache, i - 1);
 			}
 		}
@@ -3436,7 +3622,7 @@ static void clean_cache(obs_source_t *source)
 }
 
 #define MAX_ASYNC_FRAMES 30
-//if return value is not null then do (os_atomic_dec_long(&output->refs) == 0) && obs_source_frame_destroy(output)
+//if return value is not null then do (os_atomic_dec_long(&output->refs) == 0) && async_frame_destroy(output)
 static inline struct obs_source_frame *cache_video(struct obs_source *source, const struct obs_source_frame *frame)
 {
 	struct obs_source_frame *new_frame = NULL;
@@ -3477,7 +3663,7 @@ static inline struct obs_source_frame *cache_video(struct obs_source *source, co
 	if (!new_frame) {
 		struct async_frame new_af;
 
-		new_frame = obs_source_frame_create(format, frame->width, frame->height);
+		new_frame = async_frame_create(format, frame->width, frame->height);
 		new_af.frame = new_frame;
 		new_af.used = true;
 		new_af.unused_count = 0;
@@ -3517,7 +3703,7 @@ static void obs_source_output_video_internal(obs_source_t *source, const struct
 	pthread_mutex_lock(&source->async_mutex);
 	if (output) {
 		if (os_atomic_dec_long(&output->refs) == 0) {
-			obs_source_frame_destroy(output);
+			async_frame_destroy(output);
 			output = NULL;
 		} else {
 			da_push_back(source->async_frames, &output);
@@ -3643,8 +3829,8 @@ static void obs_source_preload_video_internal(obs_source_t *source, const struct
 		return;
 
 	if (preload_frame_changed(source, frame)) {
-		obs_source_frame_destroy(source->async_preload_frame);
-		source->async_preload_frame = obs_source_frame_create(frame->format, frame->width, frame->height);
+		async_frame_destroy(source->async_preload_frame);
+		source->async_preload_frame = async_frame_create(frame->format, frame->width, frame->height);
 	}
 
 	copy_frame_data(source->async_preload_frame, frame);
@@ -3720,11 +3906,13 @@ void obs_source_show_preloaded_video(obs_source_t *source)
 
 	obs_leave_graphics();
 
+	pthread_mutex_lock(&source->audio_mutex);
 	pthread_mutex_lock(&source->audio_buf_mutex);
 	sys_ts = (source->monitoring_type != OBS_MONITORING_TYPE_MONITOR_ONLY) ? os_gettime_ns() : 0;
 	reset_audio_timing(source, source->last_frame_ts, sys_ts);
 	reset_audio_data(source, sys_ts);
 	pthread_mutex_unlock(&source->audio_buf_mutex);
+	pthread_mutex_unlock(&source->audio_mutex);
 }
 
 static void obs_source_set_video_frame_internal(obs_source_t *source, const struct obs_source_frame *frame)
@@ -3737,8 +3925,8 @@ static void obs_source_set_video_frame_internal(obs_source_t *source, const stru
 	obs_enter_graphics();
 
 	if (preload_frame_changed(source, frame)) {
-		obs_source_frame_destroy(source->async_preload_frame);
-		source->async_preload_frame = obs_source_frame_create(frame->format, frame->width, frame->height);
+		async_frame_destroy(source->async_preload_frame);
+		source->async_preload_frame = async_frame_create(frame->format, frame->width, frame->height);
 	}
 
 	copy_frame_data(source->async_preload_frame, frame);
@@ -4158,12 +4346,12 @@ void obs_source_release_frame(obs_source_t *source, struct obs_source_frame *fra
 		return;
 
 	if (!source) {
-		obs_source_frame_destroy(frame);
+		async_frame_destroy(frame);
 	} else {
 		pthread_mutex_lock(&source->async_mutex);
 
 		if (os_atomic_dec_long(&frame->refs) == 0)
-			obs_source_frame_destroy(frame);
+			async_frame_destroy(frame);
 		else
 			remove_async_frame(source, frame);
 
@@ -4187,8 +4375,13 @@ void obs_source_set_name(obs_source_t *source, const char *name)
 		return;
 
 	if (!name || !*name || !source->context.name || strcmp(name, source->context.name) != 0) {
+		/* scene name indexes built while the name is being swapped
+		 * still have the old one, so bump again once it is in place */
+		os_atomic_inc_long(&obs->data.source_renames);
+
 		if (requires_canvas(source)) {
 			obs_canvas_rename_source(source, name);
+			os_atomic_inc_long(&obs->data.source_renames);
 		} else {
 			struct calldata data;
 			char *prev_name = bstrdup(source->context.name);
@@ -4198,6 +4391,7 @@ void obs_source_set_name(obs_source_t *source, const char *name)
 			} else {
 				obs_context_data_setname(&source->context, name);
 			}
+			os_atomic_inc_long(&obs->data.source_renames);
 
 			calldata_init(&data);
 			calldata_set_ptr(&data, "source", source);
@@ -4459,9 +4653,9 @@ void obs_source_set_volume(obs_source_t *source, float volume)
 		calldata_set_ptr(&data, "source", source);
 		calldata_set_float(&data, "volume", volume);
 
-		signal_handler_signal(source->context.signals, "volume", &data);
+		signal_handler_signal_id(source->context.signals, obs->signal_ids.volume, &data);
 		if (!source->context.private)
-			signal_handler_signal(obs->signals, "source_volume", &data);
+			signal_handler_signal_id(obs->signals, obs->signal_ids.source_volume, &data);
 
 		volume = (float)calldata_float(&data, "volume");
 
@@ -4683,8 +4877,10 @@ void obs_source_load(obs_source_t *source)
 {
 	if (!data_valid(source, "obs_source_load"))
 		return;
-	if (source->info.load)
+	if (source->info.load) {
 		source->info.load(source->context.data, source->context.settings);
+		obs_source_update_settings_snapshot(source);
+	}
 
 	obs_source_dosignal(source, "source_load", "load");
 }
@@ -5260,6 +5456,7 @@ static void apply_audio_volume(obs_source_t *source, uint32_t mixers, size_t cha
 	if (vol == 0.0f || mixers == 0) {
 		memset(source->audio_output_buf[0][0], 0,
 		       AUDIO_OUTPUT_FRAMES * sizeof(float) * MAX_AUDIO_CHANNELS * MAX_AUDIO_MIXES);
+		source->audio_output_mixes = 0;
 		return;
 	}
 
@@ -5293,6 +5490,8 @@ static void custom_audio_render(obs_source_t *source, uint32_t mixers, size_t ch
 	if (!success || !source->audio_ts || !mixers)
 		return;
 
+	source->audio_output_mixes = source->audio_mixers & mixers;
+
 	for (size_t mix = 0; mix < MAX_AUDIO_MIXES; mix++) {
 		uint32_t mix_bit = 1 << mix;
 
@@ -5343,6 +5542,7 @@ static inline void process_audio_source_tick(obs_source_t *source, uint32_t mixe
 	bool audio_submix = !!(source->info.output_flags & OBS_SOURCE_SUBMIX);
 
 	pthread_mutex_lock(&source->audio_buf_mutex);
+	audio_input_flush(source);
 
 	if (source->audio_input_buf[0].size < size) {
 		source->audio_pending = true;
@@ -5376,6 +5576,7 @@ static inline void process_audio_source_tick(obs_source_t *source, uint32_t mixe
 	}
 
 	if (audio_submix) {
+		source->audio_output_mixes = ~(uint32_t)0;
 		source->audio_pending = false;
 		return;
 	}
@@ -5383,6 +5584,8 @@ static inline void process_audio_source_tick(obs_source_t *source, uint32_t mixe
 	if ((source->audio_mixers & 1) == 0 || (mixers & 1) == 0)
 		memset(source->audio_output_buf[0][0], 0, size * channels);
 
+	source->audio_output_mixes = source->audio_mixers & mixers;
+
 	apply_audio_volume(source, mixers, channels, sample_rate);
 	source->audio_pending = false;
 }
@@ -5556,10 +5759,12 @@ void obs_source_set_async_decoupled(obs_source_t *source, bool decouple)
 
 	source->async_decoupled = decouple;
 	if (decouple) {
+		pthread_mutex_lock(&source->audio_mutex);
 		pthread_mutex_lock(&source->audio_buf_mutex);
 		source->timing_set = false;
 		reset_audio_data(source, 0);
 		pthread_mutex_unlock(&source->audio_buf_mutex);
+		pthread_mutex_unlock(&source->audio_mutex);
 	}
 }
 
@@ -5801,7 +6006,7 @@ void obs_source_media_started(obs_source_t *source)
 	if ((source->info.output_flags & OBS_SOURCE_CONTROLLABLE_MEDIA) == 0)
 		return;
 
-	obs_source_dosignal(source, NULL, "media_started");
+	obs_source_dosignal_id(source, NULL, obs->signal_ids.media_started);
 }
 
 void obs_source_media_ended(obs_source_t *source)
@@ -5811,7 +6016,7 @@ void obs_source_media_ended(obs_source_t *source)
 	if ((source->info.output_flags & OBS_SOURCE_CONTROLLABLE_MEDIA) == 0)
 		return;
 
-	obs_source_dosignal(source, NULL, "media_ended");
+	obs_source_dosignal_id(source, NULL, obs->signal_ids.media_ended);
 }
 
 obs_data_array_t *obs_source_backup_filters(obs_source_t *source)
@@ -208,6 +208,23 @@ enum obs_media_state {
  */
 #define OBS_SOURCE_REQUIRES_CANVAS (1 << 17)
 
+/**
+ * Source's video_tick can run on a worker thread, concurrently with the
+ * ticks of other sources.  It must not use the graphics subsystem or
+ * depend on other sources having been ticked.  It is still guaranteed to
+ * finish before the source is rendered.
+ */
+#define OBS_SOURCE_THREADSAFE_TICK (1 << 18)
+
+/**
+ * Every pixel the source draws within its width and height is fully opaque,
+ * so scene items below it can be skipped when it covers them.  Only set this
+ * if the source draws its whole area on every frame, including before it has
+ * anything to show; the source still isn't treated as opaque when it has
+ * filters.
+ */
+#define OBS_SOURCE_OPAQUE (1 << 19)
+
 /** @} */
 
 typedef void (*obs_source_enum_proc_t)(obs_source_t *parent, obs_source_t *child, void *param);
@@ -29,6 +29,54 @@
 #include <windows.h>
 #endif
 
+#define MAX_TICK_BATCHES 16
+
+struct tick_batch {
+	obs_source_t **sources;
+	uint64_t *tick_times;
+	size_t num;
+	float seconds;
+};
+
+static void tick_batch(void *param)
+{
+	struct tick_batch *batch = param;
+
+	for (size_t i = 0; i < batch->num; i++) {
+		obs_source_t *s = batch->sources[i];
+		const uint64_t start = os_gettime_ns();
+
+		s->info.video_tick(s->context.data, batch->seconds);
+		batch->tick_times[i] = os_gettime_ns() - start;
+	}
+}
+
+/* Queues the ticks of sources that have OBS_SOURCE_THREADSAFE_TICK set, the
+ * rest of the tick (show/hide, activation, deferred updates and so on) is
+ * still done on the graphics thread before the source's tick is queued. */
+static size_t queue_pooled_ticks(struct obs_core_data *data, struct tick_batch *batches, float seconds)
+{
+	size_t num = data->pooled_ticks.num;
+	size_t num_batches = num < MAX_TICK_BATCHES ? num : MAX_TICK_BATCHES;
+
+	da_resize(data->pooled_tick_times, num);
+
+	for (size_t i = 0; i < num_batches; i++) {
+		size_t start = num * i / num_batches;
+		size_t end = num * (i + 1) / num_batches;
+
+		batches[i].sources = data->pooled_ticks.array + start;
+		batches[i].tick_times = data->pooled_tick_times.array + start;
+		batches[i].num = end - start;
+		batches[i].seconds = seconds;
+
+		if (!os_task_group_submit(data->tick_group, tick_batch, &batches[i], OS_TASK_PRIORITY_HIGH))
+			tick_batch(&batches[i]);
+	}
+
+	return num_batches;
+}
+
 static uint64_t tick_sources(uint64_t cur_time, uint64_t last_time)
 {
 	struct obs_core_data *data = &obs->data;
@@ -72,11 +120,41 @@ static uint64_t tick_sources(uint64_t cur_time, uint64_t last_time)
 
 	pthread_mutex_unlock(&data->sources_mutex);
 
+	/* ------------------------------------- */
+	/* queue the thread-safe ticks first so  */
+	/* they overlap with the other ticks     */
+
+	struct tick_batch batches[MAX_TICK_BATCHES];
+	size_t num_batches = 0;
+
+	da_resize(data->pooled_ticks, 0);
+
+	for (size_t i = 0; i < data->sources_to_tick.num; i++) {
+		obs_source_t *s = data->sources_to_tick.array[i];
+
+		if (!data->tick_group)
+			break;
+		if ((s->info.output_flags & OBS_SOURCE_THREADSAFE_TICK) == 0)
+			continue;
+
+		if (!obs_source_removed(s) && obs_source_video_tick_prepare(s, seconds))
+			da_push_back(data->pooled_ticks, &s);
+		else
+			obs_source_release(s);
+
+		data->sources_to_tick.array[i] = NULL;
+	}
+
+	if (data->pooled_ticks.num)
+		num_batches = queue_pooled_ticks(data, batches, seconds);
+
 	/* ------------------------------------- */
 	/* call the tick function of each source */
 
 	for (size_t i = 0; i < data->sources_to_tick.num; i++) {
 		obs_source_t *s = data->sources_to_tick.array[i];
+		if (!s)
+			continue;
 		if (!obs_source_removed(s)) {
 			const uint64_t start = source_profiler_source_tick_start();
 			obs_source_video_tick(s, seconds);
@@ -85,6 +163,17 @@ static uint64_t tick_sources(uint64_t cur_time, uint64_t last_time)
 		obs_source_release(s);
 	}
 
+	if (num_batches)
+		os_task_group_wait(data->tick_group);
+
+	for (size_t i = 0; i < data->pooled_ticks.num; i++) {
+		obs_source_t *s = data->pooled_ticks.array[i];
+		source_profiler_source_tick_submit(s, data->pooled_tick_times.array[i]);
+		obs_source_release(s);
+	}
+
+	frame_pool_trim(&data->frame_pool);
+
 	return cur_time;
 }
 
@@ -599,43 +688,135 @@ static inline bool download_frame(struct obs_core_video_mix *video, int prev_tex
 	return true;
 }
 
-static const uint8_t *set_gpu_converted_plane(uint32_t width, uint32_t height, uint32_t linesize_input,
-					      uint32_t linesize_output, const uint8_t *in, uint8_t *out)
+/* Frames smaller than this are not worth handing to the thread pool */
+#define VIDEO_COPY_PARALLEL_MIN_SIZE (8 * 1024 * 1024)
+
+static void copy_plane_rows(const struct video_copy_plane *plane, uint32_t start_y, uint32_t end_y)
 {
-	if ((width == linesize_input) && (width == linesize_output)) {
-		size_t total = (size_t)width * (size_t)height;
-		memcpy(out, in, total);
-		in += total;
+	const uint8_t *in = plane->in + (size_t)start_y * plane->in_linesize;
+	uint8_t *out = plane->out + (size_t)start_y * plane->out_linesize;
+
+	if ((plane->width == plane->in_linesize) && (plane->width == plane->out_linesize)) {
+		memcpy(out, in, (size_t)plane->width * (size_t)(end_y - start_y));
 	} else {
-		for (size_t y = 0; y < height; y++) {
-			memcpy(out, in, width);
-			out += linesize_output;
-			in += linesize_input;
+		for (uint32_t y = start_y; y < end_y; y++) {
+			memcpy(out, in, plane->width);
+			out += plane->out_linesize;
+			in += plane->in_linesize;
 		}
 	}
+}
 
-	return in;
+static void copy_planes_band(const struct video_copy_job *job, size_t band)
+{
+	for (size_t i = 0; i < job->num_planes; i++) {
+		const struct video_copy_plane *plane = &job->planes[i];
+		const uint32_t start_y = (uint32_t)((uint64_t)plane->height * band / job->num_bands);
+		const uint32_t end_y = (uint32_t)((uint64_t)plane->height * (band + 1) / job->num_bands);
+
+		if (start_y < end_y)
+			copy_plane_rows(plane, start_y, end_y);
+	}
+}
+
+static void copy_band_task(void *param)
+{
+	struct video_copy_band *band = param;
+	copy_planes_band(band->job, band->band);
+}
+
+bool obs_init_video_copy_job(void)
+{
+	struct video_copy_job *job = &obs->video.copy_job;
+	int num_bands = os_get_physical_cores();
+
+	memset(job, 0, sizeof(*job));
+
+	if (num_bands > MAX_VIDEO_COPY_BANDS)
+		num_bands = MAX_VIDEO_COPY_BANDS;
+	if (num_bands <= 1)
+		return true;
+
+	job->group = os_task_group_create();
+	if (!job->group)
+		return false;
+
+	for (int i = 0; i < num_bands; i++) {
+		job->bands[i].job = job;
+		job->bands[i].band = (size_t)i;
+	}
+
+	job->max_bands = (size_t)num_bands;
+	return true;
+}
+
+void obs_free_video_copy_job(void)
+{
+	struct video_copy_job *job = &obs->video.copy_job;
+
+	os_task_group_destroy(job->group);
+	memset(job, 0, sizeof(*job));
+}
+
+static inline void add_copy_plane(struct video_copy_job *job, uint32_t width, uint32_t height,
+				  uint32_t linesize_input, uint32_t linesize_output, const uint8_t *in, uint8_t *out)
+{
+	struct video_copy_plane *plane = &job->planes[job->num_planes++];
+
+	plane->in = in;
+	plane->out = out;
+	plane->width = width;
+	plane->height = height;
+	plane->in_linesize = linesize_input;
+	plane->out_linesize = linesize_output;
+}
+
+static void copy_video_planes(struct video_copy_job *job)
+{
+	size_t total = 0;
+
+	for (size_t i = 0; i < job->num_planes; i++)
+		total += (size_t)job->planes[i].width * (size_t)job->planes[i].height;
+
+	if (!job->group || total < VIDEO_COPY_PARALLEL_MIN_SIZE) {
+		job->num_bands = 1;
+		copy_planes_band(job, 0);
+	} else {
+		job->num_bands = job->max_bands;
+
+		for (size_t i = 1; i < job->num_bands; i++) {
+			if (!os_task_group_submit(job->group, copy_band_task, &job->bands[i], OS_TASK_PRIORITY_HIGH))
+				copy_band_task(&job->bands[i]);
+		}
+
+		copy_planes_band(job, 0);
+		os_task_group_wait(job->group);
+	}
+
+	job->num_planes = 0;
 }
 
 static void set_gpu_converted_data(struct video_frame *output, const struct video_data *input,
 				   const struct video_output_info *info)
 {
+	struct video_copy_job *job = &obs->video.copy_job;
+
 	switch (info->format) {
 	case VIDEO_FORMAT_I420: {
 		const uint32_t width = info->width;
 		const uint32_t height = info->height;
 
-		set_gpu_converted_plane(width, height, input->linesize[0], output->linesize[0], input->data[0],
-					output->data[0]);
+		add_copy_plane(job, width, height, input->linesize[0], output->linesize[0], input->data[0],
+			       output->data[0]);
 
 		const uint32_t width_d2 = width / 2;
 		const uint32_t height_d2 = height / 2;
 
-		set_gpu_converted_plane(width_d2, height_d2, input->linesize[1], output->linesize[1], input->data[1],
-					output->data[1]);
+		add_copy_plane(job, width_d2, height_d2, input->linesize[1], output->linesize[1], input->data[1],
+			       output->data[1]);
 
-		set_gpu_converted_plane(width_d2, height_d2, input->linesize[2], output->linesize[2], input->data[2],
-					output->data[2]);
+		add_copy_plane(job, width_d2, height_d2, input->linesize[2], output->linesize[2], input->data[2],
+			       output->data[2]);
 
 		break;
 	}
@@ -644,16 +825,16 @@ static void set_gpu_converted_data(struct video_frame *output, const struct vide
 		const uint32_t height = info->height;
 		const uint32_t height_d2 = height / 2;
 		if (input->linesize[1]) {
-			set_gpu_converted_plane(width, height, input->linesize[0], output->linesize[0], input->data[0],
-						output->data[0]);
-			set_gpu_converted_plane(width, height_d2, input->linesize[1], output->linesize[1],
-						input->data[1], output->data[1]);
+			add_copy_plane(job, width, height, input->linesize[0], output->linesize[0], input->data[0],
+				       output->data[0]);
+			add_copy_plane(job, width, height_d2, input->linesize[1], output->linesize[1], input->data[1],
+				       output->data[1]);
 		} else {
-			const uint8_t *const in_uv = set_gpu_converted_plane(width, height, input->linesize[0],
-									     output->linesize[0], input->data[0],
-									     output->data[0]);
-			set_gpu_converted_plane(width, height_d2, input->linesize[0], output->linesize[1], in_uv,
-						output->data[1]);
+			const uint8_t *const in_uv = input->data[0] + (size_t)input->linesize[0] * height;
+			add_copy_plane(job, width, height, input->linesize[0], output->linesize[0], input->data[0],
+				       output->data[0]);
+			add_copy_plane(job, width, height_d2, input->linesize[0], output->linesize[1], in_uv,
+				       output->data[1]);
 		}
 
 		break;
@@ -662,14 +843,14 @@ static void set_gpu_converted_data(struct video_frame *output, const struct vide
 		const uint32_t width = info->width;
 		const uint32_t height = info->height;
 
-		set_gpu_converted_plane(width, height, input->linesize[0], output->linesize[0], input->data[0],
-					output->data[0]);
+		add_copy_plane(job, width, height, input->linesize[0], output->linesize[0], input->data[0],
+			       output->data[0]);
 
-		set_gpu_converted_plane(width, height, input->linesize[1], output->linesize[1], input->data[1],
-					output->data[1]);
+		add_copy_plane(job, width, height, input->linesize[1], output->linesize[1], input->data[1],
+			       output->data[1]);
 
-		set_gpu_converted_plane(width, height, input->linesize[2], output->linesize[2], input->data[2],
-					output->data[2]);
+		add_copy_plane(job, width, height, input->linesize[2], output->linesize[2], input->data[2],
+			       output->data[2]);
 
 		break;
 	}
@@ -677,16 +858,16 @@ static void set_gpu_converted_data(struct video_frame *output, const struct vide
 		const uint32_t width = info->width;
 		const uint32_t height = info->height;
 
-		set_gpu_converted_plane(width * 2, height, input->linesize[0], output->linesize[0], input->data[0],
-					output->data[0]);
+		add_copy_plane(job, width * 2, height, input->linesize[0], output->linesize[0], input->data[0],
+			       output->data[0]);
 
 		const uint32_t height_d2 = height / 2;
 
-		set_gpu_converted_plane(width, height_d2, input->linesize[1], output->linesize[1], input->data[1],
-					output->data[1]);
+		add_copy_plane(job, width, height_d2, input->linesize[1], output->linesize[1], input->data[1],
+			       output->data[1]);
 
-		set_gpu_converted_plane(width, height_d2, input->linesize[2], output->linesize[2], input->data[2],
-					output->data[2]);
+		add_copy_plane(job, width, height_d2, input->linesize[2], output->linesize[2], input->data[2],
+			       output->data[2]);
 
 		break;
 	}
@@ -695,16 +876,16 @@ static void set_gpu_converted_data(struct video_frame *output, const struct vide
 		const uint32_t height = info->height;
 		const uint32_t height_d2 = height / 2;
 		if (input->linesize[1]) {
-			set_gpu_converted_plane(width_x2, height, input->linesize[0], output->linesize[0],
-						input->data[0], output->data[0]);
-			set_gpu_converted_plane(width_x2, height_d2, input->linesize[1], output->linesize[1],
-						input->data[1], output->data[1]);
+			add_copy_plane(job, width_x2, height, input->linesize[0], output->linesize[0], input->data[0],
+				       output->data[0]);
+			add_copy_plane(job, width_x2, height_d2, input->linesize[1], output->linesize[1],
+				       input->data[1], output->data[1]);
 		} else {
-			const uint8_t *const in_uv = set_gpu_converted_plane(width_x2, height, input->linesize[0],
-									     output->linesize[0], input->data[0],
-									     output->data[0]);
-			set_gpu_converted_plane(width_x2, height_d2, input->linesize[0], output->linesize[1], in_uv,
-						output->data[1]);
+			const uint8_t *const in_uv = input->data[0] + (size_t)input->linesize[0] * height;
+			add_copy_plane(job, width_x2, height, input->linesize[0], output->linesize[0], input->data[0],
+				       output->data[0]);
+			add_copy_plane(job, width_x2, height_d2, input->linesize[0], output->linesize[1], in_uv,
+				       output->data[1]);
 		}
 
 		break;
@@ -713,22 +894,22 @@ static void set_gpu_converted_data(struct video_frame *output, const struct vide
 		const uint32_t width_x2 = info->width * 2;
 		const uint32_t height = info->height;
 
-		set_gpu_converted_plane(width_x2, height, input->linesize[0], output->linesize[0], input->data[0],
-					output->data[0]);
+		add_copy_plane(job, width_x2, height, input->linesize[0], output->linesize[0], input->data[0],
+			       output->data[0]);
 
-		set_gpu_converted_plane(width_x2, height, input->linesize[1], output->linesize[1], input->data[1],
-					output->data[1]);
+		add_copy_plane(job, width_x2, height, input->linesize[1], output->linesize[1], input->data[1],
+			       output->data[1]);
 
 		break;
 	}
 	case VIDEO_FORMAT_P416: {
 		const uint32_t height = info->height;
 
-		set_gpu_converted_plane(info->width * 2, height, input->linesize[0], output->linesize[0],
-					input->data[0], output->data[0]);
+		add_copy_plane(job, info->width * 2, height, input->linesize[0], output->linesize[0], input->data[0],
+			       output->data[0]);
 
-		set_gpu_converted_plane(info->width * 4, height, input->linesize[1], output->linesize[1],
-					input->data[1], output->data[1]);
+		add_copy_plane(job, info->width * 4, height, input->linesize[1], output->linesize[1], input->data[1],
+			       output->data[1]);
 
 		break;
 	}
@@ -755,25 +936,26 @@ static void set_gpu_converted_data(struct video_frame *output, const struct vide
 		/* unimplemented */
 		;
 	}
+
+	copy_video_planes(job);
 }
 
 static inline void copy_rgbx_frame(struct video_frame *output, const struct video_data *input,
 				   const struct video_output_info *info)
 {
-	uint8_t *in_ptr = input->data[0];
-	uint8_t *out_ptr = output->data[0];
+	struct video_copy_job *job = &obs->video.copy_job;
 
-	/* if the line sizes match, do a single copy */
+	/* if the line sizes match, copy the padding too so that each band is
+	 * a single copy */
 	if (input->linesize[0] == output->linesize[0]) {
-		memcpy(out_ptr, in_ptr, (size_t)input->linesize[0] * (size_t)info->height);
+		add_copy_plane(job, input->linesize[0], info->height, input->linesize[0], output->linesize[0],
+			       input->data[0], output->data[0]);
 	} else {
-		const size_t copy_size = (size_t)info->width * 4;
-		for (size_t y = 0; y < info->height; y++) {
-			memcpy(out_ptr, in_ptr, copy_size);
-			in_ptr += input->linesize[0];
-			out_ptr += output->linesize[0];
-		}
+		add_copy_plane(job, info->width * 4, info->height, input->linesize[0], output->linesize[0],
+			       input->data[0], output->data[0]);
 	}
+
+	copy_video_planes(job);
 }
 
 static inline void output_video_data(struct obs_core_video_mix *video, struct video_data *input_frame, int count)
@@ -1103,6 +1285,9 @@ bool obs_graphics_thread_loop(struct obs_graphics_context *context)
 
 	update_active_states();
 
+	obs->video.last_frame_transform_updates = (uint32_t)os_atomic_set_long(&obs->video.transform_updates, 0);
+	obs->video.last_frame_culled_items = (uint32_t)os_atomic_set_long(&obs->video.culled_items, 0);
+
 	profile_start(context->video_thread_name);
 	source_profiler_frame_begin();
 
@@ -706,6 +706,9 @@ static int obs_init_video(struct obs_video_info *ovi)
 	if (!restore_canvases())
 		return OBS_VIDEO_FAIL;
 
+	if (!obs_init_video_copy_job())
+		blog(LOG_WARNING, "Failed to create video copy task group, raw frames will be copied on the graphics thread");
+
 	int errorcode;
 #ifdef __APPLE__
 	pthread_attr_t attr;
@@ -837,6 +840,8 @@ static void obs_free_video(void)
 	pthread_mutex_destroy(&obs->video.mixes_mutex);
 	pthread_mutex_init_value(&obs->video.mixes_mutex);
 
+	obs_free_video_copy_job();
+
 	for (size_t i = 0; i < obs->video.ready_encoder_groups.num; i++) {
 		obs_weak_encoder_release(obs->video.ready_encoder_groups.array[i]);
 	}
@@ -901,6 +906,8 @@ static bool obs_init_audio(struct audio_output_info *ai)
 	audio->monitoring_device_id = bstrdup("default");
 	audio->monitoring_duplication_prevented_on_prev_tick = false;
 
+	audio->render_group = os_task_group_create();
+
 	errorcode = audio_output_open(&audio->audio, ai);
 	if (errorcode == AUDIO_OUTPUT_SUCCESS)
 		return true;
@@ -931,6 +938,8 @@ static void obs_free_audio(void)
 	deque_free(&audio->buffered_timestamps);
 	da_free(audio->render_order);
 	da_free(audio->root_nodes);
+	da_free(audio->render_leaves);
+	os_task_group_destroy(audio->render_group);
 
 	da_free(audio->monitors);
 	bfree(audio->monitoring_device_name);
@@ -967,6 +976,10 @@ static bool obs_init_data(void)
 		goto fail;
 	if (pthread_mutex_init_recursive(&obs->data.canvases_mutex) != 0)
 		goto fail;
+	if (!frame_pool_init(&data->frame_pool))
+		goto fail;
+
+	data->tick_group = os_task_group_create();
 
 	data->sources = NULL;
 	data->public_sources = NULL;
@@ -1054,6 +1067,11 @@ static void obs_free_data(void)
 		bfree(data->protocols.array[i]);
 	da_free(data->protocols);
 	da_free(data->sources_to_tick);
+	da_free(data->pooled_ticks);
+	da_free(data->pooled_tick_times);
+	os_task_group_destroy(data->tick_group);
+
+	frame_pool_free(&data->frame_pool);
 }
 
 static const char *obs_signals[] = {
@@ -1097,8 +1115,27 @@ static const char *obs_signals[] = {
 	NULL,
 };
 
+static void obs_init_signal_ids(struct obs_core_signal_ids *ids)
+{
+	ids->source_update = signal_get_id("source_update");
+	ids->source_volume = signal_get_id("source_volume");
+
+	ids->update = signal_get_id("update");
+	ids->volume = signal_get_id("volume");
+	ids->media_play = signal_get_id("media_play");
+	ids->media_pause = signal_get_id("media_pause");
+	ids->media_restart = signal_get_id("media_restart");
+	ids->media_stopped = signal_get_id("media_stopped");
+	ids->media_next = signal_get_id("media_next");
+	ids->media_previous = signal_get_id("media_previous");
+	ids->media_started = signal_get_id("media_started");
+	ids->media_ended = signal_get_id("media_ended");
+}
+
 static inline bool obs_init_handlers(void)
 {
+	obs_init_signal_ids(&obs->signal_ids);
+
 	obs->signals = signal_handler_create();
 	if (!obs->signals)
 		return false;
@@ -1311,6 +1348,9 @@ bool obs_startup(const char *locale, const char *module_config_path, profiler_na
 	com_initialized = initialize_com();
 #endif
 
+	if (bmem_thread_cache_enabled())
+		blog(LOG_INFO, "Using the thread caching allocator");
+
 	success = obs_init(locale, module_config_path, store);
 	profile_end(obs_startup_name);
 	if (!success)
@@ -1360,6 +1400,7 @@ void obs_shutdown(void)
 	struct obs_module *module;
 
 	obs_wait_for_destroy_queue();
+	bmem_log_thread_stats();
 
 	for (size_t i = 0; i < obs->source_types.num; i++) {
 		struct obs_source_info *item = &obs->source_types.array[i];
@@ -1414,6 +1455,7 @@ void obs_shutdown(void)
 	obs_free_audio();
 	obs_free_video();
 	os_task_queue_destroy(obs->destruction_task_thread);
+	os_pool_shutdown();
 	obs_free_hotkeys();
 	obs_free_graphics();
 	proc_handler_destroy(obs->procs);
@@ -3046,6 +3088,40 @@ uint32_t obs_get_lagged_frames(void)
 	return obs->video.lagged_frames;
 }
 
+uint32_t obs_get_transform_updates(void)
+{
+	return obs->video.last_frame_transform_updates;
+}
+
+uint32_t obs_get_culled_items(void)
+{
+	return obs->video.last_frame_culled_items;
+}
+
+void obs_get_frame_pool_stats(struct obs_frame_pool_stats *stats)
+{
+	struct frame_pool *pool = &obs->data.frame_pool;
+
+	if (!obs_ptr_valid(stats, "obs_get_frame_pool_stats"))
+		return;
+
+	pthread_mutex_lock(&pool->mutex);
+	stats->hits = pool->hits;
+	stats->misses = pool->misses;
+	stats->released = pool->released;
+	stats->idle_bytes = pool->idle_bytes;
+	pthread_mutex_unlock(&pool->mutex);
+}
+
+void obs_set_frame_pool_idle_timeout(uint32_t timeout_ms)
+{
+	struct frame_pool *pool = &obs->data.frame_pool;
+
+	pthread_mutex_lock(&pool->mutex);
+	pool->idle_timeout_ns = (uint64_t)timeout_ms * 1000000ULL;
+	pthread_mutex_unlock(&pool->mutex);
+}
+
 struct obs_core_video_mix *get_mix_for_video(video_t *v)
 {
 	struct obs_core_video_mix *result = NULL;
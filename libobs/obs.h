@@ -300,6 +300,7 @@ struct obs_source_frame {
 	/* used internally by libobs */
 	volatile long refs;
 	bool prev_frame;
+	bool pooled;
 };
 
 struct obs_source_frame2 {
@@ -913,6 +914,27 @@ EXPORT uint64_t obs_get_frame_interval_ns(void);
 EXPORT uint32_t obs_get_total_frames(void);
 EXPORT uint32_t obs_get_lagged_frames(void);
 
+/** Gets the number of scene item transforms that were recalculated during
+ * the last frame */
+EXPORT uint32_t obs_get_transform_updates(void);
+
+/** Gets the number of scene items that were skipped during the last frame
+ * because they were off-canvas, cropped away or covered by an opaque item */
+EXPORT uint32_t obs_get_culled_items(void);
+
+struct obs_frame_pool_stats {
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t released;
+	size_t idle_bytes;
+};
+
+/** Gets the statistics of the frame pool shared by async video sources */
+EXPORT void obs_get_frame_pool_stats(struct obs_frame_pool_stats *stats);
+
+/** Sets how long unused async video frames are kept for reuse */
+EXPORT void obs_set_frame_pool_idle_timeout(uint32_t timeout_ms);
+
 OBS_DEPRECATED EXPORT bool obs_nv12_tex_active(void);
 OBS_DEPRECATED EXPORT bool obs_p010_tex_active(void);
 
@@ -1163,6 +1185,18 @@ EXPORT void obs_source_filter_set_index(obs_source_t *source, obs_source_t *filt
 /** Gets the settings string for a source */
 EXPORT obs_data_t *obs_source_get_settings(const obs_source_t *source);
 
+/**
+ * Gets an immutable snapshot of the settings of a source, which can be read
+ * from any thread.  The snapshot is replaced (not changed) after the source is
+ * created, after obs_source_update or obs_source_reset_settings (once its
+ * update callback has run; for video sources also when the settings are
+ * applied, before the deferred update), and after obs_source_load.  Changes
+ * made directly to the obs_data of obs_source_get_settings show up with the
+ * next of those.  Returns NULL for scenes.  Release with
+ * obs_data_snapshot_release.
+ */
+EXPORT obs_data_snapshot_t *obs_source_get_settings_snapshot(obs_source_t *source);
+
 /** Gets the name of a source */
 EXPORT const char *obs_source_get_name(const obs_source_t *source);
 
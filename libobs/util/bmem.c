@@ -14,6 +14,8 @@
  * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
+#include <inttypes.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include "base.h"
@@ -98,6 +100,584 @@ static void a_free(void *ptr)
 
 static long num_allocs = 0;
 
+/* ------------------------------------------------------------------------- */
+/* Thread caching allocator
+ *
+ * Optional backend that is switched on by setting OBS_BMEM_THREAD_CACHE=1 in
+ * the environment.  The environment is read on the first allocation, so all
+ * memory of the process comes from the same backend.
+ *
+ * Small blocks are rounded up to one of a set of size classes (four per
+ * power of two), and freed blocks are kept in a per-thread cache for their
+ * class, so most allocations never take a lock or touch a shared cache line.
+ * When a thread's cache for a class grows too large, half of it is moved to
+ * a shared list that other threads refill from.  Large blocks go straight to
+ * the system allocator.
+ *
+ * Every block starts with a header holding its size and class, and each
+ * thread keeps its own statistics (and, in debug builds, its top allocation
+ * call sites), see bmem_log_thread_stats. */
+
+#define THREAD_CACHE_ENV "OBS_BMEM_THREAD_CACHE"
+
+#define HEADER_SIZE ALIGNMENT
+#define NUM_CLASSES 40
+#define MAX_CLASS_SIZE 32768
+#define LARGE_CLASS NUM_CLASSES
+
+#define THREAD_CACHE_CLASS_BYTES (64 * 1024)
+#define THREAD_CACHE_MIN_BLOCKS 4
+#define THREAD_CACHE_MAX_BLOCKS 256
+#define SHARED_CLASS_BYTES (1024 * 1024)
+
+#ifndef NDEBUG
+#define TRACK_CALL_SITES 1
+#define NUM_CALL_SITES 256
+#define CALL_SITE_PROBES 8
+#define TOP_CALL_SITES 10
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define CALL_SITE() _ReturnAddress()
+#elif defined(__GNUC__)
+#define CALL_SITE() __builtin_return_address(0)
+#else
+#define CALL_SITE() NULL
+#endif
+#else
+#define CALL_SITE() NULL
+#endif
+
+struct block_header {
+	size_t size;
+	uint32_t class_idx;
+};
+
+/* freed blocks are linked through their header */
+struct free_block {
+	struct free_block *next;
+};
+
+struct free_list {
+	struct free_block *head;
+	size_t count;
+};
+
+struct call_site {
+	void *addr;
+	uint64_t count;
+	uint64_t bytes;
+};
+
+/* The counters are only written by the owning thread, and read without
+ * synchronization when logged, so the statistics are approximate. */
+struct thread_cache {
+	struct free_list lists[NUM_CLASSES];
+
+	char name[32];
+	uint64_t allocs;
+	uint64_t frees;
+	uint64_t bytes_allocated;
+	uint64_t bytes_freed;
+
+	/* only used by bmem_log_thread_stats */
+	uint64_t logged_allocs;
+	uint64_t logged_time;
+
+#ifdef TRACK_CALL_SITES
+	struct call_site sites[NUM_CALL_SITES];
+#endif
+
+	struct thread_cache *next;
+	struct thread_cache **prev_next;
+};
+
+struct shared_list {
+	pthread_mutex_t mutex;
+	struct free_list list;
+};
+
+static volatile long thread_cache_mode = -1;
+static pthread_once_t thread_cache_once = PTHREAD_ONCE_INIT;
+static pthread_key_t thread_cache_key;
+
+static struct shared_list shared_lists[NUM_CLASSES];
+
+/* all thread caches, and the statistics of threads that have exited or that
+ * allocate after their cache was torn down */
+static pthread_mutex_t thread_cache_mutex;
+static struct thread_cache *thread_caches = NULL;
+static struct thread_cache exited_threads = {.name = "exited threads"};
+
+static THREAD_LOCAL struct thread_cache *cur_cache = NULL;
+static THREAD_LOCAL bool cur_cache_exited = false;
+
+static inline size_t get_class(size_t size)
+{
+	size_t bits = 0;
+
+	if (size <= 128)
+		return (size + 15) / 16 - 1;
+	if (size > MAX_CLASS_SIZE)
+		return LARGE_CLASS;
+
+	while (((size - 1) >> bits) > 1)
+		bits++;
+
+	return 8 + (bits - 7) * 4 + ((size - 1) >> (bits - 2)) - 4;
+}
+
+static inline size_t get_class_size(size_t idx)
+{
+	if (idx < 8)
+		return (idx + 1) * 16;
+
+	return (5 + (idx - 8) % 4) << (5 + (idx - 8) / 4);
+}
+
+static inline size_t get_thread_cache_limit(size_t idx)
+{
+	size_t count = THREAD_CACHE_CLASS_BYTES / get_class_size(idx);
+
+	if (count < THREAD_CACHE_MIN_BLOCKS)
+		return THREAD_CACHE_MIN_BLOCKS;
+	if (count > THREAD_CACHE_MAX_BLOCKS)
+		return THREAD_CACHE_MAX_BLOCKS;
+	return count;
+}
+
+static inline struct block_header *get_header(void *ptr)
+{
+	return (struct block_header *)((uint8_t *)ptr - HEADER_SIZE);
+}
+
+static inline void *get_block_data(struct block_header *header)
+{
+	return (uint8_t *)header + HEADER_SIZE;
+}
+
+static inline void free_list_push(struct free_list *list, void *block)
+{
+	struct free_block *fb = block;
+	fb->next = list->head;
+	list->head = fb;
+	list->count++;
+}
+
+static inline void *free_list_pop(struct free_list *list)
+{
+	struct free_block *fb = list->head;
+	if (fb) {
+		list->head = fb->next;
+		list->count--;
+	}
+	return fb;
+}
+
+/* moves up to count blocks to the shared list, freeing what doesn't fit */
+static void release_blocks(struct free_list *list, size_t idx, size_t count)
+{
+	struct shared_list *shared = &shared_lists[idx];
+	size_t max_blocks = SHARED_CLASS_BYTES / get_class_size(idx);
+	struct free_list excess = {0};
+
+	pthread_mutex_lock(&shared->mutex);
+	while (count-- && list->head) {
+		void *block = free_list_pop(list);
+
+		if (shared->list.count < max_blocks)
+			free_list_push(&shared->list, block);
+		else
+			free_list_push(&excess, block);
+	}
+	pthread_mutex_unlock(&shared->mutex);
+
+	while (excess.head)
+		a_free(free_list_pop(&excess));
+}
+
+static void refill_blocks(struct free_list *list, size_t idx, size_t count)
+{
+	struct shared_list *shared = &shared_lists[idx];
+
+	pthread_mutex_lock(&shared->mutex);
+	while (count-- && shared->list.head)
+		free_list_push(list, free_list_pop(&shared->list));
+	pthread_mutex_unlock(&shared->mutex);
+}
+
+#ifdef TRACK_CALL_SITES
+static void add_call_site(struct call_site *sites, void *addr, uint64_t count, uint64_t bytes)
+{
+	size_t hash = ((uintptr_t)addr >> 4) * 2654435761u;
+
+	for (size_t i = 0; i < CALL_SITE_PROBES; i++) {
+		struct call_site *site = &sites[(hash + i) & (NUM_CALL_SITES - 1)];
+
+		if (!site->addr)
+			site->addr = addr;
+		if (site->addr == addr) {
+			site->count += count;
+			site->bytes += bytes;
+			return;
+		}
+	}
+}
+
+static void merge_call_sites(struct call_site *dst, const struct call_site *src)
+{
+	for (size_t i = 0; i < NUM_CALL_SITES; i++) {
+		if (src[i].addr)
+			add_call_site(dst, src[i].addr, src[i].count, src[i].bytes);
+	}
+}
+#endif
+
+static inline void add_stats(struct thread_cache *dst, const struct thread_cache *src)
+{
+	dst->allocs += src->allocs;
+	dst->frees += src->frees;
+	dst->bytes_allocated += src->bytes_allocated;
+	dst->bytes_freed += src->bytes_freed;
+
+#ifdef TRACK_CALL_SITES
+	merge_call_sites(dst->sites, src->sites);
+#endif
+}
+
+static void thread_cache_exit(void *data)
+{
+	struct thread_cache *cache = data;
+
+	for (size_t i = 0; i < NUM_CLASSES; i++)
+		release_blocks(&cache->lists[i], i, cache->lists[i].count);
+
+	pthread_mutex_lock(&thread_cache_mutex);
+	add_stats(&exited_threads, cache);
+	*cache->prev_next = cache->next;
+	if (cache->next)
+		cache->next->prev_next = cache->prev_next;
+	pthread_mutex_unlock(&thread_cache_mutex);
+
+	/* anything freed after this point goes to the shared lists */
+	cur_cache = NULL;
+	cur_cache_exited = true;
+	free(cache);
+}
+
+static void init_thread_cache(void)
+{
+	pthread_mutex_init(&thread_cache_mutex, NULL);
+	for (size_t i = 0; i < NUM_CLASSES; i++)
+		pthread_mutex_init(&shared_lists[i].mutex, NULL);
+
+	pthread_key_create(&thread_cache_key, thread_cache_exit);
+}
+
+static inline bool thread_cache_active(void)
+{
+	long mode = os_atomic_load_long(&thread_cache_mode);
+
+	if (mode < 0) {
+		const char *env = getenv(THREAD_CACHE_ENV);
+
+		mode = env && *env && strcmp(env, "0") != 0;
+		if (mode)
+			pthread_once(&thread_cache_once, init_thread_cache);
+		os_atomic_set_long(&thread_cache_mode, mode);
+	}
+
+	return mode == 1;
+}
+
+static struct thread_cache *get_thread_cache(void)
+{
+	struct thread_cache *cache = cur_cache;
+
+	if (cache || cur_cache_exited)
+		return cache;
+
+	cache = calloc(1, sizeof(*cache));
+	if (!cache)
+		return NULL;
+
+	cache->logged_time = os_gettime_ns();
+
+	pthread_mutex_lock(&thread_cache_mutex);
+	cache->next = thread_caches;
+	cache->prev_next = &thread_caches;
+	if (thread_caches)
+		thread_caches->prev_next = &cache->next;
+	thread_caches = cache;
+	pthread_mutex_unlock(&thread_cache_mutex);
+
+	pthread_setspecific(thread_cache_key, cache);
+	cur_cache = cache;
+	return cache;
+}
+
+static void count_alloc(struct thread_cache *cache, size_t size, void *site)
+{
+	bool locked = !cache;
+
+	if (locked) {
+		pthread_mutex_lock(&thread_cache_mutex);
+		cache = &exited_threads;
+	}
+
+	cache->allocs++;
+	cache->bytes_allocated += size;
+#ifdef TRACK_CALL_SITES
+	add_call_site(cache->sites, site, 1, size);
+#else
+	UNUSED_PARAMETER(site);
+#endif
+
+	if (locked)
+		pthread_mutex_unlock(&thread_cache_mutex);
+}
+
+static void count_free(struct thread_cache *cache, size_t size)
+{
+	bool locked = !cache;
+
+	if (locked) {
+		pthread_mutex_lock(&thread_cache_mutex);
+		cache = &exited_threads;
+	}
+
+	cache->frees++;
+	cache->bytes_freed += size;
+
+	if (locked)
+		pthread_mutex_unlock(&thread_cache_mutex);
+}
+
+static void *cache_alloc(size_t size, void *site)
+{
+	struct thread_cache *cache = get_thread_cache();
+	struct block_header *header = NULL;
+	size_t idx = get_class(size);
+
+	if (idx != LARGE_CLASS) {
+		struct free_list *list;
+		struct free_list temp = {0};
+
+		list = cache ? &cache->lists[idx] : &temp;
+		if (!list->head)
+			refill_blocks(list, idx, cache ? get_thread_cache_limit(idx) / 2 : 1);
+
+		header = free_list_pop(list);
+	}
+
+	if (!header) {
+		header = a_malloc(HEADER_SIZE + (idx == LARGE_CLASS ? size : get_class_size(idx)));
+		if (!header)
+			return NULL;
+	}
+
+	header->size = size;
+	header->class_idx = (uint32_t)idx;
+	count_alloc(cache, size, site);
+	return get_block_data(header);
+}
+
+static void cache_free(void *ptr)
+{
+	struct thread_cache *cache = get_thread_cache();
+	struct block_header *header = get_header(ptr);
+	size_t idx = header->class_idx;
+
+	if (idx > LARGE_CLASS)
+		bcrash("bfree: Freeing a block that was not allocated with bmalloc (%p)", ptr);
+
+	count_free(cache, header->size);
+
+	if (idx == LARGE_CLASS) {
+		a_free(header);
+	} else if (cache) {
+		struct free_list *list = &cache->lists[idx];
+		size_t limit = get_thread_cache_limit(idx);
+
+		free_list_push(list, header);
+		if (list->count > limit)
+			release_blocks(list, idx, limit / 2);
+	} else {
+		struct free_list temp = {0};
+
+		free_list_push(&temp, header);
+		release_blocks(&temp, idx, 1);
+	}
+}
+
+static void *cache_realloc(void *ptr, size_t size, void *site)
+{
+	struct block_header *header;
+	size_t idx = get_class(size);
+	size_t old_size;
+
+	if (!ptr)
+		return cache_alloc(size, site);
+
+	header = get_header(ptr);
+	old_size = header->size;
+
+	/* still fits in the same block */
+	if (idx == header->class_idx || (idx == LARGE_CLASS && header->class_idx == LARGE_CLASS)) {
+		struct thread_cache *cache = get_thread_cache();
+
+		if (idx == LARGE_CLASS) {
+			header = a_realloc(header, HEADER_SIZE + size);
+			if (!header)
+				return NULL;
+		}
+
+		header->size = size;
+		count_free(cache, old_size);
+		count_alloc(cache, size, site);
+		return get_block_data(header);
+	}
+
+	void *new_ptr = cache_alloc(size, site);
+	if (new_ptr) {
+		memcpy(new_ptr, ptr, old_size < size ? old_size : size);
+		cache_free(ptr);
+	}
+
+	return new_ptr;
+}
+
+bool bmem_thread_cache_enabled(void)
+{
+	return thread_cache_active();
+}
+
+void bmem_set_thread_name(const char *name)
+{
+	struct thread_cache *cache;
+
+	if (!name || !thread_cache_active())
+		return;
+
+	cache = get_thread_cache();
+	if (cache)
+		snprintf(cache->name, sizeof(cache->name), "%s", name);
+}
+
+struct thread_stats {
+	char name[32];
+	int64_t bytes_live;
+	size_t bytes_cached;
+	double allocs_per_sec;
+};
+
+#ifdef TRACK_CALL_SITES
+static int compare_call_sites(const void *a, const void *b)
+{
+	const struct call_site *site_a = a;
+	const struct call_site *site_b = b;
+
+	if (site_a->count == site_b->count)
+		return 0;
+	return site_a->count > site_b->count ? -1 : 1;
+}
+#endif
+
+static size_t get_cached_bytes(const struct thread_cache *cache)
+{
+	size_t bytes = 0;
+
+	for (size_t i = 0; i < NUM_CLASSES; i++)
+		bytes += cache->lists[i].count * get_class_size(i);
+
+	return bytes;
+}
+
+/* frees count against the thread that frees the block, so threads that
+ * mostly free what others allocated can show negative live bytes */
+static void get_thread_stats(struct thread_stats *stats, struct thread_cache *cache, uint64_t cur_time)
+{
+	uint64_t allocs = cache->allocs;
+
+	snprintf(stats->name, sizeof(stats->name), "%s", *cache->name ? cache->name : "unnamed thread");
+	stats->bytes_live = (int64_t)(cache->bytes_allocated - cache->bytes_freed);
+	stats->bytes_cached = get_cached_bytes(cache);
+	stats->allocs_per_sec = 0.0;
+
+	if (cache->logged_time && cur_time > cache->logged_time)
+		stats->allocs_per_sec = (double)(allocs - cache->logged_allocs) * 1e9 /
+					(double)(cur_time - cache->logged_time);
+
+	cache->logged_allocs = allocs;
+	cache->logged_time = cur_time;
+}
+
+void bmem_log_thread_stats(void)
+{
+	struct thread_stats *stats;
+	struct thread_cache *cache;
+	size_t num_threads = 1;
+	size_t count = 0;
+	uint64_t cur_time;
+#ifdef TRACK_CALL_SITES
+	struct call_site *sites;
+#endif
+
+	if (!thread_cache_active())
+		return;
+
+	/* nothing is logged while holding the lock, logging allocates */
+	pthread_mutex_lock(&thread_cache_mutex);
+
+	for (cache = thread_caches; cache; cache = cache->next)
+		num_threads++;
+
+	stats = calloc(num_threads, sizeof(*stats));
+#ifdef TRACK_CALL_SITES
+	sites = calloc(NUM_CALL_SITES, sizeof(*sites));
+#endif
+
+	cur_time = os_gettime_ns();
+
+	if (stats) {
+		for (cache = thread_caches; cache; cache = cache->next)
+			get_thread_stats(&stats[count++], cache, cur_time);
+		get_thread_stats(&stats[count++], &exited_threads, cur_time);
+	}
+
+#ifdef TRACK_CALL_SITES
+	if (sites) {
+		for (cache = thread_caches; cache; cache = cache->next)
+			merge_call_sites(sites, cache->sites);
+		merge_call_sites(sites, exited_threads.sites);
+	}
+#endif
+
+	pthread_mutex_unlock(&thread_cache_mutex);
+
+	blog(LOG_INFO, "Thread caching allocator statistics:");
+
+	for (size_t i = 0; i < count; i++) {
+		struct thread_stats *ts = &stats[i];
+		blog(LOG_INFO, "\t%-32s %12" PRId64 " bytes live, %8.0f allocations/s, %8zu bytes cached", ts->name,
+		     ts->bytes_live, ts->allocs_per_sec, ts->bytes_cached);
+	}
+
+#ifdef TRACK_CALL_SITES
+	if (sites) {
+		qsort(sites, NUM_CALL_SITES, sizeof(*sites), compare_call_sites);
+
+		blog(LOG_INFO, "Top allocation call sites:");
+		for (size_t i = 0; i < TOP_CALL_SITES && sites[i].addr; i++)
+			blog(LOG_INFO, "\t%p: %" PRIu64 " allocations, %" PRIu64 " bytes", sites[i].addr,
+			     sites[i].count, sites[i].bytes);
+	}
+
+	free(sites);
+#endif
+	free(stats);
+}
+
 void *bmalloc(size_t size)
 {
 	if (!size) {
@@ -105,28 +685,38 @@ void *bmalloc(size_t size)
 		bcrash("bmalloc: Allocating 0 bytes is broken behavior, please fix your code!");
 	}
 
-	void *ptr = a_malloc(size);
+	void *ptr;
+
+	if (thread_cache_active()) {
+		ptr = cache_alloc(size, CALL_SITE());
+	} else {
+		ptr = a_malloc(size);
+		if (ptr)
+			os_atomic_inc_long(&num_allocs);
+	}
 
 	if (!ptr) {
 		os_oom();
 		bcrash("Out of memory while trying to allocate %lu bytes", (unsigned long)size);
 	}
 
-	os_atomic_inc_long(&num_allocs);
 	return ptr;
 }
 
 void *brealloc(void *ptr, size_t size)
 {
-	if (!ptr)
-		os_atomic_inc_long(&num_allocs);
-
 	if (!size) {
 		os_breakpoint();
 		bcrash("brealloc: Allocating 0 bytes is broken behavior, please fix your code!");
 	}
 
-	ptr = a_realloc(ptr, size);
+	if (thread_cache_active()) {
+		ptr = cache_realloc(ptr, size, CALL_SITE());
+	} else {
+		if (!ptr)
+			os_atomic_inc_long(&num_allocs);
+		ptr = a_realloc(ptr, size);
+	}
 
 	if (!ptr) {
 		os_oom();
@@ -138,7 +728,12 @@ void *brealloc(void *ptr, size_t size)
 
 void bfree(void *ptr)
 {
-	if (ptr) {
+	if (!ptr)
+		return;
+
+	if (thread_cache_active()) {
+		cache_free(ptr);
+	} else {
 		os_atomic_dec_long(&num_allocs);
 		a_free(ptr);
 	}
@@ -146,7 +741,19 @@ void bfree(void *ptr)
 
 long bnum_allocs(void)
 {
-	return num_allocs;
+	struct thread_cache *cache;
+	long long allocs;
+
+	if (!thread_cache_active())
+		return num_allocs;
+
+	pthread_mutex_lock(&thread_cache_mutex);
+	allocs = (long long)(exited_threads.allocs - exited_threads.frees);
+	for (cache = thread_caches; cache; cache = cache->next)
+		allocs += (long long)(cache->allocs - cache->frees);
+	pthread_mutex_unlock(&thread_cache_mutex);
+
+	return (long)allocs;
 }
 
 int base_get_alignment(void)
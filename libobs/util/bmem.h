@@ -39,6 +39,13 @@ EXPORT int base_get_alignment(void);
 
 EXPORT long bnum_allocs(void);
 
+/* The thread caching allocator is used when OBS_BMEM_THREAD_CACHE=1 is set in
+ * the environment before the first allocation. */
+EXPORT bool bmem_thread_cache_enabled(void);
+EXPORT void bmem_log_thread_stats(void);
+/* names the calling thread in the allocator statistics */
+EXPORT void bmem_set_thread_name(const char *name);
+
 EXPORT void *bmemdup(const void *ptr, size_t size);
 
 static inline void *bzalloc(size_t size)
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+#include "c99defs.h"
+#include <string.h>
+
+#include "bmem.h"
+#include "threading.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Single producer, single consumer ring of planar float samples
+ *
+ *   One thread writes and one thread reads, without locking.  The writer only
+ * moves the write position and the reader only moves the read position, each
+ * after the samples it covers have been copied, so neither side ever sees a
+ * partially written or freed frame.  All planes share the same positions.
+ *
+ *   Writes that don't fit and reads of more frames than are available fail as
+ * a whole and are counted as overruns and underruns.  The counters and
+ * float_ring_readable/float_ring_writable may be read from any thread.
+ */
+
+struct float_ring {
+	float *data;
+	size_t planes;
+	size_t capacity;
+
+	/* frame counters that wrap around, only the difference matters */
+	volatile long write_pos;
+	volatile long read_pos;
+
+	volatile long overruns;
+	volatile long underruns;
+};
+
+/* the capacity is rounded up to a power of two */
+static inline void float_ring_init(struct float_ring *ring, size_t planes, size_t min_frames)
+{
+	size_t capacity = 1;
+
+	while (capacity < min_frames)
+		capacity <<= 1;
+
+	memset(ring, 0, sizeof(*ring));
+	ring->planes = planes;
+	ring->capacity = capacity;
+	ring->data = (float *)bmalloc(planes * capacity * sizeof(float));
+}
+
+static inline void float_ring_free(struct float_ring *ring)
+{
+	bfree(ring->data);
+	memset(ring, 0, sizeof(*ring));
+}
+
+static inline size_t float_ring_readable(const struct float_ring *ring)
+{
+	unsigned long write_pos = (unsigned long)os_atomic_load_long(&ring->write_pos);
+	unsigned long read_pos = (unsigned long)os_atomic_load_long(&ring->read_pos);
+	return (size_t)(write_pos - read_pos);
+}
+
+static inline size_t float_ring_writable(const struct float_ring *ring)
+{
+	return ring->capacity - float_ring_readable(ring);
+}
+
+static inline float *float_ring_plane(const struct float_ring *ring, size_t plane)
+{
+	return ring->data + plane * ring->capacity;
+}
+
+/* writer only */
+static inline bool float_ring_write(struct float_ring *ring, const float *const *planes, size_t frames)
+{
+	unsigned long write_pos = (unsigned long)ring->write_pos;
+	size_t start = write_pos & (ring->capacity - 1);
+	size_t first = ring->capacity - start;
+
+	if (frames > float_ring_writable(ring)) {
+		os_atomic_inc_long(&ring->overruns);
+		return false;
+	}
+
+	if (first > frames)
+		first = frames;
+
+	for (size_t i = 0; i < ring->planes; i++) {
+		float *plane = float_ring_plane(ring, i);
+
+		memcpy(plane + start, planes[i], first * sizeof(float));
+		if (frames > first)
+			memcpy(plane, planes[i] + first, (frames - first) * sizeof(float));
+	}
+
+	os_atomic_set_long(&ring->write_pos, (long)(write_pos + frames));
+	return true;
+}
+
+/* Reader only: gets the frames of a plane that can be read before the ring
+ * wraps around, starting at offset frames from the read position.  Reading
+ * everything takes at most two calls. */
+static inline const float *float_ring_peek(const struct float_ring *ring, size_t plane, size_t offset,
+					   size_t *frames)
+{
+	unsigned long read_pos = (unsigned long)ring->read_pos + (unsigned long)offset;
+	size_t available = float_ring_readable(ring);
+	size_t start = read_pos & (ring->capacity - 1);
+	size_t contiguous = ring->capacity - start;
+
+	available = offset < available ? available - offset : 0;
+	*frames = contiguous < available ? contiguous : available;
+	return float_ring_plane(ring, plane) + start;
+}
+
+/* reader only, frees frames that have been peeked */
+static inline void float_ring_advance(struct float_ring *ring, size_t frames)
+{
+	os_atomic_set_long(&ring->read_pos, (long)((unsigned long)ring->read_pos + frames));
+}
+
+/* reader only, planes may be NULL to drop the frames */
+static inline bool float_ring_read(struct float_ring *ring, float *const *planes, size_t frames)
+{
+	if (frames > float_ring_readable(ring)) {
+		os_atomic_inc_long(&ring->underruns);
+		return false;
+	}
+
+	if (planes) {
+		for (size_t i = 0; i < ring->planes; i++) {
+			size_t first;
+			const float *data = float_ring_peek(ring, i, 0, &first);
+
+			if (first > frames)
+				first = frames;
+
+			memcpy(planes[i], data, first * sizeof(float));
+			if (frames > first)
+				memcpy(planes[i] + first, float_ring_plane(ring, i), (frames - first) * sizeof(float));
+		}
+	}
+
+	float_ring_advance(ring, frames);
+	return true;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -255,6 +255,166 @@ static DARRAY(profile_root_entry) root_entries;
 static THREAD_LOCAL profile_call *thread_context = NULL;
 static THREAD_LOCAL bool thread_enabled = true;
 
+/* ------------------------------------------------------------------------- */
+/* Tracing */
+
+#define DEFAULT_TRACE_EVENTS 65536
+
+struct trace_event {
+	const char *name;
+	uint64_t time;
+	bool begin;
+};
+
+/* Each thread writes its own ring without locking; the dump copies the rings
+ * and throws away whatever got overwritten while copying.  Rings of threads
+ * that have exited stay on the list (so the dump never has to lock against
+ * them) and are handed to the next thread that starts tracing. */
+typedef struct trace_thread trace_thread;
+struct trace_thread {
+	trace_thread *next;
+	trace_thread *free_next;
+	uint32_t id;
+	const char *volatile name;
+	uint64_t start_time;
+
+	volatile long head;
+	size_t mask;
+	struct trace_event *events;
+
+	/* only used by the owning thread */
+	long depth;
+};
+
+static volatile bool trace_enabled = false;
+static size_t trace_events_per_thread = DEFAULT_TRACE_EVENTS;
+static uint64_t trace_start_time = 0;
+
+static pthread_mutex_t trace_mutex = PTHREAD_MUTEX_INITIALIZER;
+static trace_thread *trace_threads = NULL;
+static trace_thread *free_trace_threads = NULL;
+static uint32_t trace_thread_count = 0;
+
+static volatile long trace_generation = 0;
+
+static pthread_once_t trace_once = PTHREAD_ONCE_INIT;
+static pthread_key_t trace_key;
+
+static THREAD_LOCAL trace_thread *thread_trace = NULL;
+static THREAD_LOCAL long thread_trace_generation = 0;
+
+static void trace_thread_exit(void *data)
+{
+	trace_thread *tt = data;
+
+	pthread_mutex_lock(&trace_mutex);
+	/* the ring is already gone if profiler_free ran in the meantime */
+	if (thread_trace_generation == os_atomic_load_long(&trace_generation)) {
+		tt->free_next = free_trace_threads;
+		free_trace_threads = tt;
+	}
+	pthread_mutex_unlock(&trace_mutex);
+
+	thread_trace = NULL;
+}
+
+static void init_trace_key(void)
+{
+	pthread_key_create(&trace_key, trace_thread_exit);
+}
+
+static trace_thread *take_free_trace_thread(void)
+{
+	trace_thread **prev_next = &free_trace_threads;
+
+	/* only reuse rings of the currently requested size */
+	for (trace_thread *tt = *prev_next; tt; tt = *prev_next) {
+		if (tt->mask == trace_events_per_thread - 1) {
+			*prev_next = tt->free_next;
+			tt->free_next = NULL;
+			return tt;
+		}
+		prev_next = &tt->free_next;
+	}
+
+	return NULL;
+}
+
+static trace_thread *create_trace_thread(void)
+{
+	pthread_once(&trace_once, init_trace_key);
+
+	pthread_mutex_lock(&trace_mutex);
+	trace_thread *tt = take_free_trace_thread();
+	if (tt) {
+		/* the events of the previous owner are left in the ring and
+		 * skipped by the dump, see trace_dump_thread */
+		os_atomic_store_ptr((void *volatile *)&tt->name, NULL);
+		tt->depth = 0;
+	} else {
+		tt = bzalloc(sizeof(trace_thread));
+		tt->mask = trace_events_per_thread - 1;
+		tt->events = bmalloc(trace_events_per_thread * sizeof(struct trace_event));
+		tt->next = trace_threads;
+		trace_threads = tt;
+	}
+	tt->id = ++trace_thread_count;
+	tt->start_time = os_gettime_ns();
+	pthread_mutex_unlock(&trace_mutex);
+
+	pthread_setspecific(trace_key, tt);
+	return tt;
+}
+
+static void trace_record(const char *name, uint64_t time, bool begin)
+{
+	trace_thread *tt = thread_trace;
+	long generation = os_atomic_load_long(&trace_generation);
+
+	/* profiler_free frees the rings of all threads */
+	if (!tt || thread_trace_generation != generation) {
+		tt = thread_trace = create_trace_thread();
+		thread_trace_generation = generation;
+	}
+
+	/* name the thread after the first root it profiles */
+	if (begin && !tt->depth++ && !tt->name)
+		os_atomic_store_ptr((void *volatile *)&tt->name, (void *)name);
+	else if (!begin && tt->depth)
+		tt->depth--;
+
+	unsigned long head = (unsigned long)tt->head;
+	struct trace_event *event = &tt->events[head & tt->mask];
+	event->name = name;
+	event->time = time;
+	event->begin = begin;
+
+	os_atomic_set_long(&tt->head, (long)(head + 1));
+}
+
+void profiler_trace_start(size_t events_per_thread)
+{
+	size_t size = DEFAULT_TRACE_EVENTS;
+
+	if (events_per_thread) {
+		size = 1;
+		while (size < events_per_thread)
+			size <<= 1;
+	}
+
+	pthread_mutex_lock(&trace_mutex);
+	/* only applies to threads that haven't traced anything yet */
+	trace_events_per_thread = size;
+	trace_start_time = os_gettime_ns();
+	os_atomic_set_bool(&trace_enabled, true);
+	pthread_mutex_unlock(&trace_mutex);
+}
+
+void profiler_trace_stop(void)
+{
+	os_atomic_set_bool(&trace_enabled, false);
+}
+
 void profiler_start(void)
 {
 	pthread_mutex_lock(&root_mutex);
@@ -357,6 +517,9 @@ static void merge_context(profile_call *context)
 
 void profile_start(const char *name)
 {
+	if (os_atomic_load_bool(&trace_enabled))
+		trace_record(name, os_gettime_ns(), true);
+
 	if (!thread_enabled)
 		return;
 
@@ -385,6 +548,9 @@ void profile_start(const char *name)
 void profile_end(const char *name)
 {
 	uint64_t end = os_gettime_ns();
+	if (os_atomic_load_bool(&trace_enabled))
+		trace_record(name, end, false);
+
 	if (!thread_enabled)
 		return;
 
@@ -792,6 +958,23 @@ void profiler_free(void)
 	da_free(old_root_entries);
 
 	pthread_mutex_destroy(&root_mutex);
+
+	os_atomic_set_bool(&trace_enabled, false);
+
+	pthread_mutex_lock(&trace_mutex);
+	trace_thread *tt = trace_threads;
+	trace_threads = NULL;
+	free_trace_threads = NULL;
+	trace_thread_count = 0;
+	os_atomic_inc_long(&trace_generation);
+	pthread_mutex_unlock(&trace_mutex);
+
+	while (tt) {
+		trace_thread *next = tt->next;
+		bfree(tt->events);
+		bfree(tt);
+		tt = next;
+	}
 }
 
 /* ------------------------------------------------------------------------- */
@@ -1016,6 +1199,110 @@ bool profiler_snapshot_dump_csv_gz(const profiler_snapshot_t *snap, const char *
 	return true;
 }
 
+/* ------------------------------------------------------------------------- */
+/* Trace export */
+
+static void json_escape(struct dstr *buffer, const char *str)
+{
+	for (; *str; str++) {
+		unsigned char c = (unsigned char)*str;
+
+		if (c == '"' || c == '\\')
+			dstr_catf(buffer, "\\%c", c);
+		else if (c < 0x20)
+			dstr_catf(buffer, "\\u%04x", c);
+		else
+			dstr_cat_ch(buffer, (char)c);
+	}
+}
+
+static void trace_dump_thread(FILE *f, struct dstr *buffer, trace_thread *tt, struct trace_event *copy)
+{
+	size_t capacity = tt->mask + 1;
+	unsigned long end = (unsigned long)os_atomic_load_long(&tt->head);
+	unsigned long count = end < capacity ? end : (unsigned long)capacity;
+	unsigned long first = end - count;
+	unsigned long start = first;
+	uint64_t start_time = tt->start_time;
+
+	for (unsigned long i = first; i != end; i++)
+		copy[i - first] = tt->events[i & tt->mask];
+
+	/* anything the thread wrapped around to while copying is garbage */
+	unsigned long new_end = (unsigned long)os_atomic_load_long(&tt->head);
+	if (new_end - first > capacity)
+		start = new_end - capacity;
+
+	const char *name = os_atomic_load_ptr((void *const volatile *)&tt->name);
+	dstr_printf(buffer,
+		    ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%" PRIu32 ",\"args\":{\"name\":\"",
+		    tt->id);
+	json_escape(buffer, name ? name : "unnamed");
+	dstr_cat(buffer, "\"}}");
+	fwrite(buffer->array, 1, buffer->len, f);
+
+	long depth = 0;
+	for (unsigned long i = start; i - first < count; i++) {
+		struct trace_event *event = &copy[i - first];
+
+		if (event->time < trace_start_time || event->time < start_time)
+			continue;
+
+		/* the matching begin event was already overwritten */
+		if (!event->begin && !depth)
+			continue;
+		depth += event->begin ? 1 : -1;
+
+		dstr_printf(buffer, ",\n{\"ph\":\"%c\",\"pid\":1,\"tid\":%" PRIu32 ",\"ts\":%.3f",
+			    event->begin ? 'B' : 'E', tt->id, (double)(event->time - trace_start_time) / 1000.0);
+		if (event->begin) {
+			dstr_cat(buffer, ",\"name\":\"");
+			json_escape(buffer, event->name);
+			dstr_cat(buffer, "\"");
+		}
+		dstr_cat(buffer, "}");
+		fwrite(buffer->array, 1, buffer->len, f);
+	}
+}
+
+bool profiler_trace_dump_json(const char *filename)
+{
+	struct dstr buffer = {0};
+	struct trace_event *copy = NULL;
+	size_t copy_size = 0;
+
+	FILE *f = os_fopen(filename, "wb");
+	if (!f)
+		return false;
+
+	fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+	      "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"libobs\"}}",
+	      f);
+
+	/* threads are only ever added to the front of the list, and their
+	 * rings stay around (possibly reused by a newer thread) until
+	 * profiler_free */
+	pthread_mutex_lock(&trace_mutex);
+	trace_thread *tt = trace_threads;
+	pthread_mutex_unlock(&trace_mutex);
+
+	for (; tt; tt = tt->next) {
+		if (copy_size < tt->mask + 1) {
+			copy_size = tt->mask + 1;
+			copy = brealloc(copy, copy_size * sizeof(struct trace_event));
+		}
+
+		trace_dump_thread(f, &buffer, tt, copy);
+	}
+
+	fputs("\n]}\n", f);
+
+	bfree(copy);
+	dstr_free(&buffer);
+	fclose(f);
+	return true;
+}
+
 size_t profiler_snapshot_num_roots(profiler_snapshot_t *snap)
 {
 	return snap ? snap->roots.num : 0;
@@ -32,6 +32,20 @@ EXPORT void profiler_print_time_between_calls(profiler_snapshot_t *snap);
 
 EXPORT void profiler_free(void);
 
+/* ------------------------------------------------------------------------- */
+/* Tracing */
+
+/* Records every profile_start/profile_end into a per-thread ring buffer
+ * (independently of profiler_start/profiler_stop), so the most recent
+ * events_per_thread begin/end events of each thread can be exported as a
+ * Chrome trace (chrome://tracing, ui.perfetto.dev).  0 uses the default of
+ * 65536 events per thread. */
+
+EXPORT void profiler_trace_start(size_t events_per_thread);
+EXPORT void profiler_trace_stop(void);
+
+EXPORT bool profiler_trace_dump_json(const char *filename);
+
 /* ------------------------------------------------------------------------- */
 /* Profiler name storage */
 
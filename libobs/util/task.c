@@ -2,6 +2,7 @@
 #include "bmem.h"
 #include "threading.h"
 #include "deque.h"
+#include "platform.h"
 
 struct os_task_queue {
 	pthread_t thread;
@@ -162,3 +163,361 @@ static void *tiny_tubular_task_thread(void *param)
 
 	return NULL;
 }
+
+/* ------------------------------------------------------------------------- */
+/* Global work-stealing thread pool */
+
+#define POOL_LANES (OS_TASK_PRIORITY_LOW + 1)
+#define POOL_MIN_WORKERS 2
+#define POOL_MAX_WORKERS 16
+
+struct os_task_group {
+	pthread_mutex_t mutex;
+	long pending;
+	os_event_t *done_event;
+};
+
+struct pool_task {
+	os_task_t task;
+	void *param;
+	struct os_task_group *group;
+};
+
+struct pool_worker {
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	struct deque lanes[POOL_LANES];
+};
+
+struct os_pool {
+	struct pool_worker *workers;
+	size_t num_workers;
+	os_sem_t *sem;
+	volatile long next_worker;
+	volatile bool exit;
+};
+
+static struct os_pool pool = {0};
+static volatile bool pool_active = false;
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static THREAD_LOCAL struct pool_worker *cur_worker = NULL;
+
+static void group_task_done(struct os_task_group *group, long count)
+{
+	pthread_mutex_lock(&group->mutex);
+	group->pending -= count;
+	if (!group->pending)
+		os_event_signal(group->done_event);
+	pthread_mutex_unlock(&group->mutex);
+}
+
+static inline bool worker_pop(struct pool_worker *worker, size_t lane, struct pool_task *task, bool front)
+{
+	bool found = false;
+
+	pthread_mutex_lock(&worker->mutex);
+	if (worker->lanes[lane].size) {
+		if (front)
+			deque_pop_front(&worker->lanes[lane], task, sizeof(*task));
+		else
+			deque_pop_back(&worker->lanes[lane], task, sizeof(*task));
+		found = true;
+	}
+	pthread_mutex_unlock(&worker->mutex);
+
+	return found;
+}
+
+/* A worker takes its own tasks in the order they were queued, and steals the
+ * most recently queued ones from the others.  Lanes are checked in priority
+ * order across all workers. */
+static bool take_task(struct pool_worker *self, struct pool_task *task)
+{
+	size_t start = self ? (size_t)(self - pool.workers) : 0;
+
+	for (size_t lane = 0; lane < POOL_LANES; lane++) {
+		if (self && worker_pop(self, lane, task, true))
+			return true;
+
+		for (size_t i = 0; i < pool.num_workers; i++) {
+			struct pool_worker *victim = &pool.workers[(start + i) % pool.num_workers];
+			if (victim != self && worker_pop(victim, lane, task, false))
+				return true;
+		}
+	}
+
+	return false;
+}
+
+static inline void run_task(struct pool_task *task)
+{
+	task->task(task->param);
+	if (task->group)
+		group_task_done(task->group, 1);
+}
+
+static void *pool_worker_thread(void *param)
+{
+	struct pool_worker *self = param;
+	struct pool_task task;
+
+	cur_worker = self;
+	os_set_thread_name("os_pool worker");
+
+	/* Only sleep after a full scan came up empty.  Every queued task posts
+	 * the semaphore after it is pushed, so a task missed by a scan always
+	 * wakes a worker that will scan again. */
+	for (;;) {
+		if (take_task(self, &task)) {
+			run_task(&task);
+			continue;
+		}
+
+		if (os_atomic_load_bool(&pool.exit))
+			break;
+
+		os_sem_wait(pool.sem);
+	}
+
+	cur_worker = NULL;
+	return NULL;
+}
+
+static bool pool_start(void)
+{
+	size_t num_workers;
+	int cores;
+
+	pthread_mutex_lock(&pool_mutex);
+
+	if (os_atomic_load_bool(&pool_active)) {
+		pthread_mutex_unlock(&pool_mutex);
+		return true;
+	}
+
+	/* leave one core for the thread that queues the work */
+	cores = os_get_logical_cores() - 1;
+	num_workers = cores > POOL_MIN_WORKERS ? (size_t)cores : POOL_MIN_WORKERS;
+	if (num_workers > POOL_MAX_WORKERS)
+		num_workers = POOL_MAX_WORKERS;
+
+	memset(&pool, 0, sizeof(pool));
+	if (os_sem_init(&pool.sem, 0) != 0)
+		goto fail;
+
+	pool.workers = bzalloc(sizeof(struct pool_worker) * num_workers);
+	for (size_t i = 0; i < num_workers; i++)
+		pthread_mutex_init(&pool.workers[i].mutex, NULL);
+
+	/* workers only look at num_workers once they have been created */
+	pool.num_workers = num_workers;
+	for (size_t i = 0; i < num_workers; i++) {
+		if (pthread_create(&pool.workers[i].thread, NULL, pool_worker_thread, &pool.workers[i]) != 0) {
+			os_atomic_set_bool(&pool.exit, true);
+			for (size_t j = 0; j < i; j++)
+				os_sem_post(pool.sem);
+			for (size_t j = 0; j < i; j++)
+				pthread_join(pool.workers[j].thread, NULL);
+			for (size_t j = 0; j < num_workers; j++)
+				pthread_mutex_destroy(&pool.workers[j].mutex);
+			bfree(pool.workers);
+			os_sem_destroy(pool.sem);
+			goto fail;
+		}
+	}
+
+	os_atomic_set_bool(&pool_active, true);
+	pthread_mutex_unlock(&pool_mutex);
+	return true;
+
+fail:
+	memset(&pool, 0, sizeof(pool));
+	pthread_mutex_unlock(&pool_mutex);
+	return false;
+}
+
+static bool pool_queue_task(struct os_task_group *group, os_task_t task, void *param, enum os_task_priority priority)
+{
+	struct pool_task pt = {task, param, group};
+	struct pool_worker *worker = cur_worker;
+
+	if (!task)
+		return false;
+	if ((size_t)priority >= POOL_LANES)
+		priority = OS_TASK_PRIORITY_NORMAL;
+	if (!os_atomic_load_bool(&pool_active) && !pool_start())
+		return false;
+
+	/* tasks queued by a pool task stay with its worker until stolen */
+	if (!worker) {
+		size_t idx = (size_t)os_atomic_inc_long(&pool.next_worker);
+		worker = &pool.workers[idx % pool.num_workers];
+	}
+
+	if (group) {
+		pthread_mutex_lock(&group->mutex);
+		if (!group->pending++)
+			os_event_reset(group->done_event);
+		pthread_mutex_unlock(&group->mutex);
+	}
+
+	pthread_mutex_lock(&worker->mutex);
+	deque_push_back(&worker->lanes[priority], &pt, sizeof(pt));
+	pthread_mutex_unlock(&worker->mutex);
+
+	os_sem_post(pool.sem);
+	return true;
+}
+
+bool os_pool_submit(os_task_t task, void *param, enum os_task_priority priority)
+{
+	return pool_queue_task(NULL, task, param, priority);
+}
+
+bool os_pool_inside(void)
+{
+	return cur_worker != NULL;
+}
+
+void os_pool_shutdown(void)
+{
+	pthread_mutex_lock(&pool_mutex);
+
+	if (!os_atomic_load_bool(&pool_active)) {
+		pthread_mutex_unlock(&pool_mutex);
+		return;
+	}
+
+	/* workers drain every lane before they look at the exit flag */
+	os_atomic_set_bool(&pool.exit, true);
+	for (size_t i = 0; i < pool.num_workers; i++)
+		os_sem_post(pool.sem);
+	for (size_t i = 0; i < pool.num_workers; i++)
+		pthread_join(pool.workers[i].thread, NULL);
+
+	for (size_t i = 0; i < pool.num_workers; i++) {
+		struct pool_worker *worker = &pool.workers[i];
+
+		for (size_t lane = 0; lane < POOL_LANES; lane++)
+			deque_free(&worker->lanes[lane]);
+		pthread_mutex_destroy(&worker->mutex);
+	}
+
+	bfree(pool.workers);
+	os_sem_destroy(pool.sem);
+	memset(&pool, 0, sizeof(pool));
+
+	os_atomic_set_bool(&pool_active, false);
+	pthread_mutex_unlock(&pool_mutex);
+}
+
+os_task_group_t *os_task_group_create(void)
+{
+	struct os_task_group *group = bzalloc(sizeof(*group));
+
+	if (pthread_mutex_init(&group->mutex, NULL) != 0)
+		goto fail1;
+	if (os_event_init(&group->done_event, OS_EVENT_TYPE_MANUAL) != 0)
+		goto fail2;
+
+	/* nothing pending yet */
+	os_event_signal(group->done_event);
+	return group;
+
+fail2:
+	pthread_mutex_destroy(&group->mutex);
+fail1:
+	bfree(group);
+	return NULL;
+}
+
+bool os_task_group_submit(os_task_group_t *group, os_task_t task, void *param, enum os_task_priority priority)
+{
+	if (!group)
+		return false;
+
+	return pool_queue_task(group, task, param, priority);
+}
+
+static inline bool group_pending(struct os_task_group *group)
+{
+	pthread_mutex_lock(&group->mutex);
+	bool pending = group->pending > 0;
+	pthread_mutex_unlock(&group->mutex);
+	return pending;
+}
+
+void os_task_group_wait(os_task_group_t *group)
+{
+	struct pool_worker *self = cur_worker;
+	struct pool_task task;
+
+	if (!group)
+		return;
+
+	if (!self) {
+		/* the event is manual and stays signaled until the next task
+		 * is queued, so every thread waiting on it wakes up */
+		os_event_wait(group->done_event);
+		return;
+	}
+
+	/* blocking a worker on tasks that may be queued behind it could
+	 * deadlock the pool, so keep running tasks while waiting */
+	while (group_pending(group)) {
+		if (take_task(self, &task))
+			run_task(&task);
+		else
+			os_event_timedwait(group->done_event, 1);
+	}
+}
+
+size_t os_task_group_cancel(os_task_group_t *group)
+{
+	size_t removed = 0;
+
+	if (!group || !os_atomic_load_bool(&pool_active))
+		return 0;
+
+	for (size_t i = 0; i < pool.num_workers; i++) {
+		struct pool_worker *worker = &pool.workers[i];
+
+		pthread_mutex_lock(&worker->mutex);
+
+		for (size_t lane = 0; lane < POOL_LANES; lane++) {
+			struct deque *dq = &worker->lanes[lane];
+			size_t count = dq->size / sizeof(struct pool_task);
+
+			/* rotate through the lane once, dropping the group's tasks */
+			for (size_t j = 0; j < count; j++) {
+				struct pool_task pt;
+
+				deque_pop_front(dq, &pt, sizeof(pt));
+				if (pt.group == group)
+					removed++;
+				else
+					deque_push_back(dq, &pt, sizeof(pt));
+			}
+		}
+
+		pthread_mutex_unlock(&worker->mutex);
+	}
+
+	if (removed)
+		group_task_done(group, (long)removed);
+
+	return removed;
+}
+
+void os_task_group_destroy(os_task_group_t *group)
+{
+	if (!group)
+		return;
+
+	os_task_group_cancel(group);
+	os_task_group_wait(group);
+
+	os_event_destroy(group->done_event);
+	pthread_mutex_destroy(&group->mutex);
+	bfree(group);
+}
@@ -17,6 +17,46 @@ EXPORT void os_task_queue_destroy(os_task_queue_t *tt);
 EXPORT bool os_task_queue_wait(os_task_queue_t *tt);
 EXPORT bool os_task_queue_inside(os_task_queue_t *tt);
 
+/* ------------------------------------------------------------------------- */
+/* Global work-stealing thread pool
+ *
+ * Tasks run on a fixed set of worker threads shared by everything in the
+ * process.  Every worker has its own queue and idle workers steal from the
+ * others, so there is no order between tasks; code that needs tasks to run
+ * one after another should use an os_task_queue_t instead.  Higher priority
+ * tasks are always started before lower priority ones that are waiting.
+ *
+ * Task groups track a set of tasks so that they can be waited for or
+ * canceled together.  Waiting for a group from inside a pool task runs other
+ * pool tasks in the meantime instead of blocking the worker. */
+
+enum os_task_priority {
+	OS_TASK_PRIORITY_HIGH,
+	OS_TASK_PRIORITY_NORMAL,
+	OS_TASK_PRIORITY_LOW,
+};
+
+struct os_task_group;
+typedef struct os_task_group os_task_group_t;
+
+EXPORT bool os_pool_submit(os_task_t task, void *param, enum os_task_priority priority);
+EXPORT bool os_pool_inside(void);
+
+/* Runs the tasks that are still queued and stops the worker threads.  The
+ * pool is started again by the next submitted task. */
+EXPORT void os_pool_shutdown(void);
+
+EXPORT os_task_group_t *os_task_group_create(void);
+EXPORT bool os_task_group_submit(os_task_group_t *group, os_task_t task, void *param, enum os_task_priority priority);
+EXPORT void os_task_group_wait(os_task_group_t *group);
+
+/* Removes the tasks of the group that have not been started yet, returns
+ * the number of tasks removed.  Tasks already running are not affected. */
+EXPORT size_t os_task_group_cancel(os_task_group_t *group);
+
+/* Cancels the queued tasks of the group and waits for the running ones */
+EXPORT void os_task_group_destroy(os_task_group_t *group);
+
 #ifdef __cplusplus
 }
 #endif
@@ -153,7 +153,11 @@ int os_event_signal(os_event_t *event)
 	int code = 0;
 
 	pthread_mutex_lock(&event->mutex);
-	code = pthread_cond_signal(&event->cond);
+	/* a manual event stays signaled, so it releases every waiter */
+	if (event->manual)
+		code = pthread_cond_broadcast(&event->cond);
+	else
+		code = pthread_cond_signal(&event->cond);
 	event->signalled = true;
 	pthread_mutex_unlock(&event->mutex);
 
@@ -257,6 +261,8 @@ int os_sem_wait(os_sem_t *sem)
 
 void os_set_thread_name(const char *name)
 {
+	bmem_set_thread_name(name);
+
 #if defined(__APPLE__)
 	pthread_setname_np(name);
 #elif defined(__FreeBSD__)
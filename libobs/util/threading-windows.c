@@ -167,6 +167,8 @@ struct vs_threadname_info {
 
 void os_set_thread_name(const char *name)
 {
+	bmem_set_thread_name(name);
+
 #ifdef __MINGW32__
 	UNUSED_PARAMETER(name);
 #else
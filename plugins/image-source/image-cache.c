@@ -0,0 +1,320 @@
+/******************************************************************************
+    Copyright (C) 2026 by agent <agent@local>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include <inttypes.h>
+
+#include <obs-module.h>
+#include <util/darray.h>
+#include <util/dstr.h>
+#include <util/threading.h>
+
+#include "image-cache.h"
+
+#define MiB (1024.0 * 1024.0)
+
+struct image_cache_entry {
+	char *path;
+	time_t mtime;
+	enum gs_image_alpha_mode alpha_mode;
+	uint32_t max_cx;
+	uint32_t max_cy;
+	bool shared;
+
+	/* protected by the cache mutex */
+	long refs;
+
+	/* protected by the entry mutex */
+	pthread_mutex_t mutex;
+	bool decoded;
+	bool texture_loaded;
+	gs_image_file5_t if5;
+};
+
+static struct {
+	pthread_mutex_t mutex;
+	DARRAY(struct image_cache_entry *) entries;
+
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t bytes;
+	uint64_t peak_bytes;
+} cache;
+
+static inline uint64_t entry_mem_usage(const struct image_cache_entry *entry)
+{
+	return entry->if5.image4.image3.image2.mem_usage;
+}
+
+/* animated GIFs are ticked by each source on its own */
+static bool is_shareable(const char *path)
+{
+	size_t len = strlen(path);
+	return !(len > 4 && astrcmpi(path + len - 4, ".gif") == 0);
+}
+
+static struct image_cache_entry *find_entry(const char *path, time_t mtime, enum gs_image_alpha_mode alpha_mode,
+					     uint32_t max_cx, uint32_t max_cy)
+{
+	for (size_t i = 0; i < cache.entries.num; i++) {
+		struct image_cache_entry *entry = cache.entries.array[i];
+
+		if (entry->shared && entry->mtime == mtime && entry->alpha_mode == alpha_mode &&
+		    entry->max_cx == max_cx && entry->max_cy == max_cy && strcmp(entry->path, path) == 0)
+			return entry;
+	}
+
+	return NULL;
+}
+
+static inline bool can_downscale(enum gs_color_format format)
+{
+	switch (format) {
+	case GS_RGBA:
+	case GS_BGRX:
+	case GS_BGRA:
+	case GS_RGBA_UNORM:
+	case GS_BGRX_UNORM:
+	case GS_BGRA_UNORM:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/* averages the source pixels covered by each destination pixel */
+static uint8_t *downscale_pixels(const uint8_t *src, uint32_t cx, uint32_t cy, uint32_t new_cx, uint32_t new_cy)
+{
+	uint8_t *dst = bmalloc((size_t)new_cx * new_cy * 4);
+	uint64_t *sums = bmalloc((size_t)new_cx * 4 * sizeof(uint64_t));
+
+	for (uint32_t oy = 0; oy < new_cy; oy++) {
+		uint32_t y0 = (uint32_t)((uint64_t)oy * cy / new_cy);
+		uint32_t y1 = (uint32_t)((uint64_t)(oy + 1) * cy / new_cy);
+
+		memset(sums, 0, (size_t)new_cx * 4 * sizeof(uint64_t));
+
+		for (uint32_t y = y0; y < y1; y++) {
+			const uint8_t *row = src + (size_t)y * cx * 4;
+
+			for (uint32_t ox = 0; ox < new_cx; ox++) {
+				uint32_t x0 = (uint32_t)((uint64_t)ox * cx / new_cx);
+				uint32_t x1 = (uint32_t)((uint64_t)(ox + 1) * cx / new_cx);
+				uint64_t *sum = sums + ox * 4;
+
+				for (uint32_t x = x0; x < x1; x++) {
+					sum[0] += row[x * 4 + 0];
+					sum[1] += row[x * 4 + 1];
+					sum[2] += row[x * 4 + 2];
+					sum[3] += row[x * 4 + 3];
+				}
+			}
+		}
+
+		uint8_t *out = dst + (size_t)oy * new_cx * 4;
+
+		for (uint32_t ox = 0; ox < new_cx; ox++) {
+			uint32_t x0 = (uint32_t)((uint64_t)ox * cx / new_cx);
+			uint32_t x1 = (uint32_t)((uint64_t)(ox + 1) * cx / new_cx);
+			uint64_t count = (uint64_t)(x1 - x0) * (y1 - y0);
+
+			for (size_t c = 0; c < 4; c++)
+				out[ox * 4 + c] = (uint8_t)((sums[ox * 4 + c] + count / 2) / count);
+		}
+	}
+
+	bfree(sums);
+	return dst;
+}
+
+/* scales still images down to fit in the maximum size, keeping the aspect
+ * ratio.  Animated GIFs and formats other than 8 bit RGBA are left alone. */
+static void downscale_image(struct image_cache_entry *entry)
+{
+	gs_image_file_t *image = &entry->if5.image4.image3.image2.image;
+	uint32_t new_cx, new_cy;
+
+	if ((!entry->max_cx && !entry->max_cy) || !image->texture_data || image->is_animated_gif ||
+	    !can_downscale(image->format))
+		return;
+
+	uint32_t max_cx = entry->max_cx ? entry->max_cx : image->cx;
+	uint32_t max_cy = entry->max_cy ? entry->max_cy : image->cy;
+
+	if (image->cx <= max_cx && image->cy <= max_cy)
+		return;
+
+	if ((uint64_t)image->cx * max_cy > (uint64_t)image->cy * max_cx) {
+		new_cx = max_cx;
+		new_cy = (uint32_t)((uint64_t)image->cy * max_cx / image->cx);
+	} else {
+		new_cy = max_cy;
+		new_cx = (uint32_t)((uint64_t)image->cx * max_cy / image->cy);
+	}
+
+	if (!new_cx)
+		new_cx = 1;
+	if (!new_cy)
+		new_cy = 1;
+
+	uint8_t *data = downscale_pixels(image->texture_data, image->cx, image->cy, new_cx, new_cy);
+
+	entry->if5.image4.image3.image2.mem_usage -= (uint64_t)image->cx * image->cy * 4;
+	entry->if5.image4.image3.image2.mem_usage += (uint64_t)new_cx * new_cy * 4;
+
+	bfree(image->texture_data);
+	image->texture_data = data;
+	image->cx = new_cx;
+	image->cy = new_cy;
+}
+
+void image_cache_init(void)
+{
+	memset(&cache, 0, sizeof(cache));
+	pthread_mutex_init(&cache.mutex, NULL);
+}
+
+void image_cache_free(void)
+{
+	if (cache.hits || cache.misses)
+		blog(LOG_INFO,
+		     "[image_cache] %" PRIu64 " hits, %" PRIu64 " misses, "
+		     "peak %.1f MiB of decoded images",
+		     cache.hits, cache.misses, (double)cache.peak_bytes / MiB);
+
+	if (cache.entries.num)
+		blog(LOG_WARNING, "[image_cache] %zu images still in use on unload", cache.entries.num);
+
+	da_free(cache.entries);
+	pthread_mutex_destroy(&cache.mutex);
+}
+
+struct image_cache_entry *image_cache_acquire(const char *path, time_t mtime, enum gs_image_alpha_mode alpha_mode,
+					      uint32_t max_cx, uint32_t max_cy, uint64_t gif_memory_budget,
+					      bool gif_compress_frames)
+{
+	struct image_cache_entry *entry = NULL;
+	bool shareable = is_shareable(path);
+	long refs = 1;
+
+	pthread_mutex_lock(&cache.mutex);
+
+	if (shareable)
+		entry = find_entry(path, mtime, alpha_mode, max_cx, max_cy);
+
+	if (entry) {
+		refs = ++entry->refs;
+		cache.hits++;
+	} else {
+		entry = bzalloc(sizeof(*entry));
+		entry->path = bstrdup(path);
+		entry->mtime = mtime;
+		entry->alpha_mode = alpha_mode;
+		entry->max_cx = max_cx;
+		entry->max_cy = max_cy;
+		entry->shared = shareable;
+		entry->refs = 1;
+		pthread_mutex_init(&entry->mutex, NULL);
+
+		da_push_back(cache.entries, &entry);
+		cache.misses++;
+	}
+
+	pthread_mutex_unlock(&cache.mutex);
+
+	/* whoever gets here first decodes, anyone else waits for it */
+	pthread_mutex_lock(&entry->mutex);
+
+	if (!entry->decoded) {
+		gs_image_file5_init(&entry->if5, path, alpha_mode, gif_memory_budget, gif_compress_frames);
+		downscale_image(entry);
+		entry->decoded = true;
+
+		pthread_mutex_lock(&cache.mutex);
+		cache.bytes += entry_mem_usage(entry);
+		if (cache.bytes > cache.peak_bytes)
+			cache.peak_bytes = cache.bytes;
+		pthread_mutex_unlock(&cache.mutex);
+	}
+
+	pthread_mutex_unlock(&entry->mutex);
+
+	if (refs > 1)
+		blog(LOG_DEBUG, "[image_cache] '%s' shared by %ld sources, %.1f MiB saved", path, refs,
+		     (double)entry_mem_usage(entry) * (double)(refs - 1) / MiB);
+
+	return entry;
+}
+
+void image_cache_load_texture(struct image_cache_entry *entry)
+{
+	if (!entry)
+		return;
+
+	pthread_mutex_lock(&entry->mutex);
+
+	if (!entry->texture_loaded) {
+		gs_image_file5_init_texture(&entry->if5);
+		entry->texture_loaded = true;
+	}
+
+	pthread_mutex_unlock(&entry->mutex);
+}
+
+void image_cache_release(struct image_cache_entry *entry)
+{
+	bool destroy;
+
+	if (!entry)
+		return;
+
+	pthread_mutex_lock(&cache.mutex);
+
+	destroy = --entry->refs == 0;
+	if (destroy) {
+		da_erase_item(cache.entries, &entry);
+		cache.bytes -= entry_mem_usage(entry);
+	}
+
+	pthread_mutex_unlock(&cache.mutex);
+
+	if (!destroy)
+		return;
+
+	gs_image_file5_free(&entry->if5);
+	pthread_mutex_destroy(&entry->mutex);
+	bfree(entry->path);
+	bfree(entry);
+}
+
+gs_image_file5_t *image_cache_get_image(struct image_cache_entry *entry)
+{
+	return entry ? &entry->if5 : NULL;
+}
+
+uint64_t image_cache_get_mem_usage(struct image_cache_entry *entry)
+{
+	uint64_t usage;
+
+	if (!entry)
+		return 0;
+
+	pthread_mutex_lock(&cache.mutex);
+	usage = entry_mem_usage(entry) / (uint64_t)(entry->refs > 0 ? entry->refs : 1);
+	pthread_mutex_unlock(&cache.mutex);
+
+	return usage;
+}
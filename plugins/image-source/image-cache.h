@@ -0,0 +1,57 @@
+/******************************************************************************
+    Copyright (C) 2026 by agent <agent@local>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include <time.h>
+#include <graphics/image-file.h>
+
+/*
+ * Decoded images shared by all image sources and slideshow slides of the
+ * module.  Images are keyed by path, modification time and alpha mode, so the
+ * same file used in many scenes is decoded once and uploaded to a single
+ * texture.  Entries are reference counted and freed with their last user.
+ *
+ * Images can be limited to a maximum size, in which case larger ones are
+ * scaled down to fit when they are decoded.  The limit is part of the key.
+ *
+ * Animated GIFs keep their playback state in the image itself, so every user
+ * gets its own copy of those.
+ */
+
+struct image_cache_entry;
+
+extern void image_cache_init(void);
+extern void image_cache_free(void);
+
+/* decodes the image if nobody else has it yet, may block on another thread
+ * decoding the same image.  The GIF settings only apply to animated GIFs,
+ * which are never shared. */
+extern struct image_cache_entry *image_cache_acquire(const char *path, time_t mtime,
+						     enum gs_image_alpha_mode alpha_mode, uint32_t max_cx,
+						     uint32_t max_cy, uint64_t gif_memory_budget,
+						     bool gif_compress_frames);
+
+/* must be called within the graphics context */
+extern void image_cache_load_texture(struct image_cache_entry *entry);
+extern void image_cache_release(struct image_cache_entry *entry);
+
+extern gs_image_file5_t *image_cache_get_image(struct image_cache_entry *entry);
+
+/* the memory used by the image divided among everyone sharing it, so that
+ * the usage of all users adds up to the real total */
+extern uint64_t image_cache_get_mem_usage(struct image_cache_entry *entry);
@@ -5,6 +5,8 @@
 #include <util/dstr.h>
 #include <sys/stat.h>
 
+#include "image-cache.h"
+
 #define blog(log_level, format, ...) \
 	blog(log_level, "[image_source: '%s'] " format, obs_source_get_name(context->source), ##__VA_ARGS__)
 
@@ -19,6 +21,10 @@ struct image_source {
 	bool persistent;
 	bool is_slide;
 	bool linear_alpha;
+	uint32_t max_cx;
+	uint32_t max_cy;
+	uint64_t gif_memory_budget;
+	bool gif_compress_frames;
 	time_t file_timestamp;
 	float update_time_elapsed;
 	uint64_t last_time;
@@ -27,7 +33,7 @@ struct image_source {
 	volatile bool file_decoded;
 	volatile bool texture_loaded;
 
-	gs_image_file4_t if4;
+	struct image_cache_entry *image;
 };
 
 static time_t get_modified_timestamp(const char *filename)
@@ -51,11 +57,20 @@ void image_source_preload_image(void *data)
 		return;
 
 	context->file_timestamp = get_modified_timestamp(context->file);
-	gs_image_file4_init(&context->if4, context->file,
-			    context->linear_alpha ? GS_IMAGE_ALPHA_PREMULTIPLY_SRGB : GS_IMAGE_ALPHA_PREMULTIPLY);
+	context->image = image_cache_acquire(context->file, context->file_timestamp,
+					     context->linear_alpha ? GS_IMAGE_ALPHA_PREMULTIPLY_SRGB
+								   : GS_IMAGE_ALPHA_PREMULTIPLY,
+					     context->max_cx, context->max_cy, context->gif_memory_budget,
+					     context->gif_compress_frames);
 	os_atomic_set_bool(&context->file_decoded, true);
 }
 
+bool image_source_is_decoded(void *data)
+{
+	struct image_source *context = data;
+	return os_atomic_load_bool(&context->file_decoded);
+}
+
 static void image_source_load_texture(void *data)
 {
 	struct image_source *context = data;
@@ -65,10 +80,11 @@ static void image_source_load_texture(void *data)
 	debug("loading texture '%s'", context->file);
 
 	obs_enter_graphics();
-	gs_image_file4_init_texture(&context->if4);
+	image_cache_load_texture(context->image);
 	obs_leave_graphics();
 
-	if (!context->if4.image3.image2.image.loaded)
+	gs_image_file5_t *if5 = image_cache_get_image(context->image);
+	if (!if5 || !if5->image4.image3.image2.image.loaded)
 		warn("failed to load texture '%s'", context->file);
 	context->update_time_elapsed = 0;
 	os_atomic_set_bool(&context->texture_loaded, true);
@@ -81,7 +97,8 @@ static void image_source_unload(void *data)
 	os_atomic_set_bool(&context->texture_loaded, false);
 
 	obs_enter_graphics();
-	gs_image_file4_free(&context->if4);
+	image_cache_release(context->image);
+	context->image = NULL;
 	obs_leave_graphics();
 }
 
@@ -102,6 +119,10 @@ static void image_source_update(void *data, obs_data_t *settings)
 	const bool unload = obs_data_get_bool(settings, "unload");
 	const bool linear_alpha = obs_data_get_bool(settings, "linear_alpha");
 	const bool is_slide = obs_data_get_bool(settings, "is_slide");
+	const long long max_cx = obs_data_get_int(settings, "max_width");
+	const long long max_cy = obs_data_get_int(settings, "max_height");
+	const long long gif_memory_budget = obs_data_get_int(settings, "gif_memory_budget");
+	const bool gif_compress_frames = obs_data_get_bool(settings, "gif_compress_frames");
 
 	if (context->file)
 		bfree(context->file);
@@ -109,6 +130,10 @@ static void image_source_update(void *data, obs_data_t *settings)
 	context->persistent = !unload;
 	context->linear_alpha = linear_alpha;
 	context->is_slide = is_slide;
+	context->max_cx = max_cx > 0 ? (uint32_t)max_cx : 0;
+	context->max_cy = max_cy > 0 ? (uint32_t)max_cy : 0;
+	context->gif_memory_budget = gif_memory_budget > 0 ? (uint64_t)gif_memory_budget * 1024 * 1024 : 0;
+	context->gif_compress_frames = gif_compress_frames;
 
 	if (is_slide)
 		return;
@@ -124,6 +149,8 @@ static void image_source_defaults(obs_data_t *settings)
 {
 	obs_data_set_default_bool(settings, "unload", false);
 	obs_data_set_default_bool(settings, "linear_alpha", false);
+	obs_data_set_default_int(settings, "gif_memory_budget", 512);
+	obs_data_set_default_bool(settings, "gif_compress_frames", false);
 }
 
 static void image_source_show(void *data)
@@ -145,14 +172,15 @@ static void image_source_hide(void *data)
 static void restart_gif(void *data)
 {
 	struct image_source *context = data;
+	gs_image_file5_t *if5 = image_cache_get_image(context->image);
 
-	if (context->if4.image3.image2.image.is_animated_gif) {
-		context->if4.image3.image2.image.cur_frame = 0;
-		context->if4.image3.image2.image.cur_loop = 0;
-		context->if4.image3.image2.image.cur_time = 0;
+	if (if5 && if5->image4.image3.image2.image.is_animated_gif) {
+		if5->image4.image3.image2.image.cur_frame = 0;
+		if5->image4.image3.image2.image.cur_loop = 0;
+		if5->image4.image3.image2.image.cur_time = 0;
 
 		obs_enter_graphics();
-		gs_image_file4_update_texture(&context->if4);
+		gs_image_file5_update_texture(if5);
 		obs_leave_graphics();
 
 		context->restart_gif = false;
@@ -188,13 +216,15 @@ static void image_source_destroy(void *data)
 static uint32_t image_source_getwidth(void *data)
 {
 	struct image_source *context = data;
-	return context->if4.image3.image2.image.cx;
+	gs_image_file5_t *if5 = image_cache_get_image(context->image);
+	return if5 ? if5->image4.image3.image2.image.cx : 0;
 }
 
 static uint32_t image_source_getheight(void *data)
 {
 	struct image_source *context = data;
-	return context->if4.image3.image2.image.cy;
+	gs_image_file5_t *if5 = image_cache_get_image(context->image);
+	return if5 ? if5->image4.image3.image2.image.cy : 0;
 }
 
 static void image_source_render(void *data, gs_effect_t *effect)
@@ -203,7 +233,11 @@ static void image_source_render(void *data, gs_effect_t *effect)
 	if (!os_atomic_load_bool(&context->texture_loaded))
 		return;
 
-	struct gs_image_file *const image = &context->if4.image3.image2.image;
+	gs_image_file5_t *const if5 = image_cache_get_image(context->image);
+	if (!if5)
+		return;
+
+	struct gs_image_file *const image = &if5->image4.image3.image2.image;
 	gs_texture_t *const texture = image->texture;
 	if (!texture)
 		return;
@@ -249,9 +283,12 @@ static void image_source_tick(void *data, float seconds)
 		}
 	}
 
+	gs_image_file5_t *if5 = image_cache_get_image(context->image);
+	const bool is_animated_gif = if5 && if5->image4.image3.image2.image.is_animated_gif;
+
 	if (obs_source_showing(context->source)) {
 		if (!context->active) {
-			if (context->if4.image3.image2.image.is_animated_gif)
+			if (is_animated_gif)
 				context->last_time = frame_time;
 			context->active = true;
 		}
@@ -268,13 +305,13 @@ static void image_source_tick(void *data, float seconds)
 		return;
 	}
 
-	if (context->last_time && context->if4.image3.image2.image.is_animated_gif) {
+	if (context->last_time && is_animated_gif) {
 		uint64_t elapsed = frame_time - context->last_time;
-		bool updated = gs_image_file4_tick(&context->if4, elapsed);
+		bool updated = gs_image_file5_tick(if5, elapsed);
 
 		if (updated) {
 			obs_enter_graphics();
-			gs_image_file4_update_texture(&context->if4);
+			gs_image_file5_update_texture(if5);
 			obs_leave_graphics();
 		}
 	}
@@ -310,13 +347,19 @@ static obs_properties_t *image_source_properties(void *data)
 	obs_properties_add_bool(props, "unload", obs_module_text("UnloadWhenNotShowing"));
 	obs_properties_add_bool(props, "linear_alpha", obs_module_text("LinearAlpha"));
 
+	obs_property_t *p = obs_properties_add_int(props, "gif_memory_budget", obs_module_text("GifMemoryBudget"), 0,
+						   65536, 64);
+	obs_property_int_set_suffix(p, " MB");
+	obs_property_set_long_description(p, obs_module_text("GifMemoryBudget.Description"));
+	obs_properties_add_bool(props, "gif_compress_frames", obs_module_text("GifCompressFrames"));
+
 	return props;
 }
 
 uint64_t image_source_get_memory_usage(void *data)
 {
 	struct image_source *s = data;
-	return s->if4.image3.image2.mem_usage;
+	return image_cache_get_mem_usage(s->image);
 }
 
 static void missing_file_callback(void *src, const char *new_path, void *data)
@@ -356,8 +399,8 @@ static enum gs_color_space image_source_get_color_space(void *data, size_t count
 	UNUSED_PARAMETER(preferred_spaces);
 
 	struct image_source *const s = data;
-	gs_image_file4_t *const if4 = &s->if4;
-	return if4->image3.image2.image.texture ? if4->space : GS_CS_SRGB;
+	gs_image_file5_t *const if5 = image_cache_get_image(s->image);
+	return (if5 && if5->image4.image3.image2.image.texture) ? if5->image4.space : GS_CS_SRGB;
 }
 
 static struct obs_source_info image_source_info = {
@@ -397,6 +440,8 @@ extern struct obs_source_info color_source_info_v3;
 
 bool obs_module_load(void)
 {
+	image_cache_init();
+
 	obs_register_source(&image_source_info);
 	obs_register_source(&color_source_info_v1);
 	obs_register_source(&color_source_info_v2);
@@ -405,3 +450,8 @@ bool obs_module_load(void)
 	obs_register_source(&slideshow_info_mk2);
 	return true;
 }
+
+void obs_module_unload(void)
+{
+	image_cache_free();
+}
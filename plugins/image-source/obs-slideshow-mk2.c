@@ -12,6 +12,7 @@
 	blog(level, "[slideshow: '%s'] " format, obs_source_get_name(ss->source), ##__VA_ARGS__)
 
 #define warn(format, ...) do_log(LOG_WARNING, format, ##__VA_ARGS__)
+#define debug(format, ...) do_log(LOG_DEBUG, format, ##__VA_ARGS__)
 
 /* clang-format off */
 
@@ -34,6 +35,7 @@ static const char *S_PLAYBACK_MODE           = "playback_mode";
 static const char *S_PLAYBACK_ONCE           = "once";
 static const char *S_PLAYBACK_LOOP           = "loop";
 static const char *S_PLAYBACK_RANDOM         = "random";
+static const char *S_LOOKAHEAD               = "lookahead";
 
 static const char *TR_CUT                    = "cut";
 static const char *TR_FADE                   = "fade";
@@ -58,6 +60,7 @@ static const char *TR_SLIDE                  = "slide";
 #define T_PLAYBACK_ONCE                      T_("PlaybackMode.Once")
 #define T_PLAYBACK_LOOP                      T_("PlaybackMode.Loop")
 #define T_PLAYBACK_RANDOM                    T_("PlaybackMode.Random")
+#define T_LOOKAHEAD                          T_("Lookahead")
 
 #define T_TR_(text) obs_module_text("SlideShow.Transition." text)
 #define T_TR_CUT                             T_TR_("Cut")
@@ -68,6 +71,7 @@ static const char *TR_SLIDE                  = "slide";
 /* clang-format on */
 
 extern void image_source_preload_image(void *data);
+extern bool image_source_is_decoded(void *data);
 
 /* ------------------------------------------------------------------------- */
 
@@ -90,6 +94,7 @@ enum behavior {
 };
 
 #define SLIDE_BUFFER_COUNT 5
+#define MAX_LOOKAHEAD 50
 
 struct active_slides {
 	struct deque prev;
@@ -106,6 +111,7 @@ struct slideshow_data {
 	bool manual;
 	bool randomize;
 	bool loop;
+	size_t lookahead;
 	bool restart_on_activate;
 	bool pause_on_deactivate;
 	bool restart;
@@ -124,7 +130,8 @@ struct slideshow {
 	obs_source_t *source;
 
 	struct slideshow_data data;
-	os_task_queue_t *queue;
+	os_task_group_t *decode_group;
+	volatile bool stopping;
 	obs_source_t *transition;
 	uint32_t cx;
 	uint32_t cy;
@@ -134,6 +141,27 @@ struct slideshow {
 	obs_hotkey_id stop_hotkey;
 	obs_hotkey_id next_hotkey;
 	obs_hotkey_id prev_hotkey;
+
+	/* slides are decoded on the thread pool, but only a few at a time so
+	 * that long decodes can't hold up the video and audio threads' tasks */
+	pthread_mutex_t decode_mutex;
+	struct deque decode_queue;
+	size_t decodes_running;
+	size_t max_decodes_running;
+
+	/* latency is measured from when the slide was queued */
+	uint64_t decodes;
+	uint64_t total_latency_ns;
+	uint64_t max_latency_ns;
+	uint64_t total_decode_ns;
+	uint64_t transitions;
+	uint64_t late_transitions;
+};
+
+struct slide_decode {
+	struct slideshow *ss;
+	obs_weak_source_t *weak;
+	uint64_t queued_ts;
 };
 
 static void set_media_state(void *data, enum obs_media_state state)
@@ -256,6 +284,18 @@ static void do_transition(void *data, bool to_null)
 	}
 
 	if (valid && !to_null) {
+		obs_source_t *cur = ssd->slides.cur.source;
+		bool late = cur && !image_source_is_decoded(obs_obj_get_data(cur));
+
+		pthread_mutex_lock(&ss->decode_mutex);
+		ss->transitions++;
+		if (late)
+			ss->late_transitions++;
+		pthread_mutex_unlock(&ss->decode_mutex);
+
+		if (late)
+			debug("transition to '%s' before it was decoded", ssd->slides.cur.path);
+
 		calldata_set_int(&ssd->cd, "index", ssd->slides.cur.slide_idx);
 		calldata_set_string(&ssd->cd, "path", ssd->slides.cur.path);
 
@@ -280,33 +320,97 @@ static inline struct source_data *deque_get_source(struct deque *buf, size_t sli
 	return NULL;
 }
 
+static void decode_image(void *data);
+
+static void start_decode(struct slideshow *ss, struct slide_decode *task)
+{
+	if (!os_task_group_submit(ss->decode_group, decode_image, task, OS_TASK_PRIORITY_LOW))
+		decode_image(task);
+}
+
+static void queue_decode(struct slideshow *ss, struct slide_decode *task, bool urgent)
+{
+	pthread_mutex_lock(&ss->decode_mutex);
+
+	if (ss->decodes_running < ss->max_decodes_running) {
+		ss->decodes_running++;
+		pthread_mutex_unlock(&ss->decode_mutex);
+		start_decode(ss, task);
+		return;
+	}
+
+	if (urgent)
+		deque_push_front(&ss->decode_queue, &task, sizeof(task));
+	else
+		deque_push_back(&ss->decode_queue, &task, sizeof(task));
+
+	pthread_mutex_unlock(&ss->decode_mutex);
+}
+
 static void decode_image(void *data)
 {
-	obs_weak_source_t *weak = data;
+	struct slide_decode *task = data;
+	struct slideshow *ss = task->ss;
+	struct slide_decode *next = NULL;
+	obs_source_t *source = NULL;
+
+	if (!os_atomic_load_bool(&ss->stopping))
+		source = obs_weak_source_get_source(task->weak);
 
-	obs_source_t *source = obs_weak_source_get_source(weak);
 	if (source) {
+		uint64_t start = os_gettime_ns();
 		image_source_preload_image(obs_obj_get_data(source));
+		uint64_t end = os_gettime_ns();
+		uint64_t latency = end - task->queued_ts;
+
 		obs_source_release(source);
+
+		pthread_mutex_lock(&ss->decode_mutex);
+		ss->decodes++;
+		ss->total_latency_ns += latency;
+		ss->total_decode_ns += end - start;
+		if (latency > ss->max_latency_ns)
+			ss->max_latency_ns = latency;
+		pthread_mutex_unlock(&ss->decode_mutex);
 	}
 
-	obs_weak_source_release(weak);
+	obs_weak_source_release(task->weak);
+	bfree(task);
+
+	/* start the next slide in line */
+	pthread_mutex_lock(&ss->decode_mutex);
+	if (ss->decode_queue.size)
+		deque_pop_front(&ss->decode_queue, &next, sizeof(next));
+	else
+		ss->decodes_running--;
+	pthread_mutex_unlock(&ss->decode_mutex);
+
+	if (next)
+		start_decode(ss, next);
 }
 
-/* creates source from a file path. only used in get_new_source(). */
-static inline obs_source_t *create_source_from_file(struct slideshow *ss, const char *file, bool now)
+/* creates source from a file path. only used in get_new_source(). urgent
+ * slides are decoded before the ones that are already waiting. */
+static inline obs_source_t *create_source_from_file(struct slideshow *ss, const char *file, bool now, bool urgent)
 {
 	obs_data_t *settings = obs_data_create();
+	struct slide_decode *task;
 	obs_source_t *source;
 
 	obs_data_set_string(settings, "file", file);
 	obs_data_set_bool(settings, "unload", false);
 	obs_data_set_bool(settings, "is_slide", !now);
+	obs_data_set_int(settings, "max_width", ss->cx);
+	obs_data_set_int(settings, "max_height", ss->cy);
 	source = obs_source_create_private("image_source", NULL, settings);
 
 	obs_data_release(settings);
 
-	os_task_queue_queue_task(ss->queue, decode_image, obs_source_get_weak_source(source));
+	task = bmalloc(sizeof(*task));
+	task->ss = ss;
+	task->weak = obs_source_get_weak_source(source);
+	task->queued_ts = os_gettime_ns();
+	queue_decode(ss, task, urgent);
 
 	return source;
 }
@@ -331,7 +435,8 @@ static struct source_data *find_existing_source(struct active_slides *as, size_t
 /* get a new source_data structure and reuse existing sources if possible. *
  * use the 'new' parameter if you want to create a brand new list of       *
  * active sources while still reusing the old list as well.                */
-static struct source_data get_new_source(struct slideshow *ss, struct active_slides *new, size_t slide_idx)
+static struct source_data get_new_source(struct slideshow *ss, struct active_slides *new, size_t slide_idx,
+					 bool urgent)
 {
 	struct slideshow_data *ssd = &ss->data;
 	struct source_data *psd;
@@ -365,7 +470,7 @@ static struct source_data get_new_source(struct slideshow *ss, struct active_sli
 
 	sd.path = ssd->files.array[slide_idx].path;
 	sd.slide_idx = slide_idx;
-	sd.source = create_source_from_file(ss, sd.path, false);
+	sd.source = create_source_from_file(ss, sd.path, false, urgent);
 	return sd;
 }
 
@@ -384,19 +489,19 @@ static void restart_slides(struct slideshow *ss)
 		struct source_data sd;
 		size_t idx;
 
-		new_slides.cur = get_new_source(ss, &new_slides, start_idx);
+		new_slides.cur = get_new_source(ss, &new_slides, start_idx, true);
 
 		idx = start_idx;
-		for (size_t i = 0; i < SLIDE_BUFFER_COUNT; i++) {
+		for (size_t i = 0; i < ssd->lookahead; i++) {
 			idx = get_new_file(ssd, idx, true);
-			sd = get_new_source(ss, &new_slides, idx);
+			sd = get_new_source(ss, &new_slides, idx, i == 0);
 			deque_push_back(&new_slides.next, &sd, sizeof(sd));
 		}
 
 		idx = start_idx;
 		for (size_t i = 0; i < SLIDE_BUFFER_COUNT; i++) {
 			idx = get_new_file(ssd, idx, false);
-			sd = get_new_source(ss, &new_slides, idx);
+			sd = get_new_source(ss, &new_slides, idx, false);
 			deque_push_front(&new_slides.prev, &sd, sizeof(sd));
 		}
 	}
@@ -463,6 +568,13 @@ static void ss_update(void *data, obs_data_t *settings)
 
 	new_data.hide = obs_data_get_bool(settings, S_HIDE);
 
+	long long lookahead = obs_data_get_int(settings, S_LOOKAHEAD);
+	if (lookahead < 1)
+		lookahead = 1;
+	else if (lookahead > MAX_LOOKAHEAD)
+		lookahead = MAX_LOOKAHEAD;
+	new_data.lookahead = (size_t)lookahead;
+
 	if (!old_data.tr_name || strcmp(tr_name, old_data.tr_name) != 0)
 		new_tr = obs_source_create_private(tr_name, NULL, NULL);
 
@@ -562,13 +674,15 @@ static void ss_update(void *data, obs_data_t *settings)
 	/* ------------------------------------- */
 	/* update files                          */
 
+	/* slides are scaled down to the new size when decoded */
+	ss->cx = cx;
+	ss->cy = cy;
+
 	restart_slides(ss);
 
 	/* ------------------------------------- */
 	/* restart transition                    */
 
-	ss->cx = cx;
-	ss->cy = cy;
 	obs_transition_set_size(ss->transition, cx, cy);
 	obs_transition_set_alignment(ss->transition, OBS_ALIGN_CENTER);
 	obs_transition_set_scale_type(ss->transition, OBS_TRANSITION_SCALE_ASPECT);
@@ -644,7 +758,7 @@ static void ss_next_slide(void *data)
 	if (!ssd->files.num || obs_transition_get_time(ss->transition) < 1.0f)
 		return;
 
-	struct source_data *last = deque_data(&slides->next, (SLIDE_BUFFER_COUNT - 1) * sizeof(sd));
+	struct source_data *last = deque_data(&slides->next, slides->next.size - sizeof(sd));
 
 	size_t slide_idx = last->slide_idx;
 	if (ss->data.randomize)
@@ -652,7 +766,7 @@ static void ss_next_slide(void *data)
 	else if (++slide_idx >= ssd->files.num)
 		slide_idx = 0;
 
-	sd = get_new_source(ss, NULL, slide_idx);
+	sd = get_new_source(ss, NULL, slide_idx, false);
 	deque_push_back(&slides->next, &sd, sizeof(sd));
 	deque_push_back(&slides->prev, &slides->cur, sizeof(sd));
 	deque_pop_front(&slides->next, &slides->cur, sizeof(sd));
@@ -682,7 +796,7 @@ static void ss_previous_slide(void *data)
 	else
 		--slide_idx;
 
-	sd = get_new_source(ss, NULL, slide_idx);
+	sd = get_new_source(ss, NULL, slide_idx, false);
 	deque_push_front(&slides->prev, &sd, sizeof(sd));
 	deque_push_front(&slides->next, &slides->cur, sizeof(sd));
 	deque_pop_back(&slides->prev, &slides->cur, sizeof(sd));
@@ -769,9 +883,33 @@ static void ss_destroy(void *data)
 {
 	struct slideshow *ss = data;
 
-	os_task_queue_destroy(ss->queue);
+	/* slides that haven't been decoded yet are skipped */
+	os_atomic_set_bool(&ss->stopping, true);
+
+	pthread_mutex_lock(&ss->decode_mutex);
+	while (ss->decode_queue.size) {
+		struct slide_decode *task;
+		deque_pop_front(&ss->decode_queue, &task, sizeof(task));
+		obs_weak_source_release(task->weak);
+		bfree(task);
+	}
+	pthread_mutex_unlock(&ss->decode_mutex);
+
+	os_task_group_wait(ss->decode_group);
+	os_task_group_destroy(ss->decode_group);
+
+	if (ss->decodes)
+		do_log(LOG_INFO,
+		       "%" PRIu64 " slides decoded, %.1f ms average latency (%.1f ms decoding), "
+		       "%.1f ms max, %" PRIu64 " of %" PRIu64 " transitions before the slide was decoded",
+		       ss->decodes, (double)ss->total_latency_ns / (double)ss->decodes / 1e6,
+		       (double)ss->total_decode_ns / (double)ss->decodes / 1e6, (double)ss->max_latency_ns / 1e6,
+		       ss->late_transitions, ss->transitions);
+
 	obs_source_release(ss->transition);
 	free_slideshow_data(&ss->data);
+	deque_free(&ss->decode_queue);
+	pthread_mutex_destroy(&ss->decode_mutex);
 	bfree(ss);
 }
 
@@ -786,7 +924,12 @@ static void *ss_create(obs_data_t *settings, obs_source_t *source)
 	ss->data.paused = false;
 	ss->data.stop = false;
 
-	ss->queue = os_task_queue_create();
+	ss->decode_group = os_task_group_create();
+	pthread_mutex_init(&ss->decode_mutex, NULL);
+
+	ss->max_decodes_running = (size_t)os_get_logical_cores() / 2;
+	if (!ss->max_decodes_running)
+		ss->max_decodes_running = 1;
 
 	ss->play_pause_hotkey = obs_hotkey_register_source(
 		source, "SlideShow.PlayPause", obs_module_text("SlideShow.PlayPause"), play_pause_hotkey, ss);
@@ -959,6 +1102,7 @@ static void ss_defaults(obs_data_t *settings)
 	obs_data_set_default_string(settings, S_BEHAVIOR, S_BEHAVIOR_ALWAYS_PLAY);
 	obs_data_set_default_string(settings, S_MODE, S_MODE_AUTO);
 	obs_data_set_default_string(settings, S_PLAYBACK_MODE, S_PLAYBACK_LOOP);
+	obs_data_set_default_int(settings, S_LOOKAHEAD, SLIDE_BUFFER_COUNT);
 }
 
 static const char *file_filter = "Image files (*.bmp *.tga *.png *.jpeg *.jpg"
@@ -1014,6 +1158,8 @@ static obs_properties_t *ss_properties(void *data)
 
 	obs_properties_add_bool(ppts, S_HIDE, T_HIDE);
 
+	obs_properties_add_int(ppts, S_LOOKAHEAD, T_LOOKAHEAD, 1, MAX_LOOKAHEAD, 1);
+
 	p = obs_properties_add_list(ppts, S_CUSTOM_SIZE, T_CUSTOM_SIZE, OBS_COMBO_TYPE_EDITABLE,
 				    OBS_COMBO_FORMAT_STRING);
 
@@ -502,7 +502,7 @@ static obs_properties_t *compressor_properties(void *data)
 struct obs_source_info compressor_filter = {
 	.id = "compressor_filter",
 	.type = OBS_SOURCE_TYPE_FILTER,
-	.output_flags = OBS_SOURCE_AUDIO,
+	.output_flags = OBS_SOURCE_AUDIO | OBS_SOURCE_THREADSAFE_TICK,
 	.get_name = compressor_name,
 	.create = compressor_create,
 	.destroy = compressor_destroy,
@@ -0,0 +1,416 @@
+/******************************************************************************
+    Copyright (C) 2026 by agent <agent@local>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#ifdef __linux__
+/* O_DIRECT */
+#define _GNU_SOURCE
+#endif
+
+#include "chunked-file-serializer.h"
+
+#include <errno.h>
+#include <inttypes.h>
+
+#include <util/bmem.h>
+#include <util/dstr.h>
+#include <util/platform.h>
+#include <util/threading.h>
+
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+#endif
+
+/* Page alignment satisfies O_DIRECT on every common file system */
+#define CHUNK_ALIGNMENT 4096
+
+static const size_t DEFAULT_BUF_SIZE = 32ULL * 1048576ULL; // 32 MiB
+static const size_t DEFAULT_CHUNK_SIZE = 1048576;          // 1 MiB
+
+struct chunked_file_output {
+	struct dstr filename;
+
+#ifdef _WIN32
+	FILE *file;
+#else
+	int fd;
+	bool direct;
+#endif
+
+	/* All chunks live in one aligned allocation */
+	uint8_t *memory;
+	size_t chunk_size;
+	size_t num_chunks;
+	size_t *chunk_used;
+
+	/* Chunks [head, head + queued) are waiting for the I/O thread, the
+	 * chunk after them is being filled by the writer. */
+	pthread_mutex_t mutex;
+	size_t head;
+	size_t queued;
+	size_t fill;
+	bool shutdown;
+
+	os_event_t *space_available_event;
+	os_event_t *data_available_event;
+	pthread_t io_thread;
+
+	volatile bool output_error;
+	uint64_t pos;
+
+	/* Statistics */
+	uint64_t chunks_written;
+	size_t max_queued;
+	uint64_t writer_waits;
+};
+
+static inline uint8_t *chunk_data(struct chunked_file_output *out, size_t idx)
+{
+	return out->memory + idx * out->chunk_size;
+}
+
+static void *aligned_alloc_chunks(size_t size)
+{
+#ifdef _WIN32
+	return _aligned_malloc(size, CHUNK_ALIGNMENT);
+#else
+	void *ptr;
+	return posix_memalign(&ptr, CHUNK_ALIGNMENT, size) == 0 ? ptr : NULL;
+#endif
+}
+
+static void aligned_free_chunks(void *ptr)
+{
+#ifdef _WIN32
+	_aligned_free(ptr);
+#else
+	free(ptr);
+#endif
+}
+
+/* ========================================================================== */
+/* I/O thread                                                                 */
+
+#ifndef _WIN32
+static void disable_direct_io(struct chunked_file_output *out)
+{
+	if (!out->direct)
+		return;
+
+	int flags = fcntl(out->fd, F_GETFL);
+	if (flags != -1)
+		fcntl(out->fd, F_SETFL, flags & ~O_DIRECT);
+	out->direct = false;
+}
+#endif
+
+static bool write_chunk(struct chunked_file_output *out, const uint8_t *data, size_t size)
+{
+#ifdef _WIN32
+	return fwrite(data, 1, size, out->file) == size;
+#else
+	/* O_DIRECT needs the size to be aligned as well, which is only not
+	 * the case for the final chunk */
+	if (out->direct && size % CHUNK_ALIGNMENT)
+		disable_direct_io(out);
+
+	while (size) {
+		ssize_t ret = write(out->fd, data, size);
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+
+			/* the file system accepted O_DIRECT on open but not on
+			 * write, just fall back to regular writes */
+			if (errno == EINVAL && out->direct) {
+				blog(LOG_INFO, "Direct I/O not supported for '%s', using buffered writes",
+				     out->filename.array);
+				disable_direct_io(out);
+				continue;
+			}
+			return false;
+		}
+
+		data += ret;
+		size -= (size_t)ret;
+	}
+
+	return true;
+#endif
+}
+
+static void *io_thread(void *opaque)
+{
+	struct chunked_file_output *out = opaque;
+	os_set_thread_name("chunked writer i/o thread");
+
+	for (;;) {
+		pthread_mutex_lock(&out->mutex);
+
+		while (!out->queued && !out->shutdown) {
+			pthread_mutex_unlock(&out->mutex);
+			os_event_wait(out->data_available_event);
+			pthread_mutex_lock(&out->mutex);
+		}
+
+		if (!out->queued) {
+			pthread_mutex_unlock(&out->mutex);
+			break;
+		}
+
+		size_t idx = out->head;
+		size_t used = out->chunk_used[idx];
+		pthread_mutex_unlock(&out->mutex);
+
+		/* the chunk is owned by this thread until it's released */
+		if (!write_chunk(out, chunk_data(out, idx), used)) {
+			blog(LOG_ERROR, "Error writing to '%s': %s", out->filename.array, strerror(errno));
+			os_atomic_set_bool(&out->output_error, true);
+			os_event_signal(out->space_available_event);
+			break;
+		}
+
+		out->chunks_written++;
+
+		pthread_mutex_lock(&out->mutex);
+		out->head = (out->head + 1) % out->num_chunks;
+		out->queued--;
+		pthread_mutex_unlock(&out->mutex);
+
+		os_event_signal(out->space_available_event);
+	}
+
+	return NULL;
+}
+
+/* ========================================================================== */
+/* Serializer Implementation                                                  */
+
+/* Hands the chunk being filled to the I/O thread, must hold the mutex */
+static inline void queue_fill_chunk(struct chunked_file_output *out)
+{
+	size_t idx = (out->head + out->queued) % out->num_chunks;
+
+	out->chunk_used[idx] = out->fill;
+	out->queued++;
+	out->fill = 0;
+
+	if (out->queued > out->max_queued)
+		out->max_queued = out->queued;
+
+	os_event_signal(out->data_available_event);
+}
+
+static size_t file_output_write(void *opaque, const void *buf, size_t buf_size)
+{
+	struct chunked_file_output *out = opaque;
+	const uint8_t *data = buf;
+	size_t remaining = buf_size;
+
+	while (remaining) {
+		if (os_atomic_load_bool(&out->output_error))
+			return buf_size - remaining;
+
+		pthread_mutex_lock(&out->mutex);
+
+		if (out->queued == out->num_chunks) {
+			/* every chunk is waiting to be written */
+			out->writer_waits++;
+			pthread_mutex_unlock(&out->mutex);
+			os_event_wait(out->space_available_event);
+			continue;
+		}
+
+		size_t idx = (out->head + out->queued) % out->num_chunks;
+		pthread_mutex_unlock(&out->mutex);
+
+		/* the chunk being filled is never touched by the I/O thread */
+		size_t size = out->chunk_size - out->fill;
+		if (size > remaining)
+			size = remaining;
+
+		memcpy(chunk_data(out, idx) + out->fill, data, size);
+		out->fill += size;
+		out->pos += size;
+		data += size;
+		remaining -= size;
+
+		if (out->fill == out->chunk_size) {
+			pthread_mutex_lock(&out->mutex);
+			queue_fill_chunk(out);
+			pthread_mutex_unlock(&out->mutex);
+		}
+	}
+
+	return buf_size;
+}
+
+static int64_t file_output_seek(void *opaque, int64_t offset, enum serialize_seek_type seek_type)
+{
+	struct chunked_file_output *out = opaque;
+	int64_t target = (int64_t)out->pos;
+
+	if (os_atomic_load_bool(&out->output_error))
+		return -1;
+
+	switch (seek_type) {
+	case SERIALIZE_SEEK_START:
+		target = offset;
+		break;
+	case SERIALIZE_SEEK_CURRENT:
+		target += offset;
+		break;
+	case SERIALIZE_SEEK_END:
+		target -= offset;
+		break;
+	}
+
+	if (target != (int64_t)out->pos) {
+		blog(LOG_ERROR, "Seeking is not supported when writing '%s'", out->filename.array);
+		return -1;
+	}
+
+	return target;
+}
+
+static int64_t file_output_get_pos(void *opaque)
+{
+	struct chunked_file_output *out = opaque;
+
+	if (os_atomic_load_bool(&out->output_error))
+		return -1;
+
+	return (int64_t)out->pos;
+}
+
+static bool open_output_file(struct chunked_file_output *out, const char *path)
+{
+#ifdef _WIN32
+	out->file = os_fopen(path, "wb");
+	return !!out->file;
+#else
+	out->fd = -1;
+
+#ifdef O_DIRECT
+	out->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+	out->direct = out->fd != -1;
+#endif
+	if (out->fd == -1)
+		out->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+#ifdef F_NOCACHE
+	if (out->fd != -1)
+		fcntl(out->fd, F_NOCACHE, 1);
+#endif
+
+	return out->fd != -1;
+#endif
+}
+
+static void close_output_file(struct chunked_file_output *out)
+{
+#ifdef _WIN32
+	fclose(out->file);
+#else
+	close(out->fd);
+#endif
+}
+
+bool chunked_file_serializer_init(struct serializer *s, const char *path, size_t buffer_size, size_t chunk_size)
+{
+	struct chunked_file_output *out = bzalloc(sizeof(*out));
+
+	dstr_init_copy(&out->filename, path);
+
+	if (!buffer_size)
+		buffer_size = DEFAULT_BUF_SIZE;
+	if (!chunk_size)
+		chunk_size = DEFAULT_CHUNK_SIZE;
+
+	out->chunk_size = (chunk_size + CHUNK_ALIGNMENT - 1) & ~(size_t)(CHUNK_ALIGNMENT - 1);
+	out->num_chunks = buffer_size / out->chunk_size;
+	if (out->num_chunks < 2)
+		out->num_chunks = 2;
+
+	out->memory = aligned_alloc_chunks(out->num_chunks * out->chunk_size);
+	if (!out->memory)
+		goto fail;
+
+	if (!open_output_file(out, path))
+		goto fail;
+
+	out->chunk_used = bzalloc(out->num_chunks * sizeof(size_t));
+
+	pthread_mutex_init(&out->mutex, NULL);
+	os_event_init(&out->space_available_event, OS_EVENT_TYPE_AUTO);
+	os_event_init(&out->data_available_event, OS_EVENT_TYPE_AUTO);
+
+	pthread_create(&out->io_thread, NULL, io_thread, out);
+
+	s->data = out;
+	s->read = NULL;
+	s->write = file_output_write;
+	s->seek = file_output_seek;
+	s->get_pos = file_output_get_pos;
+	return true;
+
+fail:
+	aligned_free_chunks(out->memory);
+	dstr_free(&out->filename);
+	bfree(out);
+	return false;
+}
+
+void chunked_file_serializer_free(struct serializer *s)
+{
+	struct chunked_file_output *out = s->data;
+
+	if (!out)
+		return;
+
+	/* Queue whatever is left and wait for the I/O thread to finish */
+	pthread_mutex_lock(&out->mutex);
+	/* a partially filled chunk always has a free slot */
+	if (out->fill && !os_atomic_load_bool(&out->output_error))
+		queue_fill_chunk(out);
+	out->shutdown = true;
+	pthread_mutex_unlock(&out->mutex);
+
+	os_event_signal(out->data_available_event);
+	pthread_join(out->io_thread, NULL);
+
+	blog(LOG_DEBUG,
+	     "Chunked writer: %" PRIu64 " chunks of %zu KiB written, "
+	     "max %zu/%zu queued, writer waited %" PRIu64 " times",
+	     out->chunks_written, out->chunk_size / 1024, out->max_queued, out->num_chunks, out->writer_waits);
+
+	close_output_file(out);
+
+	os_event_destroy(out->data_available_event);
+	os_event_destroy(out->space_available_event);
+	pthread_mutex_destroy(&out->mutex);
+
+	aligned_free_chunks(out->memory);
+	bfree(out->chunk_used);
+	dstr_free(&out->filename);
+	bfree(out);
+
+	s->data = NULL;
+}
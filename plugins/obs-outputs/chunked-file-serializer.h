@@ -0,0 +1,35 @@
+/******************************************************************************
+    Copyright (C) 2026 by agent <agent@local>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include <util/serializer.h>
+
+/*
+ * Append-only file serializer for streaming (fragmented) output.
+ *
+ * Data is copied into a fixed set of preallocated, page aligned chunks that
+ * a dedicated I/O thread writes out in order, so memory use never grows and
+ * a slow disk only blocks the writer once all chunks are in flight. Where
+ * the platform supports it, full chunks are written with O_DIRECT to keep
+ * long recordings from filling the page cache.
+ *
+ * Seeking is only supported to the current position.
+ */
+
+bool chunked_file_serializer_init(struct serializer *s, const char *path, size_t buffer_size, size_t chunk_size);
+void chunked_file_serializer_free(struct serializer *s);
@@ -303,125 +303,136 @@ void flv_meta_data(obs_output_t *context, uint8_t **output, size_t *size, bool w
 
 #ifdef DEBUG_TIMESTAMPS
 static int32_t last_time = 0;
-#endif
 
-static void flv_video(struct serializer *s, int32_t dts_offset, struct encoder_packet *packet, bool is_header)
+static void debug_timestamp(const char *type, int32_t time_ms)
 {
-	int32_t ct_offset_ms = get_ms_time(packet, packet->pts) - get_ms_time(packet, packet->dts);
-	int32_t time_ms = get_ms_time(packet, packet->dts) - dts_offset;
-
-	if (!packet->data || !packet->size)
-		return;
-
-	s_w8(s, RTMP_PACKET_TYPE_VIDEO);
-
-#ifdef DEBUG_TIMESTAMPS
-	blog(LOG_DEBUG, "Video: %lu", time_ms);
+	blog(LOG_DEBUG, "%s: %lu", type, time_ms);
 
 	if (last_time > time_ms)
 		blog(LOG_DEBUG, "Non-monotonic");
 
 	last_time = time_ms;
+}
 #endif
 
-	s_wb24(s, (uint32_t)packet->size + 5);
-	s_wb24(s, (uint32_t)time_ms);
-	s_w8(s, (time_ms >> 24) & 0x7F);
+/* Serializes into the fixed prefix buffer of a tag header, so the same code
+ * describes a tag whether it is muxed into one buffer or sent as separate
+ * header and payload pieces. */
+static size_t tag_header_write(void *param, const void *data, size_t size)
+{
+	struct flv_tag_header *header = param;
+
+	if (header->prefix_size + size > sizeof(header->prefix)) {
+		assert(0 && "FLV tag prefix too large");
+		return 0;
+	}
+
+	memcpy(header->prefix + header->prefix_size, data, size);
+	header->prefix_size += size;
+	return size;
+}
+
+static void tag_header_init(struct flv_tag_header *header, struct serializer *s, uint8_t type, int32_t time_ms)
+{
+	memset(s, 0, sizeof(*s));
+	s->data = header;
+	s->write = tag_header_write;
+
+	header->type = type;
+	header->time_ms = time_ms;
+	header->prefix_size = 0;
+}
+
+static void flv_write_tag(struct serializer *s, const struct flv_tag_header *header, struct encoder_packet *packet)
+{
+	s_w8(s, header->type);
+	s_wb24(s, (uint32_t)(packet->size + header->prefix_size));
+	s_wtimestamp(s, header->time_ms);
 	s_wb24(s, 0);
 
-	/* these are the 5 extra bytes mentioned above */
-	s_w8(s, packet->keyframe ? 0x17 : 0x27);
-	s_w8(s, is_header ? 0 : 1);
-	s_wb24(s, ct_offset_ms);
+	s_write(s, header->prefix, header->prefix_size);
 	s_write(s, packet->data, packet->size);
 
 	write_previous_tag_size(s);
 }
 
-static void flv_audio(struct serializer *s, int32_t dts_offset, struct encoder_packet *packet, bool is_header)
+static void flv_video_header(struct flv_tag_header *header, int32_t dts_offset, struct encoder_packet *packet,
+			     bool is_header)
 {
+	int32_t ct_offset_ms = get_ms_time(packet, packet->pts) - get_ms_time(packet, packet->dts);
 	int32_t time_ms = get_ms_time(packet, packet->dts) - dts_offset;
+	struct serializer s;
 
-	if (!packet->data || !packet->size)
-		return;
-
-	s_w8(s, RTMP_PACKET_TYPE_AUDIO);
+	tag_header_init(header, &s, RTMP_PACKET_TYPE_VIDEO, time_ms);
 
 #ifdef DEBUG_TIMESTAMPS
-	blog(LOG_DEBUG, "Audio: %lu", time_ms);
+	debug_timestamp("Video", time_ms);
+#endif
 
-	if (last_time > time_ms)
-		blog(LOG_DEBUG, "Non-monotonic");
+	s_w8(&s, packet->keyframe ? 0x17 : 0x27);
+	s_w8(&s, is_header ? 0 : 1);
+	s_wb24(&s, ct_offset_ms);
+}
 
-	last_time = time_ms;
+static void flv_audio_header(struct flv_tag_header *header, int32_t dts_offset, struct encoder_packet *packet,
+			     bool is_header)
+{
+	int32_t time_ms = get_ms_time(packet, packet->dts) - dts_offset;
+	struct serializer s;
+
+	tag_header_init(header, &s, RTMP_PACKET_TYPE_AUDIO, time_ms);
+
+#ifdef DEBUG_TIMESTAMPS
+	debug_timestamp("Audio", time_ms);
 #endif
 
-	s_wb24(s, (uint32_t)packet->size + 2);
-	s_wb24(s, (uint32_t)time_ms);
-	s_w8(s, (time_ms >> 24) & 0x7F);
-	s_wb24(s, 0);
+	s_w8(&s, 0xaf);
+	s_w8(&s, is_header ? 0 : 1);
+}
 
-	/* these are the two extra bytes mentioned above */
-	s_w8(s, 0xaf);
-	s_w8(s, is_header ? 0 : 1);
-	s_write(s, packet->data, packet->size);
+bool flv_packet_mux_header(struct encoder_packet *packet, int32_t dts_offset, struct flv_tag_header *header,
+			   bool is_header)
+{
+	if (!packet->data || !packet->size)
+		return false;
 
-	write_previous_tag_size(s);
+	if (packet->type == OBS_ENCODER_VIDEO)
+		flv_video_header(header, dts_offset, packet, is_header);
+	else
+		flv_audio_header(header, dts_offset, packet, is_header);
+	return true;
 }
 
 void flv_packet_mux(struct encoder_packet *packet, int32_t dts_offset, uint8_t **output, size_t *size, bool is_header)
 {
 	struct array_output_data data;
 	struct serializer s;
+	struct flv_tag_header header;
 
 	array_output_serializer_init(&s, &data);
 
-	if (packet->type == OBS_ENCODER_VIDEO)
-		flv_video(&s, dts_offset, packet, is_header);
-	else
-		flv_audio(&s, dts_offset, packet, is_header);
+	if (flv_packet_mux_header(packet, dts_offset, &header, is_header))
+		flv_write_tag(&s, &header, packet);
 
 	*output = data.bytes.array;
 	*size = data.bytes.num;
 }
 
-void flv_packet_audio_ex(struct encoder_packet *packet, enum audio_id_t codec_id, int32_t dts_offset, uint8_t **output,
-			 size_t *size, int type, size_t idx)
+static void flv_audio_ex_header(struct encoder_packet *packet, enum audio_id_t codec_id, int32_t dts_offset,
+				struct flv_tag_header *header, int type, size_t idx)
 {
-	struct array_output_data data;
-	struct serializer s;
-
-	array_output_serializer_init(&s, &data);
-
-	assert(packet->type == OBS_ENCODER_AUDIO);
-
 	int32_t time_ms = get_ms_time(packet, packet->dts) - dts_offset;
-
 	bool is_multitrack = idx > 0;
+	struct serializer s;
 
-	if (!packet->data || !packet->size)
-		return;
-
-	int header_metadata_size = 5; // w8+wa4cc
-	if (is_multitrack)
-		header_metadata_size += 2; // w8 + w8
+	assert(packet->type == OBS_ENCODER_AUDIO);
 
-	s_w8(&s, RTMP_PACKET_TYPE_AUDIO);
+	tag_header_init(header, &s, RTMP_PACKET_TYPE_AUDIO, time_ms);
 
 #ifdef DEBUG_TIMESTAMPS
-	blog(LOG_DEBUG, "Audio: %lu", time_ms);
-
-	if (last_time > time_ms)
-		blog(LOG_DEBUG, "Non-monotonic");
-
-	last_time = time_ms;
+	debug_timestamp("Audio", time_ms);
 #endif
 
-	s_wb24(&s, (uint32_t)packet->size + header_metadata_size);
-	s_wb24(&s, (uint32_t)time_ms);
-	s_w8(&s, (time_ms >> 24) & 0x7F);
-	s_wb24(&s, 0);
-
 	s_w8(&s, AUDIO_HEADER_EX | (is_multitrack ? AUDIO_PACKETTYPE_MULTITRACK : type));
 	if (is_multitrack) {
 		s_w8(&s, MULTITRACKTYPE_ONE_TRACK | type);
@@ -430,42 +441,38 @@ void flv_packet_audio_ex(struct encoder_packet *packet, enum audio_id_t codec_id
 	} else {
 		s_wa4cc(&s, codec_id);
 	}
+}
 
-	s_write(&s, packet->data, packet->size);
+void flv_packet_audio_ex(struct encoder_packet *packet, enum audio_id_t codec_id, int32_t dts_offset, uint8_t **output,
+			 size_t *size, int type, size_t idx)
+{
+	struct array_output_data data;
+	struct serializer s;
+	struct flv_tag_header header;
 
-	write_previous_tag_size(&s);
+	if (!packet->data || !packet->size)
+		return;
+
+	array_output_serializer_init(&s, &data);
+
+	flv_audio_ex_header(packet, codec_id, dts_offset, &header, type, idx);
+	flv_write_tag(&s, &header, packet);
 
 	*output = data.bytes.array;
 	*size = data.bytes.num;
 }
 
 // Y2023 spec
-void flv_packet_ex(struct encoder_packet *packet, enum video_id_t codec_id, int32_t dts_offset, uint8_t **output,
-		   size_t *size, int type, size_t idx)
+static void flv_video_ex_header(struct encoder_packet *packet, enum video_id_t codec_id, int32_t dts_offset,
+				struct flv_tag_header *header, int type, size_t idx)
 {
-	struct array_output_data data;
-	struct serializer s;
-	array_output_serializer_init(&s, &data);
-
-	assert(packet->type == OBS_ENCODER_VIDEO);
-
 	int32_t time_ms = get_ms_time(packet, packet->dts) - dts_offset;
-
 	bool is_multitrack = idx > 0;
+	struct serializer s;
 
-	// packet head
-	int header_metadata_size = 5; // w8+w4cc
-	// 3 extra bytes for composition time offset
-	if ((codec_id == CODEC_H264 || codec_id == CODEC_HEVC) && type == PACKETTYPE_FRAMES) {
-		header_metadata_size += 3; // w24
-	}
-	if (is_multitrack)
-		header_metadata_size += 2; // w8+w8
+	assert(packet->type == OBS_ENCODER_VIDEO);
 
-	s_w8(&s, RTMP_PACKET_TYPE_VIDEO);
-	s_wb24(&s, (uint32_t)packet->size + header_metadata_size);
-	s_wtimestamp(&s, time_ms);
-	s_wb24(&s, 0); // always 0
+	tag_header_init(header, &s, RTMP_PACKET_TYPE_VIDEO, time_ms);
 
 	uint8_t frame_type = packet->keyframe ? FT_KEY : FT_INTER;
 
@@ -489,12 +496,19 @@ void flv_packet_ex(struct encoder_packet *packet, enum video_id_t codec_id, int3
 		int32_t ct_offset_ms = get_ms_time(packet, packet->pts) - get_ms_time(packet, packet->dts);
 		s_wb24(&s, ct_offset_ms);
 	}
+}
 
-	// packet data
-	s_write(&s, packet->data, packet->size);
+void flv_packet_ex(struct encoder_packet *packet, enum video_id_t codec_id, int32_t dts_offset, uint8_t **output,
+		   size_t *size, int type, size_t idx)
+{
+	struct array_output_data data;
+	struct serializer s;
+	struct flv_tag_header header;
 
-	// packet tail
-	write_previous_tag_size(&s);
+	array_output_serializer_init(&s, &data);
+
+	flv_video_ex_header(packet, codec_id, dts_offset, &header, type, idx);
+	flv_write_tag(&s, &header, packet);
 
 	*output = data.bytes.array;
 	*size = data.bytes.num;
@@ -505,15 +519,25 @@ void flv_packet_start(struct encoder_packet *packet, enum video_id_t codec, uint
 	flv_packet_ex(packet, codec, 0, output, size, PACKETTYPE_SEQ_START, idx);
 }
 
-void flv_packet_frames(struct encoder_packet *packet, enum video_id_t codec, int32_t dts_offset, uint8_t **output,
-		       size_t *size, size_t idx)
+static inline int get_frames_packet_type(struct encoder_packet *packet, enum video_id_t codec)
 {
-	int packet_type = PACKETTYPE_FRAMES;
 	// PACKETTYPE_FRAMESX is an optimization to avoid sending composition
 	// time offsets of 0. See Enhanced RTMP spec.
 	if ((codec == CODEC_H264 || codec == CODEC_HEVC) && packet->dts == packet->pts)
-		packet_type = PACKETTYPE_FRAMESX;
-	flv_packet_ex(packet, codec, dts_offset, output, size, packet_type, idx);
+		return PACKETTYPE_FRAMESX;
+	return PACKETTYPE_FRAMES;
+}
+
+void flv_packet_frames(struct encoder_packet *packet, enum video_id_t codec, int32_t dts_offset, uint8_t **output,
+		       size_t *size, size_t idx)
+{
+	flv_packet_ex(packet, codec, dts_offset, output, size, get_frames_packet_type(packet, codec), idx);
+}
+
+void flv_packet_frames_header(struct encoder_packet *packet, enum video_id_t codec, int32_t dts_offset,
+			      struct flv_tag_header *header, size_t idx)
+{
+	flv_video_ex_header(packet, codec, dts_offset, header, get_frames_packet_type(packet, codec), idx);
 }
 
 void flv_packet_end(struct encoder_packet *packet, enum video_id_t codec, uint8_t **output, size_t *size, size_t idx)
@@ -533,6 +557,16 @@ void flv_packet_audio_frames(struct encoder_packet *packet, enum audio_id_t code
 	flv_packet_audio_ex(packet, codec, dts_offset, output, size, AUDIO_PACKETTYPE_FRAMES, idx);
 }
 
+bool flv_packet_audio_frames_header(struct encoder_packet *packet, enum audio_id_t codec, int32_t dts_offset,
+				    struct flv_tag_header *header, size_t idx)
+{
+	if (!packet->data || !packet->size)
+		return false;
+
+	flv_audio_ex_header(packet, codec, dts_offset, header, AUDIO_PACKETTYPE_FRAMES, idx);
+	return true;
+}
+
 void flv_packet_metadata(enum video_id_t codec_id, uint8_t **output, size_t *size, int bits_per_raw_sample,
 			 uint8_t color_primaries, int color_trc, int color_space, int min_luminance, int max_luminance,
 			 size_t idx)
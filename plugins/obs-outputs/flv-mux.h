@@ -58,6 +58,27 @@ static int32_t get_ms_time(struct encoder_packet *packet, int64_t val)
 	return (int32_t)(val * MILLISECOND_DEN / packet->timebase_den);
 }
 
+/* Everything of an FLV audio/video tag except the encoded payload: the tag
+ * type, its timestamp, and the codec specific bytes that precede the payload
+ * in the tag body.  Lets the payload be sent straight from the encoder packet
+ * instead of being copied into a muxed buffer first. */
+#define FLV_TAG_HEADER_SIZE 11
+#define FLV_MAX_TAG_PREFIX_SIZE 16
+
+struct flv_tag_header {
+	uint8_t type;
+	int32_t time_ms;
+	uint8_t prefix[FLV_MAX_TAG_PREFIX_SIZE];
+	size_t prefix_size;
+};
+
+/* size of the tag as flv_packet_mux & co would have written it, including
+ * the trailing previous tag size */
+static inline size_t flv_tag_size(const struct flv_tag_header *header, const struct encoder_packet *packet)
+{
+	return FLV_TAG_HEADER_SIZE + header->prefix_size + packet->size + 4;
+}
+
 extern void write_file_info(FILE *file, int64_t duration_ms, int64_t size);
 
 extern void flv_meta_data(obs_output_t *context, uint8_t **output, size_t *size, bool write_header);
@@ -77,3 +98,12 @@ extern void flv_packet_audio_start(struct encoder_packet *packet, enum audio_id_
 				   size_t idx);
 extern void flv_packet_audio_frames(struct encoder_packet *packet, enum audio_id_t codec, int32_t dts_offset,
 				    uint8_t **output, size_t *size, size_t idx);
+
+/* tag header counterparts of flv_packet_mux, flv_packet_frames and
+ * flv_packet_audio_frames, false if there is nothing to send */
+extern bool flv_packet_mux_header(struct encoder_packet *packet, int32_t dts_offset, struct flv_tag_header *header,
+				  bool is_header);
+extern void flv_packet_frames_header(struct encoder_packet *packet, enum video_id_t codec, int32_t dts_offset,
+				     struct flv_tag_header *header, size_t idx);
+extern bool flv_packet_audio_frames_header(struct encoder_packet *packet, enum audio_id_t codec, int32_t dts_offset,
+					   struct flv_tag_header *header, size_t idx);
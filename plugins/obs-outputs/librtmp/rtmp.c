@@ -1576,11 +1576,29 @@ ReadN(RTMP *r, char *buffer, int n)
     return nOriginalSize - n;
 }
 
+static void
+AbortAfterSendError(RTMP *r, int sockerr)
+{
+    struct linger l;
+
+    r->last_error_code = sockerr;
+
+    // Force-close the socket. Sometimes a send() error isn't fatal, so
+    // we could end up writing an unpublish message which some services
+    // treat as a clean shutdown. We need to disable lingering too so
+    // the remote side sees an abortive shutdown (RST).
+    l.l_onoff = 1;
+    l.l_linger = 0;
+    setsockopt(r->m_sb.sb_socket, SOL_SOCKET, SO_LINGER, (char *)&l, sizeof(l));
+    RTMPSockBuf_Close(&r->m_sb);
+
+    RTMP_Close(r);
+}
+
 static int
 WriteN(RTMP *r, const char *buffer, int n)
 {
     const char *ptr = buffer;
-    struct linger l;
 
     while (n > 0)
     {
@@ -1603,18 +1621,7 @@ WriteN(RTMP *r, const char *buffer, int n)
             if (sockerr == EINTR && !RTMP_ctrlC)
                 continue;
 
-            r->last_error_code = sockerr;
-
-            // Force-close the socket. Sometimes a send() error isn't fatal, so
-            // we could end up writing an unpublish message which some services
-            // treat as a clean shutdown. We need to disable lingering too so
-            // the remote side sees an abortive shutdown (RST).
-            l.l_onoff = 1;
-            l.l_linger = 0;
-            setsockopt(r->m_sb.sb_socket, SOL_SOCKET, SO_LINGER, (char *)&l, sizeof(l));
-            RTMPSockBuf_Close(&r->m_sb);
-
-            RTMP_Close(r);
+            AbortAfterSendError(r, sockerr);
             n = 1;
             break;
         }
@@ -4085,22 +4092,12 @@ RTMP_SendChunk(RTMP *r, RTMPChunk *chunk)
     return wrote;
 }
 
-int
-RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
+static int
+AllocChannelsOut(RTMP *r, int nChannel)
 {
-    const RTMPPacket *prevPacket;
-    uint32_t last = 0;
-    int nSize;
-    int hSize, cSize;
-    char *header, *hptr, *hend, hbuf[RTMP_MAX_HEADER_SIZE], c;
-    uint32_t t;
-    char *buffer, *tbuf = NULL, *toff = NULL;
-    int nChunkSize;
-    int tlen;
-
-    if (packet->m_nChannel >= r->m_channelsAllocatedOut)
+    if (nChannel >= r->m_channelsAllocatedOut)
     {
-        int n = packet->m_nChannel + 10;
+        int n = nChannel + 10;
         RTMPPacket **packets = realloc(r->m_vecChannelsOut, sizeof(RTMPPacket*) * n);
         if (!packets)
         {
@@ -4113,6 +4110,16 @@ RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
         memset(r->m_vecChannelsOut + r->m_channelsAllocatedOut, 0, sizeof(RTMPPacket*) * (n - r->m_channelsAllocatedOut));
         r->m_channelsAllocatedOut = n;
     }
+    return TRUE;
+}
+
+/* picks the smallest header type the previous packet on the channel allows,
+ * returns the timestamp the new one is relative to */
+static uint32_t
+CompressPacketHeader(RTMP *r, RTMPPacket *packet)
+{
+    const RTMPPacket *prevPacket;
+    uint32_t last = 0;
 
     prevPacket = r->m_vecChannelsOut[packet->m_nChannel];
     if (prevPacket && packet->m_headerType != RTMP_PACKET_SIZE_LARGE)
@@ -4138,6 +4145,34 @@ RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
         last = prevPacket->m_nTimeStamp;
     }
 
+    return last;
+}
+
+static void
+StoreSentPacket(RTMP *r, const RTMPPacket *packet)
+{
+    if (!r->m_vecChannelsOut[packet->m_nChannel])
+        r->m_vecChannelsOut[packet->m_nChannel] = malloc(sizeof(RTMPPacket));
+    memcpy(r->m_vecChannelsOut[packet->m_nChannel], packet, sizeof(RTMPPacket));
+}
+
+int
+RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
+{
+    uint32_t last = 0;
+    int nSize;
+    int hSize, cSize;
+    char *header, *hptr, *hend, hbuf[RTMP_MAX_HEADER_SIZE], c;
+    uint32_t t;
+    char *buffer, *tbuf = NULL, *toff = NULL;
+    int nChunkSize;
+    int tlen;
+
+    if (!AllocChannelsOut(r, packet->m_nChannel))
+        return FALSE;
+
+    last = CompressPacketHeader(r, packet);
+
     if (packet->m_headerType > 3)	/* sanity */
     {
         RTMP_Log(RTMP_LOGERROR, "sanity failed!! trying to send header of type: 0x%02x.",
@@ -4314,12 +4349,277 @@ RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
         }
     }
 
-    if (!r->m_vecChannelsOut[packet->m_nChannel])
-        r->m_vecChannelsOut[packet->m_nChannel] = malloc(sizeof(RTMPPacket));
-    memcpy(r->m_vecChannelsOut[packet->m_nChannel], packet, sizeof(RTMPPacket));
+    StoreSentPacket(r, packet);
+    return TRUE;
+}
+
+#ifndef _WIN32
+#include <sys/uio.h>
+
+#define RTMP_MAX_IOV 64
+
+typedef struct RTMPVecWriter
+{
+    RTMP *r;
+    struct iovec iov[RTMP_MAX_IOV];
+    int niov;
+} RTMPVecWriter;
+
+static int
+VecFlush(RTMPVecWriter *w)
+{
+    struct iovec *iov = w->iov;
+    int niov = w->niov;
+
+    w->niov = 0;
+
+    while (niov > 0)
+    {
+        struct msghdr msg = {0};
+        ssize_t nBytes;
+
+        msg.msg_iov = iov;
+        msg.msg_iovlen = niov;
+
+        nBytes = sendmsg(w->r->m_sb.sb_socket, &msg, MSG_NOSIGNAL);
+        if (nBytes < 0)
+        {
+            int sockerr = GetSockError();
+            RTMP_Log(RTMP_LOGERROR, "%s, RTMP send error %d", __FUNCTION__, sockerr);
+
+            if (sockerr == EINTR && !RTMP_ctrlC)
+                continue;
+
+            AbortAfterSendError(w->r, sockerr);
+            return FALSE;
+        }
+
+        /* partial writes leave off in the middle of a buffer */
+        while (niov > 0 && (size_t)nBytes >= iov->iov_len)
+        {
+            nBytes -= iov->iov_len;
+            iov++;
+            niov--;
+        }
+        if (niov > 0)
+        {
+            iov->iov_base = (char *)iov->iov_base + nBytes;
+            iov->iov_len -= nBytes;
+        }
+    }
+
+    return TRUE;
+}
+
+static int
+VecAdd(RTMPVecWriter *w, const char *data, int len)
+{
+    if (w->niov == RTMP_MAX_IOV && !VecFlush(w))
+        return FALSE;
+
+    w->iov[w->niov].iov_base = (void *)data;
+    w->iov[w->niov].iov_len = len;
+    w->niov++;
+    return TRUE;
+}
+
+/* Same wire format as RTMP_SendPacket, but the chunk headers are built in
+ * small separate buffers and the body is referenced where it already is. */
+static int
+SendPacketVec(RTMP *r, RTMPPacket *packet, const AVal *body, int count)
+{
+    RTMPVecWriter w = {r};
+    char hbuf[RTMP_MAX_HEADER_SIZE], cbuf[RTMP_MAX_HEADER_SIZE];
+    char *hptr, *hend = hbuf + sizeof(hbuf);
+    int nSize, hSize, cSize = 0, contSize;
+    int nChunkSize = r->m_outChunkSize;
+    int nLeft, seg = 0, segOffset = 0;
+    uint32_t last, t;
+    char c;
+
+    if (!AllocChannelsOut(r, packet->m_nChannel))
+        return FALSE;
+
+    last = CompressPacketHeader(r, packet);
+
+    if (packet->m_headerType > 3)	/* sanity */
+    {
+        RTMP_Log(RTMP_LOGERROR, "sanity failed!! trying to send header of type: 0x%02x.",
+                 (unsigned char)packet->m_headerType);
+        return FALSE;
+    }
+
+    nSize = packetSize[packet->m_headerType];
+    t = packet->m_nTimeStamp - last;
+    packet->m_nLastWireTimeStamp = t;
+
+    if (packet->m_nChannel > 319)
+        cSize = 2;
+    else if (packet->m_nChannel > 63)
+        cSize = 1;
+
+    hptr = hbuf;
+    c = packet->m_headerType << 6;
+    switch (cSize)
+    {
+    case 0:
+        c |= packet->m_nChannel;
+        break;
+    case 1:
+        break;
+    case 2:
+        c |= 1;
+        break;
+    }
+    *hptr++ = c;
+    if (cSize)
+    {
+        int tmp = packet->m_nChannel - 64;
+        *hptr++ = tmp & 0xff;
+        if (cSize == 2)
+            *hptr++ = tmp >> 8;
+    }
+
+    if (nSize > 1)
+        hptr = AMF_EncodeInt24(hptr, hend, t > 0xffffff ? 0xffffff : t);
+
+    if (nSize > 4)
+    {
+        hptr = AMF_EncodeInt24(hptr, hend, packet->m_nBodySize);
+        *hptr++ = packet->m_packetType;
+    }
+
+    if (nSize > 8)
+        hptr += EncodeInt32LE(hptr, packet->m_nInfoField2);
+
+    if (nSize > 1 && t >= 0xffffff)
+        hptr = AMF_EncodeInt32(hptr, hend, t);
+
+    hSize = (int)(hptr - hbuf);
+
+    /* every following chunk of the message starts with the same type 3
+     * header */
+    contSize = 1 + cSize;
+    cbuf[0] = 0xc0 | c;
+    if (cSize)
+    {
+        int tmp = packet->m_nChannel - 64;
+        cbuf[1] = tmp & 0xff;
+        if (cSize == 2)
+            cbuf[2] = tmp >> 8;
+    }
+    if (t >= 0xffffff)
+    {
+        AMF_EncodeInt32(cbuf + contSize, cbuf + sizeof(cbuf), t);
+        contSize += 4;
+    }
+
+    RTMP_Log(RTMP_LOGDEBUG2, "%s: fd=%d, size=%d", __FUNCTION__, (int)r->m_sb.sb_socket,
+             packet->m_nBodySize);
+
+    if (!VecAdd(&w, hbuf, hSize))
+        return FALSE;
+
+    nLeft = packet->m_nBodySize;
+    while (nLeft > 0)
+    {
+        int nChunk = nLeft < nChunkSize ? nLeft : nChunkSize;
+
+        nLeft -= nChunk;
+
+        while (nChunk > 0)
+        {
+            int len = body[seg].av_len - segOffset;
+
+            if (len > nChunk)
+                len = nChunk;
+            if (len > 0 && !VecAdd(&w, body[seg].av_val + segOffset, len))
+                return FALSE;
+
+            nChunk -= len;
+            segOffset += len;
+            if (segOffset == body[seg].av_len && seg + 1 < count)
+            {
+                seg++;
+                segOffset = 0;
+            }
+        }
+
+        if (nLeft > 0 && !VecAdd(&w, cbuf, contSize))
+            return FALSE;
+    }
+
+    if (!VecFlush(&w))
+        return FALSE;
+
+    StoreSentPacket(r, packet);
     return TRUE;
 }
 
+/* plain TCP without a custom send function, where the body can be handed to
+ * the socket piecewise */
+static int
+CanSendVec(RTMP *r)
+{
+    if (r->Link.protocol & RTMP_FEATURE_HTTP)
+        return FALSE;
+    if (r->m_bCustomSend && r->m_customSendFunc)
+        return FALSE;
+#if defined(CRYPTO) && !defined(NO_SSL)
+    if (r->m_sb.sb_ssl)
+        return FALSE;
+#endif
+    return TRUE;
+}
+#endif
+
+int
+RTMP_WriteVec(RTMP *r, int packetType, uint32_t timestamp, const AVal *body, int count, int streamIdx)
+{
+    RTMPPacket packet = {0};
+    int size = 0;
+    int ret;
+
+    for (int i = 0; i < count; i++)
+        size += body[i].av_len;
+
+    packet.m_nChannel = 0x04;	/* source channel */
+    packet.m_nInfoField2 = r->Link.streams[streamIdx].id;
+    packet.m_packetType = packetType;
+    packet.m_nTimeStamp = timestamp;
+    packet.m_nBodySize = size;
+
+    if (((packetType == RTMP_PACKET_TYPE_AUDIO || packetType == RTMP_PACKET_TYPE_VIDEO) && !timestamp) ||
+            packetType == RTMP_PACKET_TYPE_INFO)
+        packet.m_headerType = RTMP_PACKET_SIZE_LARGE;
+    else
+        packet.m_headerType = RTMP_PACKET_SIZE_MEDIUM;
+
+#ifndef _WIN32
+    if (CanSendVec(r))
+        return SendPacketVec(r, &packet, body, count) ? size : -1;
+#endif
+
+    /* TLS, HTTP and custom send functions want contiguous chunks, so the
+     * body still has to be gathered once */
+    if (!RTMPPacket_Alloc(&packet, size))
+    {
+        RTMP_Log(RTMP_LOGDEBUG, "%s, failed to allocate packet", __FUNCTION__);
+        return -1;
+    }
+
+    char *enc = packet.m_body;
+    for (int i = 0; i < count; i++)
+    {
+        memcpy(enc, body[i].av_val, body[i].av_len);
+        enc += body[i].av_len;
+    }
+
+    ret = RTMP_SendPacket(r, &packet, FALSE);
+    RTMPPacket_Free(&packet);
+    return ret ? size : -1;
+}
+
 void
 RTMP_Close(RTMP *r)
 {
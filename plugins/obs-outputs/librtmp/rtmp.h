@@ -544,6 +544,12 @@ extern "C"
     int RTMP_Read(RTMP *r, char *buf, int size);
     int RTMP_Write(RTMP *r, const char *buf, int size, int streamIdx);
 
+    /* Like RTMP_Write, but takes the FLV tag type and timestamp directly and
+     * the tag body as a list of buffers, which are sent without being copied
+     * into an intermediate packet where the connection allows it. */
+    int RTMP_WriteVec(RTMP *r, int packetType, uint32_t timestamp, const AVal *body, int count,
+                      int streamIdx);
+
 #ifdef USE_HASHSWF
     /* hashswf.c */
     int RTMP_HashSWF(const char *url, unsigned int *size, unsigned char *hash,
@@ -74,6 +74,13 @@ struct fragment_sample {
 	uint32_t duration;
 };
 
+/* Random access entry for mfra (streaming mode only) */
+struct fragment_entry {
+	uint64_t time;
+	uint64_t moof_offset;
+	uint8_t traf_number;
+};
+
 struct mp4_track {
 	enum mp4_track_type type;
 	enum mp4_codec codec;
@@ -120,6 +127,9 @@ struct mp4_track {
 	/* Temporary array with information about the samples to be included
 	 * in the next fragment. */
 	DARRAY(struct fragment_sample) fragment_samples;
+
+	/* Fragments starting with a keyframe (video only, streaming mode) */
+	DARRAY(struct fragment_entry) fragments;
 };
 
 struct mp4_mux {
@@ -135,6 +145,10 @@ struct mp4_mux {
 	uint32_t fragments_written;
 	/* PTS where next fragmentation should take place */
 	int64_t next_frag_pts;
+	/* PTS where the current fragment started */
+	int64_t frag_start_pts;
+	/* Minimum fragment duration (usec) */
+	int64_t frag_duration;
 
 	/* Creation time (seconds since Jan 1 1904) */
 	uint64_t creation_time;
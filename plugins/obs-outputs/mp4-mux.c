@@ -2301,13 +2301,9 @@ static size_t mp4_write_tfhd(struct mp4_mux *mux, struct mp4_track *track, size_
 	return write_box_size(s, start);
 }
 
-/// 8.8.12 Track fragment decode time
-static size_t mp4_write_tfdt(struct mp4_mux *mux, struct mp4_track *track)
+/* Decode time of the first sample in the current fragment */
+static uint64_t get_fragment_start_time(struct mp4_track *track)
 {
-	struct serializer *s = mux->serializer;
-
-	write_fullbox(s, 20, "tfdt", 1, 0);
-
 	/* Subtract samples that are not written yet */
 	uint64_t duration_written = track->duration;
 	for (size_t i = 0; i < track->fragment_samples.num; i++)
@@ -2318,7 +2314,17 @@ static size_t mp4_write_tfdt(struct mp4_mux *mux, struct mp4_track *track)
 		duration_written = util_mul_div64(duration_written, track->timescale, track->timebase_den);
 	}
 
-	s_wb64(s, duration_written); // baseMediaDecodeTime
+	return duration_written;
+}
+
+/// 8.8.12 Track fragment decode time
+static size_t mp4_write_tfdt(struct mp4_mux *mux, struct mp4_track *track)
+{
+	struct serializer *s = mux->serializer;
+
+	write_fullbox(s, 20, "tfdt", 1, 0);
+
+	s_wb64(s, get_fragment_start_time(track)); // baseMediaDecodeTime
 
 	return 20;
 }
@@ -2434,6 +2440,63 @@ static size_t mp4_write_moof(struct mp4_mux *mux, uint32_t moof_size, int64_t mo
 	return write_box_size(s, start);
 }
 
+/// 8.8.10 Track Fragment Random Access Box
+static size_t mp4_write_tfra(struct mp4_mux *mux, struct mp4_track *track)
+{
+	struct serializer *s = mux->serializer;
+	int64_t start = serializer_get_pos(s);
+
+	write_fullbox(s, 0, "tfra", 1, 0);
+
+	s_wb32(s, track->track_id);                // track_ID
+	s_wb32(s, 0);                              // length_size_of_traf/trun/sample_num (1 byte each)
+	s_wb32(s, (uint32_t)track->fragments.num); // number_of_entry
+
+	for (size_t i = 0; i < track->fragments.num; i++) {
+		struct fragment_entry *entry = &track->fragments.array[i];
+
+		s_wb64(s, entry->time);        // time
+		s_wb64(s, entry->moof_offset); // moof_offset
+		s_w8(s, entry->traf_number);   // traf_number
+		s_w8(s, 1);                    // trun_number
+		s_w8(s, 1);                    // sample_number
+	}
+
+	return write_box_size(s, start);
+}
+
+/// 8.8.11 Movie Fragment Random Access Offset Box
+static size_t mp4_write_mfro(struct mp4_mux *mux, uint32_t mfra_size)
+{
+	struct serializer *s = mux->serializer;
+
+	write_fullbox(s, 16, "mfro", 0, 0);
+
+	s_wb32(s, mfra_size); // parent_size
+
+	return 16;
+}
+
+/// 8.8.9 Movie Fragment Random Access Box
+static size_t mp4_write_mfra(struct mp4_mux *mux)
+{
+	struct serializer *s = mux->serializer;
+	int64_t start = serializer_get_pos(s);
+
+	write_box(s, 0, "mfra");
+
+	for (size_t i = 0; i < mux->tracks.num; i++) {
+		struct mp4_track *track = &mux->tracks.array[i];
+		if (track->fragments.num)
+			mp4_write_tfra(mux, track);
+	}
+
+	/* mfro is the last box, so its size is known already */
+	mp4_write_mfro(mux, (uint32_t)(serializer_get_pos(s) - start + 16));
+
+	return write_box_size(s, start);
+}
+
 /* ========================================================================== */
 /* Chapter packets                                                            */
 
@@ -2519,7 +2582,7 @@ static void process_packets(struct mp4_mux *mux, struct mp4_track *track, uint64
 
 		/* When using negative CTS, subtract DTS-PTS offset. */
 		if (track->type == TRACK_VIDEO && mux->flags & MP4_USE_NEGATIVE_CTS) {
-			if (!track->offsets.num)
+			if (!track->samples)
 				track->dts_offset = offset;
 
 			offset -= track->dts_offset;
@@ -2547,6 +2610,11 @@ static void process_packets(struct mp4_mux *mux, struct mp4_track *track, uint64
 
 		track->samples += sample_count;
 
+		/* Sample tables are only needed for the final moov, streaming
+		 * files only carry the per-fragment information. */
+		if (mux->flags & MP4_STREAMING)
+			continue;
+
 		/* If delta (duration) matche sprevious, increment counter,
 		 * otherwise create a new entry. */
 		if (track->deltas.num == 0 || track->deltas.array[track->deltas.num - 1].delta != duration) {
@@ -2591,9 +2659,7 @@ static void write_packets(struct mp4_mux *mux, struct mp4_track *track)
 	if (!count || !track->fragment_samples.num)
 		return;
 
-	struct chunk *chk = da_push_back_new(track->chunks);
-	chk->offset = serializer_get_pos(s);
-	chk->samples = (uint32_t)track->fragment_samples.num;
+	int64_t offset = serializer_get_pos(s);
 
 	for (size_t i = 0; i < track->fragment_samples.num; i++) {
 		struct encoder_packet pkt;
@@ -2602,15 +2668,42 @@ static void write_packets(struct mp4_mux *mux, struct mp4_track *track)
 		obs_encoder_packet_release(&pkt);
 	}
 
-	chk->size = (uint32_t)(serializer_get_pos(s) - chk->offset);
+	if (!(mux->flags & MP4_STREAMING)) {
+		struct chunk *chk = da_push_back_new(track->chunks);
+		chk->offset = offset;
+		chk->size = (uint32_t)(serializer_get_pos(s) - offset);
+		chk->samples = (uint32_t)track->fragment_samples.num;
 
-	/* Fixup sample count for fixed-size codecs */
-	if (track->sample_size)
-		chk->samples = chk->size / track->sample_size;
+		/* Fixup sample count for fixed-size codecs */
+		if (track->sample_size)
+			chk->samples = chk->size / track->sample_size;
+	}
 
 	da_clear(track->fragment_samples);
 }
 
+/* Remember where video fragments start for the mfra index written at the
+ * end of streaming files. */
+static void add_fragment_entries(struct mp4_mux *mux, int64_t moof_start)
+{
+	uint8_t traf_number = 0;
+
+	for (size_t i = 0; i < mux->tracks.num; i++) {
+		struct mp4_track *track = &mux->tracks.array[i];
+		if (!track->fragment_samples.num)
+			continue;
+
+		traf_number++;
+		if (track->type != TRACK_VIDEO)
+			continue;
+
+		struct fragment_entry *entry = da_push_back_new(track->fragments);
+		entry->time = get_fragment_start_time(track);
+		entry->moof_offset = (uint64_t)moof_start;
+		entry->traf_number = traf_number;
+	}
+}
+
 static void mp4_flush_fragment(struct mp4_mux *mux)
 {
 	struct serializer *s = mux->serializer;
@@ -2619,8 +2712,10 @@ static void mp4_flush_fragment(struct mp4_mux *mux)
 	if (!mux->fragments_written) {
 		mp4_write_ftyp(mux, true);
 		/* Placeholder to write mdat header during soft-remux */
-		mux->placeholder_offset = serializer_get_pos(s);
-		mp4_write_free(mux);
+		if (!(mux->flags & MP4_STREAMING)) {
+			mux->placeholder_offset = serializer_get_pos(s);
+			mp4_write_free(mux);
+		}
 	}
 
 	// Array output as temporary buffer to avoid sending seeks to disk
@@ -2660,6 +2755,10 @@ static void mp4_flush_fragment(struct mp4_mux *mux)
 
 	// write moof once to get size
 	int64_t moof_start = serializer_get_pos(s);
+
+	if (mux->flags & MP4_STREAMING)
+		add_fragment_entries(mux, moof_start);
+
 	size_t moof_size = mp4_write_moof(mux, 0, moof_start);
 	array_output_serializer_reset(&aod);
 
@@ -2693,6 +2792,7 @@ static void mp4_flush_fragment(struct mp4_mux *mux)
 	if (!mux->next_frag_pts && mux->chapter_track)
 		write_packets(mux, mux->chapter_track);
 
+	mux->frag_start_pts = mux->next_frag_pts;
 	mux->next_frag_pts = 0;
 }
 
@@ -2829,6 +2929,7 @@ static inline void free_track(struct mp4_track *track)
 	da_free(track->offsets);
 	da_free(track->sync_samples);
 	da_free(track->fragment_samples);
+	da_free(track->fragments);
 }
 
 /* ===========================================================================*/
@@ -2920,9 +3021,13 @@ bool mp4_mux_submit_packet(struct mp4_mux *mux, struct encoder_packet *pkt)
 		else if (track->codec == CODEC_PRORES)
 			obs_encoder_packet_ref(&parsed_packet, pkt);
 
-		/* Set fragmentation PTS if packet is keyframe and PTS > 0 */
+		/* Set fragmentation PTS if packet is keyframe and PTS > 0, and
+		 * the current fragment has reached its minimum duration */
 		if (parsed_packet.keyframe && parsed_packet.pts > 0) {
-			mux->next_frag_pts = packet_pts_usec(&parsed_packet);
+			int64_t pts_usec = packet_pts_usec(&parsed_packet);
+
+			if (pts_usec - mux->frag_start_pts >= mux->frag_duration)
+				mux->next_frag_pts = pts_usec;
 		}
 	}
 
@@ -2933,7 +3038,9 @@ bool mp4_mux_submit_packet(struct mp4_mux *mux, struct encoder_packet *pkt)
 
 bool mp4_mux_add_chapter(struct mp4_mux *mux, int64_t dts_usec, const char *name)
 {
-	if (dts_usec < 0)
+	/* Chapters are written with the final moov, which streaming files
+	 * don't have. */
+	if (dts_usec < 0 || mux->flags & MP4_STREAMING)
 		return false;
 	if (!mux->chapter_track)
 		add_chapter_track(mux);
@@ -2952,6 +3059,11 @@ bool mp4_mux_add_chapter(struct mp4_mux *mux, int64_t dts_usec, const char *name
 	return true;
 }
 
+void mp4_mux_set_fragment_duration(struct mp4_mux *mux, int64_t duration_usec)
+{
+	mux->frag_duration = duration_usec;
+}
+
 bool mp4_mux_finalise(struct mp4_mux *mux)
 {
 	struct serializer *s = mux->serializer;
@@ -2966,6 +3078,20 @@ bool mp4_mux_finalise(struct mp4_mux *mux)
 
 	info("Number of fragments: %u", mux->fragments_written);
 
+	if (mux->flags & MP4_STREAMING) {
+		struct serializer fs;
+		struct array_output_data ao;
+		array_output_serializer_init(&fs, &ao);
+
+		mux->serializer = &fs;
+		mp4_write_mfra(mux);
+		s_write(s, ao.bytes.array, ao.bytes.num);
+
+		mux->serializer = s;
+		array_output_serializer_free(&ao);
+		return true;
+	}
+
 	if (mux->flags & MP4_SKIP_FINALISATION) {
 		warn("Skipping finalization!");
 		return true;
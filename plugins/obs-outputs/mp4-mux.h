@@ -38,6 +38,10 @@ enum mp4_mux_flags {
 	MP4_SKIP_FINALISATION = 1 << 2,
 	/* Use negative CTS instead of edit lists */
 	MP4_USE_NEGATIVE_CTS = 1 << 3,
+	/* Write a purely fragmented file: no sample tables are kept for a
+	 * final moov, an mfra index is written at the end instead (implies
+	 * MP4_SKIP_FINALISATION) */
+	MP4_STREAMING = 1 << 4,
 };
 
 struct mp4_mux *mp4_mux_create(obs_output_t *output, struct serializer *serializer, enum mp4_mux_flags flags,
@@ -45,4 +49,6 @@ struct mp4_mux *mp4_mux_create(obs_output_t *output, struct serializer *serializ
 void mp4_mux_destroy(struct mp4_mux *mux);
 bool mp4_mux_submit_packet(struct mp4_mux *mux, struct encoder_packet *pkt);
 bool mp4_mux_add_chapter(struct mp4_mux *mux, int64_t dts_usec, const char *name);
+/* Minimum duration of a fragment, 0 fragments on every keyframe */
+void mp4_mux_set_fragment_duration(struct mp4_mux *mux, int64_t duration_usec);
 bool mp4_mux_finalise(struct mp4_mux *mux);
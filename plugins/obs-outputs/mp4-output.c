@@ -16,6 +16,7 @@
 ******************************************************************************/
 
 #include "mp4-mux.h"
+#include "chunked-file-serializer.h"
 
 #include <inttypes.h>
 
@@ -64,6 +65,7 @@ struct mp4_output {
 	struct mp4_mux *muxer;
 	enum mp4_flavor muxer_flavor;
 	int flags;
+	int64_t fragment_duration;
 
 	size_t chapter_ctr;
 	struct deque chapters;
@@ -243,6 +245,8 @@ static void parse_custom_options(struct mp4_output *out, const char *opts_str)
 {
 	int flags = MP4_USE_NEGATIVE_CTS;
 
+	out->fragment_duration = 0;
+
 	struct obs_options opts = obs_parse_options(opts_str);
 
 	for (size_t i = 0; i < opts.count; i++) {
@@ -256,6 +260,10 @@ static void parse_custom_options(struct mp4_output *out, const char *opts_str)
 			apply_flag(&flags, opt.value, MP4_USE_MDTA_KEY_VALUE);
 		} else if (strcmp(opt.name, "use_negative_cts") == 0) {
 			apply_flag(&flags, opt.value, MP4_USE_NEGATIVE_CTS);
+		} else if (strcmp(opt.name, "fragmented") == 0) {
+			apply_flag(&flags, opt.value, MP4_STREAMING);
+		} else if (strcmp(opt.name, "fragment_duration") == 0) {
+			out->fragment_duration = strtoll(opt.value, 0, 10) * 1000LL;
 		} else if (strcmp(opt.name, "buffer_size") == 0) {
 			out->buffer_size = strtoull(opt.value, 0, 10) * 1048576ULL;
 		} else if (strcmp(opt.name, "chunk_size") == 0) {
@@ -274,6 +282,33 @@ static void parse_custom_options(struct mp4_output *out, const char *opts_str)
 
 static void generate_filename(struct mp4_output *out, struct dstr *dst, bool overwrite);
 
+/* Fragmented files are written strictly sequentially, so they can use the
+ * append-only writer with fixed, preallocated buffers. */
+static bool open_serializer(struct mp4_output *out)
+{
+	if (out->flags & MP4_STREAMING)
+		return chunked_file_serializer_init(&out->serializer, out->path.array, out->buffer_size,
+						    out->chunk_size);
+
+	return buffered_file_serializer_init(&out->serializer, out->path.array, out->buffer_size, out->chunk_size);
+}
+
+static void close_serializer(struct mp4_output *out)
+{
+	if (out->flags & MP4_STREAMING)
+		chunked_file_serializer_free(&out->serializer);
+	else
+		buffered_file_serializer_free(&out->serializer);
+}
+
+static struct mp4_mux *create_muxer(struct mp4_output *out)
+{
+	struct mp4_mux *muxer = mp4_mux_create(out->output, &out->serializer, out->flags, out->muxer_flavor);
+
+	mp4_mux_set_fragment_duration(muxer, out->fragment_duration);
+	return muxer;
+}
+
 static bool mp4_output_start(void *data)
 {
 	struct mp4_output *out = data;
@@ -313,7 +348,7 @@ static bool mp4_output_start(void *data)
 		obs_output_add_packet_callback(out->output, bpm_inject, NULL);
 	}
 
-	if (!buffered_file_serializer_init(&out->serializer, out->path.array, out->buffer_size, out->chunk_size)) {
+	if (!open_serializer(out)) {
 		warn("Unable to open file '%s'", out->path.array);
 		return false;
 	}
@@ -322,11 +357,14 @@ static bool mp4_output_start(void *data)
 	obs_output_add_packet_callback(out->output, mp4_pkt_callback, (void *)out);
 
 	/* Initialise muxer and start capture */
-	out->muxer = mp4_mux_create(out->output, &out->serializer, out->flags, out->muxer_flavor);
+	out->muxer = create_muxer(out);
 	os_atomic_set_bool(&out->active, true);
 	obs_output_begin_data_capture(out->output, 0);
 
-	info("Writing Hybrid MP4/MOV file '%s'...", out->path.array);
+	if (out->flags & MP4_STREAMING)
+		info("Writing fragmented MP4/MOV file '%s'...", out->path.array);
+	else
+		info("Writing Hybrid MP4/MOV file '%s'...", out->path.array);
 	return true;
 }
 
@@ -421,7 +459,7 @@ static bool change_file(struct mp4_output *out, struct encoder_packet *pkt)
 	info("Waiting for file writer to finish...");
 
 	/* flush/close file and destroy old muxer */
-	buffered_file_serializer_free(&out->serializer);
+	close_serializer(out);
 	mp4_mux_destroy(out->muxer);
 	mp4_clear_chapters(out);
 
@@ -431,12 +469,12 @@ static bool change_file(struct mp4_output *out, struct encoder_packet *pkt)
 	generate_filename(out, &out->path, out->allow_overwrite);
 	info("Changing output file to '%s'", out->path.array);
 
-	if (!buffered_file_serializer_init(&out->serializer, out->path.array, out->buffer_size, out->chunk_size)) {
+	if (!open_serializer(out)) {
 		warn("Unable to open file '%s'", out->path.array);
 		return false;
 	}
 
-	out->muxer = mp4_mux_create(out->output, &out->serializer, out->flags, out->muxer_flavor);
+	out->muxer = create_muxer(out);
 
 	calldata_t cd = {0};
 	signal_handler_t *sh = obs_output_get_signal_handler(out->output);
@@ -486,7 +524,7 @@ static void mp4_output_actual_stop(struct mp4_output *out, int code)
 	info("Waiting for file writer to finish...");
 
 	/* Flush/close output file and destroy muxer */
-	buffered_file_serializer_free(&out->serializer);
+	close_serializer(out);
 	obs_queue_task(OBS_TASK_DESTROY, mp4_mux_destroy_task, out->muxer, false);
 	out->muxer = NULL;
 
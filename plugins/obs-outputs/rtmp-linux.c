@@ -0,0 +1,558 @@
+/******************************************************************************
+    Copyright (C) 2026 by agent <agent@local>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#ifdef __linux__
+#include "rtmp-stream.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <linux/errqueue.h>
+#include <linux/sockios.h>
+
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+#ifndef SO_EE_ORIGIN_ZEROCOPY
+#define SO_EE_ORIGIN_ZEROCOPY 5
+#endif
+#ifndef SO_EE_CODE_ZEROCOPY_COPIED
+#define SO_EE_CODE_ZEROCOPY_COPIED 1
+#endif
+#ifndef TCP_NOTSENT_LOWAT
+#define TCP_NOTSENT_LOWAT 25
+#endif
+#ifndef SIOCOUTQNSD
+#define SIOCOUTQNSD 0x894B
+#endif
+
+#define SOCKET_MAX_IOV 64
+#define LATENCY_FACTOR 20
+#define POLL_TIMEOUT_MS 20
+#define TCP_INFO_INTERVAL_NS 250000000ULL
+#define EXIT_TIMEOUT_NS 2000000000ULL
+
+/* zero copy sends have to pin pages and wait for a completion, which only
+ * pays off for larger batches */
+#define ZEROCOPY_MIN_BATCH 16384
+
+/* how far the round trip time may rise above the minimum seen on the
+ * connection before it is reported as full congestion */
+#define RTT_CONGESTION_USEC 200000
+
+/* ------------------------------------------------------------------------- */
+/* block queue
+ *
+ * write_buf is split into fixed size blocks used as a ring.  The RTMP send
+ * thread appends to the newest block, the socket thread sends every filled
+ * range it finds in one sendmsg call, and a block is only handed back once
+ * all of its data has been sent and, for zero copy sends, the kernel has
+ * reported that it no longer references it. */
+
+static inline struct sock_block *get_block(struct rtmp_stream *stream, size_t i)
+{
+	return &stream->sock_blocks[(stream->sock_block_head + i) % stream->sock_num_blocks];
+}
+
+static inline uint8_t *get_block_data(struct rtmp_stream *stream, struct sock_block *block)
+{
+	return stream->write_buf + (size_t)(block - stream->sock_blocks) * SOCKET_BLOCK_SIZE;
+}
+
+static void retire_blocks(struct rtmp_stream *stream)
+{
+	bool retired = false;
+
+	while (stream->sock_block_count) {
+		struct sock_block *block = get_block(stream, 0);
+		if (block->sent != block->len || block->zc_pending)
+			break;
+
+		stream->write_buf_len -= block->len;
+		stream->sock_block_head = (stream->sock_block_head + 1) % stream->sock_num_blocks;
+		stream->sock_block_count--;
+		retired = true;
+	}
+
+	if (retired)
+		os_event_signal(stream->buffer_space_available_event);
+}
+
+bool socket_queue_init_linux(struct rtmp_stream *stream)
+{
+	size_t num_blocks = stream->write_buf_size / SOCKET_BLOCK_SIZE;
+
+	bfree(stream->sock_blocks);
+	stream->sock_blocks = bzalloc(num_blocks * sizeof(struct sock_block));
+	stream->sock_num_blocks = num_blocks;
+	stream->sock_block_head = 0;
+	stream->sock_block_count = 0;
+	stream->sock_bytes_unsent = 0;
+	stream->sock_zc_blocks = 0;
+	stream->sock_zc_next_id = 0;
+	stream->write_buf_len = 0;
+
+	os_atomic_set_long(&stream->sock_rtt_usec, 0);
+	os_atomic_set_long(&stream->sock_min_rtt_usec, 0);
+	os_atomic_set_long(&stream->sock_bytes_in_flight, 0);
+	os_atomic_set_long(&stream->sock_bytes_notsent, 0);
+	os_atomic_set_long(&stream->sock_cwnd_bytes, 0);
+	return num_blocks > 0;
+}
+
+int socket_queue_data_linux(RTMPSockBuf *sb, const char *data, int len, void *arg)
+{
+	UNUSED_PARAMETER(sb);
+
+	struct rtmp_stream *stream = arg;
+	size_t remaining = (size_t)len;
+
+	while (remaining) {
+		struct sock_block *block = NULL;
+
+		if (!RTMP_IsConnected(&stream->rtmp))
+			return 0;
+
+		pthread_mutex_lock(&stream->write_buf_mutex);
+
+		if (stream->sock_block_count)
+			block = get_block(stream, stream->sock_block_count - 1);
+
+		if (!block || block->len == SOCKET_BLOCK_SIZE) {
+			if (stream->sock_block_count == stream->sock_num_blocks) {
+				pthread_mutex_unlock(&stream->write_buf_mutex);
+
+				if (os_event_wait(stream->buffer_space_available_event))
+					return 0;
+				continue;
+			}
+
+			block = get_block(stream, stream->sock_block_count++);
+			memset(block, 0, sizeof(*block));
+		}
+
+		size_t size = SOCKET_BLOCK_SIZE - block->len;
+		if (size > remaining)
+			size = remaining;
+
+		memcpy(get_block_data(stream, block) + block->len, data, size);
+		block->len += size;
+		stream->write_buf_len += size;
+		stream->sock_bytes_unsent += size;
+
+		pthread_mutex_unlock(&stream->write_buf_mutex);
+
+		data += size;
+		remaining -= size;
+
+		os_event_signal(stream->buffer_has_data_event);
+	}
+
+	return len;
+}
+
+/* ------------------------------------------------------------------------- */
+/* socket thread */
+
+struct socket_stats {
+	uint64_t sends;
+	uint64_t bytes;
+	uint64_t zc_sends;
+	uint64_t zc_copied;
+	uint64_t rtt_total;
+	uint64_t rtt_samples;
+	long max_in_flight;
+};
+
+static void fatal_sock_shutdown(struct rtmp_stream *stream)
+{
+	pthread_mutex_lock(&stream->write_buf_mutex);
+	close(stream->rtmp.m_sb.sb_socket);
+	stream->rtmp.m_sb.sb_socket = -1;
+	stream->write_buf_len = 0;
+	stream->sock_block_count = 0;
+	stream->sock_bytes_unsent = 0;
+	stream->sock_zc_blocks = 0;
+	pthread_mutex_unlock(&stream->write_buf_mutex);
+
+	os_event_signal(stream->buffer_space_available_event);
+}
+
+static void set_socket_options(struct rtmp_stream *stream, int fd, int lowat)
+{
+	if (setsockopt(fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT, &lowat, sizeof(lowat)) != 0)
+		blog(LOG_WARNING, "socket_thread_linux: Failed to set TCP_NOTSENT_LOWAT, error %d", errno);
+
+	if (stream->zerocopy) {
+		int one = 1;
+
+		if (setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) != 0) {
+			blog(LOG_INFO, "socket_thread_linux: Zero copy sends not supported, error %d", errno);
+			stream->zerocopy = false;
+		}
+	}
+
+	blog(LOG_INFO, "socket_thread_linux: Unsent data limit %d bytes, zero copy %s", lowat,
+	     stream->zerocopy ? "enabled" : "disabled");
+}
+
+static inline bool zc_id_in_range(uint32_t id, uint32_t lo, uint32_t hi)
+{
+	return (int32_t)(id - lo) >= 0 && (int32_t)(hi - id) >= 0;
+}
+
+static void complete_zerocopy(struct rtmp_stream *stream, uint32_t lo, uint32_t hi)
+{
+	pthread_mutex_lock(&stream->write_buf_mutex);
+
+	for (size_t i = 0; i < stream->sock_block_count; i++) {
+		struct sock_block *block = get_block(stream, i);
+
+		if (block->zc_pending && zc_id_in_range(block->zc_id, lo, hi)) {
+			block->zc_pending = false;
+			stream->sock_zc_blocks--;
+		}
+	}
+
+	retire_blocks(stream);
+	pthread_mutex_unlock(&stream->write_buf_mutex);
+}
+
+/* zero copy completions arrive on the socket error queue as ranges of send
+ * call ids, which are counted up from 0 for every successful send */
+static void reap_zerocopy(struct rtmp_stream *stream, int fd, struct socket_stats *stats)
+{
+	for (;;) {
+		char control[128];
+		struct msghdr msg = {0};
+		struct cmsghdr *cmsg;
+
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof(control);
+
+		if (recvmsg(fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) == -1)
+			break;
+
+		for (cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+			struct sock_extended_err serr;
+
+			if (!(cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) &&
+			    !(cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR))
+				continue;
+
+			memcpy(&serr, CMSG_DATA(cmsg), sizeof(serr));
+			if (serr.ee_errno != 0 || serr.ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+				continue;
+
+			/* the kernel fell back to copying, e.g. on loopback or
+			 * devices without scatter-gather support */
+			if (serr.ee_code & SO_EE_CODE_ZEROCOPY_COPIED)
+				stats->zc_copied += serr.ee_data - serr.ee_info + 1;
+
+			complete_zerocopy(stream, serr.ee_info, serr.ee_data);
+		}
+	}
+}
+
+static bool discard_recv_data(struct rtmp_stream *stream, int fd)
+{
+	char discard[16384];
+
+	for (;;) {
+		ssize_t ret = recv(fd, discard, sizeof(discard), MSG_DONTWAIT);
+		if (ret > 0)
+			continue;
+		if (ret == -1 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+			return true;
+
+		blog(LOG_ERROR, "socket_thread_linux: Socket error, recv() returned %zd, errno %d", ret,
+		     ret ? errno : 0);
+		stream->rtmp.last_error_code = ret ? errno : 0;
+		return false;
+	}
+}
+
+static void update_tcp_info(struct rtmp_stream *stream, int fd, struct socket_stats *stats)
+{
+	struct tcp_info info;
+	socklen_t size = sizeof(info);
+	int outq = 0, notsent = 0;
+
+	if (getsockopt(fd, IPPROTO_TCP, TCP_INFO, &info, &size) == 0 && info.tcpi_rtt) {
+		long rtt = (long)info.tcpi_rtt;
+		long min_rtt = os_atomic_load_long(&stream->sock_min_rtt_usec);
+
+		os_atomic_set_long(&stream->sock_rtt_usec, rtt);
+		if (!min_rtt || rtt < min_rtt)
+			os_atomic_set_long(&stream->sock_min_rtt_usec, rtt);
+
+		stats->rtt_total += (uint64_t)rtt;
+		stats->rtt_samples++;
+
+		os_atomic_set_long(&stream->sock_cwnd_bytes, (long)info.tcpi_snd_cwnd * (long)info.tcpi_snd_mss);
+	}
+
+	/* everything in the send queue that was not acknowledged yet, and the
+	 * part of it that was not even sent yet */
+	if (ioctl(fd, SIOCOUTQ, &outq) == 0 && ioctl(fd, SIOCOUTQNSD, &notsent) == 0) {
+		long in_flight = outq > notsent ? (long)(outq - notsent) : 0;
+
+		os_atomic_set_long(&stream->sock_bytes_in_flight, in_flight);
+		os_atomic_set_long(&stream->sock_bytes_notsent, (long)notsent);
+
+		if (in_flight > stats->max_in_flight)
+			stats->max_in_flight = in_flight;
+	}
+}
+
+enum send_ret { SEND_DONE, SEND_BLOCKED, SEND_FATAL };
+
+/* gathers every unsent range in the queue into one sendmsg call */
+static enum send_ret send_batch(struct rtmp_stream *stream, int fd, struct socket_stats *stats)
+{
+	struct iovec iov[SOCKET_MAX_IOV];
+	struct msghdr msg = {0};
+	size_t first, num_iov = 0, total = 0;
+	bool zerocopy;
+	ssize_t ret;
+
+	pthread_mutex_lock(&stream->write_buf_mutex);
+
+	for (first = 0; first < stream->sock_block_count; first++) {
+		struct sock_block *block = get_block(stream, first);
+		if (block->sent < block->len)
+			break;
+	}
+
+	for (size_t i = first; i < stream->sock_block_count && num_iov < SOCKET_MAX_IOV; i++) {
+		struct sock_block *block = get_block(stream, i);
+
+		iov[num_iov].iov_base = get_block_data(stream, block) + block->sent;
+		iov[num_iov].iov_len = block->len - block->sent;
+		total += iov[num_iov++].iov_len;
+	}
+
+	pthread_mutex_unlock(&stream->write_buf_mutex);
+
+	if (!total)
+		return SEND_DONE;
+
+	/* the ranges handed to the kernel are never written to again by the
+	 * queue function, and their blocks can't be reused until they are
+	 * marked as sent, so the lock doesn't need to be held here */
+	zerocopy = stream->zerocopy && total >= ZEROCOPY_MIN_BATCH;
+	msg.msg_iov = iov;
+	msg.msg_iovlen = num_iov;
+
+	ret = sendmsg(fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL | (zerocopy ? MSG_ZEROCOPY : 0));
+	if (ret <= 0) {
+		if (ret == -1 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+			return SEND_BLOCKED;
+
+		/* ENOBUFS means the zero copy notification could not be
+		 * queued, the data was not sent so just retry with a copy */
+		if (ret == -1 && zerocopy && errno == ENOBUFS) {
+			stream->zerocopy = false;
+			blog(LOG_WARNING, "socket_thread_linux: Out of zero copy notification space, "
+					  "disabling zero copy");
+			return SEND_DONE;
+		}
+
+		blog(LOG_ERROR, "socket_thread_linux: Socket error, sendmsg() returned %zd, errno %d", ret,
+		     ret ? errno : 0);
+		stream->rtmp.last_error_code = ret ? errno : 0;
+		return SEND_FATAL;
+	}
+
+	stats->sends++;
+	stats->bytes += (uint64_t)ret;
+
+	pthread_mutex_lock(&stream->write_buf_mutex);
+	stream->sock_bytes_unsent -= (size_t)ret;
+
+	size_t remaining = (size_t)ret;
+	for (size_t i = first; remaining; i++) {
+		struct sock_block *block = get_block(stream, i);
+		size_t size = block->len - block->sent;
+
+		if (size > remaining)
+			size = remaining;
+
+		block->sent += size;
+		remaining -= size;
+
+		if (zerocopy) {
+			if (!block->zc_pending)
+				stream->sock_zc_blocks++;
+			block->zc_pending = true;
+			block->zc_id = stream->sock_zc_next_id;
+		}
+	}
+
+	if (zerocopy) {
+		stream->sock_zc_next_id++;
+		stats->zc_sends++;
+	}
+
+	retire_blocks(stream);
+	pthread_mutex_unlock(&stream->write_buf_mutex);
+
+	return (size_t)ret < total ? SEND_BLOCKED : SEND_DONE;
+}
+
+static inline void socket_thread_linux_internal(struct rtmp_stream *stream)
+{
+	struct socket_stats stats = {0};
+	uint64_t last_tcp_info = 0;
+	uint64_t exit_deadline = 0;
+	int fd = stream->rtmp.m_sb.sb_socket;
+	int lowat;
+
+	/* keep the unsent backlog in our queue rather than in the kernel, so
+	 * that a slow connection shows up as congestion right away */
+	if (stream->low_latency_mode)
+		lowat = (int)(stream->write_buf_size / LATENCY_FACTOR);
+	else
+		lowat = (int)stream->write_buf_size;
+	if (lowat < SOCKET_BLOCK_SIZE)
+		lowat = SOCKET_BLOCK_SIZE;
+
+	os_atomic_set_long(&stream->sock_notsent_lowat, lowat);
+	set_socket_options(stream, fd, lowat);
+
+	for (;;) {
+		bool unsent, pending;
+		uint64_t now = os_gettime_ns();
+
+		pthread_mutex_lock(&stream->write_buf_mutex);
+		unsent = stream->sock_bytes_unsent > 0;
+		pending = stream->sock_zc_blocks > 0;
+		pthread_mutex_unlock(&stream->write_buf_mutex);
+
+		if (os_event_try(stream->send_thread_signaled_exit) != EAGAIN) {
+			if (!unsent && !pending) {
+				os_event_reset(stream->send_thread_signaled_exit);
+				break;
+			}
+
+			if (!exit_deadline)
+				exit_deadline = now + EXIT_TIMEOUT_NS;
+			if (!unsent && now >= exit_deadline) {
+				blog(LOG_WARNING, "socket_thread_linux: Timed out waiting for zero copy "
+						  "completions");
+				break;
+			}
+		}
+
+		if (now - last_tcp_info >= TCP_INFO_INTERVAL_NS) {
+			update_tcp_info(stream, fd, &stats);
+			last_tcp_info = now;
+		}
+
+		if (!unsent && !pending) {
+			os_event_timedwait(stream->buffer_has_data_event, POLL_TIMEOUT_MS);
+			if (!discard_recv_data(stream, fd)) {
+				fatal_sock_shutdown(stream);
+				return;
+			}
+			continue;
+		}
+
+		/* with TCP_NOTSENT_LOWAT set, POLLOUT is only reported once
+		 * the kernel has sent most of what it already has queued */
+		struct pollfd pfd = {fd, POLLIN | (unsent ? POLLOUT : 0), 0};
+		int ret = poll(&pfd, 1, POLL_TIMEOUT_MS);
+
+		if (ret == -1 && errno != EINTR) {
+			blog(LOG_ERROR, "socket_thread_linux: Aborting due to poll() failure, errno %d", errno);
+			fatal_sock_shutdown(stream);
+			return;
+		}
+		if (ret <= 0)
+			continue;
+
+		if (pfd.revents & POLLERR)
+			reap_zerocopy(stream, fd, &stats);
+
+		if (pfd.revents & (POLLIN | POLLHUP)) {
+			if (!discard_recv_data(stream, fd)) {
+				fatal_sock_shutdown(stream);
+				return;
+			}
+		}
+
+		if (pfd.revents & POLLOUT) {
+			if (send_batch(stream, fd, &stats) == SEND_FATAL) {
+				fatal_sock_shutdown(stream);
+				return;
+			}
+		}
+	}
+
+	blog(LOG_INFO,
+	     "socket_thread_linux: Normal exit, %" PRIu64 " bytes in %" PRIu64 " sends, "
+	     "%" PRIu64 " zero copy (%" PRIu64 " copied), average RTT %" PRIu64 " ms, "
+	     "max in flight %ld bytes",
+	     stats.bytes, stats.sends, stats.zc_sends, stats.zc_copied,
+	     stats.rtt_samples ? stats.rtt_total / stats.rtt_samples / 1000 : 0, stats.max_in_flight);
+}
+
+void *socket_thread_linux(void *data)
+{
+	struct rtmp_stream *stream = data;
+
+	os_set_thread_name("rtmp-stream: socket_thread");
+	socket_thread_linux_internal(stream);
+	return NULL;
+}
+
+/* Congestion for the new socket loop is how full the queue is, or how far the
+ * measured round trip time has risen above the connection's minimum,
+ * whichever is higher.  The queue counts the data the kernel has not sent yet
+ * and the data that is in flight, against the TCP congestion window, so a
+ * connection that keeps its window full shows up before our own queue fills.
+ * Packet counts say little here since packets are merged into large sends. */
+float socket_congestion_linux(struct rtmp_stream *stream)
+{
+	long rtt = os_atomic_load_long(&stream->sock_rtt_usec);
+	long min_rtt = os_atomic_load_long(&stream->sock_min_rtt_usec);
+	long notsent = os_atomic_load_long(&stream->sock_bytes_notsent);
+	long in_flight = os_atomic_load_long(&stream->sock_bytes_in_flight);
+	long cwnd = os_atomic_load_long(&stream->sock_cwnd_bytes);
+	long lowat = os_atomic_load_long(&stream->sock_notsent_lowat);
+	float queue, delay = 0.0f;
+
+	/* without a window size yet, in flight data can't be weighed */
+	if (!cwnd)
+		in_flight = 0;
+
+	queue = (float)(stream->write_buf_len + (size_t)notsent + (size_t)in_flight) /
+		(float)(stream->write_buf_size + (size_t)lowat + (size_t)cwnd);
+
+	if (min_rtt && rtt > min_rtt)
+		delay = (float)(rtt - min_rtt) / (float)RTT_CONGESTION_USEC;
+
+	queue = queue > delay ? queue : delay;
+	return queue < 1.0f ? queue : 1.0f;
+}
+#endif
@@ -145,6 +145,7 @@ static void rtmp_stream_destroy(void *data)
 
 	if (stream->write_buf)
 		bfree(stream->write_buf);
+	bfree(stream->sock_blocks);
 	bfree(stream);
 }
 
@@ -396,8 +397,34 @@ static int handle_socket_read(struct rtmp_stream *stream)
 	return 0;
 }
 
+/* Sends an FLV tag without muxing it into a buffer first: the tag prefix and
+ * the encoder packet payload are passed to librtmp as separate pieces, which
+ * writes the chunk headers around them and hands everything to the socket in
+ * place. */
+static int send_tag(struct rtmp_stream *stream, struct encoder_packet *packet, const struct flv_tag_header *header)
+{
+	AVal body[2] = {
+		{(char *)header->prefix, (int)header->prefix_size},
+		{(char *)packet->data, (int)packet->size},
+	};
+	size_t size = flv_tag_size(header, packet);
+	int ret;
+
+#ifdef TEST_FRAMEDROPS
+	droptest_cap_data_rate(stream, size);
+#endif
+
+	ret = RTMP_WriteVec(&stream->rtmp, header->type, (uint32_t)header->time_ms & 0x7FFFFFFF, body, 2, 0);
+
+	obs_encoder_packet_release(packet);
+
+	stream->total_bytes_sent += size;
+	return ret;
+}
+
 static int send_packet(struct rtmp_stream *stream, struct encoder_packet *packet, bool is_header)
 {
+	struct flv_tag_header header;
 	uint8_t *data;
 	size_t size;
 	int ret = 0;
@@ -405,6 +432,14 @@ static int send_packet(struct rtmp_stream *stream, struct encoder_packet *packet
 	if (handle_socket_read(stream))
 		return -1;
 
+	if (!is_header) {
+		if (flv_packet_mux_header(packet, stream->start_dts_offset, &header, false))
+			return send_tag(stream, packet, &header);
+
+		obs_encoder_packet_release(packet);
+		return 0;
+	}
+
 	flv_packet_mux(packet, is_header ? 0 : stream->start_dts_offset, &data, &size, is_header);
 
 #ifdef TEST_FRAMEDROPS
@@ -426,6 +461,7 @@ static int send_packet(struct rtmp_stream *stream, struct encoder_packet *packet
 static int send_packet_ex(struct rtmp_stream *stream, struct encoder_packet *packet, bool is_header, bool is_footer,
 			  size_t idx)
 {
+	struct flv_tag_header header;
 	uint8_t *data;
 	size_t size = 0;
 	int ret = 0;
@@ -438,7 +474,8 @@ static int send_packet_ex(struct rtmp_stream *stream, struct encoder_packet *pac
 	} else if (is_footer) {
 		flv_packet_end(packet, stream->video_codec[idx], &data, &size, idx);
 	} else {
-		flv_packet_frames(packet, stream->video_codec[idx], stream->start_dts_offset, &data, &size, idx);
+		flv_packet_frames_header(packet, stream->video_codec[idx], stream->start_dts_offset, &header, idx);
+		return send_tag(stream, packet, &header);
 	}
 
 #ifdef TEST_FRAMEDROPS
@@ -459,6 +496,7 @@ static int send_packet_ex(struct rtmp_stream *stream, struct encoder_packet *pac
 
 static int send_audio_packet_ex(struct rtmp_stream *stream, struct encoder_packet *packet, bool is_header, size_t idx)
 {
+	struct flv_tag_header header;
 	uint8_t *data;
 	size_t size = 0;
 	int ret = 0;
@@ -469,7 +507,12 @@ static int send_audio_packet_ex(struct rtmp_stream *stream, struct encoder_packe
 	if (is_header) {
 		flv_packet_audio_start(packet, stream->audio_codec[idx], &data, &size, idx);
 	} else {
-		flv_packet_audio_frames(packet, stream->audio_codec[idx], stream->start_dts_offset, &data, &size, idx);
+		if (flv_packet_audio_frames_header(packet, stream->audio_codec[idx], stream->start_dts_offset, &header,
+						   idx))
+			return send_tag(stream, packet, &header);
+
+		obs_encoder_packet_release(packet);
+		return 0;
 	}
 
 	ret = RTMP_Write(&stream->rtmp, (char *)data, (int)size, 0);
@@ -1057,10 +1100,7 @@ static int init_send(struct rtmp_stream *stream)
 		stream->write_buf_size = ideal_buffer_size;
 		stream->write_buf = bmalloc(ideal_buffer_size);
 
-#ifndef _WIN32
-		warn("New socket loop not supported on this platform");
-		return OBS_OUTPUT_ERROR;
-#else
+#ifdef _WIN32
 		ret = pthread_create(&stream->socket_thread, NULL, socket_thread_windows, stream);
 
 		if (ret != 0) {
@@ -1073,6 +1113,41 @@ static int init_send(struct rtmp_stream *stream)
 		stream->rtmp.m_bCustomSend = true;
 		stream->rtmp.m_customSendFunc = socket_queue_data;
 		stream->rtmp.m_customSendParam = stream;
+#elif defined(__linux__)
+		if (stream->zerocopy)
+			info("Zero copy sends enabled by user");
+
+		if (socket_queue_init_linux(stream)) {
+			ret = pthread_create(&stream->socket_thread, NULL, socket_thread_linux, stream);
+
+			if (ret != 0) {
+				RTMP_Close(&stream->rtmp);
+				warn("Failed to create socket thread");
+				return OBS_OUTPUT_ERROR;
+			}
+
+			stream->socket_thread_active = true;
+			stream->rtmp.m_bCustomSend = true;
+			stream->rtmp.m_customSendFunc = socket_queue_data_linux;
+			stream->rtmp.m_customSendParam = stream;
+		} else {
+			int zero = 0;
+
+			warn("Failed to set up the socket queue for a %zu byte buffer, "
+			     "falling back to sending from the send thread",
+			     stream->write_buf_size);
+
+			/* no data has been captured yet, so the send thread
+			 * has not looked at new_socket_loop */
+			ioctl(stream->rtmp.m_sb.sb_socket, FIONBIO, &zero);
+			bfree(stream->write_buf);
+			stream->write_buf = NULL;
+			stream->write_buf_size = 0;
+			stream->new_socket_loop = false;
+		}
+#else
+		warn("New socket loop not supported on this platform");
+		return OBS_OUTPUT_ERROR;
 #endif
 	}
 
@@ -1336,9 +1411,12 @@ static bool init_connect(struct rtmp_stream *stream)
 		stream->addrlen_hint = len;
 	}
 
-#ifdef _WIN32
+#if defined(_WIN32) || defined(__linux__)
 	stream->new_socket_loop = obs_data_get_bool(settings, OPT_NEWSOCKETLOOP_ENABLED);
 	stream->low_latency_mode = obs_data_get_bool(settings, OPT_LOWLATENCY_ENABLED);
+#ifdef __linux__
+	stream->zerocopy = obs_data_get_bool(settings, OPT_ZEROCOPY_ENABLED);
+#endif
 
 	// ugly hack for now, can be removed once new loop is reworked
 	if (stream->new_socket_loop && !strncmp(stream->path.array, "rtmps://", 8)) {
@@ -1720,10 +1798,13 @@ static void rtmp_stream_defaults(obs_data_t *defaults)
 	obs_data_set_default_int(defaults, OPT_PFRAME_DROP_THRESHOLD, 900);
 	obs_data_set_default_int(defaults, OPT_MAX_SHUTDOWN_TIME_SEC, 30);
 	obs_data_set_default_string(defaults, OPT_BIND_IP, "default");
-#ifdef _WIN32
+#if defined(_WIN32) || defined(__linux__)
 	obs_data_set_default_bool(defaults, OPT_NEWSOCKETLOOP_ENABLED, false);
 	obs_data_set_default_bool(defaults, OPT_LOWLATENCY_ENABLED, false);
 #endif
+#ifdef __linux__
+	obs_data_set_default_bool(defaults, OPT_ZEROCOPY_ENABLED, false);
+#endif
 }
 
 static obs_properties_t *rtmp_stream_properties(void *unused)
@@ -1757,10 +1838,13 @@ static obs_properties_t *rtmp_stream_properties(void *unused)
 	}
 	netif_saddr_data_free(&addrs);
 
-#ifdef _WIN32
+#if defined(_WIN32) || defined(__linux__)
 	obs_properties_add_bool(props, OPT_NEWSOCKETLOOP_ENABLED, obs_module_text("RTMPStream.NewSocketLoop"));
 	obs_properties_add_bool(props, OPT_LOWLATENCY_ENABLED, obs_module_text("RTMPStream.LowLatencyMode"));
 #endif
+#ifdef __linux__
+	obs_properties_add_bool(props, OPT_ZEROCOPY_ENABLED, obs_module_text("RTMPStream.ZeroCopy"));
+#endif
 
 	return props;
 }
@@ -1781,10 +1865,14 @@ static float rtmp_stream_congestion(void *data)
 {
 	struct rtmp_stream *stream = data;
 
-	if (stream->new_socket_loop)
-		return (float)stream->write_buf_len / (float)stream->write_buf_size;
-	else
+	if (!stream->new_socket_loop)
 		return stream->min_priority > 0 ? 1.0f : stream->congestion;
+
+#ifdef __linux__
+	return socket_congestion_linux(stream);
+#else
+	return (float)stream->write_buf_len / (float)stream->write_buf_size;
+#endif
 }
 
 static int rtmp_stream_connect_time(void *data)
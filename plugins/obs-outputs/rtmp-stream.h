@@ -30,6 +30,7 @@
 #define OPT_IP_FAMILY "ip_family"
 #define OPT_NEWSOCKETLOOP_ENABLED "new_socket_loop_enabled"
 #define OPT_LOWLATENCY_ENABLED "low_latency_mode_enabled"
+#define OPT_ZEROCOPY_ENABLED "zerocopy_enabled"
 #define OPT_METADATA_MULTITRACK "metadata_multitrack"
 
 //#define TEST_FRAMEDROPS
@@ -46,6 +47,16 @@ struct droptest_info {
 };
 #endif
 
+/* Linux socket loop send queue block, see rtmp-linux.c */
+#define SOCKET_BLOCK_SIZE 16384
+
+struct sock_block {
+	size_t len;
+	size_t sent;
+	uint32_t zc_id;
+	bool zc_pending;
+};
+
 struct dbr_frame {
 	uint64_t send_beg;
 	uint64_t send_end;
@@ -131,10 +142,31 @@ struct rtmp_stream {
 	os_event_t *buffer_has_data_event;
 	os_event_t *socket_available_event;
 	os_event_t *send_thread_signaled_exit;
+
+	/* Linux socket loop */
+	bool zerocopy;
+	struct sock_block *sock_blocks;
+	size_t sock_num_blocks;
+	size_t sock_block_head;
+	size_t sock_block_count;
+	size_t sock_bytes_unsent;
+	size_t sock_zc_blocks;
+	uint32_t sock_zc_next_id;
+	volatile long sock_notsent_lowat;
+	volatile long sock_rtt_usec;
+	volatile long sock_min_rtt_usec;
+	volatile long sock_bytes_in_flight;
+	volatile long sock_bytes_notsent;
+	volatile long sock_cwnd_bytes;
 };
 
 #ifdef _WIN32
 void *socket_thread_windows(void *data);
+#elif defined(__linux__)
+bool socket_queue_init_linux(struct rtmp_stream *stream);
+int socket_queue_data_linux(RTMPSockBuf *sb, const char *data, int len, void *arg);
+void *socket_thread_linux(void *data);
+float socket_congestion_linux(struct rtmp_stream *stream);
 #endif
 
 /* Adapted from FFmpeg's libavutil/pixfmt.h
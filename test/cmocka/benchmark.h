@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Benchmarks print their measurements instead of checking them, so they
+ * only run when OBS_CMOCKA_BENCHMARKS is set (and not "0"), e.g.
+ *
+ *   OBS_CMOCKA_BENCHMARKS=1 ctest -R test_obs_data --verbose
+ */
+static inline int benchmarks_enabled(void)
+{
+	const char *env = getenv("OBS_CMOCKA_BENCHMARKS");
+	return env && *env && strcmp(env, "0") != 0;
+}
+
+/* Runs a group of benchmarks if enabled, returns the number that failed */
+#define run_benchmarks(benchmarks) (benchmarks_enabled() ? cmocka_run_group_tests(benchmarks, NULL, NULL) : 0)
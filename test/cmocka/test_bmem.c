@@ -0,0 +1,131 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <util/bmem.h>
+#include <util/threading.h>
+
+/* Run with OBS_BMEM_THREAD_CACHE=1, see CMakeLists.txt */
+
+#define NUM_THREADS 4
+#define NUM_BLOCKS 4096
+
+static void fill_block(uint8_t *ptr, size_t size, uint8_t seed)
+{
+	for (size_t i = 0; i < size; i++)
+		ptr[i] = (uint8_t)(seed + i);
+}
+
+static bool check_block(const uint8_t *ptr, size_t size, uint8_t seed)
+{
+	for (size_t i = 0; i < size; i++) {
+		if (ptr[i] != (uint8_t)(seed + i))
+			return false;
+	}
+	return true;
+}
+
+static void size_classes_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	long start_allocs = bnum_allocs();
+	uintptr_t alignment = (uintptr_t)base_get_alignment();
+
+	assert_true(bmem_thread_cache_enabled());
+
+	for (size_t size = 1; size < 70000; size += size / 3 + 1) {
+		uint8_t *ptr = bmalloc(size);
+		assert_int_equal((uintptr_t)ptr & (alignment - 1), 0);
+		fill_block(ptr, size, (uint8_t)size);
+
+		/* grow within and past the size class, then shrink again */
+		ptr = brealloc(ptr, size + 1);
+		assert_true(check_block(ptr, size, (uint8_t)size));
+		ptr = brealloc(ptr, size * 3);
+		assert_true(check_block(ptr, size, (uint8_t)size));
+		ptr = brealloc(ptr, size / 2 + 1);
+		assert_true(check_block(ptr, size / 2 + 1, (uint8_t)size));
+		assert_int_equal((uintptr_t)ptr & (alignment - 1), 0);
+
+		bfree(ptr);
+	}
+
+	assert_int_equal(bnum_allocs(), start_allocs);
+}
+
+struct thread_data {
+	uint8_t *blocks[NUM_BLOCKS];
+	size_t sizes[NUM_BLOCKS];
+	uint8_t seed;
+};
+
+static void *alloc_thread(void *param)
+{
+	struct thread_data *data = param;
+
+	os_set_thread_name("test_bmem alloc");
+
+	for (size_t i = 0; i < NUM_BLOCKS; i++) {
+		data->sizes[i] = (i * 7919) % 2048 + 1;
+		data->blocks[i] = bmalloc(data->sizes[i]);
+		fill_block(data->blocks[i], data->sizes[i], data->seed);
+	}
+
+	return NULL;
+}
+
+/* frees blocks allocated by another thread, which end up in this thread's
+ * cache and then on the shared lists */
+static void *free_thread(void *param)
+{
+	struct thread_data *data = param;
+	bool valid = true;
+
+	os_set_thread_name("test_bmem free");
+
+	for (size_t i = 0; i < NUM_BLOCKS; i++) {
+		valid = valid && check_block(data->blocks[i], data->sizes[i], data->seed);
+		bfree(data->blocks[i]);
+	}
+
+	return valid ? data : NULL;
+}
+
+static void threads_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	static struct thread_data data[NUM_THREADS];
+	pthread_t threads[NUM_THREADS];
+	long start_allocs = bnum_allocs();
+
+	for (size_t i = 0; i < NUM_THREADS; i++) {
+		data[i].seed = (uint8_t)i;
+		pthread_create(&threads[i], NULL, alloc_thread, &data[i]);
+	}
+	for (size_t i = 0; i < NUM_THREADS; i++)
+		pthread_join(threads[i], NULL);
+
+	for (size_t i = 0; i < NUM_THREADS; i++)
+		pthread_create(&threads[i], NULL, free_thread, &data[(i + 1) % NUM_THREADS]);
+	for (size_t i = 0; i < NUM_THREADS; i++) {
+		void *result;
+		pthread_join(threads[i], &result);
+		assert_non_null(result);
+	}
+
+	assert_int_equal(bnum_allocs(), start_allocs);
+	bmem_log_thread_stats();
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(size_classes_test),
+		cmocka_unit_test(threads_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,253 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <cmocka.h>
+
+#include "benchmark.h"
+
+#include <util/deque.h>
+#include <util/float-ring.h>
+#include <util/platform.h>
+#include <util/threading.h>
+
+#define PLANES 2
+#define PACKET_FRAMES 480
+#define TICK_FRAMES 1024
+#define RING_FRAMES (TICK_FRAMES * 16)
+
+static void basic_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct float_ring ring;
+	float in[PLANES][100];
+	float out[PLANES][100];
+	const float *in_planes[PLANES] = {in[0], in[1]};
+	float *out_planes[PLANES] = {out[0], out[1]};
+
+	for (size_t i = 0; i < 100; i++) {
+		in[0][i] = (float)i;
+		in[1][i] = -(float)i;
+	}
+
+	float_ring_init(&ring, PLANES, 100);
+	assert_int_equal(ring.capacity, 128);
+
+	assert_true(float_ring_write(&ring, in_planes, 100));
+	assert_false(float_ring_write(&ring, in_planes, 50));
+	assert_int_equal(ring.overruns, 1);
+
+	assert_true(float_ring_read(&ring, out_planes, 60));
+	assert_true(out[0][59] == 59.0f && out[1][59] == -59.0f);
+
+	/* wraps around */
+	assert_true(float_ring_write(&ring, in_planes, 80));
+	assert_int_equal(float_ring_readable(&ring), 120);
+	assert_true(float_ring_read(&ring, NULL, 40));
+	assert_true(float_ring_read(&ring, out_planes, 80));
+	for (size_t i = 0; i < 80; i++)
+		assert_true(out[0][i] == (float)i && out[1][i] == -(float)i);
+
+	assert_false(float_ring_read(&ring, out_planes, 1));
+	assert_int_equal(ring.underruns, 1);
+
+	float_ring_free(&ring);
+}
+
+/* -------------------------------------------------------------------------
+ * Capture thread and audio thread: the capture thread outputs packets of
+ * PACKET_FRAMES as fast as it can, the audio thread takes TICK_FRAMES at a
+ * time.  Both paths carry the same sample sequence, which is checked. */
+
+struct audio_path {
+	bool use_ring;
+	size_t total_frames;
+
+	struct float_ring ring;
+
+	pthread_mutex_t mutex;
+	struct deque buf[PLANES];
+
+	uint64_t push_ns;
+	uint64_t max_push_ns;
+	uint64_t full_waits;
+	bool valid;
+};
+
+static bool path_push(struct audio_path *path, const float *const *planes)
+{
+	if (path->use_ring)
+		return float_ring_write(&path->ring, planes, PACKET_FRAMES);
+
+	bool pushed = false;
+
+	pthread_mutex_lock(&path->mutex);
+	if (path->buf[0].size + PACKET_FRAMES * sizeof(float) <= RING_FRAMES * sizeof(float)) {
+		for (size_t i = 0; i < PLANES; i++)
+			deque_push_back(&path->buf[i], planes[i], PACKET_FRAMES * sizeof(float));
+		pushed = true;
+	}
+	pthread_mutex_unlock(&path->mutex);
+
+	return pushed;
+}
+
+static bool path_pop(struct audio_path *path, float *const *planes)
+{
+	if (path->use_ring)
+		return float_ring_read(&path->ring, planes, TICK_FRAMES);
+
+	bool popped = false;
+
+	pthread_mutex_lock(&path->mutex);
+	if (path->buf[0].size >= TICK_FRAMES * sizeof(float)) {
+		for (size_t i = 0; i < PLANES; i++)
+			deque_pop_front(&path->buf[i], planes[i], TICK_FRAMES * sizeof(float));
+		popped = true;
+	}
+	pthread_mutex_unlock(&path->mutex);
+
+	return popped;
+}
+
+static void *capture_thread(void *param)
+{
+	struct audio_path *path = param;
+	float data[PLANES][PACKET_FRAMES];
+	const float *planes[PLANES] = {data[0], data[1]};
+
+	for (size_t frame = 0; frame < path->total_frames; frame += PACKET_FRAMES) {
+		for (size_t i = 0; i < PACKET_FRAMES; i++) {
+			data[0][i] = (float)((frame + i) & 0xFFFFFF);
+			data[1][i] = -data[0][i];
+		}
+
+		for (;;) {
+			uint64_t start = os_gettime_ns();
+			bool pushed = path_push(path, planes);
+			uint64_t elapsed = os_gettime_ns() - start;
+
+			path->push_ns += elapsed;
+			if (elapsed > path->max_push_ns)
+				path->max_push_ns = elapsed;
+
+			if (pushed)
+				break;
+
+			path->full_waits++;
+			os_sleep_ms(0);
+		}
+	}
+
+	return NULL;
+}
+
+static void *mixer_thread(void *param)
+{
+	struct audio_path *path = param;
+	float data[PLANES][TICK_FRAMES];
+	float *planes[PLANES] = {data[0], data[1]};
+	size_t total = path->total_frames / TICK_FRAMES * TICK_FRAMES;
+
+	path->valid = true;
+
+	for (size_t frame = 0; frame < total;) {
+		if (!path_pop(path, planes)) {
+			os_sleep_ms(0);
+			continue;
+		}
+
+		for (size_t i = 0; i < TICK_FRAMES; i++) {
+			float expected = (float)((frame + i) & 0xFFFFFF);
+			if (data[0][i] != expected || data[1][i] != -expected)
+				path->valid = false;
+		}
+
+		frame += TICK_FRAMES;
+	}
+
+	return NULL;
+}
+
+static uint64_t run_path(struct audio_path *path)
+{
+	pthread_t capture, mixer;
+	uint64_t start = os_gettime_ns();
+
+	pthread_create(&mixer, NULL, mixer_thread, path);
+	pthread_create(&capture, NULL, capture_thread, path);
+	pthread_join(capture, NULL);
+	pthread_join(mixer, NULL);
+
+	return os_gettime_ns() - start;
+}
+
+static void threads_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct audio_path path = {.use_ring = true, .total_frames = PACKET_FRAMES * 20000};
+
+	float_ring_init(&path.ring, PLANES, RING_FRAMES);
+	run_path(&path);
+	assert_true(path.valid);
+	float_ring_free(&path.ring);
+}
+
+/* Not a pass/fail test: compares the time the capture thread spends handing
+ * over audio on both paths. */
+static void benchmark_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	for (int use_ring = 0; use_ring < 2; use_ring++) {
+		struct audio_path path = {.use_ring = !!use_ring, .total_frames = PACKET_FRAMES * 200000};
+		double packets = (double)(path.total_frames / PACKET_FRAMES);
+		uint64_t total_ns;
+
+		if (path.use_ring) {
+			float_ring_init(&path.ring, PLANES, RING_FRAMES);
+		} else {
+			pthread_mutex_init(&path.mutex, NULL);
+			for (size_t i = 0; i < PLANES; i++)
+				deque_init(&path.buf[i]);
+		}
+
+		total_ns = run_path(&path);
+		assert_true(path.valid);
+
+		printf("%-12s %7.1f ms total, %6.1f ns per push (max %.1f us), %llu pushes while full\n",
+		       path.use_ring ? "float_ring" : "deque+mutex", (double)total_ns / 1e6,
+		       (double)path.push_ns / packets, (double)path.max_push_ns / 1e3,
+		       (unsigned long long)path.full_waits);
+
+		if (path.use_ring) {
+			float_ring_free(&path.ring);
+		} else {
+			for (size_t i = 0; i < PLANES; i++)
+				deque_free(&path.buf[i]);
+			pthread_mutex_destroy(&path.mutex);
+		}
+	}
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(basic_test),
+		cmocka_unit_test(threads_test),
+	};
+	const struct CMUnitTest benchmarks[] = {
+		cmocka_unit_test(benchmark_test),
+	};
+
+	int failed = cmocka_run_group_tests(tests, NULL, NULL);
+
+	/* push latency of the ring against a locked deque, the timings are
+	 * only printed */
+	failed += run_benchmarks(benchmarks);
+
+	return failed;
+}
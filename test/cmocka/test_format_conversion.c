@@ -0,0 +1,254 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <string.h>
+#include <cmocka.h>
+
+#include <util/bmem.h>
+#include <media-io/format-conversion.h>
+#include <media-io/format-conversion-internal.h>
+
+static const uint32_t widths[] = {1, 2, 3, 7, 15, 17, 33, 63, 65, 130};
+static const uint32_t heights[] = {1, 2, 3, 5, 8};
+
+static const enum format_conversion_simd simd_sets[] = {
+	FORMAT_CONVERSION_SIMD_SSE2,
+	FORMAT_CONVERSION_SIMD_AVX2,
+	FORMAT_CONVERSION_SIMD_AVX512,
+};
+
+#define NUM_PLANES 3
+#define GUARD 64
+
+struct test_frame {
+	uint8_t *data[NUM_PLANES];
+	uint32_t linesize[NUM_PLANES];
+	size_t size[NUM_PLANES];
+};
+
+static void fill_random(uint8_t *data, size_t size, uint32_t seed)
+{
+	for (size_t i = 0; i < size; i++) {
+		seed = seed * 1103515245 + 12345;
+		data[i] = (uint8_t)(seed >> 16);
+	}
+}
+
+static void frame_init(struct test_frame *frame, const uint32_t linesize[NUM_PLANES], uint32_t height, uint32_t seed)
+{
+	for (size_t i = 0; i < NUM_PLANES; i++) {
+		frame->linesize[i] = linesize[i];
+		frame->size[i] = (size_t)linesize[i] * height + GUARD;
+		frame->data[i] = bmalloc(frame->size[i]);
+		fill_random(frame->data[i], frame->size[i], seed + (uint32_t)i);
+	}
+}
+
+static void frame_free(struct test_frame *frame)
+{
+	for (size_t i = 0; i < NUM_PLANES; i++)
+		bfree(frame->data[i]);
+}
+
+static void frame_assert_equal(const struct test_frame *a, const struct test_frame *b)
+{
+	for (size_t i = 0; i < NUM_PLANES; i++)
+		assert_memory_equal(a->data[i], b->data[i], a->size[i]);
+}
+
+enum conversion {
+	CONVERT_I420,
+	CONVERT_NV12,
+	CONVERT_I444,
+	CONVERT_DECOMPRESS_420,
+	CONVERT_DECOMPRESS_NV12,
+	CONVERT_DECOMPRESS_YUY2,
+	CONVERT_DECOMPRESS_UYVY,
+};
+
+static void run_conversion(enum conversion conversion, const struct test_frame *in, struct test_frame *out,
+			   uint32_t height)
+{
+	const uint8_t *const in_planes[NUM_PLANES] = {in->data[0], in->data[1], in->data[2]};
+
+	switch (conversion) {
+	case CONVERT_I420:
+		compress_uyvx_to_i420(in->data[0], in->linesize[0], 0, height, out->data, out->linesize);
+		break;
+	case CONVERT_NV12:
+		compress_uyvx_to_nv12(in->data[0], in->linesize[0], 0, height, out->data, out->linesize);
+		break;
+	case CONVERT_I444:
+		convert_uyvx_to_i444(in->data[0], in->linesize[0], 0, height, out->data, out->linesize);
+		break;
+	case CONVERT_DECOMPRESS_420:
+		decompress_420(in_planes, in->linesize, 0, height, out->data[0], out->linesize[0]);
+		break;
+	case CONVERT_DECOMPRESS_NV12:
+		decompress_nv12(in_planes, in->linesize, 0, height, out->data[0], out->linesize[0]);
+		break;
+	case CONVERT_DECOMPRESS_YUY2:
+		decompress_422(in->data[0], in->linesize[0], 0, height, out->data[0], out->linesize[0], true);
+		break;
+	case CONVERT_DECOMPRESS_UYVY:
+		decompress_422(in->data[0], in->linesize[0], 0, height, out->data[0], out->linesize[0], false);
+		break;
+	}
+}
+
+static void get_linesizes(enum conversion conversion, uint32_t width, uint32_t in_linesize[NUM_PLANES],
+			  uint32_t out_linesize[NUM_PLANES])
+{
+	const uint32_t chroma_width = (width + 1) / 2;
+
+	switch (conversion) {
+	case CONVERT_I420:
+		in_linesize[0] = in_linesize[1] = in_linesize[2] = width * 4;
+		out_linesize[0] = width;
+		out_linesize[1] = out_linesize[2] = chroma_width;
+		break;
+	case CONVERT_NV12:
+		in_linesize[0] = in_linesize[1] = in_linesize[2] = width * 4;
+		out_linesize[0] = width;
+		out_linesize[1] = out_linesize[2] = chroma_width * 2;
+		break;
+	case CONVERT_I444:
+		in_linesize[0] = in_linesize[1] = in_linesize[2] = width * 4;
+		out_linesize[0] = out_linesize[1] = out_linesize[2] = width;
+		break;
+	case CONVERT_DECOMPRESS_420:
+		in_linesize[0] = width;
+		in_linesize[1] = in_linesize[2] = chroma_width;
+		out_linesize[0] = out_linesize[1] = out_linesize[2] = width * 4;
+		break;
+	case CONVERT_DECOMPRESS_NV12:
+		in_linesize[0] = width;
+		in_linesize[1] = in_linesize[2] = chroma_width * 2;
+		out_linesize[0] = out_linesize[1] = out_linesize[2] = width * 4;
+		break;
+	case CONVERT_DECOMPRESS_YUY2:
+	case CONVERT_DECOMPRESS_UYVY:
+		in_linesize[0] = in_linesize[1] = in_linesize[2] = chroma_width * 4;
+		out_linesize[0] = out_linesize[1] = out_linesize[2] = width * 4;
+		break;
+	}
+}
+
+static void check_conversion(enum conversion conversion)
+{
+	const enum format_conversion_simd prev = format_conversion_get_simd();
+
+	for (size_t w = 0; w < sizeof(widths) / sizeof(widths[0]); w++) {
+		for (size_t h = 0; h < sizeof(heights) / sizeof(heights[0]); h++) {
+			uint32_t in_linesize[NUM_PLANES];
+			uint32_t out_linesize[NUM_PLANES];
+			struct test_frame in, ref;
+
+			get_linesizes(conversion, widths[w], in_linesize, out_linesize);
+			frame_init(&in, in_linesize, heights[h], 1);
+			frame_init(&ref, out_linesize, heights[h], 2);
+
+			assert_true(format_conversion_set_simd(FORMAT_CONVERSION_SIMD_NONE));
+			run_conversion(conversion, &in, &ref, heights[h]);
+
+			for (size_t s = 0; s < sizeof(simd_sets) / sizeof(simd_sets[0]); s++) {
+				struct test_frame out;
+
+				if (!format_conversion_set_simd(simd_sets[s]))
+					continue;
+
+				frame_init(&out, out_linesize, heights[h], 2);
+				run_conversion(conversion, &in, &out, heights[h]);
+				frame_assert_equal(&ref, &out);
+				frame_free(&out);
+			}
+
+			frame_free(&ref);
+			frame_free(&in);
+		}
+	}
+
+	format_conversion_set_simd(prev);
+}
+
+static void compress_i420_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+	check_conversion(CONVERT_I420);
+}
+
+static void compress_nv12_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+	check_conversion(CONVERT_NV12);
+}
+
+static void convert_i444_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+	check_conversion(CONVERT_I444);
+}
+
+static void decompress_420_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+	check_conversion(CONVERT_DECOMPRESS_420);
+}
+
+static void decompress_nv12_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+	check_conversion(CONVERT_DECOMPRESS_NV12);
+}
+
+static void decompress_422_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+	check_conversion(CONVERT_DECOMPRESS_YUY2);
+	check_conversion(CONVERT_DECOMPRESS_UYVY);
+}
+
+static void scalar_reference_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	const enum format_conversion_simd prev = format_conversion_get_simd();
+
+	/* 3x3 uyvx image, columns and rows chosen so every average is known */
+	const uint8_t in[3 * 12] = {
+		10, 100, 20, 0, 30, 101, 40, 0, 50, 102, 60, 0, /* row 0 */
+		70, 103, 80, 0, 90, 104, 100, 0, 110, 105, 120, 0, /* row 1 */
+		130, 106, 140, 0, 150, 107, 160, 0, 170, 108, 180, 0, /* row 2 */
+	};
+	uint8_t lum[9], u[4], v[4];
+	uint8_t *planes[3] = {lum, u, v};
+	const uint32_t linesize[3] = {3, 2, 2};
+
+	const uint8_t lum_ref[9] = {100, 101, 102, 103, 104, 105, 106, 107, 108};
+	const uint8_t u_ref[4] = {(10 + 30 + 70 + 90) / 4, (50 + 50 + 110 + 110) / 4, (130 + 150) / 2, 170};
+	const uint8_t v_ref[4] = {(20 + 40 + 80 + 100) / 4, (60 + 60 + 120 + 120) / 4, (140 + 160) / 2, 180};
+
+	assert_true(format_conversion_set_simd(FORMAT_CONVERSION_SIMD_NONE));
+	compress_uyvx_to_i420(in, 12, 0, 3, planes, linesize);
+
+	assert_memory_equal(lum, lum_ref, sizeof(lum_ref));
+	assert_memory_equal(u, u_ref, sizeof(u_ref));
+	assert_memory_equal(v, v_ref, sizeof(v_ref));
+
+	format_conversion_set_simd(prev);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(scalar_reference_test),
+		cmocka_unit_test(compress_i420_test),
+		cmocka_unit_test(compress_nv12_test),
+		cmocka_unit_test(convert_i444_test),
+		cmocka_unit_test(decompress_420_test),
+		cmocka_unit_test(decompress_nv12_test),
+		cmocka_unit_test(decompress_422_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
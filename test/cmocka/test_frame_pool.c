@@ -0,0 +1,102 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <obs-frame-pool.h>
+
+static void reuse_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct frame_pool pool;
+	assert_true(frame_pool_init(&pool));
+
+	struct obs_source_frame *frame = frame_pool_create_frame(&pool, VIDEO_FORMAT_NV12, 1920, 1080);
+	assert_non_null(frame);
+	assert_true(frame->pooled);
+	assert_int_equal(frame->width, 1920);
+	assert_int_equal(frame->height, 1080);
+	assert_int_equal(frame->linesize[0], 1920);
+	assert_ptr_equal(frame->data[1], frame->data[0] + 1920 * 1080);
+
+	frame->timestamp = 1234;
+	frame_pool_destroy_frame(&pool, frame);
+	assert_true(pool.idle_bytes >= 1920 * 1080 * 3 / 2);
+
+	/* a frame of the same size class comes back reset */
+	struct obs_source_frame *again = frame_pool_create_frame(&pool, VIDEO_FORMAT_NV12, 1920, 1080);
+	assert_ptr_equal(again, frame);
+	assert_true(again->pooled);
+	assert_int_equal(again->timestamp, 0);
+	assert_int_equal(pool.idle_bytes, 0);
+	assert_int_equal(pool.hits, 1);
+	assert_int_equal(pool.misses, 1);
+
+	/* a different size class does not pick it up */
+	frame_pool_destroy_frame(&pool, again);
+	struct obs_source_frame *small = frame_pool_create_frame(&pool, VIDEO_FORMAT_NV12, 640, 360);
+	assert_ptr_not_equal(small, again);
+	assert_int_equal(pool.misses, 2);
+
+	frame_pool_destroy_frame(&pool, small);
+	frame_pool_free(&pool);
+}
+
+static void foreign_frame_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct frame_pool pool;
+	assert_true(frame_pool_init(&pool));
+
+	/* frames made outside of the pool, e.g. returned by an async filter,
+	 * are destroyed instead of being filed under a size class */
+	struct obs_source_frame *frame = obs_source_frame_create(VIDEO_FORMAT_BGRA, 64, 64);
+	assert_false(frame->pooled);
+
+	frame_pool_destroy_frame(&pool, frame);
+	assert_int_equal(pool.classes.num, 0);
+	assert_int_equal(pool.idle_bytes, 0);
+
+	frame_pool_free(&pool);
+}
+
+static void trim_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct frame_pool pool;
+	assert_true(frame_pool_init(&pool));
+
+	struct obs_source_frame *a = frame_pool_create_frame(&pool, VIDEO_FORMAT_I420, 1280, 720);
+	struct obs_source_frame *b = frame_pool_create_frame(&pool, VIDEO_FORMAT_I420, 1280, 720);
+	frame_pool_destroy_frame(&pool, a);
+	frame_pool_destroy_frame(&pool, b);
+	assert_int_equal(pool.classes.num, 1);
+	assert_int_equal(pool.classes.array[0].frames.num, 2);
+
+	/* recently used classes are kept */
+	frame_pool_trim(&pool);
+	assert_int_equal(pool.classes.num, 1);
+
+	pool.idle_timeout_ns = 0;
+	pool.last_trim = 0;
+	frame_pool_trim(&pool);
+	assert_int_equal(pool.classes.num, 0);
+	assert_int_equal(pool.idle_bytes, 0);
+	assert_int_equal(pool.released, 2);
+
+	frame_pool_free(&pool);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(reuse_test),
+		cmocka_unit_test(foreign_frame_test),
+		cmocka_unit_test(trim_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,234 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <cmocka.h>
+
+#include "benchmark.h"
+
+#include <util/platform.h>
+#include <graphics/image-file.h>
+
+#define TEST_GIF "test_image_file.gif"
+
+#define FRAME_DELAY 4 /* in hundredths of a second */
+#define FRAME_TIME_NS (FRAME_DELAY * 10000000ULL + 1)
+
+#define MAX_WAITS 10000
+
+struct gif_writer {
+	FILE *file;
+	uint8_t block[255];
+	size_t size;
+};
+
+static void put_u16(FILE *file, uint16_t val)
+{
+	fputc(val & 0xFF, file);
+	fputc(val >> 8, file);
+}
+
+static void put_code(struct gif_writer *w, uint8_t code)
+{
+	w->block[w->size++] = code;
+
+	if (w->size == sizeof(w->block)) {
+		fputc((int)w->size, w->file);
+		fwrite(w->block, 1, w->size, w->file);
+		w->size = 0;
+	}
+}
+
+/* Writes a looping GIF without actually compressing it: 7 bit pixels are
+ * written as 8 bit codes, with a clear code often enough that the code size
+ * never grows.  Every frame is made of 16x16 blocks that move one color over
+ * from the frame before. */
+static void write_gif(const char *path, uint16_t cx, uint16_t cy, int frames)
+{
+	struct gif_writer w = {0};
+
+	w.file = os_fopen(path, "wb");
+	assert_non_null(w.file);
+
+	fwrite("GIF89a", 1, 6, w.file);
+	put_u16(w.file, cx);
+	put_u16(w.file, cy);
+	fputc(0xE6, w.file); /* 128 entry global color table */
+	fputc(0, w.file);
+	fputc(0, w.file);
+
+	for (int i = 0; i < 128; i++) {
+		fputc(i * 2, w.file);
+		fputc(255 - i * 2, w.file);
+		fputc((i * 37) & 0xFF, w.file);
+	}
+
+	fwrite("\x21\xFF\x0BNETSCAPE2.0\x03\x01\x00\x00\x00", 1, 19, w.file);
+
+	for (int i = 0; i < frames; i++) {
+		fwrite("\x21\xF9\x04\x04", 1, 4, w.file);
+		put_u16(w.file, FRAME_DELAY);
+		fputc(0, w.file);
+		fputc(0, w.file);
+
+		fputc(0x2C, w.file);
+		put_u16(w.file, 0);
+		put_u16(w.file, 0);
+		put_u16(w.file, cx);
+		put_u16(w.file, cy);
+		fputc(0, w.file);
+		fputc(7, w.file);
+
+		for (size_t p = 0; p < (size_t)cx * cy; p++) {
+			size_t x = p % cx;
+			size_t y = p / cx;
+
+			if (p % 120 == 0)
+				put_code(&w, 128);
+			put_code(&w, (uint8_t)((x / 16 + y / 16 + (size_t)i) % 128));
+		}
+
+		put_code(&w, 129);
+		if (w.size) {
+			fputc((int)w.size, w.file);
+			fwrite(w.block, 1, w.size, w.file);
+			w.size = 0;
+		}
+		fputc(0, w.file);
+	}
+
+	fputc(0x3B, w.file);
+	fclose(w.file);
+}
+
+/* Ticks to the next frame, waiting for the decoder if it isn't there yet.
+ * Without a graphics context, updating the texture only takes the frame. */
+static uint64_t next_frame(gs_image_file5_t *if5, uint64_t elapsed)
+{
+	uint64_t waits = 0;
+
+	while (!gs_image_file5_tick(if5, elapsed)) {
+		assert_true(++waits < MAX_WAITS);
+		elapsed = 0;
+		os_sleep_ms(1);
+	}
+
+	gs_image_file5_update_texture(if5);
+	return waits;
+}
+
+static void stream_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	gs_image_file5_t if5;
+	gs_image_file_t *image = &if5.image4.image3.image2.image;
+
+	write_gif(TEST_GIF, 64, 32, 12);
+
+	/* fits in the budget, decoded at once as before */
+	gs_image_file5_init(&if5, TEST_GIF, GS_IMAGE_ALPHA_PREMULTIPLY, 64 * 32 * 4 * 12, false);
+	assert_true(image->loaded);
+	assert_true(image->is_animated_gif);
+	assert_null(if5.gif_stream);
+	gs_image_file5_free(&if5);
+
+	for (int compress = 0; compress < 2; compress++) {
+		gs_image_file5_init(&if5, TEST_GIF, GS_IMAGE_ALPHA_PREMULTIPLY, 1, compress);
+		assert_true(image->loaded);
+		assert_non_null(if5.gif_stream);
+		assert_int_equal(image->cx, 64);
+		assert_int_equal(image->cy, 32);
+
+		/* a few loops, then a skip of several frames */
+		for (int i = 1; i <= 30; i++) {
+			next_frame(&if5, FRAME_TIME_NS);
+			assert_int_equal(image->cur_frame, i % 12);
+		}
+
+		next_frame(&if5, FRAME_TIME_NS * 5);
+		assert_int_equal(image->cur_frame, 11);
+
+		/* restarting goes back to the first frame */
+		image->cur_frame = 0;
+		image->cur_loop = 0;
+		image->cur_time = 0;
+		gs_image_file5_update_texture(&if5);
+		next_frame(&if5, FRAME_TIME_NS);
+		assert_int_equal(image->cur_frame, 1);
+
+		gs_image_file5_free(&if5);
+		assert_null(if5.gif_stream);
+	}
+
+	os_unlink(TEST_GIF);
+}
+
+/* Not a pass/fail test: plays a large GIF twice over in each mode and reports
+ * the peak resident size above what the process used before loading it. */
+static void benchmark_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	static const struct {
+		const char *name;
+		uint64_t budget;
+		bool compress;
+	} modes[] = {
+		{"streamed", 32ULL * 1024 * 1024, false},
+		{"streamed, compressed", 64ULL * 1024 * 1024, true},
+		{"fully decoded", 0, false},
+	};
+
+	const uint16_t cx = 1280;
+	const uint16_t cy = 720;
+	const int frames = 48;
+
+	write_gif(TEST_GIF, cx, cy, frames);
+
+	for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+		uint64_t base = os_get_proc_resident_size();
+		uint64_t peak = base;
+		uint64_t waits = 0;
+		uint64_t start = os_gettime_ns();
+		gs_image_file5_t if5;
+
+		gs_image_file5_init(&if5, TEST_GIF, GS_IMAGE_ALPHA_PREMULTIPLY, modes[m].budget, modes[m].compress);
+		assert_true(if5.image4.image3.image2.image.loaded);
+
+		for (int i = 0; i < frames * 2; i++) {
+			waits += next_frame(&if5, FRAME_TIME_NS);
+
+			uint64_t rss = os_get_proc_resident_size();
+			if (rss > peak)
+				peak = rss;
+		}
+
+		uint64_t elapsed = os_gettime_ns() - start;
+		gs_image_file5_free(&if5);
+
+		printf("%dx%d, %d frames, %s: peak %.1f MiB resident, %.2f ms per frame, waited %d ms\n", cx, cy,
+		       frames, modes[m].name, (double)(peak - base) / (1024.0 * 1024.0),
+		       (double)elapsed / 1e6 / (frames * 2), (int)waits);
+	}
+
+	os_unlink(TEST_GIF);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(stream_test),
+	};
+	const struct CMUnitTest benchmarks[] = {
+		cmocka_unit_test(benchmark_test),
+	};
+
+	int failed = cmocka_run_group_tests(tests, NULL, NULL);
+
+	/* peak resident memory and decode time of streamed GIF decoding */
+	failed += run_benchmarks(benchmarks);
+
+	return failed;
+}
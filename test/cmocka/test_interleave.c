@@ -0,0 +1,287 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <cmocka.h>
+
+#include "benchmark.h"
+
+#include <util/platform.h>
+#include <obs-interleave.h>
+
+#define VIDEO_INTERVAL_USEC 16667
+#define AUDIO_INTERVAL_USEC 21333
+
+struct stream_packet {
+	struct encoder_packet packet;
+	int64_t arrival;
+};
+
+static uint32_t next_random(uint32_t *seed)
+{
+	*seed = *seed * 1103515245 + 12345;
+	return *seed >> 16;
+}
+
+static int compare_arrival(const void *a, const void *b)
+{
+	const struct stream_packet *pa = a;
+	const struct stream_packet *pb = b;
+
+	if (pa->arrival != pb->arrival)
+		return pa->arrival < pb->arrival ? -1 : 1;
+	return pa->packet.dts_usec < pb->packet.dts_usec ? -1 : (pa->packet.dts_usec > pb->packet.dts_usec);
+}
+
+/* Synthetic encoder output: every track produces packets in DTS order, but
+ * each encoder has its own latency and jitter, so tracks arrive interleaved
+ * out of DTS order the way they do in a real output.  Tracks of the same type
+ * start in phase so there are plenty of equal timestamps. */
+static struct stream_packet *make_streams(size_t video_tracks, size_t audio_tracks, int64_t duration_usec,
+					  size_t *count)
+{
+	DARRAY(struct stream_packet) packets;
+	uint32_t seed = 1;
+
+	da_init(packets);
+
+	for (size_t t = 0; t < video_tracks + audio_tracks; t++) {
+		bool video = t < video_tracks;
+		int64_t interval = video ? VIDEO_INTERVAL_USEC : AUDIO_INTERVAL_USEC;
+		int64_t latency = (int64_t)(next_random(&seed) % 20000);
+		int64_t last_arrival = 0;
+
+		for (int64_t dts = 0; dts < duration_usec; dts += interval) {
+			struct stream_packet *sp = da_push_back_new(packets);
+			int64_t arrival = dts + latency + (int64_t)(next_random(&seed) % 5000);
+
+			sp->packet.type = video ? OBS_ENCODER_VIDEO : OBS_ENCODER_AUDIO;
+			sp->packet.track_idx = video ? t : t - video_tracks;
+			sp->packet.dts_usec = dts;
+			sp->packet.dts = dts;
+			sp->packet.pts = dts;
+			sp->arrival = arrival > last_arrival ? arrival : last_arrival;
+			last_arrival = sp->arrival;
+		}
+	}
+
+	qsort(packets.array, packets.num, sizeof(*packets.array), compare_arrival);
+
+	*count = packets.num;
+	return packets.array;
+}
+
+/* the single sorted array the interleaver replaced, used as the reference */
+struct sorted_interleaver {
+	DARRAY(struct encoder_packet) packets;
+};
+
+static void sorted_push(struct sorted_interleaver *si, struct encoder_packet *out)
+{
+	size_t idx;
+	for (idx = 0; idx < si->packets.num; idx++) {
+		struct encoder_packet *cur_packet = si->packets.array + idx;
+
+		if (out->dts_usec == cur_packet->dts_usec && out->type == OBS_ENCODER_VIDEO &&
+		    cur_packet->type == OBS_ENCODER_VIDEO && out->track_idx > cur_packet->track_idx)
+			continue;
+
+		if (out->dts_usec == cur_packet->dts_usec && out->type == OBS_ENCODER_VIDEO) {
+			break;
+		} else if (out->dts_usec < cur_packet->dts_usec) {
+			break;
+		}
+	}
+
+	da_insert(si->packets, idx, out);
+}
+
+static bool sorted_pop(struct sorted_interleaver *si, struct encoder_packet *out)
+{
+	if (!si->packets.num)
+		return false;
+
+	*out = si->packets.array[0];
+	da_erase(si->packets, 0);
+	return true;
+}
+
+static void assert_packet_equal(const struct encoder_packet *a, const struct encoder_packet *b)
+{
+	assert_int_equal(a->type, b->type);
+	assert_int_equal(a->track_idx, b->track_idx);
+	assert_int_equal(a->dts_usec, b->dts_usec);
+}
+
+static void check_against_reference(size_t video_tracks, size_t audio_tracks, size_t window)
+{
+	struct packet_interleaver pi = {0};
+	struct sorted_interleaver si = {0};
+	struct encoder_packet a, b;
+	size_t count;
+
+	struct stream_packet *packets = make_streams(video_tracks, audio_tracks, 2000000, &count);
+
+	for (size_t i = 0; i < count; i++) {
+		packet_interleaver_push(&pi, &packets[i].packet);
+		sorted_push(&si, &packets[i].packet);
+		assert_int_equal(pi.num, si.packets.num);
+
+		while (pi.num > window) {
+			assert_true(packet_interleaver_pop(&pi, &a));
+			assert_true(sorted_pop(&si, &b));
+			assert_packet_equal(&a, &b);
+		}
+	}
+
+	while (packet_interleaver_pop(&pi, &a)) {
+		assert_true(sorted_pop(&si, &b));
+		assert_packet_equal(&a, &b);
+	}
+	assert_false(sorted_pop(&si, &b));
+
+	packet_interleaver_free(&pi);
+	da_free(si.packets);
+	bfree(packets);
+}
+
+static void single_track_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+	check_against_reference(1, 1, 16);
+}
+
+static void multitrack_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+	check_against_reference(MAX_OUTPUT_VIDEO_ENCODERS, MAX_OUTPUT_AUDIO_ENCODERS, 64);
+}
+
+static void iterator_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct packet_interleaver pi = {0};
+	struct packet_interleaver_iter iter;
+	struct interleaved_packet *ip;
+	struct encoder_packet packet;
+	size_t count, walked = 0;
+
+	struct stream_packet *packets = make_streams(3, 6, 500000, &count);
+
+	for (size_t i = 0; i < count; i++)
+		packet_interleaver_push(&pi, &packets[i].packet);
+
+	/* walking must see exactly what popping returns, in the same order */
+	packet_interleaver_iter_init(&pi, &iter);
+	while ((ip = packet_interleaver_iter_next(&pi, &iter)) != NULL) {
+		struct encoder_packet expected = ip->packet;
+
+		walked++;
+		assert_true(packet_interleaver_pop(&pi, &packet));
+		assert_packet_equal(&expected, &packet);
+		packet_interleaver_iter_init(&pi, &iter);
+	}
+
+	assert_int_equal(walked, count);
+	assert_int_equal(pi.num, 0);
+
+	packet_interleaver_free(&pi);
+	bfree(packets);
+}
+
+static void resort_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct packet_interleaver pi = {0};
+	struct encoder_packet packet;
+	int64_t last = INT64_MIN;
+	size_t count;
+
+	struct stream_packet *packets = make_streams(2, 2, 500000, &count);
+
+	for (size_t i = 0; i < count; i++)
+		packet_interleaver_push(&pi, &packets[i].packet);
+
+	/* shift one track the way applying start offsets does */
+	struct interleave_queue *queue = &pi.queues[interleave_queue_idx(OBS_ENCODER_AUDIO, 1)];
+	for (size_t i = queue->head; i < queue->packets.num; i++)
+		queue->packets.array[i].packet.dts_usec -= 30000;
+	packet_interleaver_resort(&pi);
+
+	while (packet_interleaver_pop(&pi, &packet)) {
+		assert_true(packet.dts_usec >= last);
+		last = packet.dts_usec;
+	}
+
+	packet_interleaver_free(&pi);
+	bfree(packets);
+}
+
+/* Not a pass/fail test: runs both implementations over the same synthetic
+ * multitrack streams and reports the cost per packet. */
+static void benchmark_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	static const size_t windows[] = {32, 128, 512};
+	struct encoder_packet packet;
+	size_t count;
+
+	struct stream_packet *packets =
+		make_streams(MAX_OUTPUT_VIDEO_ENCODERS, MAX_OUTPUT_AUDIO_ENCODERS, 60000000, &count);
+
+	for (size_t w = 0; w < sizeof(windows) / sizeof(windows[0]); w++) {
+		struct packet_interleaver pi = {0};
+		struct sorted_interleaver si = {0};
+		uint64_t start, heap_ns, sorted_ns;
+
+		start = os_gettime_ns();
+		for (size_t i = 0; i < count; i++) {
+			packet_interleaver_push(&pi, &packets[i].packet);
+			while (pi.num > windows[w])
+				packet_interleaver_pop(&pi, &packet);
+		}
+		heap_ns = os_gettime_ns() - start;
+
+		start = os_gettime_ns();
+		for (size_t i = 0; i < count; i++) {
+			sorted_push(&si, &packets[i].packet);
+			while (si.packets.num > windows[w])
+				sorted_pop(&si, &packet);
+		}
+		sorted_ns = os_gettime_ns() - start;
+
+		printf("interleave %zu packets, %zu buffered: queues %.1f ns/packet, sorted array %.1f ns/packet\n",
+		       count, windows[w], (double)heap_ns / (double)count, (double)sorted_ns / (double)count);
+
+		packet_interleaver_free(&pi);
+		da_free(si.packets);
+	}
+
+	bfree(packets);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(single_track_test),
+		cmocka_unit_test(multitrack_test),
+		cmocka_unit_test(iterator_test),
+		cmocka_unit_test(resort_test),
+	};
+	const struct CMUnitTest benchmarks[] = {
+		cmocka_unit_test(benchmark_test),
+	};
+
+	int failed = cmocka_run_group_tests(tests, NULL, NULL);
+
+	/* compares the queue based interleaver with a sorted array, the
+	 * timings are only printed */
+	failed += run_benchmarks(benchmarks);
+
+	return failed;
+}
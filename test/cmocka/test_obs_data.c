@@ -0,0 +1,293 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <cmocka.h>
+
+#include "benchmark.h"
+
+#include <util/dstr.h>
+#include <util/platform.h>
+#include <obs-data.h>
+
+static const char *test_json = "{\"name\":\"Scene \\\"1\\\"\\n\\u00e9\\ud83d\\ude00\",\"int\":-42,"
+			       "\"big\":9007199254740993,\"real\":0.5,\"exp\":1e3,\"on\":true,\"off\":false,"
+			       "\"nothing\":null,"
+			       "\"obj\":{\"inner\":{\"x\":1}},\"items\":[{\"a\":1},2,\"s\",[{\"b\":2}],{\"c\":3}]}";
+
+static void load_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	obs_data_t *data = obs_data_create_from_json(test_json);
+	assert_non_null(data);
+
+	assert_string_equal(obs_data_get_string(data, "name"), "Scene \"1\"\n\xc3\xa9\xf0\x9f\x98\x80");
+	assert_int_equal(obs_data_get_int(data, "int"), -42);
+	assert_true(obs_data_get_int(data, "big") == 9007199254740993LL);
+	assert_true(obs_data_get_double(data, "real") == 0.5);
+	assert_true(obs_data_get_double(data, "exp") == 1000.0);
+	assert_true(obs_data_get_bool(data, "on"));
+	assert_false(obs_data_get_bool(data, "off"));
+	assert_false(obs_data_has_user_value(data, "nothing"));
+
+	obs_data_t *obj = obs_data_get_obj(data, "obj");
+	obs_data_t *inner = obs_data_get_obj(obj, "inner");
+	assert_int_equal(obs_data_get_int(inner, "x"), 1);
+	obs_data_release(inner);
+	obs_data_release(obj);
+
+	/* arrays only keep their objects */
+	obs_data_array_t *array = obs_data_get_array(data, "items");
+	assert_int_equal(obs_data_array_count(array), 2);
+	obs_data_t *item = obs_data_array_item(array, 1);
+	assert_int_equal(obs_data_get_int(item, "c"), 3);
+	obs_data_release(item);
+	obs_data_array_release(array);
+
+	obs_data_release(data);
+}
+
+static void save_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	obs_data_t *data = obs_data_create_from_json(test_json);
+	assert_non_null(data);
+
+	assert_string_equal(obs_data_get_json(data),
+			    "{\"name\":\"Scene \\\"1\\\"\\n\xc3\xa9\xf0\x9f\x98\x80\",\"int\":-42,"
+			    "\"big\":9007199254740993,\"real\":0.5,\"exp\":1000.0,\"on\":true,\"off\":false,"
+			    "\"obj\":{\"inner\":{\"x\":1}},\"items\":[{\"a\":1},{\"c\":3}]}");
+
+	obs_data_release(data);
+
+	data = obs_data_create_from_json("{\"a\":{},\"b\":[],\"c\":[{\"d\":\"\\u0001\"}]}");
+	assert_non_null(data);
+	assert_string_equal(obs_data_get_json_pretty(data), "{\n"
+							    "    \"a\": {},\n"
+							    "    \"b\": [],\n"
+							    "    \"c\": [\n"
+							    "        {\n"
+							    "            \"d\": \"\\u0001\"\n"
+							    "        }\n"
+							    "    ]\n"
+							    "}");
+	obs_data_release(data);
+
+	/* defaults are only written when asked for */
+	data = obs_data_create();
+	obs_data_set_default_int(data, "def", 1);
+	obs_data_set_string(data, "user", "x");
+	assert_string_equal(obs_data_get_json(data), "{\"user\":\"x\"}");
+	assert_string_equal(obs_data_get_json_with_defaults(data), "{\"def\":1,\"user\":\"x\"}");
+	obs_data_release(data);
+}
+
+static void invalid_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	static const char *invalid[] = {
+		"",
+		"1",
+		"{",
+		"{\"a\":1,}",
+		"{\"a\":1}x",
+		"{\"a\":1,\"a\":2}",
+		"{\"a\":01}",
+		"{\"a\":1.}",
+		"{\"a\":tru}",
+		"{\"a\":\"\\x\"}",
+		"{\"a\":\"\\u0000\"}",
+		"{\"a\":\"\\ud83d\"}",
+		"{\"a\":\"\xc3\"}",
+		"{\"a\":\"\x01\"}",
+		"{\"a\":99999999999999999999}",
+		"{\"a\":[{\"b\":1,\"b\":1}]}",
+	};
+
+	for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++)
+		assert_null(obs_data_create_from_json(invalid[i]));
+
+	/* an array root is valid, but has nothing to load */
+	obs_data_t *data = obs_data_create_from_json(" [1, {\"a\": 1}] ");
+	assert_non_null(data);
+	assert_null(obs_data_first(data));
+	obs_data_release(data);
+}
+
+static void loaded_items_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	obs_data_t *data = obs_data_create_from_json("{\"a\":\"x\",\"b\":1,\"c\":{\"d\":2}}");
+	assert_non_null(data);
+
+	/* items loaded from JSON have to grow and go away like any other */
+	obs_data_set_string(data, "a", "a much longer string than the one that was loaded");
+	obs_data_set_default_string(data, "b", "default");
+	obs_data_erase(data, "b");
+	obs_data_set_int(data, "e", 3);
+
+	obs_data_item_t *item = obs_data_item_byname(data, "c");
+	obs_data_release(data);
+
+	obs_data_t *obj = obs_data_item_get_obj(item);
+	assert_int_equal(obs_data_get_int(obj, "d"), 2);
+	obs_data_release(obj);
+	obs_data_item_release(&item);
+}
+
+static void snapshot_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	obs_data_t *data = obs_data_create_from_json(test_json);
+	assert_non_null(data);
+	obs_data_set_default_int(data, "def", 7);
+	obs_data_set_default_int(data, "int", 1);
+
+	obs_data_snapshot_t *snapshot = obs_data_snapshot_create(data);
+	assert_non_null(snapshot);
+
+	/* changes after the snapshot was taken don't show up in it */
+	obs_data_set_int(data, "int", 5);
+	obs_data_erase(data, "name");
+
+	assert_string_equal(obs_data_snapshot_get_string(snapshot, obs_data_key("name")),
+			    "Scene \"1\"\n\xc3\xa9\xf0\x9f\x98\x80");
+	assert_int_equal(obs_data_snapshot_get_int(snapshot, obs_data_key("int")), -42);
+	assert_int_equal(obs_data_snapshot_get_int(snapshot, obs_data_key("def")), 7);
+	assert_true(obs_data_snapshot_get_int(snapshot, obs_data_key("big")) == 9007199254740993LL);
+	assert_true(obs_data_snapshot_get_double(snapshot, obs_data_key("exp")) == 1000.0);
+	assert_int_equal(obs_data_snapshot_get_int(snapshot, obs_data_key("real")), 0);
+	assert_true(obs_data_snapshot_get_bool(snapshot, obs_data_key("on")));
+	assert_false(obs_data_snapshot_has_value(snapshot, obs_data_key("nothing")));
+	assert_false(obs_data_snapshot_has_value(snapshot, obs_data_key("missing")));
+
+	/* wrong types read as empty values */
+	assert_string_equal(obs_data_snapshot_get_string(snapshot, obs_data_key("int")), "");
+	assert_false(obs_data_snapshot_get_bool(snapshot, obs_data_key("name")));
+
+	const obs_data_snapshot_t *obj = obs_data_snapshot_get_obj(snapshot, obs_data_key("obj"));
+	const obs_data_snapshot_t *inner = obs_data_snapshot_get_obj(obj, obs_data_key("inner"));
+	assert_int_equal(obs_data_snapshot_get_int(inner, obs_data_key("x")), 1);
+
+	obs_data_key_t items = obs_data_key("items");
+	assert_int_equal(obs_data_snapshot_array_count(snapshot, items), 2);
+	assert_int_equal(obs_data_snapshot_get_int(obs_data_snapshot_array_item(snapshot, items, 1), obs_data_key("c")),
+			 3);
+	assert_null(obs_data_snapshot_array_item(snapshot, items, 2));
+
+	obs_data_release(data);
+	obs_data_snapshot_release(snapshot);
+}
+
+/* Roughly what a large scene collection looks like: sources with settings,
+ * filters and hotkeys, and scenes with their items. */
+static void make_scene_collection(struct dstr *json, size_t num_sources)
+{
+	dstr_copy(json, "{\"current_scene\":\"Scene 0\",\"name\":\"Benchmark\",\"sources\":[");
+
+	for (size_t i = 0; i < num_sources; i++) {
+		bool scene = i % 10 == 0;
+
+		dstr_catf(json,
+			  "%s{\"balance\":0.5,\"deinterlace_mode\":0,\"enabled\":true,\"flags\":0,"
+			  "\"hotkeys\":{\"libobs.mute\":[],\"libobs.unmute\":[],\"libobs.push-to-talk\":[]},"
+			  "\"id\":\"%s\",\"mixers\":255,\"monitoring_type\":0,\"muted\":false,"
+			  "\"name\":\"%s %zu\",\"uuid\":\"6c1f3a52-8d6e-4a6b-9b5f-%012zx\","
+			  "\"private_settings\":{},\"push-to-mute\":false,\"push-to-talk\":false,"
+			  "\"sync\":0,\"volume\":1.0,\"settings\":{",
+			  i ? "," : "", scene ? "scene" : "image_source", scene ? "Scene" : "Image", i, i);
+
+		if (scene) {
+			dstr_cat(json, "\"custom_size\":false,\"id_counter\":10,\"items\":[");
+			for (size_t j = 0; j < 10; j++)
+				dstr_catf(json,
+					  "%s{\"align\":5,\"blend_method\":\"default\",\"blend_type\":\"normal\","
+					  "\"bounds\":{\"x\":0.0,\"y\":0.0},\"bounds_align\":0,\"bounds_type\":0,"
+					  "\"crop_bottom\":0,\"crop_left\":0,\"crop_right\":0,\"crop_top\":0,"
+					  "\"id\":%zu,\"locked\":false,\"name\":\"Image %zu\",\"pos\":{\"x\":%zu.25,"
+					  "\"y\":-12.5},\"rot\":0.0,\"scale\":{\"x\":0.25,\"y\":0.5},"
+					  "\"scale_filter\":\"disable\",\"visible\":true}",
+					  j ? "," : "", j + 1, i + j + 1, j * 64);
+			dstr_cat(json, "]}");
+		} else {
+			dstr_catf(json,
+				  "\"file\":\"C:/Users/Streamer/Pictures/Overlays/overlay \xc3\xa9 %zu.png\","
+				  "\"unload\":false},\"filters\":[{\"enabled\":true,\"id\":\"color_filter\","
+				  "\"name\":\"Color Correction\",\"settings\":{\"brightness\":0.0625,"
+				  "\"contrast\":-0.125,\"gamma\":0.25,\"saturation\":1.5}}]",
+				  i);
+		}
+
+		dstr_cat(json, "}");
+	}
+
+	dstr_cat(json, "],\"transitions\":[],\"transition_duration\":300}");
+}
+
+/* Not a pass/fail test: loads and saves a large generated scene collection
+ * and reports the throughput. */
+static void benchmark_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	static const size_t sizes[] = {1000, 20000};
+	struct dstr json = {0};
+
+	for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+		uint64_t start, load_ns, save_ns, pretty_ns;
+		double mb;
+
+		make_scene_collection(&json, sizes[s]);
+		mb = (double)json.len / (1024.0 * 1024.0);
+
+		start = os_gettime_ns();
+		obs_data_t *data = obs_data_create_from_json(json.array);
+		load_ns = os_gettime_ns() - start;
+		assert_non_null(data);
+
+		start = os_gettime_ns();
+		const char *saved = obs_data_get_json(data);
+		save_ns = os_gettime_ns() - start;
+		assert_string_equal(saved, json.array);
+
+		start = os_gettime_ns();
+		obs_data_get_json_pretty(data);
+		pretty_ns = os_gettime_ns() - start;
+
+		printf("scene collection %.1f MiB: load %.1f ms (%.0f MiB/s), save %.1f ms (%.0f MiB/s), "
+		       "save pretty %.1f ms\n",
+		       mb, (double)load_ns / 1e6, mb / ((double)load_ns / 1e9), (double)save_ns / 1e6,
+		       mb / ((double)save_ns / 1e9), (double)pretty_ns / 1e6);
+
+		obs_data_release(data);
+	}
+
+	dstr_free(&json);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(load_test),
+		cmocka_unit_test(save_test),
+		cmocka_unit_test(invalid_test),
+		cmocka_unit_test(loaded_items_test),
+		cmocka_unit_test(snapshot_test),
+	};
+	const struct CMUnitTest benchmarks[] = {
+		cmocka_unit_test(benchmark_test),
+	};
+
+	int failed = cmocka_run_group_tests(tests, NULL, NULL);
+
+	/* load/save throughput of a large generated scene collection */
+	failed += run_benchmarks(benchmarks);
+
+	return failed;
+}
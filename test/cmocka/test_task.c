@@ -0,0 +1,247 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <util/task.h>
+#include <util/threading.h>
+#include <util/platform.h>
+
+#define NUM_TASKS 256
+#define WAIT_TIMEOUT_MS 10000
+
+static volatile long counter = 0;
+
+static void count_task(void *param)
+{
+	UNUSED_PARAMETER(param);
+	os_atomic_inc_long(&counter);
+}
+
+static void signal_task(void *param)
+{
+	os_event_signal(param);
+}
+
+static void submit_wait_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	os_task_group_t *group = os_task_group_create();
+	assert_non_null(group);
+
+	/* waiting for an empty group returns right away */
+	os_task_group_wait(group);
+
+	os_atomic_set_long(&counter, 0);
+	for (size_t i = 0; i < NUM_TASKS; i++)
+		assert_true(os_task_group_submit(group, count_task, NULL, (enum os_task_priority)(i % 3)));
+
+	os_task_group_wait(group);
+	assert_int_equal(os_atomic_load_long(&counter), NUM_TASKS);
+
+	/* tasks outside of a group */
+	os_event_t *event;
+	assert_int_equal(os_event_init(&event, OS_EVENT_TYPE_MANUAL), 0);
+	assert_true(os_pool_submit(signal_task, event, OS_TASK_PRIORITY_NORMAL));
+	assert_int_equal(os_event_timedwait(event, WAIT_TIMEOUT_MS), 0);
+	os_event_destroy(event);
+
+	assert_false(os_pool_inside());
+	os_task_group_destroy(group);
+}
+
+struct nested_data {
+	os_task_group_t *outer;
+	os_task_group_t *inner;
+	os_event_t *done_event;
+	volatile bool ok;
+};
+
+static void nested_task(void *param)
+{
+	struct nested_data *data = param;
+
+	os_atomic_set_bool(&data->ok, os_pool_inside());
+
+	for (size_t i = 0; i < NUM_TASKS; i++)
+		os_task_group_submit(data->inner, count_task, NULL, OS_TASK_PRIORITY_NORMAL);
+
+	/* a worker waiting for its own tasks runs them instead of blocking */
+	os_task_group_wait(data->inner);
+}
+
+static void nested_wait_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct nested_data data = {0};
+	data.outer = os_task_group_create();
+	data.inner = os_task_group_create();
+
+	os_atomic_set_long(&counter, 0);
+	assert_true(os_task_group_submit(data.outer, nested_task, &data, OS_TASK_PRIORITY_HIGH));
+	os_task_group_wait(data.outer);
+
+	assert_true(os_atomic_load_bool(&data.ok));
+	assert_int_equal(os_atomic_load_long(&counter), NUM_TASKS);
+
+	os_task_group_destroy(data.inner);
+	os_task_group_destroy(data.outer);
+}
+
+static void last_count_task(void *param)
+{
+	if (os_atomic_inc_long(&counter) == NUM_TASKS)
+		os_event_signal(param);
+}
+
+static void blocking_task(void *param)
+{
+	struct nested_data *data = param;
+
+	/* tasks queued from a pool task stay with its worker, so they can
+	 * only run while this one blocks if another worker steals them */
+	for (size_t i = 0; i < NUM_TASKS; i++)
+		os_pool_submit(last_count_task, data->done_event, OS_TASK_PRIORITY_NORMAL);
+
+	os_atomic_set_bool(&data->ok, os_event_timedwait(data->done_event, WAIT_TIMEOUT_MS) == 0);
+}
+
+static void stealing_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct nested_data data = {0};
+	data.outer = os_task_group_create();
+	assert_int_equal(os_event_init(&data.done_event, OS_EVENT_TYPE_MANUAL), 0);
+
+	os_atomic_set_long(&counter, 0);
+	assert_true(os_task_group_submit(data.outer, blocking_task, &data, OS_TASK_PRIORITY_NORMAL));
+	os_task_group_wait(data.outer);
+
+	assert_true(os_atomic_load_bool(&data.ok));
+	assert_int_equal(os_atomic_load_long(&counter), NUM_TASKS);
+
+	os_event_destroy(data.done_event);
+	os_task_group_destroy(data.outer);
+}
+
+static os_event_t *gate_event = NULL;
+
+static void gated_task(void *param)
+{
+	UNUSED_PARAMETER(param);
+	os_event_wait(gate_event);
+	os_atomic_inc_long(&counter);
+}
+
+static void *open_gate_thread(void *param)
+{
+	UNUSED_PARAMETER(param);
+	os_sleep_ms(100);
+	os_event_signal(gate_event);
+	return NULL;
+}
+
+static void destroy_pending_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	os_task_group_t *group = os_task_group_create();
+	pthread_t thread;
+
+	assert_int_equal(os_event_init(&gate_event, OS_EVENT_TYPE_MANUAL), 0);
+	os_atomic_set_long(&counter, 0);
+
+	/* more tasks than there are workers, all stuck until the gate opens */
+	for (size_t i = 0; i < NUM_TASKS; i++)
+		assert_true(os_task_group_submit(group, gated_task, NULL, OS_TASK_PRIORITY_LOW));
+
+	pthread_create(&thread, NULL, open_gate_thread, NULL);
+
+	/* the queued tasks are dropped and the running ones waited for */
+	os_task_group_destroy(group);
+	long ran = os_atomic_load_long(&counter);
+	assert_true(ran < NUM_TASKS);
+
+	pthread_join(thread, NULL);
+
+	/* nothing of the destroyed group runs afterwards */
+	os_sleep_ms(50);
+	assert_int_equal(os_atomic_load_long(&counter), ran);
+
+	os_event_destroy(gate_event);
+	gate_event = NULL;
+}
+
+static void cancel_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	os_task_group_t *group = os_task_group_create();
+	os_task_group_t *other = os_task_group_create();
+	pthread_t thread;
+
+	assert_int_equal(os_event_init(&gate_event, OS_EVENT_TYPE_MANUAL), 0);
+	os_atomic_set_long(&counter, 0);
+
+	for (size_t i = 0; i < NUM_TASKS; i++)
+		assert_true(os_task_group_submit(group, gated_task, NULL, OS_TASK_PRIORITY_LOW));
+	for (size_t i = 0; i < NUM_TASKS; i++)
+		assert_true(os_task_group_submit(other, gated_task, NULL, OS_TASK_PRIORITY_LOW));
+
+	/* only the tasks of the canceled group are removed */
+	size_t removed = os_task_group_cancel(group);
+	assert_true(removed > 0);
+
+	pthread_create(&thread, NULL, open_gate_thread, NULL);
+	os_task_group_wait(group);
+	os_task_group_wait(other);
+	pthread_join(thread, NULL);
+
+	assert_int_equal(os_atomic_load_long(&counter), 2 * NUM_TASKS - (long)removed);
+
+	os_task_group_destroy(other);
+	os_task_group_destroy(group);
+	os_event_destroy(gate_event);
+	gate_event = NULL;
+}
+
+static void shutdown_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	os_task_group_t *group = os_task_group_create();
+
+	os_atomic_set_long(&counter, 0);
+	for (size_t i = 0; i < NUM_TASKS; i++)
+		assert_true(os_task_group_submit(group, count_task, NULL, OS_TASK_PRIORITY_NORMAL));
+
+	/* queued tasks still run before the workers stop */
+	os_pool_shutdown();
+	assert_int_equal(os_atomic_load_long(&counter), NUM_TASKS);
+	os_task_group_wait(group);
+
+	/* and the pool starts again on demand */
+	assert_true(os_task_group_submit(group, count_task, NULL, OS_TASK_PRIORITY_NORMAL));
+	os_task_group_wait(group);
+	assert_int_equal(os_atomic_load_long(&counter), NUM_TASKS + 1);
+
+	os_task_group_destroy(group);
+	os_pool_shutdown();
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(submit_wait_test),
+		cmocka_unit_test(nested_wait_test),
+		cmocka_unit_test(stealing_test),
+		cmocka_unit_test(destroy_pending_test),
+		cmocka_unit_test(cancel_test),
+		cmocka_unit_test(shutdown_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}